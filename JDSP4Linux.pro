@@ -2,6 +2,8 @@ TEMPLATE = subdirs
 
 SUBDIRS += \
     libjamesdsp \
-    src
+    src \
+    bench
 
 src.depends = libjamesdsp
+bench.depends = libjamesdsp
@@ -0,0 +1,29 @@
+#-------------------------------------------------
+#
+# jdsp-bench: headless libjamesdsp benchmark
+#
+#-------------------------------------------------
+
+TARGET = jdsp-bench
+TEMPLATE = app
+
+CONFIG += console c++17
+CONFIG -= qt app_bundle
+
+DEBUG_ASAN: CONFIG += sanitizer sanitize_address
+
+SOURCES += \
+    main.cpp
+
+unix {
+    # Route the allocator through main.cpp to count allocations made by the library
+    QMAKE_LFLAGS += -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc,--wrap=posix_memalign,--wrap=aligned_alloc
+    LIBS += -lpthread -lm
+}
+
+# Link libjamesdsp
+unix:!macx: LIBS += -L$$OUT_PWD/../libjamesdsp -llibjamesdsp
+INCLUDEPATH += $$PWD/../libjamesdsp/subtree/Main/libjamesdsp/jni/jamesdsp/jdsp/ \
+               $$PWD/../libjamesdsp
+DEPENDPATH += $$PWD/../libjamesdsp
+unix:!macx: PRE_TARGETDEPS += $$OUT_PWD/../libjamesdsp/liblibjamesdsp.a
@@ -0,0 +1,612 @@
+/*
+ *  jdsp-bench
+ *  Headless benchmark for libjamesdsp. Every effect is run in isolation and in
+ *  a few realistic combinations across a sweep of block sizes and sample rates.
+ *  Results are written to stdout as JSON; progress goes to stderr.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+extern "C" {
+#include <jdsp_header.h>
+}
+
+/* Allocation accounting. The binary is linked with --wrap for the libc allocator,
+   so every call made from libjamesdsp and from this file ends up here. */
+static std::atomic<size_t> allocCount{0};
+static std::atomic<size_t> allocBytes{0};
+
+extern "C" {
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t nmemb, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+int __real_posix_memalign(void** memptr, size_t alignment, size_t size);
+void* __real_aligned_alloc(size_t alignment, size_t size);
+
+void* __wrap_malloc(size_t size)
+{
+    allocCount.fetch_add(1, std::memory_order_relaxed);
+    allocBytes.fetch_add(size, std::memory_order_relaxed);
+    return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t nmemb, size_t size)
+{
+    allocCount.fetch_add(1, std::memory_order_relaxed);
+    allocBytes.fetch_add(nmemb * size, std::memory_order_relaxed);
+    return __real_calloc(nmemb, size);
+}
+
+void* __wrap_realloc(void* ptr, size_t size)
+{
+    allocCount.fetch_add(1, std::memory_order_relaxed);
+    allocBytes.fetch_add(size, std::memory_order_relaxed);
+    return __real_realloc(ptr, size);
+}
+
+// The convolver spectrum arenas come from the aligned allocators
+int __wrap_posix_memalign(void** memptr, size_t alignment, size_t size)
+{
+    allocCount.fetch_add(1, std::memory_order_relaxed);
+    allocBytes.fetch_add(size, std::memory_order_relaxed);
+    return __real_posix_memalign(memptr, alignment, size);
+}
+
+void* __wrap_aligned_alloc(size_t alignment, size_t size)
+{
+    allocCount.fetch_add(1, std::memory_order_relaxed);
+    allocBytes.fetch_add(size, std::memory_order_relaxed);
+    return __real_aligned_alloc(alignment, size);
+}
+}
+
+typedef std::function<void(JamesDSPLib*)> SetupFunc;
+
+struct BenchCase
+{
+    std::string name;
+    SetupFunc setup;
+};
+
+struct BenchResult
+{
+    double nsPerSample;
+    double realtimeFactor;
+    size_t setupAllocations;
+    size_t setupBytes;
+    size_t processAllocations;
+    size_t processBytes;
+    size_t stateBytes;
+    unsigned long long missedDeadlines;
+    unsigned long long spinResolved;
+};
+
+static const char* liveprogScript =
+        "desc: bench gain\n"
+        "@init\n"
+        "gain = 0.5;\n"
+        "@sample\n"
+        "spl0 = spl0 * gain;\n"
+        "spl1 = spl1 * gain;\n";
+
+/* Single second order section, 44.1k and 48k variants (b0, b1, b2, a1, a2) */
+static const char* ddcString =
+        "SR_44100:1.0093,-1.9601,0.9524,-1.9601,0.9617\n"
+        "SR_48000:1.0086,-1.9636,0.9566,-1.9636,0.9652\n";
+
+static void setupTube(JamesDSPLib* dsp)
+{
+    VacuumTubeSetGain(dsp, 0.5);
+    VacuumTubeEnable(dsp);
+}
+
+static void setupCompressor(JamesDSPLib* dsp)
+{
+    double freq[7] = { 95.0, 200.0, 400.0, 800.0, 1600.0, 3400.0, 7500.0 };
+    double gain[7] = { 0.2, 0.1, 0.0, -0.1, 0.0, 0.1, 0.2 };
+    CompressorSetParam(dsp, 0.22f, 2, 0, 0);
+    CompressorSetGain(dsp, freq, gain, 1);
+    CompressorEnable(dsp, 1);
+}
+
+static void setupBassBoost(JamesDSPLib* dsp)
+{
+    BassBoostSetParam(dsp, 6.0f);
+    BassBoostEnable(dsp);
+}
+
+static void setupEqualizer(JamesDSPLib* dsp, int filterType)
+{
+    double param[30] = { 25.0, 40.0, 63.0, 100.0, 160.0, 250.0, 400.0, 630.0, 1000.0, 1600.0, 2500.0, 4000.0, 6300.0, 10000.0, 16000.0,
+                         4.0, 3.0, 2.0, 1.0, 0.0, -1.0, -1.0, 0.0, 0.0, 1.0, 2.0, 2.0, 1.0, 0.0, -2.0 };
+    MultimodalEqualizerAxisInterpolation(dsp, 0, filterType, param, param + 15);
+    MultimodalEqualizerEnable(dsp, 1);
+}
+
+static void setupArbEq(JamesDSPLib* dsp)
+{
+    char eq[] = "GraphicEQ: 25 3; 100 1; 400 -1; 1000 0; 4000 2; 10000 1; 16000 -3";
+    ArbitraryResponseEqualizerStringParser(dsp, eq);
+    ArbitraryResponseEqualizerEnable(dsp, 1);
+}
+
+static void setupConvolver(JamesDSPLib* dsp, double seconds)
+{
+    // Exponentially decaying noise, roughly what a room impulse response looks like
+    size_t len = (size_t)(dsp->fs * seconds);
+    std::vector<float> ir(len * 2);
+    uint64_t state[2] = { 0x9E3779B97F4A7C15ULL, 0xD1B54A32D192ED03ULL };
+    float decay = (float)std::pow(10.0, -60.0 / 20.0 / (double)len);
+    float env = 1.0f;
+    for (size_t i = 0; i < len; i++)
+    {
+        ir[i * 2] = (float)(randXorshift(state) * 2.0 - 1.0) * env;
+        ir[i * 2 + 1] = (float)(randXorshift(state) * 2.0 - 1.0) * env;
+        env *= decay;
+    }
+    Convolver1DLoadImpulseResponse(dsp, ir.data(), 2, len, 1);
+    Convolver1DEnable(dsp);
+}
+
+static void setupDdc(JamesDSPLib* dsp)
+{
+    std::string ddc(ddcString);
+    DDCStringParser(dsp, ddc.data());
+    DDCEnable(dsp, 1);
+}
+
+static void setupLiveprog(JamesDSPLib* dsp)
+{
+    std::string script(liveprogScript);
+    LiveProgStringParser(dsp, script.data());
+    LiveProgEnable(dsp);
+}
+
+static void setupCrossfeed(JamesDSPLib* dsp, int mode)
+{
+    CrossfeedChangeMode(dsp, mode);
+    CrossfeedEnable(dsp, 1);
+}
+
+static void setupStereoEnhancement(JamesDSPLib* dsp)
+{
+    StereoEnhancementSetParam(dsp, 0.6f);
+    StereoEnhancementEnable(dsp);
+}
+
+static void setupReverb(JamesDSPLib* dsp)
+{
+    ReverbSetAdvancedParam(dsp, 1, 0.40f, -9.0f, -7.0f, 1.6f, 0.7f, 1.0f, 0.0f, 0.25f, 0.15f, 0.7f,
+                           17000, 500, 7000, 10000, 3.2f, 0.02f);
+    ReverbEnable(dsp);
+}
+
+static std::vector<BenchCase> buildCases()
+{
+    return {
+        { "bypass", [](JamesDSPLib*) {} },
+        // A non-unity post gain keeps the output stage engaged, the two cases differ only in the limiter mode
+        { "limiter", [](JamesDSPLib* d) { JamesDSPSetPostGain(d, -1.0f); } },
+        { "limiter_truepeak", [](JamesDSPLib* d) { JamesDSPSetPostGain(d, -1.0f); JLimiterSetTruePeak(d, 1); } },
+        { "tube", setupTube },
+        { "compressor", setupCompressor },
+        { "bassboost", setupBassBoost },
+        { "equalizer_fir", [](JamesDSPLib* d) { setupEqualizer(d, 0); } },
+        { "equalizer_iir", [](JamesDSPLib* d) { setupEqualizer(d, 2); } },
+        { "arbeq", setupArbEq },
+        { "convolver_short", [](JamesDSPLib* d) { setupConvolver(d, 0.1); } },
+        { "convolver_long", [](JamesDSPLib* d) { setupConvolver(d, 3.0); } },
+        { "ddc", setupDdc },
+        { "liveprog", setupLiveprog },
+        { "crossfeed_bs2b", [](JamesDSPLib* d) { setupCrossfeed(d, 1); } },
+        { "crossfeed_hrtf", [](JamesDSPLib* d) { setupCrossfeed(d, 2); } },
+        { "crossfeed_surround", [](JamesDSPLib* d) { setupCrossfeed(d, 5); } },
+        { "stereoenh", setupStereoEnhancement },
+        { "reverb", setupReverb },
+        // Realistic combinations
+        { "combo_music", [](JamesDSPLib* d) {
+              setupBassBoost(d);
+              setupEqualizer(d, 0);
+              setupCompressor(d);
+              setupCrossfeed(d, 1);
+          } },
+        { "combo_headphone", [](JamesDSPLib* d) {
+              setupArbEq(d);
+              setupConvolver(d, 0.5);
+              setupCrossfeed(d, 2);
+          } },
+        { "combo_all", [](JamesDSPLib* d) {
+              setupTube(d);
+              setupCompressor(d);
+              setupBassBoost(d);
+              setupEqualizer(d, 0);
+              setupArbEq(d);
+              setupConvolver(d, 1.0);
+              setupDdc(d);
+              setupLiveprog(d);
+              setupCrossfeed(d, 2);
+              setupStereoEnhancement(d);
+              setupReverb(d);
+          } }
+    };
+}
+
+static BenchResult runCase(const BenchCase& bc, float rate, size_t blockSize, double seconds)
+{
+    BenchResult res;
+
+    size_t a0 = allocCount.load();
+    size_t b0 = allocBytes.load();
+
+    JamesDSPLib* dsp = (JamesDSPLib*)malloc(sizeof(JamesDSPLib));
+    memset(dsp, 0, sizeof(JamesDSPLib));
+    JamesDSPInit(dsp, (int)blockSize, rate);
+    bc.setup(dsp);
+
+    std::vector<float> in[2] = { std::vector<float>(blockSize), std::vector<float>(blockSize) };
+    std::vector<float> out[2] = { std::vector<float>(blockSize), std::vector<float>(blockSize) };
+    uint64_t state[2] = { 0x2545F4914F6CDD1DULL, 0x5851F42D4C957F2DULL };
+    for (size_t i = 0; i < blockSize; i++)
+    {
+        in[0][i] = (float)(randXorshift(state) - 0.5) * 0.5f;
+        in[1][i] = (float)(randXorshift(state) - 0.5) * 0.5f;
+    }
+
+    // Warm up: lets internal buffering settle and the first block size change go through
+    size_t warmupBlocks = (size_t)(rate * 0.1) / blockSize + 2;
+    for (size_t i = 0; i < warmupBlocks; i++)
+        dsp->processFloatDeinterleaved(dsp, in[0].data(), in[1].data(), out[0].data(), out[1].data(), blockSize);
+    // Repartitioning runs on the library's worker thread, keep feeding blocks until it has been swapped in
+    while (JamesDSPRebuildPending(dsp))
+    {
+        dsp->processFloatDeinterleaved(dsp, in[0].data(), in[1].data(), out[0].data(), out[1].data(), blockSize);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    res.setupAllocations = allocCount.load() - a0;
+    res.setupBytes = allocBytes.load() - b0;
+
+    size_t blocks = (size_t)std::ceil(rate * seconds / (double)blockSize);
+    size_t a1 = allocCount.load();
+    size_t b1 = allocBytes.load();
+    ConvolverWorkerPoolStats pool0, pool1;
+    ConvolverWorkerPoolGetStats(&pool0);
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < blocks; i++)
+        dsp->processFloatDeinterleaved(dsp, in[0].data(), in[1].data(), out[0].data(), out[1].data(), blockSize);
+    auto end = std::chrono::steady_clock::now();
+    ConvolverWorkerPoolGetStats(&pool1);
+    res.processAllocations = allocCount.load() - a1;
+    res.processBytes = allocBytes.load() - b1;
+    // Tail jobs the audio thread had to wait for, the counters are process wide
+    res.missedDeadlines = pool1.missedDeadlines - pool0.missedDeadlines;
+    res.spinResolved = pool1.spinResolved - pool0.spinResolved;
+
+    double elapsedNs = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+    double samples = (double)(blocks * blockSize);
+    res.nsPerSample = elapsedNs / samples;
+    res.realtimeFactor = (samples / rate) / (elapsedNs * 1e-9);
+    res.stateBytes = JamesDSPGetMemoryUsage(dsp, NULL);
+
+    JamesDSPFree(dsp);
+    free(dsp);
+    return res;
+}
+
+// Times every real FFT kernel set the CPU supports at every transform size, against the scalar codelets
+static void runFFT(double seconds)
+{
+    std::vector<const RealFFTKernels*> sets;
+    for (int level = REALFFT_SCALAR; level < REALFFT_BEST; level++)
+    {
+        const RealFFTKernels* k = realFFTSelect(level);
+        if (k->level == level)
+            sets.push_back(k);
+    }
+
+    printf("{\n  \"secondsPerRun\": %g,\n  \"fft\": [", seconds);
+    bool first = true;
+    for (unsigned int n = 16; n <= (1U << REALFFT_MAX_LOG2); n <<= 1)
+    {
+        std::vector<float> table(n), input(n), reference(n), work(n);
+        realFFTTable(table.data(), n);
+        uint64_t state[2] = { 0x2545F4914F6CDD1DULL, 0x5851F42D4C957F2DULL };
+        for (unsigned int i = 0; i < n; i++)
+            input[i] = (float)(randXorshift(state) - 0.5);
+        reference = input;
+        realFFTKernel(sets[0], n)(reference.data(), table.data());
+
+        double scalarNs = 0.0;
+        for (const RealFFTKernels* k : sets)
+        {
+            RealFFTFunc fht = realFFTKernel(k, n);
+            work = input;
+            fht(work.data(), table.data());
+            double maxDiff = 0.0;
+            for (unsigned int i = 0; i < n; i++)
+                maxDiff = std::fmax(maxDiff, std::fabs((double)work[i] - (double)reference[i]));
+
+            // Every run transforms a fresh copy of the input, the copy is timed alike for all kernel sets
+            size_t runs = 0;
+            double elapsedNs = 0.0;
+            auto start = std::chrono::steady_clock::now();
+            do
+            {
+                for (int r = 0; r < 8; r++)
+                {
+                    memcpy(work.data(), input.data(), n * sizeof(float));
+                    fht(work.data(), table.data());
+                }
+                runs += 8;
+                elapsedNs = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+            } while (elapsedNs < seconds * 1e9);
+            double ns = elapsedNs / (double)runs;
+            if (k->level == REALFFT_SCALAR)
+                scalarNs = ns;
+            fprintf(stderr, "fft %-8s %8u %12.1f ns, %5.2fx\n", k->name, n, ns, scalarNs / ns);
+
+            printf("%s\n    { \"kernels\": \"%s\", \"size\": %u, \"nsPerTransform\": %.1f, "
+                   "\"speedup\": %.2f, \"maxAbsDiff\": %g }",
+                   first ? "" : ",", k->name, n, ns, scalarNs / ns, maxDiff);
+            fflush(stdout);
+            first = false;
+        }
+    }
+    printf("\n  ]\n}\n");
+}
+
+// Runs the N x M matrix convolver, uniform and multi-stage, against a direct convolution of the same impulse responses
+static void runMatrix(double seconds)
+{
+    struct MatrixShape
+    {
+        unsigned int inputs;
+        unsigned int outputs;
+    };
+    const MatrixShape shapes[] = { { 2, 2 }, { 6, 2 }, { 8, 8 } };
+    const unsigned int uniform[] = { 128 };
+    const unsigned int staged[] = { 128, 512, 2048 };
+    const unsigned int blockSize = 128;
+    const unsigned int irLen = 4600;
+    const unsigned int checkLen = 6144;
+    const float rate = 48000.0f;
+
+    printf("{\n  \"secondsPerRun\": %g,\n  \"matrix\": [", seconds);
+    bool first = true;
+    for (const MatrixShape& shape : shapes)
+    {
+        const unsigned int paths = shape.inputs * shape.outputs;
+        uint64_t state[2] = { 0x9E3779B97F4A7C15ULL, 0xD1B54A32D192ED03ULL };
+        float decay = (float)std::pow(10.0, -60.0 / 20.0 / (double)irLen);
+        std::vector<std::vector<float>> ir(paths, std::vector<float>(irLen));
+        for (unsigned int p = 0; p < paths; p++)
+        {
+            float env = 1.0f;
+            for (unsigned int k = 0; k < irLen; k++)
+            {
+                ir[p][k] = (float)(randXorshift(state) * 2.0 - 1.0) * env;
+                env *= decay;
+            }
+        }
+        std::vector<std::vector<float>> x(shape.inputs, std::vector<float>(checkLen));
+        for (auto& ch : x)
+            for (unsigned int t = 0; t < checkLen; t++)
+                ch[t] = (float)(randXorshift(state) - 0.5) * 0.5f;
+
+        // Reference in double precision, output o sums input i convolved with ir[i * outputs + o]
+        std::vector<std::vector<double>> ref(shape.outputs, std::vector<double>(checkLen, 0.0));
+        double peak = 0.0;
+        for (unsigned int o = 0; o < shape.outputs; o++)
+        {
+            for (unsigned int i = 0; i < shape.inputs; i++)
+            {
+                const float* h = ir[i * shape.outputs + o].data();
+                const float* in = x[i].data();
+                for (unsigned int t = 0; t < checkLen; t++)
+                {
+                    double acc = 0.0;
+                    unsigned int taps = t < irLen ? t + 1 : irLen;
+                    for (unsigned int k = 0; k < taps; k++)
+                        acc += (double)in[t - k] * (double)h[k];
+                    ref[o][t] += acc;
+                }
+            }
+            for (unsigned int t = 0; t < checkLen; t++)
+                peak = std::fmax(peak, std::fabs(ref[o][t]));
+        }
+
+        const float* irPtr[FFTCONVOLVER_MAX_CHANNELS * FFTCONVOLVER_MAX_CHANNELS];
+        for (unsigned int p = 0; p < paths; p++)
+            irPtr[p] = ir[p].data();
+
+        for (int layout = 0; layout < 2; layout++)
+        {
+            const unsigned int* sizes = layout ? staged : uniform;
+            unsigned int stageCount = layout ? 3 : 1;
+            const char* name = layout ? "multistage" : "uniform";
+
+            MultiStageFFTConvolverNxM* conv = (MultiStageFFTConvolverNxM*)malloc(sizeof(MultiStageFFTConvolverNxM));
+            MultiStageFFTConvolverNxMInit(conv);
+            if (!MultiStageFFTConvolverNxMLoadImpulseResponse(conv, sizes, stageCount, shape.inputs, shape.outputs, irPtr, irLen))
+            {
+                fprintf(stderr, "matrix %ux%u %s: impulse response not loaded\n", shape.inputs, shape.outputs, name);
+                free(conv);
+                continue;
+            }
+
+            std::vector<std::vector<float>> y(shape.outputs, std::vector<float>(checkLen));
+            const float* xp[FFTCONVOLVER_MAX_CHANNELS];
+            float* yp[FFTCONVOLVER_MAX_CHANNELS];
+            for (unsigned int off = 0; off < checkLen; off += blockSize)
+            {
+                for (unsigned int i = 0; i < shape.inputs; i++)
+                    xp[i] = x[i].data() + off;
+                for (unsigned int o = 0; o < shape.outputs; o++)
+                    yp[o] = y[o].data() + off;
+                MultiStageFFTConvolverNxMProcess(conv, xp, yp, checkLen - off < blockSize ? checkLen - off : blockSize);
+            }
+            double maxDiff = 0.0;
+            for (unsigned int o = 0; o < shape.outputs; o++)
+                for (unsigned int t = 0; t < checkLen; t++)
+                    maxDiff = std::fmax(maxDiff, std::fabs((double)y[o][t] - ref[o][t]));
+
+            // Timed on the first block of the same input, the convolver keeps running from where the check stopped
+            for (unsigned int i = 0; i < shape.inputs; i++)
+                xp[i] = x[i].data();
+            for (unsigned int o = 0; o < shape.outputs; o++)
+                yp[o] = y[o].data();
+            size_t blocks = (size_t)std::ceil(rate * seconds / (double)blockSize);
+            size_t a1 = allocCount.load();
+            auto start = std::chrono::steady_clock::now();
+            for (size_t b = 0; b < blocks; b++)
+                MultiStageFFTConvolverNxMProcess(conv, xp, yp, blockSize);
+            auto end = std::chrono::steady_clock::now();
+            size_t processAllocations = allocCount.load() - a1;
+
+            double elapsedNs = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+            double samples = (double)(blocks * blockSize);
+            double nsPerSample = elapsedNs / samples;
+            double realtimeFactor = (samples / rate) / (elapsedNs * 1e-9);
+            size_t stateBytes = MultiStageFFTConvolverNxMMemoryUsage(conv);
+            fprintf(stderr, "matrix %ux%u %-10s %8.2f ns/sample, %8.1fx real-time, max error %g (peak %g)\n",
+                    shape.inputs, shape.outputs, name, nsPerSample, realtimeFactor, maxDiff, peak);
+
+            printf("%s\n    { \"inputs\": %u, \"outputs\": %u, \"layout\": \"%s\", \"irLength\": %u, \"blockSize\": %u, "
+                   "\"nsPerSample\": %.3f, \"realtimeFactor\": %.2f, \"maxAbsError\": %g, \"referencePeak\": %g, "
+                   "\"processAllocations\": %zu, \"stateBytes\": %zu }",
+                   first ? "" : ",", shape.inputs, shape.outputs, name, irLen, blockSize,
+                   nsPerSample, realtimeFactor, maxDiff, peak, processAllocations, stateBytes);
+            fflush(stdout);
+            first = false;
+
+            MultiStageFFTConvolverNxMFree(conv);
+            free(conv);
+        }
+    }
+    printf("\n  ]\n}\n");
+}
+
+static void usage(const char* self)
+{
+    fprintf(stderr, "Usage: %s [-q] [-d seconds] [-c case[,case...]] [-f] [-m]\n"
+                    "  -q          quick mode (subset of block sizes and sample rates)\n"
+                    "  -d seconds  amount of audio processed per measurement (default: 1.0)\n"
+                    "  -c cases    comma separated list of cases to run (default: all)\n"
+                    "  -l          list available cases and exit\n"
+                    "  -f          time the real FFT kernel sets per transform size instead\n"
+                    "  -m          check and time the N x M matrix convolver against a direct convolution instead\n", self);
+}
+
+int main(int argc, char** argv)
+{
+    bool quick = false;
+    bool fft = false;
+    bool matrix = false;
+    double seconds = 1.0;
+    std::string filter;
+
+    auto cases = buildCases();
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "-q"))
+            quick = true;
+        else if (!strcmp(argv[i], "-d") && i + 1 < argc)
+            seconds = atof(argv[++i]);
+        else if (!strcmp(argv[i], "-c") && i + 1 < argc)
+            filter = std::string(",") + argv[++i] + ",";
+        else if (!strcmp(argv[i], "-f"))
+            fft = true;
+        else if (!strcmp(argv[i], "-m"))
+            matrix = true;
+        else if (!strcmp(argv[i], "-l"))
+        {
+            for (const auto& bc : cases)
+                printf("%s\n", bc.name.c_str());
+            return 0;
+        }
+        else
+        {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (fft)
+    {
+        runFFT(seconds);
+        return 0;
+    }
+
+    if (matrix)
+    {
+        JamesDSPGlobalMemoryAllocation();
+        runMatrix(seconds);
+        JamesDSPGlobalMemoryDeallocation();
+        return 0;
+    }
+
+    std::vector<size_t> blockSizes;
+    std::vector<float> rates;
+    if (quick)
+    {
+        blockSizes = { 64, 512, 4096 };
+        rates = { 48000.0f, 96000.0f };
+    }
+    else
+    {
+        for (size_t n = 32; n <= 8192; n <<= 1)
+            blockSizes.push_back(n);
+        rates = { 44100.0f, 48000.0f, 88200.0f, 96000.0f, 176400.0f, 192000.0f };
+    }
+
+    // Use the built-in cost model so the convolvers are refreshed on block size changes
+    double c0[MAX_BENCHMARK], c1[MAX_BENCHMARK];
+    JamesDSP_Save_benchmark(c0, c1);
+    JamesDSP_Load_benchmark(c0, c1);
+    JamesDSPGlobalMemoryAllocation();
+
+    printf("{\n  \"secondsPerRun\": %g,\n  \"results\": [", seconds);
+    bool first = true;
+    for (const auto& bc : cases)
+    {
+        if (!filter.empty() && filter.find("," + bc.name + ",") == std::string::npos)
+            continue;
+
+        for (float rate : rates)
+        {
+            for (size_t n : blockSizes)
+            {
+                fprintf(stderr, "%-20s %6.0f Hz %5zu ...", bc.name.c_str(), rate, n);
+                BenchResult r = runCase(bc, rate, n, seconds);
+                fprintf(stderr, " %8.2f ns/sample, %8.1fx real-time\n", r.nsPerSample, r.realtimeFactor);
+
+                printf("%s\n    { \"case\": \"%s\", \"sampleRate\": %.0f, \"blockSize\": %zu, "
+                       "\"nsPerSample\": %.3f, \"realtimeFactor\": %.2f, "
+                       "\"setupAllocations\": %zu, \"setupBytes\": %zu, "
+                       "\"processAllocations\": %zu, \"processBytes\": %zu, \"stateBytes\": %zu, "
+                       "\"missedDeadlines\": %llu, \"spinResolved\": %llu }",
+                       first ? "" : ",", bc.name.c_str(), rate, n,
+                       r.nsPerSample, r.realtimeFactor,
+                       r.setupAllocations, r.setupBytes,
+                       r.processAllocations, r.processBytes, r.stateBytes,
+                       r.missedDeadlines, r.spinResolved);
+                fflush(stdout);
+                first = false;
+            }
+        }
+    }
+    printf("\n  ]\n}\n");
+
+    JamesDSPGlobalMemoryDeallocation();
+    return 0;
+}
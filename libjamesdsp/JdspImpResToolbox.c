@@ -364,10 +364,9 @@ float* loadAudioFile(const char *filename, double targetFs, unsigned int *channe
     return pSampleData;
 }
 
-float* ReadImpulseResponseToFloat
+static float* PreprocessImpulseResponse
 (const char* mIRFileName, int targetSampleRate, int* jImpInfo, int convMode, int* javaAdvSetPtr)
 {
-    if (strlen(mIRFileName) <= 0) return 0;
     unsigned int channels;
     drwav_uint64 frameCount;
     float *pFrameBuffer = loadAudioFile(mIRFileName, targetSampleRate, &channels, &frameCount, 1);
@@ -483,6 +482,45 @@ float* ReadImpulseResponseToFloat
     return pFrameBuffer;
 }
 
+// Decoding, resampling and minimum phase conversion are cached by file content and settings
+float* ReadImpulseResponseToFloat
+(const char* mIRFileName, int targetSampleRate, int* jImpInfo, int convMode, int* javaAdvSetPtr)
+{
+    if (strlen(mIRFileName) <= 0) return 0;
+    IRCacheKey key;
+    int32_t settings[8] = { targetSampleRate, convMode };
+    memcpy(settings + 2, javaAdvSetPtr, 6 * sizeof(int32_t));
+    IRCacheKeyInit(&key, "impulse-response-1");
+    IRCacheKeyUpdate(&key, settings, sizeof(settings));
+    int keyed = IRCacheKeyUpdateFile(&key, mIRFileName);
+    IRCacheEntry entry;
+    if (keyed && IRCacheOpen(&key, &entry))
+    {
+        uint32_t shape[2];
+        memcpy(shape, entry.data, sizeof(shape));
+        size_t bytes = (size_t)shape[0] * shape[1] * sizeof(float);
+        float *ir = 0;
+        if (entry.bytes == sizeof(shape) + bytes && (ir = (float*)malloc(bytes)))
+        {
+            memcpy(ir, (const char*)entry.data + sizeof(shape), bytes);
+            jImpInfo[0] = (int)shape[0];
+            jImpInfo[1] = (int)shape[1];
+        }
+        IRCacheClose(&entry);
+        if (ir)
+            return ir;
+    }
+    float *ir = PreprocessImpulseResponse(mIRFileName, targetSampleRate, jImpInfo, convMode, javaAdvSetPtr);
+    IRCacheWriter w;
+    if (ir && keyed && IRCacheWriterOpen(&w, &key))
+    {
+        uint32_t shape[2] = { (uint32_t)jImpInfo[0], (uint32_t)jImpInfo[1] };
+        int ok = IRCacheWrite(&w, shape, sizeof(shape)) && IRCacheWrite(&w, ir, (size_t)shape[0] * shape[1] * sizeof(float));
+        IRCacheWriterClose(&w, ok);
+    }
+    return ir;
+}
+
 /*JNIEXPORT jstring JNICALL Java_james_dsp_activity_JdspImpResToolbox_OfflineAudioResample
 (JNIEnv *env, jobject obj, jstring path, jstring filename, jint targetSampleRate)
 {
@@ -47,12 +47,18 @@ HEADERS += \
     $$BASEPATH/Effects/eel2/numericSys/libsamplerate/samplerate.h \
     $$BASEPATH/Effects/eel2/numericSys/quadprog.h \
     $$BASEPATH/Effects/eel2/numericSys/solvopt.h \
+    $$BASEPATH/Effects/eel2/numericSys/spectralMAC.h \
+    $$BASEPATH/Effects/eel2/numericSys/realFFT.h \
     $$BASEPATH/Effects/eel2/s_str.h \
     $$BASEPATH/Effects/eel2/stb_sprintf.h \
     $$BASEPATH/generalDSP/ArbFIRGen.h \
+    $$BASEPATH/generalDSP/MultiStageFFTConvolver.h \
+    $$BASEPATH/generalDSP/ConvolverWorkerPool.h \
+    $$BASEPATH/generalDSP/IRCache.h \
     $$BASEPATH/generalDSP/TwoStageFFTConvolver.h \
     $$BASEPATH/generalDSP/digitalFilters.h \
     $$BASEPATH/generalDSP/interpolation.h \
+    $$BASEPATH/generalDSP/sampleConv.h \
     $$BASEPATH/generalDSP/spectralInterpolatorFloat.h \
     $$BASEPATH/jdsp_header.h \
     EELStdOutExtension.h \
@@ -105,6 +111,8 @@ SOURCES += \
     $$BASEPATH/Effects/eel2/numericSys/libsamplerate/src_linear.c \
     $$BASEPATH/Effects/eel2/numericSys/quadprog.c \
     $$BASEPATH/Effects/eel2/numericSys/solvopt.c \
+    $$BASEPATH/Effects/eel2/numericSys/spectralMAC.c \
+    $$BASEPATH/Effects/eel2/numericSys/realFFT.c \
     $$BASEPATH/Effects/eel2/s_str.c \
     $$BASEPATH/Effects/eel2/y.tab.c \
     $$BASEPATH/Effects/liveprogWrapper.c \
@@ -114,10 +122,14 @@ SOURCES += \
     $$BASEPATH/Effects/vdc.c \
     $$BASEPATH/binaryBlobs.c \
     $$BASEPATH/generalDSP/ArbFIRGen.c \
+    $$BASEPATH/generalDSP/MultiStageFFTConvolver.c \
+    $$BASEPATH/generalDSP/ConvolverWorkerPool.c \
+    $$BASEPATH/generalDSP/IRCache.c \
     $$BASEPATH/generalDSP/TwoStageFFTConvolver.c \
     $$BASEPATH/generalDSP/digitalFilters.c \
     $$BASEPATH/generalDSP/generalProg.c \
     $$BASEPATH/generalDSP/interpolation.c \
+    $$BASEPATH/generalDSP/sampleConv.c \
     $$BASEPATH/generalDSP/spectralInterpolatorFloat.c \
     $$BASEPATH/jdspController.c \
     EELStdOutExtension.c \
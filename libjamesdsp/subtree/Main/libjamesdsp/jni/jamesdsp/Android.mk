@@ -9,9 +9,15 @@ LOCAL_SRC_FILES := \
 	jdsp/Effects/eel2/numericSys/codelet.c \
 	jdsp/generalDSP/digitalFilters.c \
 	jdsp/Effects/eel2/numericSys/FFTConvolver.c \
+	jdsp/Effects/eel2/numericSys/spectralMAC.c \
+	jdsp/Effects/eel2/numericSys/realFFT.c \
 	jdsp/generalDSP/TwoStageFFTConvolver.c \
+	jdsp/generalDSP/MultiStageFFTConvolver.c \
+	jdsp/generalDSP/ConvolverWorkerPool.c \
+	jdsp/generalDSP/IRCache.c \
 	jdsp/generalDSP/interpolation.c \
 	jdsp/generalDSP/generalProg.c \
+	jdsp/generalDSP/sampleConv.c \
 	jdsp/Effects/vdc.c \
 	jdsp/Effects/vacuumTube.c \
 	jdsp/Effects/stereoEnhancement.c \
@@ -4,51 +4,93 @@
 #include <math.h>
 #include <float.h>
 #include "../jdsp_header.h"
+typedef struct
+{
+	JParamSnapshot hdr;
+	FFTConvolver2x2 conv;
+} ArbEqSnapshot;
 void ArbitraryResponseEqualizerConstructor(JamesDSPLib *jdsp)
 {
 	jdsp->arbMag.instance.filterLen = InitArbitraryEq(&jdsp->arbMag.instance.coeffGen, 0);
-	FFTConvolver2x2Init(&jdsp->arbMag.instance.convState);
 	FFTConvolver2x2Init(&jdsp->arbMag.conv);
 	float *kDelta = (float*)malloc(jdsp->arbMag.instance.filterLen * sizeof(float));
 	memset(kDelta, 0, jdsp->arbMag.instance.filterLen * sizeof(float));
 	kDelta[0] = 1.0f;
-	FFTConvolver2x2LoadImpulseResponse(&jdsp->arbMag.instance.convState, (unsigned int)jdsp->blockSize, kDelta, kDelta, jdsp->arbMag.instance.filterLen);
 	FFTConvolver2x2LoadImpulseResponse(&jdsp->arbMag.conv, (unsigned int)jdsp->blockSize, kDelta, kDelta, jdsp->arbMag.instance.filterLen);
 	free(kDelta);
 }
 void ArbitraryResponseEqualizerDestructor(JamesDSPLib *jdsp)
 {
 	EqNodesFree(&jdsp->arbMag.instance.coeffGen);
-	FFTConvolver2x2Free(&jdsp->arbMag.instance.convState);
+	ArbitraryEqReleaseWork(&jdsp->arbMag.instance.coeffGen);
 	FFTConvolver2x2Free(&jdsp->arbMag.conv);
 }
+static void ArbEqSnapshotApply(JamesDSPLib *jdsp, JParamSnapshot *snap)
+{
+	FFTConvolver2x2 *old = &((ArbEqSnapshot *)snap)->conv;
+	if (!FFTConvolver2x2ExchangeImpulseResponse(&jdsp->arbMag.conv, old) && jdsp->arbitraryMagEnabled && old->_segCount)
+		JamesDSPDrainStart(jdsp, &jdsp->arbMagDrain, JDSP_PARAM_ARBEQ, snap, old->_segCount * old->_blockSize);
+}
+static void ArbEqSnapshotDestroy(JParamSnapshot *snap)
+{
+	FFTConvolver2x2Free(&((ArbEqSnapshot *)snap)->conv);
+}
+// Returns 0 and keeps the previous filter when memory runs out
+static int ArbitraryResponseEqualizerCommit(JamesDSPLib *jdsp)
+{
+	float *eqFil = jdsp->arbMag.instance.coeffGen.GetFilter(&jdsp->arbMag.instance.coeffGen, (float)jdsp->fs);
+	jdsp->arbMag.instance.lastDesign = crossPlatformCurTime();
+	if (!eqFil)
+		return 1;
+	ArbEqSnapshot *as = (ArbEqSnapshot *)malloc(sizeof(ArbEqSnapshot));
+	if (!as)
+		return 0;
+	as->hdr.apply = ArbEqSnapshotApply;
+	as->hdr.destroy = ArbEqSnapshotDestroy;
+	FFTConvolver2x2Init(&as->conv);
+	FFTConvolver2x2LoadImpulseResponse(&as->conv, JamesDSPBlockSize(jdsp), eqFil, eqFil, jdsp->arbMag.instance.filterLen);
+	JamesDSPCommitParam(jdsp, JDSP_PARAM_ARBEQ, &as->hdr);
+	Convolver1DFuseKernel(jdsp, JDSP_FUSED_ARBEQ, eqFil, jdsp->arbMag.instance.filterLen);
+	return 1;
+}
 void ArbitraryResponseEqualizerStringParser(JamesDSPLib *jdsp, char *stringEq)
 {
+	jdsp_lock(jdsp);
 	ArbitraryEqString2SortedNodes(&jdsp->arbMag.instance.coeffGen, stringEq);
-	float *eqFil = jdsp->arbMag.instance.coeffGen.GetFilter(&jdsp->arbMag.instance.coeffGen, (float)jdsp->fs);
-	FFTConvolver2x2RefreshImpulseResponse(&jdsp->arbMag.instance.convState, &jdsp->arbMag.conv, eqFil, eqFil, jdsp->arbMag.instance.filterLen);
+	ArbitraryResponseEqualizerCommit(jdsp);
+	jdsp_unlock(jdsp);
 }
 void ArbitraryResponseEqualizerEnable(JamesDSPLib *jdsp, char enable)
 {
-	if (jdsp->arbMagForceRefresh)
-	{
-		float *eqFil = jdsp->arbMag.instance.coeffGen.GetFilter(&jdsp->arbMag.instance.coeffGen, (float)jdsp->fs);
-		jdsp_lock(jdsp);
-		FFTConvolver2x2Free(&jdsp->arbMag.instance.convState);
-		FFTConvolver2x2Free(&jdsp->arbMag.conv);
-		FFTConvolver2x2LoadImpulseResponse(&jdsp->arbMag.instance.convState, (unsigned int)jdsp->blockSize, eqFil, eqFil, jdsp->arbMag.instance.filterLen);
-		FFTConvolver2x2LoadImpulseResponse(&jdsp->arbMag.conv, (unsigned int)jdsp->blockSize, eqFil, eqFil, jdsp->arbMag.instance.filterLen);
-		jdsp_unlock(jdsp);
+	jdsp_lock(jdsp);
+	if (jdsp->arbMagForceRefresh && ArbitraryResponseEqualizerCommit(jdsp))
 		jdsp->arbMagForceRefresh = 0;
-	}
+	jdsp_unlock(jdsp);
 	if (enable)
 		jdsp->arbitraryMagEnabled = 1;
+	Convolver1DFuseRefresh(jdsp);
 }
 void ArbitraryResponseEqualizerDisable(JamesDSPLib *jdsp)
 {
 	jdsp->arbitraryMagEnabled = 0;
+	Convolver1DFuseRefresh(jdsp);
+}
+void ArbitraryResponseEqualizerReleaseIdle(JamesDSPLib *jdsp, double now)
+{
+	if (now - jdsp->arbMag.instance.lastDesign >= jdsp->idleRelease)
+		ArbitraryEqReleaseWork(&jdsp->arbMag.instance.coeffGen);
+}
+size_t ArbitraryResponseEqualizerMemoryUsage(JamesDSPLib *jdsp)
+{
+	return sizeof(jdsp->arbMag) + ArbitraryEqWorkBytes(&jdsp->arbMag.instance.coeffGen) + FFTConvolver2x2MemoryUsage(&jdsp->arbMag.conv);
 }
 void ArbitraryResponseEqualizerProcess(JamesDSPLib *jdsp, size_t n)
 {
+	if (jdsp->arbMagDrain.remaining)
+	{
+		float **y = JamesDSPDrainBuffer(jdsp, n);
+		FFTConvolver2x2Process(&((ArbEqSnapshot *)jdsp->arbMagDrain.snap)->conv, y[0], y[1], y[0], y[1], (unsigned int)n);
+	}
 	FFTConvolver2x2Process(&jdsp->arbMag.conv, jdsp->tmpBuffer[0], jdsp->tmpBuffer[1], jdsp->tmpBuffer[0], jdsp->tmpBuffer[1], (unsigned int)n);
+	JamesDSPDrainFinish(jdsp, &jdsp->arbMagDrain, n);
 }
\ No newline at end of file
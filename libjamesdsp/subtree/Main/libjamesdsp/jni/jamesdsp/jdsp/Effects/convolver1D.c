@@ -4,42 +4,153 @@
 #include <math.h>
 #include <float.h>
 #include "../jdsp_header.h"
+typedef struct
+{
+	JParamSnapshot hdr;
+	Convolver1D conv;
+	unsigned int drainLen; // Nonzero for a repartitioning of the IR already playing
+	unsigned int fadeLen; // Nonzero for a new IR, crossfaded against the one playing
+	int fused; // JDSP_FUSED_* stages folded into the IR
+	int idle; // Outgoing instance was not running, it fades out as a pass through
+} Convolver1DSnapshot;
 void Convolver1DEnable(JamesDSPLib *jdsp)
 {
-	if (jdsp->conv.process)
+	if (jdsp->conv.process || JamesDSPParamPending(jdsp, JDSP_PARAM_CONVOLVER))
+	{
 		jdsp->convolverEnabled = 1;
+		Convolver1DFuseRefresh(jdsp);
+	}
 }
 void Convolver1DDisable(JamesDSPLib *jdsp)
 {
 	jdsp->convolverEnabled = 0;
+	Convolver1DFuseRefresh(jdsp);
 }
 void Convolver1DConstructor(JamesDSPLib *jdsp)
 {
 	memset(&jdsp->conv, 0, sizeof(jdsp->conv));
+	jdsp->convCrossfadeMs = 50.0f;
 }
-void Convolver1DDestructor(JamesDSPLib *jdsp)
+// Convolvers and the stored IR run off mapped cache entries shared with every instance and process using the same IR
+void Convolver1DSetSharedSpectra(JamesDSPLib *jdsp, int enable)
 {
-	if (jdsp->conv.conv1d2x2_S_S)
+	jdsp_lock(jdsp);
+	jdsp->convShareSpectra = enable;
+	jdsp_unlock(jdsp);
+}
+// Length of the crossfade between the playing and a newly loaded IR, 0 switches at the next block
+void Convolver1DSetCrossfade(JamesDSPLib *jdsp, float ms)
+{
+	jdsp_lock(jdsp);
+	jdsp->convCrossfadeMs = ms > 0.0f ? ms : 0.0f;
+	jdsp_unlock(jdsp);
+}
+// Partitions at least -thresholdDb quieter than the loudest one are skipped, 0 disables it, reloads the playing IR
+void Convolver1DSetPartitionSkip(JamesDSPLib *jdsp, float thresholdDb)
+{
+	jdsp_lock(jdsp);
+	thresholdDb = thresholdDb < 0.0f ? thresholdDb : 0.0f;
+	if (jdsp->convSkipThresholdDb != thresholdDb)
+	{
+		jdsp->convSkipThresholdDb = thresholdDb;
+		if (jdsp->impulseResponseStorage.impulseResponse)
+			Convolver1DLoadImpulseResponse(jdsp, jdsp->impulseResponseStorage.impulseResponse, jdsp->impulseResponseStorage.impChannels, jdsp->impulseResponseStorage.impulseLengthActual, 0);
+	}
+	jdsp_unlock(jdsp);
+}
+void Convolver1DGetPartitionSkipStats(JamesDSPLib *jdsp, FFTConvolverSkipStats *stats)
+{
+	jdsp_lock(jdsp);
+	*stats = jdsp->convSkipStats;
+	jdsp_unlock(jdsp);
+}
+static void Convolver1DFree(Convolver1D *conv)
+{
+	if (conv->conv1d2x2_S_S)
+	{
+		FFTConvolver2x2Free(conv->conv1d2x2_S_S);
+		free(conv->conv1d2x2_S_S);
+	}
+	if (conv->conv1d2x2_T_S)
 	{
-		FFTConvolver2x2Free(jdsp->conv.conv1d2x2_S_S);
-		free(jdsp->conv.conv1d2x2_S_S);
+		TwoStageFFTConvolver2x2Free(conv->conv1d2x2_T_S);
+		free(conv->conv1d2x2_T_S);
 	}
-	if (jdsp->conv.conv1d2x2_T_S)
+	if (conv->conv1d2x4x2_S_S)
 	{
-		TwoStageFFTConvolver2x2Free(jdsp->conv.conv1d2x2_T_S);
-		free(jdsp->conv.conv1d2x2_T_S);
+		FFTConvolver2x4x2Free(conv->conv1d2x4x2_S_S);
+		free(conv->conv1d2x4x2_S_S);
 	}
-	if (jdsp->conv.conv1d2x4x2_S_S)
+	if (conv->conv1d2x4x2_T_S)
 	{
-		FFTConvolver2x4x2Free(jdsp->conv.conv1d2x4x2_S_S);
-		free(jdsp->conv.conv1d2x4x2_S_S);
+		TwoStageFFTConvolver2x4x2Free(conv->conv1d2x4x2_T_S);
+		free(conv->conv1d2x4x2_T_S);
 	}
-	if (jdsp->conv.conv1d2x4x2_T_S)
+	if (conv->conv1d2x2_M_S)
 	{
-		TwoStageFFTConvolver2x4x2Free(jdsp->conv.conv1d2x4x2_T_S);
-		free(jdsp->conv.conv1d2x4x2_T_S);
+		MultiStageFFTConvolver2x2Free(conv->conv1d2x2_M_S);
+		free(conv->conv1d2x2_M_S);
+	}
+	if (conv->conv1d2x4x2_M_S)
+	{
+		MultiStageFFTConvolver2x4x2Free(conv->conv1d2x4x2_M_S);
+		free(conv->conv1d2x4x2_M_S);
+	}
+}
+void Convolver1DReleaseStorage(tmpIRData *ir)
+{
+	if (ir->shared)
+		IRCacheMappingRelease(ir->shared);
+	else if (ir->impulseResponse)
+		free(ir->impulseResponse);
+	ir->impulseResponse = 0;
+	ir->shared = 0;
+}
+void Convolver1DDestructor(JamesDSPLib *jdsp)
+{
+	Convolver1DFree(&jdsp->conv);
+	for (int i = 0; i < 2; i++)
+		free(jdsp->convFusedKernel[i]);
+}
+// Stages leaving the IR run on their own again, from silence rather than the history of before they joined
+static void Convolver1DResetStages(JamesDSPLib *jdsp, int stages)
+{
+	if (stages & JDSP_FUSED_EQUALIZER)
+	{
+		FFTConvolver2x2Reset(&jdsp->mEQ.conv);
+		jdsp->eqDrain.remaining = 0;
+	}
+	if (stages & JDSP_FUSED_ARBEQ)
+	{
+		FFTConvolver2x2Reset(&jdsp->arbMag.conv);
+		jdsp->arbMagDrain.remaining = 0;
 	}
 }
+static void Convolver1DSnapshotApply(JamesDSPLib *jdsp, JParamSnapshot *snap)
+{
+	Convolver1DSnapshot *cs = (Convolver1DSnapshot *)snap;
+	Convolver1D live = jdsp->conv;
+	const int playing = live.process && (jdsp->convolverEnabled || jdsp->convFused);
+	const int fused = jdsp->convFused;
+	jdsp->conv = cs->conv;
+	cs->conv = live;
+	cs->idle = !playing;
+	Convolver1DResetStages(jdsp, fused & ~cs->fused);
+	jdsp->convFused = jdsp->convFusedOut = cs->fused;
+	if (cs->drainLen && playing)
+		JamesDSPDrainStart(jdsp, &jdsp->convDrain, JDSP_PARAM_CONVOLVER, snap, cs->drainLen);
+	else if (cs->fadeLen && (playing || (fused != cs->fused && !(cs->fused & JDSP_FUSED_CONVOLVER))))
+	{
+		// Stages moving in or out of the IR keep running on the input of the outgoing instance until it is gone,
+		// an idle one passes it through. A convolver starting to play cuts in as it does unfused.
+		JamesDSPCrossfadeStart(jdsp, &jdsp->convDrain, JDSP_PARAM_CONVOLVER, snap, cs->fadeLen);
+		jdsp->convFusedOut = fused;
+	}
+}
+static void Convolver1DSnapshotDestroy(JParamSnapshot *snap)
+{
+	Convolver1DFree(&((Convolver1DSnapshot *)snap)->conv);
+}
 void Convolver1DProcessFFTConvolver2x2(JamesDSPLib *jdsp, size_t n)
 {
 	FFTConvolver2x2Process(jdsp->conv.conv1d2x2_S_S, jdsp->tmpBuffer[0], jdsp->tmpBuffer[1], jdsp->tmpBuffer[0], jdsp->tmpBuffer[1], (unsigned int)n);
@@ -56,167 +167,527 @@ void Convolver1DProcessTwoStageFFTConvolver2x4x2(JamesDSPLib *jdsp, size_t n)
 {
 	TwoStageFFTConvolver2x4x2Process(jdsp->conv.conv1d2x4x2_T_S, jdsp->tmpBuffer[0], jdsp->tmpBuffer[1], jdsp->tmpBuffer[0], jdsp->tmpBuffer[1], (unsigned int)n);
 }
-int Convolver1DLoadImpulseResponse(JamesDSPLib *jdsp, float *tempImpulseFloat, unsigned int impChannels, size_t impulseLengthActual, char updateOld)
+void Convolver1DProcessMultiStageFFTConvolver2x2(JamesDSPLib *jdsp, size_t n)
 {
-	jdsp_lock(jdsp);
-	Convolver1DDestructor(jdsp);
-	if (updateOld)
-	{
-		if (jdsp->impulseResponseStorage.impulseResponse)
-			free(jdsp->impulseResponseStorage.impulseResponse);
-		jdsp->impulseResponseStorage.impulseResponse = (float *)malloc(impChannels * impulseLengthActual * sizeof(float));
-		memcpy(jdsp->impulseResponseStorage.impulseResponse, tempImpulseFloat, impChannels * impulseLengthActual * sizeof(float));
-		jdsp->impulseResponseStorage.impChannels = impChannels;
-		jdsp->impulseResponseStorage.impulseLengthActual = impulseLengthActual;
-	}
-	Convolver1DConstructor(jdsp);
-	float **finalImpulse = (float**)malloc(impChannels * sizeof(float*));
-	memset(finalImpulse, 0, impChannels * sizeof(float*));
-	int ret = 1;
-	if (!finalImpulse)
-	{
-		ret = 0;
-		goto bufDeleteAndUnlock;
-	}
-	for (unsigned int i = 0; i < impChannels; i++)
+	MultiStageFFTConvolver2x2Process(jdsp->conv.conv1d2x2_M_S, jdsp->tmpBuffer[0], jdsp->tmpBuffer[1], jdsp->tmpBuffer[0], jdsp->tmpBuffer[1], (unsigned int)n);
+}
+void Convolver1DProcessMultiStageFFTConvolver2x4x2(JamesDSPLib *jdsp, size_t n)
+{
+	MultiStageFFTConvolver2x4x2Process(jdsp->conv.conv1d2x4x2_M_S, jdsp->tmpBuffer[0], jdsp->tmpBuffer[1], jdsp->tmpBuffer[0], jdsp->tmpBuffer[1], (unsigned int)n);
+}
+// Runs whichever convolver the instance holds, in place
+static void Convolver1DRun(Convolver1D *conv, float *x1, float *x2, size_t n)
+{
+	if (conv->conv1d2x2_S_S)
+		FFTConvolver2x2Process(conv->conv1d2x2_S_S, x1, x2, x1, x2, (unsigned int)n);
+	else if (conv->conv1d2x2_T_S)
+		TwoStageFFTConvolver2x2Process(conv->conv1d2x2_T_S, x1, x2, x1, x2, (unsigned int)n);
+	else if (conv->conv1d2x4x2_S_S)
+		FFTConvolver2x4x2Process(conv->conv1d2x4x2_S_S, x1, x2, x1, x2, (unsigned int)n);
+	else if (conv->conv1d2x4x2_T_S)
+		TwoStageFFTConvolver2x4x2Process(conv->conv1d2x4x2_T_S, x1, x2, x1, x2, (unsigned int)n);
+	else if (conv->conv1d2x2_M_S)
+		MultiStageFFTConvolver2x2Process(conv->conv1d2x2_M_S, x1, x2, x1, x2, (unsigned int)n);
+	else if (conv->conv1d2x4x2_M_S)
+		MultiStageFFTConvolver2x4x2Process(conv->conv1d2x4x2_M_S, x1, x2, x1, x2, (unsigned int)n);
+}
+// FIR stages an instance expects ahead of it but the chain skipped
+static void Convolver1DRunStages(JamesDSPLib *jdsp, int stages, size_t n)
+{
+	if (stages & JDSP_FUSED_EQUALIZER)
+		MultimodalEqualizerProcess(jdsp, n);
+	if (stages & JDSP_FUSED_ARBEQ)
+		ArbitraryResponseEqualizerProcess(jdsp, n);
+}
+void Convolver1DProcess(JamesDSPLib *jdsp, size_t n)
+{
+	if (jdsp->convDrain.remaining)
 	{
-		float* channelbuf = (float*)malloc(impulseLengthActual * sizeof(float));
-		if (!channelbuf)
+		Convolver1DSnapshot *out = (Convolver1DSnapshot *)jdsp->convDrain.snap;
+		float **y;
+		if (!jdsp->convDrain.fadeLen)
+			y = JamesDSPDrainBuffer(jdsp, n);
+		else
 		{
-			ret = 0;
-			goto bufDeleteAndUnlock;
+			// Fused sets differ while a stage joins or leaves the IR, each instance gets the input its IR was built for
+			const int skipped = jdsp->convFused | jdsp->convFusedOut;
+			const int enabled = (jdsp->equalizerEnabled ? JDSP_FUSED_EQUALIZER : 0) | (jdsp->arbitraryMagEnabled ? JDSP_FUSED_ARBEQ : 0);
+			const int liveStages = enabled & skipped & ~jdsp->convFused;
+			const int outStages = enabled & skipped & ~jdsp->convFusedOut;
+			if (!(liveStages | outStages))
+				y = JamesDSPCrossfadeBuffer(jdsp, n);
+			else
+			{
+				// The stages use tmpBuffer[6..7] for their own tails, the outgoing input waits in tmpBuffer[8..9]
+				memcpy(jdsp->tmpBuffer[8], jdsp->tmpBuffer[0], n * sizeof(float));
+				memcpy(jdsp->tmpBuffer[9], jdsp->tmpBuffer[1], n * sizeof(float));
+				Convolver1DRunStages(jdsp, liveStages, n);
+				float *x[2] = { jdsp->tmpBuffer[0], jdsp->tmpBuffer[1] };
+				jdsp->tmpBuffer[0] = jdsp->tmpBuffer[8];
+				jdsp->tmpBuffer[1] = jdsp->tmpBuffer[9];
+				Convolver1DRunStages(jdsp, outStages, n);
+				y = JamesDSPCrossfadeBuffer(jdsp, n);
+				jdsp->tmpBuffer[0] = x[0];
+				jdsp->tmpBuffer[1] = x[1];
+			}
 		}
-		float* p = tempImpulseFloat + i;
-		for (unsigned int j = 0; j < impulseLengthActual; j++)
-			channelbuf[j] = p[j * impChannels];
-		finalImpulse[i] = channelbuf;
+		if (!out->idle)
+			Convolver1DRun(&out->conv, y[0], y[1], n);
 	}
-	unsigned int seg2Len = 0;
-	if (selectConvPartitions(jdsp, impulseLengthActual, &seg2Len) == 1)
+	if ((jdsp->convolverEnabled || jdsp->convFused) && jdsp->conv.process)
+		jdsp->conv.process(jdsp, n);
+	JamesDSPDrainFinish(jdsp, &jdsp->convDrain, n);
+	if (!jdsp->convDrain.remaining)
+		jdsp->convFusedOut = jdsp->convFused;
+}
+// Builds the convolver matching the channel count and partitioning, hybrid puts a time domain head before the stages
+static int Convolver1DBuild(Convolver1D *conv, float **finalImpulse, unsigned int impChannels, size_t impulseLengthActual, unsigned int blockSize, const unsigned int *blockSizes, unsigned int stageCount, int hybrid)
+{
+	int ret = 1;
+	if (stageCount == 1 && !hybrid)
 	{
 		if (impChannels == 1)
 		{
-			jdsp->conv.conv1d2x2_S_S = (FFTConvolver2x2*)malloc(sizeof(FFTConvolver2x2));
-			if (!jdsp->conv.conv1d2x2_S_S)
+			conv->conv1d2x2_S_S = (FFTConvolver2x2*)malloc(sizeof(FFTConvolver2x2));
+			if (!conv->conv1d2x2_S_S)
 			{
 				ret = 0;
-				goto bufDeleteAndUnlock;
+				return ret;
 			}
-			FFTConvolver2x2Init(jdsp->conv.conv1d2x2_S_S);
-			ret = FFTConvolver2x2LoadImpulseResponse(jdsp->conv.conv1d2x2_S_S, (unsigned int)jdsp->blockSize, finalImpulse[0], finalImpulse[0], impulseLengthActual);
+			FFTConvolver2x2Init(conv->conv1d2x2_S_S);
+			ret = FFTConvolver2x2LoadImpulseResponse(conv->conv1d2x2_S_S, blockSize, finalImpulse[0], finalImpulse[0], impulseLengthActual);
 			if (!ret)
 			{
-				free(jdsp->conv.conv1d2x2_S_S);
-				jdsp->conv.conv1d2x2_S_S = 0;
-				goto bufDeleteAndUnlock;
+				free(conv->conv1d2x2_S_S);
+				conv->conv1d2x2_S_S = 0;
+				return ret;
 			}
-			jdsp->conv.process = Convolver1DProcessFFTConvolver2x2;
+			conv->process = Convolver1DProcessFFTConvolver2x2;
 		}
 		if (impChannels == 2)
 		{
-			jdsp->conv.conv1d2x2_S_S = (FFTConvolver2x2*)malloc(sizeof(FFTConvolver2x2));
-			if (!jdsp->conv.conv1d2x2_S_S)
+			conv->conv1d2x2_S_S = (FFTConvolver2x2*)malloc(sizeof(FFTConvolver2x2));
+			if (!conv->conv1d2x2_S_S)
 			{
 				ret = 0;
-				goto bufDeleteAndUnlock;
+				return ret;
 			}
-			FFTConvolver2x2Init(jdsp->conv.conv1d2x2_S_S);
-			ret = FFTConvolver2x2LoadImpulseResponse(jdsp->conv.conv1d2x2_S_S, (unsigned int)jdsp->blockSize, finalImpulse[0], finalImpulse[1], impulseLengthActual);
+			FFTConvolver2x2Init(conv->conv1d2x2_S_S);
+			ret = FFTConvolver2x2LoadImpulseResponse(conv->conv1d2x2_S_S, blockSize, finalImpulse[0], finalImpulse[1], impulseLengthActual);
 			if (!ret)
 			{
-				free(jdsp->conv.conv1d2x2_S_S);
-				jdsp->conv.conv1d2x2_S_S = 0;
-				goto bufDeleteAndUnlock;
+				free(conv->conv1d2x2_S_S);
+				conv->conv1d2x2_S_S = 0;
+				return ret;
 			}
-			jdsp->conv.process = Convolver1DProcessFFTConvolver2x2;
+			conv->process = Convolver1DProcessFFTConvolver2x2;
 		}
 		if (impChannels == 4)
 		{
-			jdsp->conv.conv1d2x4x2_S_S = (FFTConvolver2x4x2*)malloc(sizeof(FFTConvolver2x4x2));
-			if (!jdsp->conv.conv1d2x4x2_S_S)
+			conv->conv1d2x4x2_S_S = (FFTConvolver2x4x2*)malloc(sizeof(FFTConvolver2x4x2));
+			if (!conv->conv1d2x4x2_S_S)
 			{
 				ret = 0;
-				goto bufDeleteAndUnlock;
+				return ret;
 			}
-			FFTConvolver2x4x2Init(jdsp->conv.conv1d2x4x2_S_S);
-			ret = FFTConvolver2x4x2LoadImpulseResponse(jdsp->conv.conv1d2x4x2_S_S, (unsigned int)jdsp->blockSize, finalImpulse[0], finalImpulse[1], finalImpulse[2], finalImpulse[3], impulseLengthActual);
+			FFTConvolver2x4x2Init(conv->conv1d2x4x2_S_S);
+			ret = FFTConvolver2x4x2LoadImpulseResponse(conv->conv1d2x4x2_S_S, blockSize, finalImpulse[0], finalImpulse[1], finalImpulse[2], finalImpulse[3], impulseLengthActual);
 			if (!ret)
 			{
-				free(jdsp->conv.conv1d2x4x2_S_S);
-				jdsp->conv.conv1d2x4x2_S_S = 0;
-				goto bufDeleteAndUnlock;
+				free(conv->conv1d2x4x2_S_S);
+				conv->conv1d2x4x2_S_S = 0;
+				return ret;
 			}
-			jdsp->conv.process = Convolver1DProcessFFTConvolver2x4x2;
+			conv->process = Convolver1DProcessFFTConvolver2x4x2;
 		}
 	}
-	else
+	else if (stageCount == 2 && !hybrid)
 	{
-		if (seg2Len < 1)
-			seg2Len = 1;
+		unsigned int seg2Len = blockSizes[1];
 		if (impChannels == 1)
 		{
-			jdsp->conv.conv1d2x2_T_S = (TwoStageFFTConvolver2x2*)malloc(sizeof(TwoStageFFTConvolver2x2));
-			if (!jdsp->conv.conv1d2x2_T_S)
+			conv->conv1d2x2_T_S = (TwoStageFFTConvolver2x2*)malloc(sizeof(TwoStageFFTConvolver2x2));
+			if (!conv->conv1d2x2_T_S)
 			{
 				ret = 0;
-				goto bufDeleteAndUnlock;
+				return ret;
 			}
-			TwoStageFFTConvolver2x2Init(jdsp->conv.conv1d2x2_T_S);
-			ret = TwoStageFFTConvolver2x2LoadImpulseResponse(jdsp->conv.conv1d2x2_T_S, (unsigned int)jdsp->blockSize, seg2Len, finalImpulse[0], finalImpulse[0], impulseLengthActual);
+			TwoStageFFTConvolver2x2Init(conv->conv1d2x2_T_S);
+			ret = TwoStageFFTConvolver2x2LoadImpulseResponse(conv->conv1d2x2_T_S, blockSize, seg2Len, finalImpulse[0], finalImpulse[0], impulseLengthActual);
 			if (!ret)
 			{
-				free(jdsp->conv.conv1d2x2_T_S);
-				jdsp->conv.conv1d2x2_T_S = 0;
-				goto bufDeleteAndUnlock;
+				free(conv->conv1d2x2_T_S);
+				conv->conv1d2x2_T_S = 0;
+				return ret;
 			}
-			jdsp->conv.process = Convolver1DProcessTwoStageFFTConvolver2x2;
+			conv->process = Convolver1DProcessTwoStageFFTConvolver2x2;
 		}
 		if (impChannels == 2)
 		{
-			jdsp->conv.conv1d2x2_T_S = (TwoStageFFTConvolver2x2*)malloc(sizeof(TwoStageFFTConvolver2x2));
-			if (!jdsp->conv.conv1d2x2_T_S)
+			conv->conv1d2x2_T_S = (TwoStageFFTConvolver2x2*)malloc(sizeof(TwoStageFFTConvolver2x2));
+			if (!conv->conv1d2x2_T_S)
 			{
 				ret = 0;
-				goto bufDeleteAndUnlock;
+				return ret;
 			}
-			TwoStageFFTConvolver2x2Init(jdsp->conv.conv1d2x2_T_S);
-			ret = TwoStageFFTConvolver2x2LoadImpulseResponse(jdsp->conv.conv1d2x2_T_S, (unsigned int)jdsp->blockSize, seg2Len, finalImpulse[0], finalImpulse[1], impulseLengthActual);
+			TwoStageFFTConvolver2x2Init(conv->conv1d2x2_T_S);
+			ret = TwoStageFFTConvolver2x2LoadImpulseResponse(conv->conv1d2x2_T_S, blockSize, seg2Len, finalImpulse[0], finalImpulse[1], impulseLengthActual);
 			if (!ret)
 			{
-				free(jdsp->conv.conv1d2x2_T_S);
-				jdsp->conv.conv1d2x2_T_S = 0;
-				goto bufDeleteAndUnlock;
+				free(conv->conv1d2x2_T_S);
+				conv->conv1d2x2_T_S = 0;
+				return ret;
 			}
-			jdsp->conv.process = Convolver1DProcessTwoStageFFTConvolver2x2;
+			conv->process = Convolver1DProcessTwoStageFFTConvolver2x2;
 		}
 		if (impChannels == 4)
 		{
-			jdsp->conv.conv1d2x4x2_T_S = (TwoStageFFTConvolver2x4x2*)malloc(sizeof(TwoStageFFTConvolver2x4x2));
-			if (!jdsp->conv.conv1d2x4x2_T_S)
+			conv->conv1d2x4x2_T_S = (TwoStageFFTConvolver2x4x2*)malloc(sizeof(TwoStageFFTConvolver2x4x2));
+			if (!conv->conv1d2x4x2_T_S)
 			{
 				ret = 0;
-				goto bufDeleteAndUnlock;
+				return ret;
 			}
-			TwoStageFFTConvolver2x4x2Init(jdsp->conv.conv1d2x4x2_T_S);
-			ret = TwoStageFFTConvolver2x4x2LoadImpulseResponse(jdsp->conv.conv1d2x4x2_T_S, (unsigned int)jdsp->blockSize, seg2Len, finalImpulse[0], finalImpulse[1], finalImpulse[2], finalImpulse[3], impulseLengthActual);
+			TwoStageFFTConvolver2x4x2Init(conv->conv1d2x4x2_T_S);
+			ret = TwoStageFFTConvolver2x4x2LoadImpulseResponse(conv->conv1d2x4x2_T_S, blockSize, seg2Len, finalImpulse[0], finalImpulse[1], finalImpulse[2], finalImpulse[3], impulseLengthActual);
 			if (!ret)
 			{
-				free(jdsp->conv.conv1d2x4x2_T_S);
-				jdsp->conv.conv1d2x4x2_T_S = 0;
-				goto bufDeleteAndUnlock;
+				free(conv->conv1d2x4x2_T_S);
+				conv->conv1d2x4x2_T_S = 0;
+				return ret;
 			}
-			jdsp->conv.process = Convolver1DProcessTwoStageFFTConvolver2x4x2;
+			conv->process = Convolver1DProcessTwoStageFFTConvolver2x4x2;
 		}
 	}
-bufDeleteAndUnlock:
+	else
+	{
+		if (impChannels == 1 || impChannels == 2)
+		{
+			conv->conv1d2x2_M_S = (MultiStageFFTConvolver2x2*)malloc(sizeof(MultiStageFFTConvolver2x2));
+			if (!conv->conv1d2x2_M_S)
+			{
+				ret = 0;
+				return ret;
+			}
+			MultiStageFFTConvolver2x2Init(conv->conv1d2x2_M_S);
+			if (hybrid)
+				ret = MultiStageFFTConvolver2x2LoadImpulseResponseHybrid(conv->conv1d2x2_M_S, blockSizes, stageCount, finalImpulse[0], finalImpulse[impChannels - 1], (unsigned int)impulseLengthActual);
+			else
+				ret = MultiStageFFTConvolver2x2LoadImpulseResponse(conv->conv1d2x2_M_S, blockSizes, stageCount, finalImpulse[0], finalImpulse[impChannels - 1], (unsigned int)impulseLengthActual);
+			if (!ret)
+			{
+				free(conv->conv1d2x2_M_S);
+				conv->conv1d2x2_M_S = 0;
+				return ret;
+			}
+			conv->process = Convolver1DProcessMultiStageFFTConvolver2x2;
+		}
+		if (impChannels == 4)
+		{
+			conv->conv1d2x4x2_M_S = (MultiStageFFTConvolver2x4x2*)malloc(sizeof(MultiStageFFTConvolver2x4x2));
+			if (!conv->conv1d2x4x2_M_S)
+			{
+				ret = 0;
+				return ret;
+			}
+			MultiStageFFTConvolver2x4x2Init(conv->conv1d2x4x2_M_S);
+			if (hybrid)
+				ret = MultiStageFFTConvolver2x4x2LoadImpulseResponseHybrid(conv->conv1d2x4x2_M_S, blockSizes, stageCount, finalImpulse[0], finalImpulse[1], finalImpulse[2], finalImpulse[3], (unsigned int)impulseLengthActual);
+			else
+				ret = MultiStageFFTConvolver2x4x2LoadImpulseResponse(conv->conv1d2x4x2_M_S, blockSizes, stageCount, finalImpulse[0], finalImpulse[1], finalImpulse[2], finalImpulse[3], (unsigned int)impulseLengthActual);
+			if (!ret)
+			{
+				free(conv->conv1d2x4x2_M_S);
+				conv->conv1d2x4x2_M_S = 0;
+				return ret;
+			}
+			conv->process = Convolver1DProcessMultiStageFFTConvolver2x4x2;
+		}
+	}
+	return ret;
+}
+// Skips the partitions thresholdDb below the loudest one in whichever convolver the instance holds
+static void Convolver1DSkipPartitions(Convolver1D *conv, float thresholdDb, FFTConvolverSkipStats *stats)
+{
+	if (conv->conv1d2x2_S_S)
+		FFTConvolver2x2SkipPartitions(conv->conv1d2x2_S_S, FFTConvolver2x2PartitionPowerMax(conv->conv1d2x2_S_S) * pow(10.0, thresholdDb * 0.1), stats);
+	else if (conv->conv1d2x2_T_S)
+		TwoStageFFTConvolver2x2SkipPartitions(conv->conv1d2x2_T_S, thresholdDb, stats);
+	else if (conv->conv1d2x4x2_S_S)
+		FFTConvolver2x4x2SkipPartitions(conv->conv1d2x4x2_S_S, FFTConvolver2x4x2PartitionPowerMax(conv->conv1d2x4x2_S_S) * pow(10.0, thresholdDb * 0.1), stats);
+	else if (conv->conv1d2x4x2_T_S)
+		TwoStageFFTConvolver2x4x2SkipPartitions(conv->conv1d2x4x2_T_S, thresholdDb, stats);
+	else if (conv->conv1d2x2_M_S)
+		MultiStageFFTConvolver2x2SkipPartitions(conv->conv1d2x2_M_S, thresholdDb, stats);
+	else if (conv->conv1d2x4x2_M_S)
+		MultiStageFFTConvolver2x4x2SkipPartitions(conv->conv1d2x4x2_M_S, thresholdDb, stats);
+}
+// The FIR stages ahead of the convolver folded into its IR, none unless at least two of them are running
+static int Convolver1DFusedStages(JamesDSPLib *jdsp)
+{
+	if (!jdsp->convFusedLTI)
+		return 0;
+	int stages = 0, count = 0;
+	if (jdsp->equalizerEnabled && jdsp->convFusedKernel[0])
+	{
+		stages |= JDSP_FUSED_EQUALIZER;
+		count++;
+	}
+	if (jdsp->arbitraryMagEnabled && jdsp->convFusedKernel[1])
+	{
+		stages |= JDSP_FUSED_ARBEQ;
+		count++;
+	}
+	if (jdsp->convolverEnabled && jdsp->impulseResponseStorage.impulseResponse)
+	{
+		stages |= JDSP_FUSED_CONVOLVER;
+		count++;
+	}
+	return count > 1 ? stages : 0;
+}
+// y = x * kernel in place, y holds xLen samples followed by room for kernelLen - 1 more
+static int Convolver1DConvolveInPlace(float *y, size_t xLen, const float *kernel, unsigned int kernelLen)
+{
+	FFTConvolver1x1 conv;
+	FFTConvolver1x1Init(&conv);
+	if (!FFTConvolver1x1LoadImpulseResponse(&conv, 1024, kernel, kernelLen))
+		return 0;
+	memset(y + xLen, 0, (kernelLen - 1) * sizeof(float));
+	FFTConvolver1x1Process(&conv, y, y, (unsigned int)(xLen + kernelLen - 1));
+	FFTConvolver1x1Free(&conv);
+	return 1;
+}
+// Interleaved IR of the stored one, or a unit impulse, convolved with the kernels of the fused equalizers
+// The equalizers filter both channels alike, so they commute with every path of a true stereo IR
+static float *Convolver1DFusedImpulseResponse(JamesDSPLib *jdsp, int stages, unsigned int *impChannels, size_t *impulseLength)
+{
+	unsigned int channels = 1;
+	size_t len = 1, fusedLen = 1;
+	if (stages & JDSP_FUSED_CONVOLVER)
+	{
+		channels = jdsp->impulseResponseStorage.impChannels;
+		len = fusedLen = jdsp->impulseResponseStorage.impulseLengthActual;
+	}
+	for (int i = 0; i < 2; i++)
+		if (stages & (JDSP_FUSED_EQUALIZER << i))
+			fusedLen += jdsp->convFusedKernelLen[i] - 1;
+	float *ir = (float *)malloc(channels * fusedLen * sizeof(float));
+	float *channelbuf = (float *)malloc(fusedLen * sizeof(float));
+	if (!ir || !channelbuf)
+	{
+		free(ir);
+		free(channelbuf);
+		return 0;
+	}
+	for (unsigned int ch = 0; ch < channels; ch++)
+	{
+		size_t n = len;
+		if (stages & JDSP_FUSED_CONVOLVER)
+		{
+			const float *p = jdsp->impulseResponseStorage.impulseResponse + ch;
+			for (size_t j = 0; j < len; j++)
+				channelbuf[j] = p[j * channels];
+		}
+		else
+			channelbuf[0] = 1.0f;
+		for (int i = 0; i < 2; i++)
+		{
+			if (!(stages & (JDSP_FUSED_EQUALIZER << i)))
+				continue;
+			if (!Convolver1DConvolveInPlace(channelbuf, n, jdsp->convFusedKernel[i], jdsp->convFusedKernelLen[i]))
+				memset(channelbuf, 0, fusedLen * sizeof(float));
+			n += jdsp->convFusedKernelLen[i] - 1;
+		}
+		for (size_t j = 0; j < fusedLen; j++)
+			ir[j * channels + ch] = channelbuf[j];
+	}
+	free(channelbuf);
+	*impChannels = channels;
+	*impulseLength = fusedLen;
+	return ir;
+}
+// Builds the stored IR, with whichever stages are fused into it, off the audio thread and commits it
+// updateOld: a new response crossfaded against the playing one, otherwise the same one repartitioned and drained
+static int Convolver1DCommit(JamesDSPLib *jdsp, char updateOld)
+{
+	int fused = Convolver1DFusedStages(jdsp);
+	float *tempImpulseFloat = jdsp->impulseResponseStorage.impulseResponse;
+	unsigned int impChannels = jdsp->impulseResponseStorage.impChannels;
+	size_t impulseLengthActual = jdsp->impulseResponseStorage.impulseLengthActual;
+	float *fusedImpulse = 0;
+	if (fused)
+		tempImpulseFloat = fusedImpulse = Convolver1DFusedImpulseResponse(jdsp, fused, &impChannels, &impulseLengthActual);
+	// Built off the audio thread, swapped in at the next block boundary
+	Convolver1DSnapshot *cs = (Convolver1DSnapshot *)malloc(sizeof(Convolver1DSnapshot));
+	if (!cs)
+	{
+		free(fusedImpulse);
+		return -2;
+	}
+	memset(cs, 0, sizeof(Convolver1DSnapshot));
+	cs->hdr.apply = Convolver1DSnapshotApply;
+	cs->hdr.destroy = Convolver1DSnapshotDestroy;
+	cs->fused = fused;
+	jdsp->convFusedCommitted = fused;
+	memset(&jdsp->convSkipStats, 0, sizeof(FFTConvolverSkipStats));
+	if (!tempImpulseFloat) // Nothing left to run, or out of memory
+	{
+		JamesDSPCommitParam(jdsp, JDSP_PARAM_CONVOLVER, &cs->hdr);
+		return -2;
+	}
+	if (!updateOld)
+		cs->drainLen = (unsigned int)impulseLengthActual;
+	else
+		cs->fadeLen = (unsigned int)(jdsp->convCrossfadeMs * 0.001f * jdsp->fs);
+	Convolver1D *conv = &cs->conv;
+	float **finalImpulse = (float**)malloc(impChannels * sizeof(float*));
+	int ret = 1;
+	IRCacheSpectra cache;
+	if (!finalImpulse)
+	{
+		ret = 0;
+		goto bufDeleteAndUnlock;
+	}
+	memset(finalImpulse, 0, impChannels * sizeof(float*));
 	for (unsigned int i = 0; i < impChannels; i++)
-		if (finalImpulse[i])
-			free(finalImpulse[i]);
+	{
+		float* channelbuf = (float*)malloc(impulseLengthActual * sizeof(float));
+		if (!channelbuf)
+		{
+			ret = 0;
+			goto bufDeleteAndUnlock;
+		}
+		float* p = tempImpulseFloat + i;
+		for (unsigned int j = 0; j < impulseLengthActual; j++)
+			channelbuf[j] = p[j * impChannels];
+		finalImpulse[i] = channelbuf;
+	}
+	// Read once, the audio thread may publish a new block size while this builds
+	const unsigned int blockSize = JamesDSPBlockSize(jdsp);
+	unsigned int blockSizes[MULTISTAGE_MAX_STAGES];
+	unsigned int stageCount = selectConvStages(jdsp, blockSize, (unsigned int)impulseLengthActual, blockSizes);
+	const int hybrid = blockSize < CONV_DIRECT_HEAD_BELOW;
+	// Fused IRs change with every equalizer edit, not worth an entry in the cache
+	if (fused)
+		ret = Convolver1DBuild(conv, finalImpulse, impChannels, impulseLengthActual, blockSize, blockSizes, stageCount, hybrid);
+	else
+	{
+		// Partition spectra depend on the IR and the partitioning only
+		IRCacheKey key;
+		uint64_t shape[3] = { impChannels, impulseLengthActual, blockSize };
+		IRCacheKeyInit(&key, "convolver1d-spectra-2");
+		IRCacheKeyUpdate(&key, shape, sizeof(shape));
+		IRCacheKeyUpdate(&key, &stageCount, sizeof(stageCount));
+		IRCacheKeyUpdate(&key, blockSizes, stageCount * sizeof(unsigned int));
+		IRCacheKeyUpdate(&key, tempImpulseFloat, impChannels * impulseLengthActual * sizeof(float));
+		IRCacheSpectraBegin(&cache, &key, jdsp->convShareSpectra);
+		ret = Convolver1DBuild(conv, finalImpulse, impChannels, impulseLengthActual, blockSize, blockSizes, stageCount, hybrid);
+		int stored = ret && cache.writing;
+		IRCacheSpectraEnd(&cache, ret);
+		if (stored && jdsp->convShareSpectra)
+		{
+			// Spectra just written, swap the private copy for the mapped one
+			Convolver1D shared;
+			memset(&shared, 0, sizeof(Convolver1D));
+			IRCacheSpectraBegin(&cache, &key, 1);
+			if (cache.mapping && Convolver1DBuild(&shared, finalImpulse, impChannels, impulseLengthActual, blockSize, blockSizes, stageCount, hybrid))
+			{
+				Convolver1DFree(conv);
+				*conv = shared;
+			}
+			else
+				Convolver1DFree(&shared);
+			IRCacheSpectraEnd(&cache, 0);
+		}
+	}
+	if (ret && jdsp->convSkipThresholdDb < 0.0f)
+		Convolver1DSkipPartitions(conv, jdsp->convSkipThresholdDb, &jdsp->convSkipStats);
+bufDeleteAndUnlock:
 	if (finalImpulse)
+	{
+		for (unsigned int i = 0; i < impChannels; i++)
+			if (finalImpulse[i])
+				free(finalImpulse[i]);
 		free(finalImpulse);
-	jdsp_unlock(jdsp);
+	}
+	free(fusedImpulse);
+	if (!ret) // Nothing to hand over to
+		cs->drainLen = cs->fadeLen = 0;
+	JamesDSPCommitParam(jdsp, JDSP_PARAM_CONVOLVER, &cs->hdr);
 	if (!ret)
 		return -2;
 	else
 		return 1;
 }
+int Convolver1DLoadImpulseResponse(JamesDSPLib *jdsp, float *tempImpulseFloat, unsigned int impChannels, size_t impulseLengthActual, char updateOld)
+{
+	jdsp_lock(jdsp);
+	if (updateOld)
+	{
+		Convolver1DReleaseStorage(&jdsp->impulseResponseStorage);
+		IRCacheMapping *m = 0;
+		if (jdsp->convShareSpectra)
+		{
+			IRCacheKey key;
+			IRCacheKeyInit(&key, "convolver1d-ir-1");
+			IRCacheKeyUpdate(&key, tempImpulseFloat, impChannels * impulseLengthActual * sizeof(float));
+			m = IRCacheMapOrStore(&key, tempImpulseFloat, impChannels * impulseLengthActual * sizeof(float));
+		}
+		if (m)
+		{
+			jdsp->impulseResponseStorage.impulseResponse = (float *)m->entry.data;
+			jdsp->impulseResponseStorage.shared = m;
+		}
+		else
+		{
+			jdsp->impulseResponseStorage.impulseResponse = (float *)malloc(impChannels * impulseLengthActual * sizeof(float));
+			memcpy(jdsp->impulseResponseStorage.impulseResponse, tempImpulseFloat, impChannels * impulseLengthActual * sizeof(float));
+		}
+		jdsp->impulseResponseStorage.impChannels = impChannels;
+		jdsp->impulseResponseStorage.impulseLengthActual = impulseLengthActual;
+	}
+	int ret = Convolver1DCommit(jdsp, updateOld);
+	jdsp_unlock(jdsp);
+	return ret;
+}
+// Runs the FIR equalizer and the arbitrary magnitude equalizer as part of the convolver IR
+// whenever at least two of the three stages are enabled, saving their FFTs and latency
+void Convolver1DSetFusedLTI(JamesDSPLib *jdsp, int enable)
+{
+	jdsp_lock(jdsp);
+	jdsp->convFusedLTI = enable;
+	if (Convolver1DFusedStages(jdsp) != jdsp->convFusedCommitted)
+		Convolver1DCommit(jdsp, 1);
+	jdsp_unlock(jdsp);
+}
+// Keeps the kernel a FIR stage ahead of the convolver was designed with, NULL while it runs as IIR
+void Convolver1DFuseKernel(JamesDSPLib *jdsp, int stage, const float *kernel, unsigned int len)
+{
+	jdsp_lock(jdsp);
+	int i = stage == JDSP_FUSED_ARBEQ;
+	int changed = !kernel != !jdsp->convFusedKernel[i];
+	if (kernel && !changed)
+		changed = len != jdsp->convFusedKernelLen[i] || memcmp(kernel, jdsp->convFusedKernel[i], len * sizeof(float));
+	if (changed)
+	{
+		free(jdsp->convFusedKernel[i]);
+		jdsp->convFusedKernel[i] = kernel ? (float *)malloc(len * sizeof(float)) : 0;
+		jdsp->convFusedKernelLen[i] = jdsp->convFusedKernel[i] ? len : 0;
+		if (jdsp->convFusedKernel[i])
+			memcpy(jdsp->convFusedKernel[i], kernel, len * sizeof(float));
+	}
+	int stages = Convolver1DFusedStages(jdsp);
+	if (stages != jdsp->convFusedCommitted || (changed && (stages & stage)))
+		Convolver1DCommit(jdsp, 1);
+	jdsp_unlock(jdsp);
+}
+// Recommits the convolver after one of the stages it can fuse was enabled or disabled
+void Convolver1DFuseRefresh(JamesDSPLib *jdsp)
+{
+	if (!jdsp->convFusedLTI && !jdsp->convFusedCommitted)
+		return;
+	jdsp_lock(jdsp);
+	if (Convolver1DFusedStages(jdsp) != jdsp->convFusedCommitted)
+		Convolver1DCommit(jdsp, 1);
+	jdsp_unlock(jdsp);
+}
@@ -4,35 +4,135 @@
 #include <math.h>
 #include <float.h>
 #include "../jdsp_header.h"
+typedef struct
+{
+	JParamSnapshot hdr;
+	Crossfeed xf;
+	unsigned int shortLen, longLen;
+} CrossfeedSnapshot;
 void CrossfeedConstructor(JamesDSPLib *jdsp)
 {
 	memset(&jdsp->advXF, 0, sizeof(jdsp->advXF));
 }
-void CrossfeedDestructor(JamesDSPLib *jdsp)
+static void CrossfeedFreeConvolvers(Crossfeed *xf)
 {
-	if (jdsp->advXF.conv[0])
+	for (int i = 0; i < 3; i++)
 	{
-		FFTConvolver2x4x2Free(jdsp->advXF.conv[0]);
-		FFTConvolver2x4x2Free(jdsp->advXF.conv[1]);
-		FFTConvolver2x4x2Free(jdsp->advXF.conv[2]);
-		free(jdsp->advXF.conv[0]);
-		free(jdsp->advXF.conv[1]);
-		free(jdsp->advXF.conv[2]);
-		jdsp->advXF.conv[0] = 0;
+		if (xf->conv[i])
+		{
+			FFTConvolver2x4x2Free(xf->conv[i]);
+			free(xf->conv[i]);
+			xf->conv[i] = 0;
+		}
+		if (xf->convMS[i])
+		{
+			FFTConvolver2x2Free(xf->convMS[i]);
+			free(xf->convMS[i]);
+			xf->convMS[i] = 0;
+		}
 	}
-	if (jdsp->advXF.convLong_T_S)
+	if (xf->convLong_T_S)
 	{
-		TwoStageFFTConvolver2x4x2Free(jdsp->advXF.convLong_T_S);
-		free(jdsp->advXF.convLong_T_S);
-		jdsp->advXF.convLong_T_S = 0;
+		TwoStageFFTConvolver2x4x2Free(xf->convLong_T_S);
+		free(xf->convLong_T_S);
+		xf->convLong_T_S = 0;
 	}
-	if (jdsp->advXF.convLong_S_S)
+	if (xf->convLong_S_S)
+	{
+		FFTConvolver2x4x2Free(xf->convLong_S_S);
+		free(xf->convLong_S_S);
+		xf->convLong_S_S = 0;
+	}
+	if (xf->convLong_M_S)
+	{
+		MultiStageFFTConvolver2x4x2Free(xf->convLong_M_S);
+		free(xf->convLong_M_S);
+		xf->convLong_M_S = 0;
+	}
+	if (xf->convLongMS_T_S)
+	{
+		TwoStageFFTConvolver2x2Free(xf->convLongMS_T_S);
+		free(xf->convLongMS_T_S);
+		xf->convLongMS_T_S = 0;
+	}
+	if (xf->convLongMS_S_S)
+	{
+		FFTConvolver2x2Free(xf->convLongMS_S_S);
+		free(xf->convLongMS_S_S);
+		xf->convLongMS_S_S = 0;
+	}
+	if (xf->convLongMS_M_S)
+	{
+		MultiStageFFTConvolver2x2Free(xf->convLongMS_M_S);
+		free(xf->convLongMS_M_S);
+		xf->convLongMS_M_S = 0;
+	}
+}
+void CrossfeedDestructor(JamesDSPLib *jdsp)
+{
+	CrossfeedFreeConvolvers(&jdsp->advXF);
+}
+// Mode and BS2B state stay live, only the HRTF convolvers are exchanged
+static void CrossfeedSnapshotApply(JamesDSPLib *jdsp, JParamSnapshot *snap)
+{
+	Crossfeed *live = &jdsp->advXF, *xf = &((CrossfeedSnapshot *)snap)->xf;
+	Crossfeed tmp = *live;
+	memcpy(live->conv, xf->conv, sizeof(live->conv));
+	memcpy(live->convMS, xf->convMS, sizeof(live->convMS));
+	live->convLong_T_S = xf->convLong_T_S;
+	live->convLong_S_S = xf->convLong_S_S;
+	live->convLong_M_S = xf->convLong_M_S;
+	live->convLongMS_T_S = xf->convLongMS_T_S;
+	live->convLongMS_S_S = xf->convLongMS_S_S;
+	live->convLongMS_M_S = xf->convLongMS_M_S;
+	live->process = xf->process;
+	memcpy(xf->conv, tmp.conv, sizeof(xf->conv));
+	memcpy(xf->convMS, tmp.convMS, sizeof(xf->convMS));
+	xf->convLong_T_S = tmp.convLong_T_S;
+	xf->convLong_S_S = tmp.convLong_S_S;
+	xf->convLong_M_S = tmp.convLong_M_S;
+	xf->convLongMS_T_S = tmp.convLongMS_T_S;
+	xf->convLongMS_S_S = tmp.convLongMS_S_S;
+	xf->convLongMS_M_S = tmp.convLongMS_M_S;
+	xf->process = tmp.process;
+	// Let the outgoing HRTF ring out, in the mode it was running
+	if (jdsp->crossfeedEnabled && tmp.process && tmp.mode >= 2)
 	{
-		FFTConvolver2x4x2Free(jdsp->advXF.convLong_S_S);
-		free(jdsp->advXF.convLong_S_S);
-		jdsp->advXF.convLong_S_S = 0;
+		xf->mode = tmp.mode;
+		JamesDSPDrainStart(jdsp, &jdsp->xfDrain, JDSP_PARAM_CROSSFEED, snap, tmp.mode < 5 ? ((CrossfeedSnapshot *)snap)->shortLen : ((CrossfeedSnapshot *)snap)->longLen);
 	}
 }
+// Mirrored HRTFs run as a 2x2 convolver between two mid/side butterflies
+static void CrossfeedRunMidSide(Crossfeed *xf, float *x1, float *x2, unsigned int n)
+{
+	FFTConvolverMidSide(x1, x2, n);
+	if (xf->mode < 5)
+		FFTConvolver2x2Process(xf->convMS[xf->mode - 2], x1, x2, x1, x2, n);
+	else if (xf->convLongMS_S_S)
+		FFTConvolver2x2Process(xf->convLongMS_S_S, x1, x2, x1, x2, n);
+	else if (xf->convLongMS_M_S)
+		MultiStageFFTConvolver2x2Process(xf->convLongMS_M_S, x1, x2, x1, x2, n);
+	else
+		TwoStageFFTConvolver2x2Process(xf->convLongMS_T_S, x1, x2, x1, x2, n);
+	FFTConvolverMidSide(x1, x2, n);
+}
+static void CrossfeedRunHRTF(Crossfeed *xf, float *x1, float *x2, size_t n)
+{
+	if (xf->mode < 5 ? xf->convMS[xf->mode - 2] != 0 : (xf->convLongMS_S_S || xf->convLongMS_M_S || xf->convLongMS_T_S))
+		CrossfeedRunMidSide(xf, x1, x2, (unsigned int)n);
+	else if (xf->mode < 5)
+		FFTConvolver2x4x2Process(xf->conv[xf->mode - 2], x1, x2, x1, x2, (unsigned int)n);
+	else if (xf->convLong_S_S)
+		FFTConvolver2x4x2Process(xf->convLong_S_S, x1, x2, x1, x2, (unsigned int)n);
+	else if (xf->convLong_M_S)
+		MultiStageFFTConvolver2x4x2Process(xf->convLong_M_S, x1, x2, x1, x2, (unsigned int)n);
+	else
+		TwoStageFFTConvolver2x4x2Process(xf->convLong_T_S, x1, x2, x1, x2, (unsigned int)n);
+}
+static void CrossfeedSnapshotDestroy(JParamSnapshot *snap)
+{
+	CrossfeedFreeConvolvers(&((CrossfeedSnapshot *)snap)->xf);
+}
 void CrossfeedProcessFFTConvolver2x4x2(JamesDSPLib *jdsp, size_t n)
 {
 	FFTConvolver2x4x2Process(jdsp->advXF.convLong_S_S, jdsp->tmpBuffer[0], jdsp->tmpBuffer[1], jdsp->tmpBuffer[0], jdsp->tmpBuffer[1], (unsigned int)n);
@@ -41,39 +141,145 @@ void CrossfeedProcessTwoStageFFTConvolver2x4x2(JamesDSPLib *jdsp, size_t n)
 {
 	TwoStageFFTConvolver2x4x2Process(jdsp->advXF.convLong_T_S, jdsp->tmpBuffer[0], jdsp->tmpBuffer[1], jdsp->tmpBuffer[0], jdsp->tmpBuffer[1], (unsigned int)n);
 }
+void CrossfeedProcessMultiStageFFTConvolver2x4x2(JamesDSPLib *jdsp, size_t n)
+{
+	MultiStageFFTConvolver2x4x2Process(jdsp->advXF.convLong_M_S, jdsp->tmpBuffer[0], jdsp->tmpBuffer[1], jdsp->tmpBuffer[0], jdsp->tmpBuffer[1], (unsigned int)n);
+}
+void CrossfeedProcessMidSide(JamesDSPLib *jdsp, size_t n)
+{
+	CrossfeedRunMidSide(&jdsp->advXF, jdsp->tmpBuffer[0], jdsp->tmpBuffer[1], (unsigned int)n);
+}
 void CrossfeedEnable(JamesDSPLib *jdsp, char enable)
 {
     jdsp_lock(jdsp);
-	if (jdsp->crossfeedForceRefresh || !jdsp->advXF.conv[0] || !jdsp->advXF.conv[1] || !jdsp->advXF.conv[2] || !jdsp->advXF.convLong_S_S || !jdsp->advXF.convLong_T_S)
+	if (jdsp->crossfeedForceRefresh || (!jdsp->advXF.process && !JamesDSPParamPending(jdsp, JDSP_PARAM_CROSSFEED)))
 	{
-		CrossfeedDestructor(jdsp);
-		jdsp->advXF.conv[0] = (FFTConvolver2x4x2 *)malloc(sizeof(FFTConvolver2x4x2));
-		FFTConvolver2x4x2Init(jdsp->advXF.conv[0]);
-		FFTConvolver2x4x2LoadImpulseResponse(jdsp->advXF.conv[0], (unsigned int)jdsp->blockSize, jdsp->blobsCh1[0], jdsp->blobsCh2[0], jdsp->blobsCh3[0], jdsp->blobsCh4[0], jdsp->blobsResampledLen);
-		jdsp->advXF.conv[1] = (FFTConvolver2x4x2 *)malloc(sizeof(FFTConvolver2x4x2));
-		FFTConvolver2x4x2Init(jdsp->advXF.conv[1]);
-		FFTConvolver2x4x2LoadImpulseResponse(jdsp->advXF.conv[1], (unsigned int)jdsp->blockSize, jdsp->blobsCh1[1], jdsp->blobsCh2[1], jdsp->blobsCh3[1], jdsp->blobsCh4[1], jdsp->blobsResampledLen);
-		jdsp->advXF.conv[2] = (FFTConvolver2x4x2 *)malloc(sizeof(FFTConvolver2x4x2));
-		FFTConvolver2x4x2Init(jdsp->advXF.conv[2]);
-		FFTConvolver2x4x2LoadImpulseResponse(jdsp->advXF.conv[2], (unsigned int)jdsp->blockSize, jdsp->blobsCh1[2], jdsp->blobsCh2[2], jdsp->blobsCh3[2], jdsp->blobsCh4[2], jdsp->blobsResampledLen);
+		CrossfeedSnapshot *cs = (CrossfeedSnapshot *)malloc(sizeof(CrossfeedSnapshot));
+		if (!cs)
+			goto settle;
+		memset(cs, 0, sizeof(CrossfeedSnapshot));
+		cs->hdr.apply = CrossfeedSnapshotApply;
+		cs->hdr.destroy = CrossfeedSnapshotDestroy;
+		cs->shortLen = jdsp->blobsResampledLen;
+		cs->longLen = jdsp->frameLenSVirResampled;
+		Crossfeed *xf = &cs->xf;
+		const unsigned int shortLen = jdsp->blobsResampledLen, longLen = jdsp->frameLenSVirResampled;
+		float **hrtf = jdsp->hrtfblobsResampled;
+		const unsigned int blockSize = JamesDSPBlockSize(jdsp);
+		float *ms = (float *)malloc((shortLen > longLen ? shortLen : longLen) * 2 * sizeof(float));
+		for (int i = 0; i < 3; i++)
+		{
+			if (ms && FFTConvolver2x4x2Symmetric(jdsp->blobsCh1[i], jdsp->blobsCh2[i], jdsp->blobsCh3[i], jdsp->blobsCh4[i], shortLen))
+			{
+				FFTConvolver2x4x2MidSideImpulseResponse(jdsp->blobsCh1[i], jdsp->blobsCh2[i], ms, ms + shortLen, shortLen);
+				xf->convMS[i] = (FFTConvolver2x2 *)malloc(sizeof(FFTConvolver2x2));
+				if (xf->convMS[i])
+				{
+					FFTConvolver2x2Init(xf->convMS[i]);
+					FFTConvolver2x2LoadImpulseResponse(xf->convMS[i], blockSize, ms, ms + shortLen, shortLen);
+				}
+			}
+			else
+			{
+				xf->conv[i] = (FFTConvolver2x4x2 *)malloc(sizeof(FFTConvolver2x4x2));
+				if (xf->conv[i])
+				{
+					FFTConvolver2x4x2Init(xf->conv[i]);
+					FFTConvolver2x4x2LoadImpulseResponse(xf->conv[i], blockSize, jdsp->blobsCh1[i], jdsp->blobsCh2[i], jdsp->blobsCh3[i], jdsp->blobsCh4[i], shortLen);
+				}
+			}
+		}
+		const int longMS = ms && FFTConvolver2x4x2Symmetric(hrtf[0], hrtf[1], hrtf[2], hrtf[3], longLen);
+		if (longMS)
+			FFTConvolver2x4x2MidSideImpulseResponse(hrtf[0], hrtf[1], ms, ms + longLen, longLen);
 		unsigned int seg2Len = 0;
-		if (selectConvPartitions(jdsp, jdsp->frameLenSVirResampled, &seg2Len) == 1)
+		if (blockSize < CONV_DIRECT_HEAD_BELOW)
+		{
+			unsigned int blockSizes[MULTISTAGE_MAX_STAGES];
+			unsigned int stageCount = selectConvStages(jdsp, blockSize, longLen, blockSizes);
+			if (longMS)
+			{
+				xf->convLongMS_M_S = (MultiStageFFTConvolver2x2 *)malloc(sizeof(MultiStageFFTConvolver2x2));
+				if (xf->convLongMS_M_S)
+				{
+					MultiStageFFTConvolver2x2Init(xf->convLongMS_M_S);
+					MultiStageFFTConvolver2x2LoadImpulseResponseHybrid(xf->convLongMS_M_S, blockSizes, stageCount, ms, ms + longLen, longLen);
+				}
+				xf->process = CrossfeedProcessMidSide;
+			}
+			else
+			{
+				xf->convLong_M_S = (MultiStageFFTConvolver2x4x2 *)malloc(sizeof(MultiStageFFTConvolver2x4x2));
+				if (xf->convLong_M_S)
+				{
+					MultiStageFFTConvolver2x4x2Init(xf->convLong_M_S);
+					MultiStageFFTConvolver2x4x2LoadImpulseResponseHybrid(xf->convLong_M_S, blockSizes, stageCount, hrtf[0], hrtf[1], hrtf[2], hrtf[3], longLen);
+				}
+				xf->process = CrossfeedProcessMultiStageFFTConvolver2x4x2;
+			}
+		}
+		else if (selectConvPartitions(jdsp, blockSize, longLen, &seg2Len) == 1)
 		{
-			jdsp->advXF.convLong_S_S = (FFTConvolver2x4x2 *)malloc(sizeof(FFTConvolver2x4x2));
-			FFTConvolver2x4x2Init(jdsp->advXF.convLong_S_S);
-			FFTConvolver2x4x2LoadImpulseResponse(jdsp->advXF.convLong_S_S, (unsigned int)jdsp->blockSize, jdsp->hrtfblobsResampled[0], jdsp->hrtfblobsResampled[1], jdsp->hrtfblobsResampled[2], jdsp->hrtfblobsResampled[3], jdsp->frameLenSVirResampled);
-			jdsp->advXF.process = CrossfeedProcessFFTConvolver2x4x2;
+			if (longMS)
+			{
+				xf->convLongMS_S_S = (FFTConvolver2x2 *)malloc(sizeof(FFTConvolver2x2));
+				if (xf->convLongMS_S_S)
+				{
+					FFTConvolver2x2Init(xf->convLongMS_S_S);
+					FFTConvolver2x2LoadImpulseResponse(xf->convLongMS_S_S, blockSize, ms, ms + longLen, longLen);
+				}
+				xf->process = CrossfeedProcessMidSide;
+			}
+			else
+			{
+				xf->convLong_S_S = (FFTConvolver2x4x2 *)malloc(sizeof(FFTConvolver2x4x2));
+				if (xf->convLong_S_S)
+				{
+					FFTConvolver2x4x2Init(xf->convLong_S_S);
+					FFTConvolver2x4x2LoadImpulseResponse(xf->convLong_S_S, blockSize, hrtf[0], hrtf[1], hrtf[2], hrtf[3], longLen);
+				}
+				xf->process = CrossfeedProcessFFTConvolver2x4x2;
+			}
 		}
 		else
 		{
 			//seg2Len = (jdsp->frameLenSVirResampled - jdsp->blockSize) / 4;
-			jdsp->advXF.convLong_T_S = (TwoStageFFTConvolver2x4x2 *)malloc(sizeof(TwoStageFFTConvolver2x4x2));
-			TwoStageFFTConvolver2x4x2Init(jdsp->advXF.convLong_T_S);
-			TwoStageFFTConvolver2x4x2LoadImpulseResponse(jdsp->advXF.convLong_T_S, (unsigned int)jdsp->blockSize, seg2Len, jdsp->hrtfblobsResampled[0], jdsp->hrtfblobsResampled[1], jdsp->hrtfblobsResampled[2], jdsp->hrtfblobsResampled[3], jdsp->frameLenSVirResampled);
-			jdsp->advXF.process = CrossfeedProcessTwoStageFFTConvolver2x4x2;
+			if (longMS)
+			{
+				xf->convLongMS_T_S = (TwoStageFFTConvolver2x2 *)malloc(sizeof(TwoStageFFTConvolver2x2));
+				if (xf->convLongMS_T_S)
+				{
+					TwoStageFFTConvolver2x2Init(xf->convLongMS_T_S);
+					TwoStageFFTConvolver2x2LoadImpulseResponse(xf->convLongMS_T_S, blockSize, seg2Len, ms, ms + longLen, longLen);
+				}
+				xf->process = CrossfeedProcessMidSide;
+			}
+			else
+			{
+				xf->convLong_T_S = (TwoStageFFTConvolver2x4x2 *)malloc(sizeof(TwoStageFFTConvolver2x4x2));
+				if (xf->convLong_T_S)
+				{
+					TwoStageFFTConvolver2x4x2Init(xf->convLong_T_S);
+					TwoStageFFTConvolver2x4x2LoadImpulseResponse(xf->convLong_T_S, blockSize, seg2Len, hrtf[0], hrtf[1], hrtf[2], hrtf[3], longLen);
+				}
+				xf->process = CrossfeedProcessTwoStageFFTConvolver2x4x2;
+			}
+		}
+		free(ms);
+		int complete = xf->convLong_T_S || xf->convLong_S_S || xf->convLong_M_S || xf->convLongMS_T_S || xf->convLongMS_S_S || xf->convLongMS_M_S;
+		for (int i = 0; i < 3; i++)
+			complete &= xf->conv[i] || xf->convMS[i];
+		if (!complete)
+		{
+			// Out of memory, the previous convolvers keep playing and the refresh flag stays for a retry
+			CrossfeedFreeConvolvers(xf);
+			free(cs);
+			goto settle;
 		}
+		JamesDSPCommitParam(jdsp, JDSP_PARAM_CROSSFEED, &cs->hdr);
 		jdsp->crossfeedForceRefresh = 0;
 	}
+settle:
 	if (jdsp->advXF.mode < 2)
 	{
 		memset(&jdsp->advXF.bs2b, 0, sizeof(jdsp->advXF.bs2b));
@@ -106,6 +312,11 @@ void CrossfeedChangeMode(JamesDSPLib *jdsp, int nMode)
 }
 void CrossfeedProcess(JamesDSPLib *jdsp, size_t n)
 {
+	if (jdsp->xfDrain.remaining)
+	{
+		float **y = JamesDSPDrainBuffer(jdsp, n);
+		CrossfeedRunHRTF(&((CrossfeedSnapshot *)jdsp->xfDrain.snap)->xf, y[0], y[1], n);
+	}
 	if (jdsp->advXF.mode < 2)
 	{
 		double tmpL, tmpR;
@@ -118,8 +329,11 @@ void CrossfeedProcess(JamesDSPLib *jdsp, size_t n)
 			jdsp->tmpBuffer[1][i] = (float)tmpR;
 		}
 	}
+	else if (!jdsp->advXF.process) // HRTF convolvers not swapped in yet
+		return;
 	else if (jdsp->advXF.mode < 5)
-		FFTConvolver2x4x2Process(jdsp->advXF.conv[jdsp->advXF.mode - 2], jdsp->tmpBuffer[0], jdsp->tmpBuffer[1], jdsp->tmpBuffer[0], jdsp->tmpBuffer[1], (unsigned int)n);
+		CrossfeedRunHRTF(&jdsp->advXF, jdsp->tmpBuffer[0], jdsp->tmpBuffer[1], n);
 	else
 		jdsp->advXF.process(jdsp, (unsigned int)n);
+	JamesDSPDrainFinish(jdsp, &jdsp->xfDrain, n);
 }
\ No newline at end of file
@@ -3,23 +3,317 @@
 #include <string.h>
 #include <math.h>
 #include <float.h>
-#include "eel2/numericSys/codelet.h"
+#include "eel2/numericSys/realFFT.h"
 #include "eel2/ns-eel.h"
 #include "../jdsp_header.h"
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define JLIMITER_SIMD
+typedef __m128 vf4;
+#define vf4Load _mm_loadu_ps
+#define vf4Store _mm_storeu_ps
+#define vf4Set1 _mm_set1_ps
+#define vf4Add _mm_add_ps
+#define vf4Mul _mm_mul_ps
+#define vf4Div _mm_div_ps
+#define vf4Max _mm_max_ps
+#define vf4Abs(x) _mm_andnot_ps(_mm_set1_ps(-0.0f), x)
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define JLIMITER_SIMD
+typedef float32x4_t vf4;
+#define vf4Load vld1q_f32
+#define vf4Store vst1q_f32
+#define vf4Set1 vdupq_n_f32
+#define vf4Add vaddq_f32
+#define vf4Mul vmulq_f32
+#define vf4Div vdivq_f32
+#define vf4Max vmaxq_f32
+#define vf4Abs vabsq_f32
+#endif
+// The true peak detector reports the sample this many samples back together with the 3 points following it
+#define JLIMITER_TP_DELAY (JLIMITER_TP_TAPS / 2)
 void JLimiterSetCoefficients(JamesDSPLib *jdsp, double thresholddB, double msRelease)
 {
 	if (msRelease < 1.5)
 		msRelease = 1.5;
 	jdsp->limiter.relCoef = (float)exp(-1000.0 / (msRelease * round((double)jdsp->fs)));
 	jdsp->limiter.threshold = (float)pow(10.0, thresholddB / 20.0);
+	// 1 ms lookahead
+	unsigned int lookahead = (unsigned int)ceil(jdsp->fs * 0.001);
+	if (lookahead < JLIMITER_TP_TAPS)
+		lookahead = JLIMITER_TP_TAPS;
+	if (lookahead > JLIMITER_LOOKAHEAD_MAX)
+		lookahead = JLIMITER_LOOKAHEAD_MAX;
+	__atomic_store_n(&jdsp->limiter.lookaheadRequest, lookahead, __ATOMIC_RELAXED);
+}
+static double besselI0(double x)
+{
+	double sum = 1.0, term = 1.0;
+	for (int k = 1; k < 32; k++)
+	{
+		term *= (x * 0.5 / k) * (x * 0.5 / k);
+		sum += term;
+	}
+	return sum;
+}
+void JLimiterReset(JamesDSPLib *jdsp)
+{
+	JLimiter *lim = &jdsp->limiter;
+	lim->envOverThreshold = 0.0f;
+	memset(lim->tpHist, 0, sizeof(lim->tpHist));
+	memset(lim->delay, 0, sizeof(lim->delay));
+	lim->holdHead = lim->holdTail = lim->clock = 0;
+	// Output so far was the undelayed input, true peak mode fades its delay in
+	lim->fadeFrom = 0;
+	lim->fadePos = 0;
 }
 void JLimiterInit(JamesDSPLib *jdsp)
 {
-	jdsp->limiter.envOverThreshold = 0.0f;
+	JLimiter *lim = &jdsp->limiter;
+	JLimiterReset(jdsp);
+	// Kaiser (beta 4) windowed sinc interpolating at 1/4, 2/4 and 3/4 past x[n - JLIMITER_TP_DELAY]
+	// Within -0.03 / +0.12 dB up to 0.375 fs, reading high is the safe side for a limiter
+	for (int p = 1; p < 4; p++)
+	{
+		double sum = 0.0;
+		double h[JLIMITER_TP_TAPS];
+		for (int k = 0; k < JLIMITER_TP_TAPS; k++)
+		{
+			double d = k - JLIMITER_TP_DELAY + p * 0.25;
+			double r = d / JLIMITER_TP_DELAY;
+			h[k] = sin(M_PI * d) / (M_PI * d) * besselI0(4.0 * sqrt(1.0 - r * r)) / besselI0(4.0);
+			sum += h[k];
+		}
+		for (int k = 0; k < JLIMITER_TP_TAPS; k++)
+			lim->tpCoeffs[p - 1][k] = (float)(h[k] / sum);
+	}
 }
-#ifndef M_PI
-#define M_PI 3.14159265358979323846
+void JLimiterSetTruePeak(JamesDSPLib *jdsp, int enable)
+{
+	__atomic_store_n(&jdsp->limiter.truePeakRequest, enable ? 1 : 0, __ATOMIC_RELAXED);
+}
+// Post gain, then the stereo linked sample peak floored at the threshold
+static void limiterSamplePeak(float *x0, float *x1, float *pk, float gain, float threshold, size_t n)
+{
+	size_t i = 0;
+#ifdef JLIMITER_SIMD
+	const vf4 g = vf4Set1(gain), thr = vf4Set1(threshold);
+	for (; i + 4 <= n; i += 4)
+	{
+		vf4 l = vf4Mul(vf4Load(x0 + i), g);
+		vf4 r = vf4Mul(vf4Load(x1 + i), g);
+		vf4Store(x0 + i, l);
+		vf4Store(x1 + i, r);
+		vf4Store(pk + i, vf4Max(vf4Max(vf4Abs(l), vf4Abs(r)), thr));
+	}
 #endif
+	for (; i < n; i++)
+	{
+		x0[i] *= gain;
+		x1[i] *= gain;
+		float maxLR = max(fabsf(x0[i]), fabsf(x1[i]));
+		pk[i] = max(maxLR, threshold);
+	}
+}
+static void limiterScale(float *x, float gain, size_t n)
+{
+	size_t i = 0;
+#ifdef JLIMITER_SIMD
+	const vf4 g = vf4Set1(gain);
+	for (; i + 4 <= n; i += 4)
+		vf4Store(x + i, vf4Mul(vf4Load(x + i), g));
+#endif
+	for (; i < n; i++)
+		x[i] *= gain;
+}
+static inline float tpInput(const float *x, const float *hist, ptrdiff_t i)
+{
+	return i >= 0 ? x[i] : hist[JLIMITER_TP_TAPS - 1 + i];
+}
+static float tpPeakAt(const JLimiter *lim, const float *x, const float *hist, ptrdiff_t i)
+{
+	float pk = fabsf(tpInput(x, hist, i - JLIMITER_TP_DELAY));
+	for (int p = 0; p < 3; p++)
+	{
+		float acc = 0.0f;
+		for (int k = 0; k < JLIMITER_TP_TAPS; k++)
+			acc += lim->tpCoeffs[p][k] * tpInput(x, hist, i - k);
+		pk = max(pk, fabsf(acc));
+	}
+	return pk;
+}
+// Stereo linked true peak between x[i - JLIMITER_TP_DELAY] and the next sample, floored at the threshold
+static void limiterTruePeak(JLimiter *lim, const float *x0, const float *x1, float *pk, size_t n)
+{
+	size_t i = 0;
+	for (; i < n && i < JLIMITER_TP_TAPS - 1; i++)
+		pk[i] = max(max(tpPeakAt(lim, x0, lim->tpHist[0], i), tpPeakAt(lim, x1, lim->tpHist[1], i)), lim->threshold);
+#ifdef JLIMITER_SIMD
+	// The three phases share every input load, six independent accumulator chains
+	const vf4 zero = vf4Set1(0.0f), thr = vf4Set1(lim->threshold);
+	for (; i + 4 <= n; i += 4)
+	{
+		vf4 l1 = zero, l2 = zero, l3 = zero, r1 = zero, r2 = zero, r3 = zero;
+		for (int k = 0; k < JLIMITER_TP_TAPS; k++)
+		{
+			vf4 l = vf4Load(x0 + i - k), r = vf4Load(x1 + i - k);
+			vf4 c1 = vf4Set1(lim->tpCoeffs[0][k]), c2 = vf4Set1(lim->tpCoeffs[1][k]), c3 = vf4Set1(lim->tpCoeffs[2][k]);
+			l1 = vf4Add(l1, vf4Mul(c1, l));
+			l2 = vf4Add(l2, vf4Mul(c2, l));
+			l3 = vf4Add(l3, vf4Mul(c3, l));
+			r1 = vf4Add(r1, vf4Mul(c1, r));
+			r2 = vf4Add(r2, vf4Mul(c2, r));
+			r3 = vf4Add(r3, vf4Mul(c3, r));
+		}
+		vf4 m = vf4Max(vf4Abs(vf4Load(x0 + i - JLIMITER_TP_DELAY)), vf4Abs(vf4Load(x1 + i - JLIMITER_TP_DELAY)));
+		m = vf4Max(m, vf4Max(vf4Max(vf4Abs(l1), vf4Abs(r1)), vf4Max(vf4Abs(l2), vf4Abs(r2))));
+		m = vf4Max(m, vf4Max(vf4Abs(l3), vf4Abs(r3)));
+		vf4Store(pk + i, vf4Max(m, thr));
+	}
+#endif
+	for (; i < n; i++)
+		pk[i] = max(max(tpPeakAt(lim, x0, lim->tpHist[0], i), tpPeakAt(lim, x1, lim->tpHist[1], i)), lim->threshold);
+	const size_t histLen = JLIMITER_TP_TAPS - 1;
+	const float *x[2] = { x0, x1 };
+	for (int ch = 0; ch < 2; ch++)
+	{
+		if (n >= histLen)
+			memcpy(lim->tpHist[ch], x[ch] + n - histLen, histLen * sizeof(float));
+		else
+		{
+			memmove(lim->tpHist[ch], lim->tpHist[ch] + n, (histLen - n) * sizeof(float));
+			memcpy(lim->tpHist[ch] + histLen - n, x[ch], n * sizeof(float));
+		}
+	}
+}
+// Running maximum over the lookahead window, the gain then reaches its target before the peak leaves the delay line
+static void limiterHold(JLimiter *lim, float *pk, size_t n)
+{
+	const uint32_t mask = JLIMITER_LOOKAHEAD_MAX - 1;
+	const uint32_t window = lim->lookahead - JLIMITER_TP_DELAY + 1;
+	for (size_t i = 0; i < n; i++)
+	{
+		float v = pk[i];
+		while (lim->holdTail != lim->holdHead && lim->holdVal[(lim->holdTail - 1) & mask] <= v)
+			lim->holdTail--;
+		lim->holdVal[lim->holdTail & mask] = v;
+		lim->holdPos[lim->holdTail & mask] = lim->clock;
+		lim->holdTail++;
+		if (lim->clock - lim->holdPos[lim->holdHead & mask] >= window)
+			lim->holdHead++;
+		lim->clock++;
+		pk[i] = lim->holdVal[lim->holdHead & mask];
+	}
+}
+// Delays x by d samples in place, line keeps the last JLIMITER_LOOKAHEAD_MAX input samples for any d
+static void limiterDelay(float *x, float *line, unsigned int d, size_t n)
+{
+	const size_t len = JLIMITER_LOOKAHEAD_MAX, keep = min(n, len);
+	float tail[JLIMITER_LOOKAHEAD_MAX];
+	memcpy(tail, x + n - keep, keep * sizeof(float));
+	if (d)
+	{
+		if (n > d)
+			memmove(x + d, x, (n - d) * sizeof(float));
+		memcpy(x, line + len - d, min(n, d) * sizeof(float));
+	}
+	memmove(line, line + keep, (len - keep) * sizeof(float));
+	memcpy(line + len - keep, tail, keep * sizeof(float));
+}
+// Linear crossfade from the input delayed by fadeFrom to the one delayed by d, both read from the same history
+static void limiterDelayFade(const JLimiter *lim, float *x, float *line, unsigned int d, size_t n)
+{
+	float old[JLIMITER_FADE];
+	const size_t m = min(n, JLIMITER_FADE - lim->fadePos);
+	for (size_t i = 0; i < m; i++)
+	{
+		ptrdiff_t k = (ptrdiff_t)i - (ptrdiff_t)lim->fadeFrom;
+		old[i] = k >= 0 ? x[k] : line[JLIMITER_LOOKAHEAD_MAX + k];
+	}
+	limiterDelay(x, line, d, n);
+	for (size_t i = 0; i < m; i++)
+	{
+		float w = (float)(lim->fadePos + i + 1) / JLIMITER_FADE;
+		x[i] = old[i] + w * (x[i] - old[i]);
+	}
+}
+static void limiterApply(float *x0, float *x1, const float *env, float threshold, size_t n)
+{
+	size_t i = 0;
+#ifdef JLIMITER_SIMD
+	const vf4 thr = vf4Set1(threshold);
+	for (; i + 4 <= n; i += 4)
+	{
+		vf4 gR = vf4Div(thr, vf4Load(env + i));
+		vf4Store(x0 + i, vf4Mul(vf4Load(x0 + i), gR));
+		vf4Store(x1 + i, vf4Mul(vf4Load(x1 + i), gR));
+	}
+#endif
+	for (; i < n; i++)
+	{
+		float gR = threshold / env[i];
+		x0[i] *= gR;
+		x1[i] *= gR;
+	}
+}
+// Output stage, post gain and the limiter on tmpBuffer[0..1], tmpBuffer[6] holds the envelope
+// Only the release recursion runs per sample, the other passes are block wide vector loops
+void JLimiterProcess(JamesDSPLib *jdsp, size_t n)
+{
+	JLimiter *lim = &jdsp->limiter;
+	float *x0 = jdsp->tmpBuffer[0], *x1 = jdsp->tmpBuffer[1], *env = jdsp->tmpBuffer[6];
+	int truePeak = __atomic_load_n(&lim->truePeakRequest, __ATOMIC_RELAXED);
+	unsigned int lookahead = __atomic_load_n(&lim->lookaheadRequest, __ATOMIC_RELAXED);
+	if (truePeak != lim->truePeak || lookahead != lim->lookahead)
+	{
+		// Detector restarts on the input history, the output crossfades to the new delay instead of a silent delay line
+		const unsigned int from = lim->truePeak ? lim->lookahead : 0;
+		for (int ch = 0; ch < 2; ch++)
+			memcpy(lim->tpHist[ch], lim->delay[ch] + JLIMITER_LOOKAHEAD_MAX - (JLIMITER_TP_TAPS - 1), sizeof(lim->tpHist[ch]));
+		lim->holdHead = lim->holdTail = lim->clock = 0;
+		lim->truePeak = truePeak;
+		lim->lookahead = lookahead;
+		lim->fadeFrom = from;
+		lim->fadePos = 0;
+	}
+	if (!lim->truePeak)
+		limiterSamplePeak(x0, x1, env, jdsp->postGain, lim->threshold, n);
+	else
+	{
+		limiterScale(x0, jdsp->postGain, n);
+		limiterScale(x1, jdsp->postGain, n);
+		limiterTruePeak(lim, x0, x1, env, n);
+		limiterHold(lim, env, n);
+	}
+	float envOverThreshold = lim->envOverThreshold;
+	for (size_t i = 0; i < n; i++)
+	{
+		if (env[i] > envOverThreshold)
+			envOverThreshold = env[i];
+		else
+			envOverThreshold = env[i] + lim->relCoef * (envOverThreshold - env[i]);
+		env[i] = envOverThreshold;
+	}
+	lim->envOverThreshold = envOverThreshold;
+	// Sample peak mode runs undelayed but still records the history a switch crossfades from
+	const unsigned int d = lim->truePeak ? lim->lookahead : 0;
+	if (lim->fadePos < JLIMITER_FADE && lim->fadeFrom != d)
+	{
+		limiterDelayFade(lim, x0, lim->delay[0], d, n);
+		limiterDelayFade(lim, x1, lim->delay[1], d, n);
+		lim->fadePos += (unsigned int)min(n, JLIMITER_FADE - lim->fadePos);
+	}
+	else
+	{
+		limiterDelay(x0, lim->delay[0], d, n);
+		limiterDelay(x1, lim->delay[1], d, n);
+	}
+	limiterApply(x0, x1, env, lim->threshold, n);
+}
 float map(float x, float in_min, float in_max, float out_min, float out_max)
 {
 	return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
@@ -1116,24 +1410,7 @@ void FFTCompanderInit(FFTCompander *cm, float fs, int tfresolution, unsigned int
 		cm->fftLen = 32;
 		cm->ovpCount = 1;
 	}
-	if (cm->fftLen == 32)
-		cm->fft = DFT32;
-	else if (cm->fftLen == 64)
-		cm->fft = DFT64;
-	else if (cm->fftLen == 128)
-		cm->fft = DFT128;
-	else if (cm->fftLen == 256)
-		cm->fft = DFT256;
-	else if (cm->fftLen == 512)
-		cm->fft = DFT512;
-	else if (cm->fftLen == 1024)
-		cm->fft = DFT1024;
-	else if (cm->fftLen == 2048)
-		cm->fft = DFT2048;
-	else if (cm->fftLen == 4096)
-		cm->fft = DFT4096;
-	else
-		cm->fft = DFT8192;
+	cm->fft = realFFTKernel(realFFTSelect(REALFFT_BEST), cm->fftLen);
 	cm->minus_fftLen = cm->fftLen - 1;
 	cm->ovpLen = cm->fftLen / cm->ovpCount;
 	cm->halfLen = (cm->fftLen >> 1) + 1;
@@ -1145,7 +1422,7 @@ void FFTCompanderInit(FFTCompander *cm, float fs, int tfresolution, unsigned int
 	else
 		cm->procUpTo = idx;
 	LLbitReversalTbl(cm->mBitRev, cm->fftLen);
-	fhtsinHalfTblFloat(cm->mSineTab, cm->fftLen);
+	realFFTTable(cm->mSineTab, cm->fftLen);
 	for (i = 0; i < MAX_OUTPUT_BUFFERS_DRS; i++)
 		cm->mOutputBuffer[i] = cm->buffer[i];
 	cm->mInputSamplesNeeded = cm->ovpLen;
@@ -1585,115 +1862,78 @@ void FFTCompanderInit(FFTCompander *cm, float fs, int tfresolution, unsigned int
 		cm->alpha = 0.5f / cm->updatePerNSmps;
 	}
 }
-void CompressorConstructor(JamesDSPLib *jdsp)
+typedef struct
 {
-	FFTCompander *cm = (FFTCompander *)(&jdsp->comp);
-	double freq[NUMPTS_DRS] = { 95.0, 200.0, 400.0, 800.0, 1600.0, 3400.0, 7500.0 };
-	memcpy(cm->freq2 + 1, freq, NUMPTS_DRS * sizeof(double));
-	cm->freq2[0] = 0.0;
-	cm->gains2[0] = cm->gains2[1];
-	cm->freq2[NUMPTS_DRS + 1] = 24000.0;
-	initIerper(&cm->pch, NUMPTS_DRS + 2);
-}
-void CompressorDestructor(JamesDSPLib *jdsp)
+	JParamSnapshot hdr;
+	FFTCompander *comp; // Replaces the live instance, NULL: the gain curve below goes to the live one
+	char release; // Hands the idle instance back for the control thread to free
+	float DREmult[HALFWNDLEN_DRS];
+	float headRoomdB, alpha;
+} CompressorSnapshot;
+static void CompressorSnapshotApply(JamesDSPLib *jdsp, JParamSnapshot *snap)
 {
-	freeIerper(&jdsp->comp.pch);
-}
-void CompressorEnable(JamesDSPLib *jdsp, char enable)
-{
-	if (jdsp->compForceRefresh)
+	CompressorSnapshot *cs = (CompressorSnapshot *)snap;
+	if (cs->comp || cs->release)
 	{
-		CompressorSetParam(jdsp, jdsp->comp.fgt_facT, jdsp->comp.granularity, jdsp->comp.tfresolution, 1);
-		CompressorSetGain(jdsp, 0, 0, 0);
+		FFTCompander *old = jdsp->comp;
+		jdsp->comp = cs->comp;
+		cs->comp = old;
+	}
+	else if (jdsp->comp)
+	{
+		memcpy(jdsp->comp->DREmult, cs->DREmult, sizeof(cs->DREmult));
+		jdsp->comp->headRoomdB = cs->headRoomdB;
+		jdsp->comp->alpha = cs->alpha;
 	}
-	if (enable)
-		jdsp->compEnabled = 1;
 }
-void CompressorDisable(JamesDSPLib *jdsp)
+static void CompressorSnapshotDestroy(JParamSnapshot *snap)
 {
-	jdsp->compEnabled = 0;
+	free(((CompressorSnapshot *)snap)->comp);
 }
-void CompressorSetParam(JamesDSPLib *jdsp, float fgt_facT, int granularity, int tfresolution, char forceRefresh)
+void CompressorConstructor(JamesDSPLib *jdsp)
 {
-	FFTCompander *cm = (FFTCompander *)(&jdsp->comp);
-	if ((fgt_facT != cm->fgt_facT || tfresolution != cm->tfresolution || granularity != cm->granularity) || forceRefresh)
-	{
-		FFTCompanderInit(&jdsp->comp, jdsp->fs, tfresolution, 3, 1.0);
-		cm->fgt_facT = fgt_facT;
-		cm->tfresolution = tfresolution;
-		cm->granularity = granularity;
-		if (cm->tfresolution < 3)
-		{
-			cm->fgt_fac = (float)(1.0 - exp(-1.0 / (cm->fgt_facT * jdsp->comp.spectralRate)));
-			double avgBW;
-			if (!cm->granularity)
-				avgBW = 1.65;
-			else if (cm->granularity == 1)
-				avgBW = 1.45;
-			else if (cm->granularity == 2)
-				avgBW = 1.2;
-			else if (cm->granularity == 3)
-				avgBW = 1.15;
-			else
-				avgBW = 1.08;
-			FFTCompanderSetavgBW(cm, avgBW);
-		}
-		else if (cm->tfresolution == 3)
-		{
-			cm->fgt_fac = (float)(1.0 - exp(-1.0 / (cm->fgt_facT * jdsp->fs)));
-		}
-	}
+	double freq[NUMPTS_DRS] = { 95.0, 200.0, 400.0, 800.0, 1600.0, 3400.0, 7500.0 };
+	memcpy(jdsp->compParam.freq, freq, NUMPTS_DRS * sizeof(double));
+	initIerper(&jdsp->compPch, NUMPTS_DRS + 2);
+	jdsp->comp = 0;
+	jdsp->compCommitted = 0;
 }
-void CompressorSetGain(JamesDSPLib *jdsp, double *freq, double *gains, char cpy)
+void CompressorDestructor(JamesDSPLib *jdsp)
 {
-	FFTCompander *cm = (FFTCompander *)(&jdsp->comp);
-	if (cpy)
-	{
-		memcpy(cm->freq2 + 1, freq, NUMPTS_DRS * sizeof(double));
-		memcpy(cm->gains2 + 1, gains, NUMPTS_DRS * sizeof(double));
-	}
-	cm->freq2[0] = 0.0;
-	cm->gains2[0] = cm->gains2[1];
-	cm->freq2[NUMPTS_DRS + 1] = 24000.0;
-	cm->gains2[NUMPTS_DRS + 1] = cm->gains2[NUMPTS_DRS];
-	pchip(&cm->pch, cm->freq2, cm->gains2, NUMPTS_DRS + 2, 1, 1);
-	unsigned int specLen = *((unsigned int *)(cm->octaveSmooth));
-	float reciprocal = *((float *)(cm->octaveSmooth + sizeof(unsigned int)));
-	unsigned int lpLen = *((unsigned int *)(cm->octaveSmooth + sizeof(unsigned int) + sizeof(float)));
-	float *lv1 = (float *)(cm->octaveSmooth + sizeof(unsigned int) + sizeof(float) + sizeof(unsigned int) + (lpLen << 1) * sizeof(unsigned int) + lpLen * sizeof(float));
-	float *lv2 = (float *)(cm->octaveSmooth + sizeof(unsigned int) + sizeof(float) + sizeof(unsigned int) + (lpLen << 1) * sizeof(unsigned int) + lpLen * sizeof(float) + (lpLen + 3) * sizeof(float));
+	free(jdsp->comp);
+	jdsp->comp = 0;
+	freeIerper(&jdsp->compPch);
+}
+// Gain curve of the recorded parameters for the layout of cm, which is only read
+static void CompressorDesignGain(JamesDSPLib *jdsp, FFTCompander *cm, float *DREmult, float *headRoomdB, float *alpha)
+{
+	double freq2[NUMPTS_DRS + 2], gains2[NUMPTS_DRS + 2];
+	memcpy(freq2 + 1, jdsp->compParam.freq, NUMPTS_DRS * sizeof(double));
+	memcpy(gains2 + 1, jdsp->compParam.gains, NUMPTS_DRS * sizeof(double));
+	freq2[0] = 0.0;
+	gains2[0] = gains2[1];
+	freq2[NUMPTS_DRS + 1] = 24000.0;
+	gains2[NUMPTS_DRS + 1] = gains2[NUMPTS_DRS];
+	pchip(&jdsp->compPch, freq2, gains2, NUMPTS_DRS + 2, 1, 1);
 	if (cm->tfresolution < 3)
 	{
+		float DREmultUniform[HALFWNDLEN_DRS];
 		for (int i = 0; i < HALFWNDLEN_DRS; i++)
-			cm->DREmultUniform[i] = getValueAt(&cm->pch.cb, i * jdsp->fs / cm->fftLen * 0.25);
+			DREmultUniform[i] = getValueAt(&jdsp->compPch.cb, i * jdsp->fs / cm->fftLen * 0.25);
 		if (!cm->noGridDownsampling)
-			ShrinkGridSpectralInterpolator(cm->octaveSmooth, cm->procUpTo, cm->DREmultUniform, cm->DREmult);
-		else
-			memcpy(cm->DREmult, cm->DREmultUniform, cm->procUpTo * sizeof(float));
-		cm->headRoomdB = 10.0f;
-		if (!cm->noGridDownsampling)
-		{
-			for (int i = 0; i < cm->smallGridSize; i++)
-			{
-				if (cm->DREmult[i] < -1.2)
-					cm->DREmult[i] = -1.2;
-				if (cm->DREmult[i] > 1.2)
-					cm->DREmult[i] = 1.2;
-				if (cm->headRoomdB < cm->DREmult[i] * 12.0f)
-					cm->headRoomdB = cm->DREmult[i] * 12.0f;
-			}
-		}
+			ShrinkGridSpectralInterpolator(cm->octaveSmooth, cm->procUpTo, DREmultUniform, DREmult);
 		else
+			memcpy(DREmult, DREmultUniform, cm->procUpTo * sizeof(float));
+		*headRoomdB = 10.0f;
+		const int len = !cm->noGridDownsampling ? cm->smallGridSize : cm->procUpTo;
+		for (int i = 0; i < len; i++)
 		{
-			for (int i = 0; i < cm->procUpTo; i++)
-			{
-				if (cm->DREmult[i] < -1.2)
-					cm->DREmult[i] = -1.2;
-				if (cm->DREmult[i] > 1.2)
-					cm->DREmult[i] = 1.2;
-				if (cm->headRoomdB < cm->DREmult[i] * 12.0f)
-					cm->headRoomdB = cm->DREmult[i] * 12.0f;
-			}
+			if (DREmult[i] < -1.2)
+				DREmult[i] = -1.2;
+			if (DREmult[i] > 1.2)
+				DREmult[i] = 1.2;
+			if (*headRoomdB < DREmult[i] * 12.0f)
+				*headRoomdB = DREmult[i] * 12.0f;
 		}
 	}
 	else
@@ -1701,12 +1941,12 @@ void CompressorSetGain(JamesDSPLib *jdsp, double *freq, double *gains, char cpy)
 		float avgGain = 0.0f;
 		for (int i = 0; i < DYN_BANDS_GAMMATONE; i++)
 		{
-			cm->DREmult[i] = getValueAt(&cm->pch.cb, cm->gmtFreq[i]);
-			if (cm->DREmult[i] < -1.2)
-				cm->DREmult[i] = -1.2;
-			if (cm->DREmult[i] > 1.2)
-				cm->DREmult[i] = 1.2;
-			avgGain += cm->DREmult[i];
+			DREmult[i] = getValueAt(&jdsp->compPch.cb, cm->gmtFreq[i]);
+			if (DREmult[i] < -1.2)
+				DREmult[i] = -1.2;
+			if (DREmult[i] > 1.2)
+				DREmult[i] = 1.2;
+			avgGain += DREmult[i];
 		}
 		avgGain /= DYN_BANDS_GAMMATONE;
 		const float oX[11] = { -1.2, -0.8, -0.6, -0.4, -0.2, 0.0, 0.2, 0.4, 0.6, 0.8, 1.2 };
@@ -1720,16 +1960,137 @@ void CompressorSetGain(JamesDSPLib *jdsp, double *freq, double *gains, char cpy)
 			rate *= 0.99f;
 		else if (cm->granularity == 3)
 			rate *= 1.0f;
-		cm->alpha = rate / cm->updatePerNSmps;
-		cm->headRoomdB = 10.0f;
+		*alpha = rate / cm->updatePerNSmps;
+		*headRoomdB = 10.0f;
 		for (int i = 0; i < DYN_BANDS_GAMMATONE; i++)
-			if (cm->headRoomdB < cm->DREmult[i] * 12.0f)
-				cm->headRoomdB = cm->DREmult[i] * 12.0f;
+			if (*headRoomdB < DREmult[i] * 12.0f)
+				*headRoomdB = DREmult[i] * 12.0f;
+	}
+}
+// Complete compander for the recorded parameters, built away from the audio thread
+static FFTCompander *CompressorCreate(JamesDSPLib *jdsp)
+{
+	FFTCompander *cm = (FFTCompander *)malloc(sizeof(FFTCompander));
+	if (!cm)
+		return 0;
+	memset(cm, 0, sizeof(FFTCompander));
+	FFTCompanderInit(cm, jdsp->fs, jdsp->compParam.tfresolution, 3, 1.0);
+	cm->fgt_facT = jdsp->compParam.fgt_facT;
+	cm->tfresolution = jdsp->compParam.tfresolution;
+	cm->granularity = jdsp->compParam.granularity;
+	if (cm->tfresolution < 3)
+	{
+		cm->fgt_fac = (float)(1.0 - exp(-1.0 / (cm->fgt_facT * cm->spectralRate)));
+		double avgBW;
+		if (!cm->granularity)
+			avgBW = 1.65;
+		else if (cm->granularity == 1)
+			avgBW = 1.45;
+		else if (cm->granularity == 2)
+			avgBW = 1.2;
+		else if (cm->granularity == 3)
+			avgBW = 1.15;
+		else
+			avgBW = 1.08;
+		FFTCompanderSetavgBW(cm, avgBW);
+	}
+	else if (cm->tfresolution == 3)
+	{
+		cm->fgt_fac = (float)(1.0 - exp(-1.0 / (cm->fgt_facT * jdsp->fs)));
+	}
+	CompressorDesignGain(jdsp, cm, cm->DREmult, &cm->headRoomdB, &cm->alpha);
+	return cm;
+}
+// Publishes a new instance, without rebuild only the gain curve of the committed one when that suffices
+// Returns 0 and keeps the previous state when memory runs out
+static int CompressorCommit(JamesDSPLib *jdsp, char rebuild)
+{
+	CompressorSnapshot *cs = (CompressorSnapshot *)malloc(sizeof(CompressorSnapshot));
+	if (!cs)
+		return 0;
+	cs->hdr.apply = CompressorSnapshotApply;
+	cs->hdr.destroy = CompressorSnapshotDestroy;
+	cs->comp = 0;
+	cs->release = 0;
+	// A pending instance may still be superseded, so the gain curve alone only goes to the playing one
+	if (rebuild || JamesDSPParamPending(jdsp, JDSP_PARAM_COMPRESSOR))
+	{
+		cs->comp = CompressorCreate(jdsp);
+		if (!cs->comp)
+		{
+			free(cs);
+			return 0;
+		}
+	}
+	else
+	{
+		// The audio thread never writes these, entries past the designed range stay as they are
+		memcpy(cs->DREmult, jdsp->comp->DREmult, sizeof(cs->DREmult));
+		cs->alpha = jdsp->comp->alpha;
+		CompressorDesignGain(jdsp, jdsp->comp, cs->DREmult, &cs->headRoomdB, &cs->alpha);
+	}
+	JamesDSPCommitParam(jdsp, JDSP_PARAM_COMPRESSOR, &cs->hdr);
+	jdsp->compCommitted = 1;
+	return 1;
+}
+void CompressorEnable(JamesDSPLib *jdsp, char enable)
+{
+	jdsp_lock(jdsp);
+	// Spectral state only exists while the compressor is in use, rebuilt from the recorded parameters
+	if ((enable && !jdsp->compCommitted) || (jdsp->compForceRefresh && jdsp->compCommitted))
+		CompressorCommit(jdsp, 1);
+	jdsp->compForceRefresh = 0;
+	if (enable && jdsp->compCommitted)
+		jdsp->compEnabled = 1;
+	jdsp_unlock(jdsp);
+}
+void CompressorDisable(JamesDSPLib *jdsp)
+{
+	jdsp->compEnabled = 0;
+	jdsp->compIdleSince = crossPlatformCurTime();
+}
+void CompressorReleaseIdle(JamesDSPLib *jdsp, double now)
+{
+	if (!jdsp->compEnabled && jdsp->compCommitted && now - jdsp->compIdleSince >= jdsp->idleRelease)
+	{
+		// The audio thread may still hold the instance, it comes back through the retire ring
+		CompressorSnapshot *cs = (CompressorSnapshot *)malloc(sizeof(CompressorSnapshot));
+		if (!cs)
+			return;
+		cs->hdr.apply = CompressorSnapshotApply;
+		cs->hdr.destroy = CompressorSnapshotDestroy;
+		cs->comp = 0;
+		cs->release = 1;
+		JamesDSPCommitParam(jdsp, JDSP_PARAM_COMPRESSOR, &cs->hdr);
+		jdsp->compCommitted = 0;
+	}
+}
+void CompressorSetParam(JamesDSPLib *jdsp, float fgt_facT, int granularity, int tfresolution, char forceRefresh)
+{
+	jdsp_lock(jdsp);
+	const int changed = fgt_facT != jdsp->compParam.fgt_facT || tfresolution != jdsp->compParam.tfresolution || granularity != jdsp->compParam.granularity;
+	jdsp->compParam.fgt_facT = fgt_facT;
+	jdsp->compParam.granularity = granularity;
+	jdsp->compParam.tfresolution = tfresolution;
+	if (jdsp->compCommitted && (changed || forceRefresh))
+		CompressorCommit(jdsp, 1);
+	jdsp_unlock(jdsp);
+}
+void CompressorSetGain(JamesDSPLib *jdsp, double *freq, double *gains, char cpy)
+{
+	jdsp_lock(jdsp);
+	if (cpy)
+	{
+		memcpy(jdsp->compParam.freq, freq, NUMPTS_DRS * sizeof(double));
+		memcpy(jdsp->compParam.gains, gains, NUMPTS_DRS * sizeof(double));
 	}
+	if (jdsp->compCommitted)
+		CompressorCommit(jdsp, 0);
+	jdsp_unlock(jdsp);
 }
 void CompressorProcess(JamesDSPLib *jdsp, size_t n)
 {
-	FFTCompander *cm = (FFTCompander *)(&jdsp->comp);
+	FFTCompander *cm = jdsp->comp;
 	if (cm->tfresolution < 3)
 	{
 		unsigned int offset = 0;
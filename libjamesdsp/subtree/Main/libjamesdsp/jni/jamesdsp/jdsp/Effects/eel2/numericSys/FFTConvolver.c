@@ -4,7 +4,6 @@
 #include <float.h>
 #include <math.h>
 #include "../ns-eel.h"
-#include "codelet.h"
 unsigned int upper_power_of_two(unsigned int v)
 {
 	v--;
@@ -15,6 +14,101 @@ unsigned int upper_power_of_two(unsigned int v)
 	v |= v >> 16;
 	return ++v;
 }
+// Every spectrum starts on a 64 byte boundary
+static unsigned int spectrumStride(unsigned int fftComplexSize)
+{
+	return (fftComplexSize + 15) & ~15u;
+}
+// *tables[k] gets pointed at spectrum k of every segment, all tables share the index block owned by *tables[0]
+static void spectrumArenaIndex(float ***tables[], unsigned int perSeg, unsigned int segCount, unsigned int stride, float *arena)
+{
+	float **index = (float**)malloc((size_t)perSeg * segCount * sizeof(float*));
+	for (unsigned int k = 0; k < perSeg; k++)
+	{
+		*tables[k] = index + k * segCount;
+		for (unsigned int i = 0; i < segCount; i++)
+			(*tables[k])[i] = arena + ((size_t)i * perSeg + k) * stride;
+	}
+}
+// One zeroed, 64 byte aligned arena holding perSeg spectra for each of segCount segments, laid out segment after segment
+static float *spectrumArenaAlloc(float ***tables[], unsigned int perSeg, unsigned int segCount, unsigned int stride)
+{
+	const size_t bytes = (size_t)perSeg * segCount * stride * sizeof(float);
+#ifdef _WIN32
+	float *arena = (float*)_aligned_malloc(bytes, 64);
+#else
+	void *mem = 0;
+	if (posix_memalign(&mem, 64, bytes))
+		mem = 0;
+	float *arena = (float*)mem;
+#endif
+	memset(arena, 0, bytes);
+	spectrumArenaIndex(tables, perSeg, segCount, stride, arena);
+	return arena;
+}
+// Points the second path of a two path index at the spectra of the first, the arena then only holds the first path
+static void spectrumArenaAliasPath(float ***tables[], unsigned int segCount)
+{
+	float **index = (float**)realloc(*tables[0], (size_t)4 * segCount * sizeof(float*));
+	memcpy(index + (size_t)2 * segCount, index, (size_t)2 * segCount * sizeof(float*));
+	for (unsigned int k = 0; k < 4; k++)
+		*tables[k] = index + k * segCount;
+}
+// Cache standing in for the IR transforms of the convolvers loaded on this thread
+#ifdef _MSC_VER
+static __declspec(thread) const FFTConvolverSpectrumHook *spectrumHook = 0;
+#else
+static __thread const FFTConvolverSpectrumHook *spectrumHook = 0;
+#endif
+void FFTConvolverSetSpectrumHook(const FFTConvolverSpectrumHook *hook)
+{
+	spectrumHook = hook;
+}
+static int spectrumHookFill(float *arena, unsigned int perSeg, unsigned int segCount, unsigned int stride)
+{
+	if (!spectrumHook)
+		return 0;
+	return spectrumHook->fill(spectrumHook->ctx, arena, (size_t)perSeg * segCount * stride * sizeof(float));
+}
+static void spectrumHookStore(const float *arena, unsigned int perSeg, unsigned int segCount, unsigned int stride)
+{
+	if (spectrumHook)
+		spectrumHook->store(spectrumHook->ctx, arena, (size_t)perSeg * segCount * stride * sizeof(float));
+}
+static void spectrumArenaFree(float *arena, float **index)
+{
+#ifdef _WIN32
+	_aligned_free(arena);
+#else
+	free(arena);
+#endif
+	free(index);
+}
+// Impulse response arena, mapped from the hook when it shares spectra of this layout
+static float *spectrumArenaIR(float ***tables[], unsigned int perSeg, unsigned int segCount, unsigned int stride, FFTConvolverSharedSpectra **shared)
+{
+	*shared = 0;
+	if (spectrumHook && spectrumHook->share)
+	{
+		float *arena = (float*)spectrumHook->share(spectrumHook->ctx, (size_t)perSeg * segCount * stride * sizeof(float), shared);
+		if (arena)
+		{
+			spectrumArenaIndex(tables, perSeg, segCount, stride, arena);
+			return arena;
+		}
+	}
+	return spectrumArenaAlloc(tables, perSeg, segCount, stride);
+}
+static void spectrumArenaFreeIR(float *arena, float **index, FFTConvolverSharedSpectra *shared)
+{
+	if (shared)
+	{
+		shared->release(shared);
+		free(index);
+	}
+	else
+		spectrumArenaFree(arena, index);
+}
 void FFTConvolver1x1Init(FFTConvolver1x1 *conv)
 {
 	conv->bit = 0;
@@ -22,6 +116,9 @@ void FFTConvolver1x1Init(FFTConvolver1x1 *conv)
 	conv->_segSize = 0;
 	conv->_segCount = 0;
 	conv->_fftComplexSize = 0;
+	conv->_inputArena = 0;
+	conv->_irArena = 0;
+	conv->_irShared = 0;
 	conv->_segmentsRe = 0;
 	conv->_segmentsIm = 0;
 	conv->_segmentsIRRe = 0;
@@ -40,6 +137,11 @@ void FFTConvolver2x4x2Init(FFTConvolver2x4x2 *conv)
 	conv->_segSize = 0;
 	conv->_segCount = 0;
 	conv->_fftComplexSize = 0;
+	conv->_inputArena = 0;
+	conv->_irArena = 0;
+	conv->_irShared = 0;
+	conv->_activeSegments = 0;
+	conv->_activeCount = 0;
 	conv->_segmentsReLeft = 0;
 	conv->_segmentsImLeft = 0;
 	conv->_segmentsReRight = 0;
@@ -66,6 +168,11 @@ void FFTConvolver2x2Init(FFTConvolver2x2 *conv)
 	conv->_segSize = 0;
 	conv->_segCount = 0;
 	conv->_fftComplexSize = 0;
+	conv->_inputArena = 0;
+	conv->_irArena = 0;
+	conv->_irShared = 0;
+	conv->_activeSegments = 0;
+	conv->_activeCount = 0;
 	conv->_segmentsReLeft = 0;
 	conv->_segmentsImLeft = 0;
 	conv->_segmentsReRight = 0;
@@ -74,6 +181,7 @@ void FFTConvolver2x2Init(FFTConvolver2x2 *conv)
 	conv->_segmentsLLIRIm = 0;
 	conv->_segmentsRRIRRe = 0;
 	conv->_segmentsRRIRIm = 0;
+	conv->_sharedKernel = 0;
 	conv->_current = 0;
 	conv->_fftBuffer[0] = 0;
 	conv->_inputBuffer[0] = 0;
@@ -88,6 +196,9 @@ void FFTConvolver1x2Init(FFTConvolver1x2 *conv)
 	conv->_segSize = 0;
 	conv->_segCount = 0;
 	conv->_fftComplexSize = 0;
+	conv->_inputArena = 0;
+	conv->_irArena = 0;
+	conv->_irShared = 0;
 	conv->_segmentsRe = 0;
 	conv->_segmentsLLIRRe = 0;
 	conv->_segmentsLLIRIm = 0;
@@ -100,21 +211,39 @@ void FFTConvolver1x2Init(FFTConvolver1x2 *conv)
 	conv->_inputBufferFill = 0;
 	conv->_preMultiplied[0][0] = 0;
 }
+void FFTConvolverNxMInit(FFTConvolverNxM *conv)
+{
+	conv->bit = 0;
+	conv->_inputs = 0;
+	conv->_outputs = 0;
+	conv->_blockSize = 0;
+	conv->_segSize = 0;
+	conv->_segCount = 0;
+	conv->_fftComplexSize = 0;
+	conv->_inputArena = 0;
+	conv->_irArena = 0;
+	conv->_irShared = 0;
+	conv->_activeSegments = 0;
+	conv->_activeCount = 0;
+	conv->_segmentsRe[0] = 0;
+	conv->_segmentsIRRe[0] = 0;
+	conv->_current = 0;
+	conv->_fftBuffer[0] = 0;
+	conv->_inputBuffer[0] = 0;
+	conv->_overlap[0] = 0;
+	conv->_inputBufferFill = 0;
+	conv->_preMultiplied[0][0] = 0;
+	conv->_accumulator[0] = 0;
+}
 void FFTConvolver1x1Free(FFTConvolver1x1 *conv)
 {
 	if (conv->_segmentsRe)
 	{
-		for (unsigned int i = 0; i < conv->_segCount; ++i)
-		{
-			free(conv->_segmentsRe[i]);
-			free(conv->_segmentsIm[i]);
-			free(conv->_segmentsIRRe[i]);
-			free(conv->_segmentsIRIm[i]);
-		}
-		free(conv->_segmentsRe);
-		free(conv->_segmentsIm);
-		free(conv->_segmentsIRRe);
-		free(conv->_segmentsIRIm);
+		spectrumArenaFree(conv->_inputArena, conv->_segmentsRe);
+		spectrumArenaFreeIR(conv->_irArena, conv->_segmentsIRRe, conv->_irShared);
+		conv->_inputArena = 0;
+		conv->_irArena = 0;
+		conv->_irShared = 0;
 		conv->_segmentsRe = 0;
 		conv->_segmentsIm = 0;
 		conv->_segmentsIRRe = 0;
@@ -158,33 +287,11 @@ void FFTConvolver2x4x2Free(FFTConvolver2x4x2 *conv)
 {
 	if (conv->_segmentsReLeft)
 	{
-		for (unsigned int i = 0; i < conv->_segCount; ++i)
-		{
-			free(conv->_segmentsReLeft[i]);
-			free(conv->_segmentsImLeft[i]);
-			free(conv->_segmentsReRight[i]);
-			free(conv->_segmentsImRight[i]);
-			free(conv->_segmentsLLIRRe[i]);
-			free(conv->_segmentsLLIRIm[i]);
-			free(conv->_segmentsLRIRRe[i]);
-			free(conv->_segmentsLRIRIm[i]);
-			free(conv->_segmentsRLIRRe[i]);
-			free(conv->_segmentsRLIRIm[i]);
-			free(conv->_segmentsRRIRRe[i]);
-			free(conv->_segmentsRRIRIm[i]);
-		}
-		free(conv->_segmentsReLeft);
-		free(conv->_segmentsImLeft);
-		free(conv->_segmentsReRight);
-		free(conv->_segmentsImRight);
-		free(conv->_segmentsLLIRRe);
-		free(conv->_segmentsLLIRIm);
-		free(conv->_segmentsLRIRRe);
-		free(conv->_segmentsLRIRIm);
-		free(conv->_segmentsRLIRRe);
-		free(conv->_segmentsRLIRIm);
-		free(conv->_segmentsRRIRRe);
-		free(conv->_segmentsRRIRIm);
+		spectrumArenaFree(conv->_inputArena, conv->_segmentsReLeft);
+		spectrumArenaFreeIR(conv->_irArena, conv->_segmentsLLIRRe, conv->_irShared);
+		conv->_inputArena = 0;
+		conv->_irArena = 0;
+		conv->_irShared = 0;
 		conv->_segmentsReLeft = 0;
 		conv->_segmentsImLeft = 0;
 		conv->_segmentsReRight = 0;
@@ -206,6 +313,9 @@ void FFTConvolver2x4x2Free(FFTConvolver2x4x2 *conv)
 		free(conv->_preMultiplied[1][1]);
 		conv->_preMultiplied[0][0] = 0;
 	}
+	free(conv->_activeSegments);
+	conv->_activeSegments = 0;
+	conv->_activeCount = 0;
 	if (conv->bit)
 	{
 		free(conv->bit);
@@ -242,25 +352,11 @@ void FFTConvolver2x2Free(FFTConvolver2x2 *conv)
 {
 	if (conv->_segmentsReLeft)
 	{
-		for (unsigned int i = 0; i < conv->_segCount; ++i)
-		{
-			free(conv->_segmentsReLeft[i]);
-			free(conv->_segmentsImLeft[i]);
-			free(conv->_segmentsReRight[i]);
-			free(conv->_segmentsImRight[i]);
-			free(conv->_segmentsLLIRRe[i]);
-			free(conv->_segmentsLLIRIm[i]);
-			free(conv->_segmentsRRIRRe[i]);
-			free(conv->_segmentsRRIRIm[i]);
-		}
-		free(conv->_segmentsReLeft);
-		free(conv->_segmentsImLeft);
-		free(conv->_segmentsReRight);
-		free(conv->_segmentsImRight);
-		free(conv->_segmentsLLIRRe);
-		free(conv->_segmentsLLIRIm);
-		free(conv->_segmentsRRIRRe);
-		free(conv->_segmentsRRIRIm);
+		spectrumArenaFree(conv->_inputArena, conv->_segmentsReLeft);
+		spectrumArenaFreeIR(conv->_irArena, conv->_segmentsLLIRRe, conv->_irShared);
+		conv->_inputArena = 0;
+		conv->_irArena = 0;
+		conv->_irShared = 0;
 		conv->_segmentsReLeft = 0;
 		conv->_segmentsImLeft = 0;
 		conv->_segmentsReRight = 0;
@@ -269,6 +365,7 @@ void FFTConvolver2x2Free(FFTConvolver2x2 *conv)
 		conv->_segmentsLLIRIm = 0;
 		conv->_segmentsRRIRRe = 0;
 		conv->_segmentsRRIRIm = 0;
+		conv->_sharedKernel = 0;
 	}
 	if (conv->_preMultiplied[0][0])
 	{
@@ -278,6 +375,9 @@ void FFTConvolver2x2Free(FFTConvolver2x2 *conv)
 		free(conv->_preMultiplied[1][1]);
 		conv->_preMultiplied[0][0] = 0;
 	}
+	free(conv->_activeSegments);
+	conv->_activeSegments = 0;
+	conv->_activeCount = 0;
 	if (conv->bit)
 	{
 		free(conv->bit);
@@ -314,21 +414,11 @@ void FFTConvolver1x2Free(FFTConvolver1x2 *conv)
 {
 	if (conv->_segmentsRe)
 	{
-		for (unsigned int i = 0; i < conv->_segCount; ++i)
-		{
-			free(conv->_segmentsRe[i]);
-			free(conv->_segmentsIm[i]);
-			free(conv->_segmentsLLIRRe[i]);
-			free(conv->_segmentsLLIRIm[i]);
-			free(conv->_segmentsRRIRRe[i]);
-			free(conv->_segmentsRRIRIm[i]);
-		}
-		free(conv->_segmentsRe);
-		free(conv->_segmentsIm);
-		free(conv->_segmentsLLIRRe);
-		free(conv->_segmentsLLIRIm);
-		free(conv->_segmentsRRIRRe);
-		free(conv->_segmentsRRIRIm);
+		spectrumArenaFree(conv->_inputArena, conv->_segmentsRe);
+		spectrumArenaFreeIR(conv->_irArena, conv->_segmentsLLIRRe, conv->_irShared);
+		conv->_inputArena = 0;
+		conv->_irArena = 0;
+		conv->_irShared = 0;
 		conv->_segmentsRe = 0;
 		conv->_segmentsIm = 0;
 		conv->_segmentsLLIRRe = 0;
@@ -374,8 +464,57 @@ void FFTConvolver1x2Free(FFTConvolver1x2 *conv)
 	conv->_current = 0;
 	conv->_inputBufferFill = 0;
 }
+void FFTConvolverNxMFree(FFTConvolverNxM *conv)
+{
+	unsigned int c;
+	if (conv->_segmentsRe[0])
+	{
+		spectrumArenaFree(conv->_inputArena, conv->_segmentsRe[0]);
+		spectrumArenaFreeIR(conv->_irArena, conv->_segmentsIRRe[0], conv->_irShared);
+		conv->_inputArena = 0;
+		conv->_irArena = 0;
+		conv->_irShared = 0;
+		conv->_segmentsRe[0] = 0;
+		conv->_segmentsIRRe[0] = 0;
+	}
+	if (conv->_preMultiplied[0][0])
+	{
+		for (c = 0; c < conv->_outputs; c++)
+		{
+			free(conv->_preMultiplied[c][0]);
+			free(conv->_preMultiplied[c][1]);
+			free(conv->_fftBuffer[c]);
+			free(conv->_overlap[c]);
+		}
+		for (c = 0; c < conv->_inputs; c++)
+			free(conv->_inputBuffer[c]);
+		free(conv->_accumulator[0]);
+		free(conv->_accumulator[1]);
+		conv->_preMultiplied[0][0] = 0;
+		conv->_fftBuffer[0] = 0;
+		conv->_overlap[0] = 0;
+		conv->_inputBuffer[0] = 0;
+		conv->_accumulator[0] = 0;
+	}
+	free(conv->_activeSegments);
+	conv->_activeSegments = 0;
+	conv->_activeCount = 0;
+	if (conv->bit)
+	{
+		free(conv->bit);
+		free(conv->sine);
+		conv->bit = 0;
+	}
+	conv->_inputs = 0;
+	conv->_outputs = 0;
+	conv->_blockSize = 0;
+	conv->_segSize = 0;
+	conv->_segCount = 0;
+	conv->_fftComplexSize = 0;
+	conv->_current = 0;
+	conv->_inputBufferFill = 0;
+}
 extern void fhtbitReversalTbl(unsigned *dst, unsigned int n);
-extern void fhtsinHalfTblFloat(float *dst, unsigned int n);
 int FFTConvolver1x1LoadImpulseResponse(FFTConvolver1x1 *conv, unsigned int blockSize, const float* ir, unsigned int irLen)
 {
 	if (blockSize == 0)
@@ -392,70 +531,29 @@ int FFTConvolver1x1LoadImpulseResponse(FFTConvolver1x1 *conv, unsigned int block
 	conv->_fftComplexSize = (conv->_segSize >> 1) + 1;
 
 	// FFT
-	if (conv->_segSize == 2)
-		conv->fft = DFT2;
-	else if (conv->_segSize == 4)
-		conv->fft = DFT4;
-	else if (conv->_segSize == 8)
-		conv->fft = DFT8;
-	else if (conv->_segSize == 16)
-		conv->fft = DFT16;
-	else if (conv->_segSize == 32)
-		conv->fft = DFT32;
-	else if (conv->_segSize == 64)
-		conv->fft = DFT64;
-	else if (conv->_segSize == 128)
-		conv->fft = DFT128;
-	else if (conv->_segSize == 256)
-		conv->fft = DFT256;
-	else if (conv->_segSize == 512)
-		conv->fft = DFT512;
-	else if (conv->_segSize == 1024)
-		conv->fft = DFT1024;
-	else if (conv->_segSize == 2048)
-		conv->fft = DFT2048;
-	else if (conv->_segSize == 4096)
-		conv->fft = DFT4096;
-	else if (conv->_segSize == 8192)
-		conv->fft = DFT8192;
-	else if (conv->_segSize == 16384)
-		conv->fft = DFT16384;
-	else if (conv->_segSize == 32768)
-		conv->fft = DFT32768;
-	else if (conv->_segSize == 65536)
-		conv->fft = DFT65536;
-	else if (conv->_segSize == 131072)
-		conv->fft = DFT131072;
-	else if (conv->_segSize == 262144)
-		conv->fft = DFT262144;
-	else if (conv->_segSize == 524288)
-		conv->fft = DFT524288;
-	else if (conv->_segSize == 1048576)
-		conv->fft = DFT1048576;
+	conv->fft = realFFTKernel(realFFTSelect(REALFFT_BEST), conv->_segSize);
 	conv->bit = (unsigned int*)malloc(conv->_segSize * sizeof(unsigned int));
 	conv->sine = (float*)malloc(conv->_segSize * sizeof(float));
 	fhtbitReversalTbl(conv->bit, conv->_segSize);
-	fhtsinHalfTblFloat(conv->sine, conv->_segSize);
+	realFFTTable(conv->sine, conv->_segSize);
 	conv->_fftBuffer = (float*)malloc(conv->_segSize * sizeof(float));
 
 	// Prepare segments
-	conv->_segmentsRe = (float**)malloc(conv->_segCount * sizeof(float*));
-	conv->_segmentsIm = (float**)malloc(conv->_segCount * sizeof(float*));
-	for (unsigned int i = 0; i < conv->_segCount; ++i)
 	{
-		conv->_segmentsRe[i] = (float*)malloc(conv->_fftComplexSize * sizeof(float));
-		conv->_segmentsIm[i] = (float*)malloc(conv->_fftComplexSize * sizeof(float));
-		memset(conv->_segmentsRe[i], 0, conv->_fftComplexSize * sizeof(float));
-		memset(conv->_segmentsIm[i], 0, conv->_fftComplexSize * sizeof(float));
+		float ***tables[] = { &conv->_segmentsRe, &conv->_segmentsIm };
+		conv->_inputArena = spectrumArenaAlloc(tables, 2, conv->_segCount, spectrumStride(conv->_fftComplexSize));
 	}
 
 	// Prepare IR
-	conv->_segmentsIRRe = (float**)malloc(conv->_segCount * sizeof(float*));
-	conv->_segmentsIRIm = (float**)malloc(conv->_segCount * sizeof(float*));
-	for (unsigned int i = 0; i < conv->_segCount; ++i)
 	{
-		float* segmentRe = (float*)malloc(conv->_fftComplexSize * sizeof(float));
-		float* segmentIm = (float*)malloc(conv->_fftComplexSize * sizeof(float));
+		float ***tables[] = { &conv->_segmentsIRRe, &conv->_segmentsIRIm };
+		conv->_irArena = spectrumArenaIR(tables, 2, conv->_segCount, spectrumStride(conv->_fftComplexSize), &conv->_irShared);
+	}
+	const int irCached = conv->_irShared || spectrumHookFill(conv->_irArena, 2, conv->_segCount, spectrumStride(conv->_fftComplexSize));
+	for (unsigned int i = 0; i < conv->_segCount && !irCached; ++i)
+	{
+		float* segmentRe = conv->_segmentsIRRe[i];
+		float* segmentIm = conv->_segmentsIRIm[i];
 		const unsigned int remaining = irLen - (i * conv->_blockSize);
 		const unsigned int sizeCopy = (remaining >= conv->_blockSize) ? conv->_blockSize : remaining;
 		for (unsigned int j = 0; j < sizeCopy; j++)
@@ -471,9 +569,9 @@ int FFTConvolver1x1LoadImpulseResponse(FFTConvolver1x1 *conv, unsigned int block
 			segmentRe[j] = conv->_fftBuffer[j] + conv->_fftBuffer[symIdx];
 			segmentIm[j] = conv->_fftBuffer[j] - conv->_fftBuffer[symIdx];
 		}
-		conv->_segmentsIRRe[i] = segmentRe;
-		conv->_segmentsIRIm[i] = segmentIm;
 	}
+	if (!irCached)
+		spectrumHookStore(conv->_irArena, 2, conv->_segCount, spectrumStride(conv->_fftComplexSize));
 
 	// Prepare convolution buffers
 	conv->_preMultiplied[0] = (float*)malloc(conv->_fftComplexSize * sizeof(float));
@@ -491,6 +589,7 @@ int FFTConvolver1x1LoadImpulseResponse(FFTConvolver1x1 *conv, unsigned int block
 	// Reset current position
 	conv->_current = 0;
 	conv->gain = 1.0f / ((float)conv->_segSize * 2.0f);
+	conv->mac = spectralMACSelect(SPECTRALMAC_BEST);
 	return 1;
 }
 int FFTConvolver1x1RefreshImpulseResponse(FFTConvolver1x1 *conv, unsigned int blockSize, const float* ir, unsigned int irLen)
@@ -539,84 +638,31 @@ int FFTConvolver2x4x2LoadImpulseResponse(FFTConvolver2x4x2 *conv, unsigned int b
 	conv->_fftComplexSize = (conv->_segSize >> 1) + 1;
 
 	// FFT
-	if (conv->_segSize == 2)
-		conv->fft = DFT2;
-	else if (conv->_segSize == 4)
-		conv->fft = DFT4;
-	else if (conv->_segSize == 8)
-		conv->fft = DFT8;
-	else if (conv->_segSize == 16)
-		conv->fft = DFT16;
-	else if (conv->_segSize == 32)
-		conv->fft = DFT32;
-	else if (conv->_segSize == 64)
-		conv->fft = DFT64;
-	else if (conv->_segSize == 128)
-		conv->fft = DFT128;
-	else if (conv->_segSize == 256)
-		conv->fft = DFT256;
-	else if (conv->_segSize == 512)
-		conv->fft = DFT512;
-	else if (conv->_segSize == 1024)
-		conv->fft = DFT1024;
-	else if (conv->_segSize == 2048)
-		conv->fft = DFT2048;
-	else if (conv->_segSize == 4096)
-		conv->fft = DFT4096;
-	else if (conv->_segSize == 8192)
-		conv->fft = DFT8192;
-	else if (conv->_segSize == 16384)
-		conv->fft = DFT16384;
-	else if (conv->_segSize == 32768)
-		conv->fft = DFT32768;
-	else if (conv->_segSize == 65536)
-		conv->fft = DFT65536;
-	else if (conv->_segSize == 131072)
-		conv->fft = DFT131072;
-	else if (conv->_segSize == 262144)
-		conv->fft = DFT262144;
-	else if (conv->_segSize == 524288)
-		conv->fft = DFT524288;
-	else if (conv->_segSize == 1048576)
-		conv->fft = DFT1048576;
+	conv->fft = realFFTKernel(realFFTSelect(REALFFT_BEST), conv->_segSize);
 	conv->bit = (unsigned int*)malloc(conv->_segSize * sizeof(unsigned int));
 	conv->sine = (float*)malloc(conv->_segSize * sizeof(float));
 	fhtbitReversalTbl(conv->bit, conv->_segSize);
-	fhtsinHalfTblFloat(conv->sine, conv->_segSize);
+	realFFTTable(conv->sine, conv->_segSize);
 	conv->_fftBuffer[0] = (float*)malloc(conv->_segSize * sizeof(float));
 	conv->_fftBuffer[1] = (float*)malloc(conv->_segSize * sizeof(float));
 
 	// Prepare segments
-	conv->_segmentsReLeft = (float**)malloc(conv->_segCount * sizeof(float*));
-	conv->_segmentsImLeft = (float**)malloc(conv->_segCount * sizeof(float*));
-	conv->_segmentsReRight = (float**)malloc(conv->_segCount * sizeof(float*));
-	conv->_segmentsImRight = (float**)malloc(conv->_segCount * sizeof(float*));
-	for (unsigned int i = 0; i < conv->_segCount; ++i)
 	{
-		conv->_segmentsReLeft[i] = (float*)malloc(conv->_fftComplexSize * sizeof(float));
-		conv->_segmentsImLeft[i] = (float*)malloc(conv->_fftComplexSize * sizeof(float));
-		memset(conv->_segmentsReLeft[i], 0, conv->_fftComplexSize * sizeof(float));
-		memset(conv->_segmentsImLeft[i], 0, conv->_fftComplexSize * sizeof(float));
-		conv->_segmentsReRight[i] = (float*)malloc(conv->_fftComplexSize * sizeof(float));
-		conv->_segmentsImRight[i] = (float*)malloc(conv->_fftComplexSize * sizeof(float));
-		memset(conv->_segmentsReRight[i], 0, conv->_fftComplexSize * sizeof(float));
-		memset(conv->_segmentsImRight[i], 0, conv->_fftComplexSize * sizeof(float));
+		float ***tables[] = { &conv->_segmentsReLeft, &conv->_segmentsImLeft, &conv->_segmentsReRight, &conv->_segmentsImRight };
+		conv->_inputArena = spectrumArenaAlloc(tables, 4, conv->_segCount, spectrumStride(conv->_fftComplexSize));
 	}
 
 	// Prepare IR
-	conv->_segmentsLLIRRe = (float**)malloc(conv->_segCount * sizeof(float*));
-	conv->_segmentsLLIRIm = (float**)malloc(conv->_segCount * sizeof(float*));
-	conv->_segmentsLRIRRe = (float**)malloc(conv->_segCount * sizeof(float*));
-	conv->_segmentsLRIRIm = (float**)malloc(conv->_segCount * sizeof(float*));
-	conv->_segmentsRLIRRe = (float**)malloc(conv->_segCount * sizeof(float*));
-	conv->_segmentsRLIRIm = (float**)malloc(conv->_segCount * sizeof(float*));
-	conv->_segmentsRRIRRe = (float**)malloc(conv->_segCount * sizeof(float*));
-	conv->_segmentsRRIRIm = (float**)malloc(conv->_segCount * sizeof(float*));
-	for (unsigned int i = 0; i < conv->_segCount; ++i)
+	{
+		float ***tables[] = { &conv->_segmentsLLIRRe, &conv->_segmentsLLIRIm, &conv->_segmentsLRIRRe, &conv->_segmentsLRIRIm, &conv->_segmentsRLIRRe, &conv->_segmentsRLIRIm, &conv->_segmentsRRIRRe, &conv->_segmentsRRIRIm };
+		conv->_irArena = spectrumArenaIR(tables, 8, conv->_segCount, spectrumStride(conv->_fftComplexSize), &conv->_irShared);
+	}
+	const int irCached = conv->_irShared || spectrumHookFill(conv->_irArena, 8, conv->_segCount, spectrumStride(conv->_fftComplexSize));
+	for (unsigned int i = 0; i < conv->_segCount && !irCached; ++i)
 	{
 		unsigned int j, symIdx;
-		float* segmentLLRe = (float*)malloc(conv->_fftComplexSize * sizeof(float));
-		float* segmentLLIm = (float*)malloc(conv->_fftComplexSize * sizeof(float));
+		float* segmentLLRe = conv->_segmentsLLIRRe[i];
+		float* segmentLLIm = conv->_segmentsLLIRIm[i];
 		unsigned int remaining = irLen - (i * conv->_blockSize);
 		unsigned int sizeCopy = (remaining >= conv->_blockSize) ? conv->_blockSize : remaining;
 		for (j = 0; j < sizeCopy; j++)
@@ -632,11 +678,9 @@ int FFTConvolver2x4x2LoadImpulseResponse(FFTConvolver2x4x2 *conv, unsigned int b
 			segmentLLRe[j] = conv->_fftBuffer[0][j] + conv->_fftBuffer[0][symIdx];
 			segmentLLIm[j] = conv->_fftBuffer[0][j] - conv->_fftBuffer[0][symIdx];
 		}
-		conv->_segmentsLLIRRe[i] = segmentLLRe;
-		conv->_segmentsLLIRIm[i] = segmentLLIm;
 		//
-		float* segmentLRRe = (float*)malloc(conv->_fftComplexSize * sizeof(float));
-		float* segmentLRIm = (float*)malloc(conv->_fftComplexSize * sizeof(float));
+		float* segmentLRRe = conv->_segmentsLRIRRe[i];
+		float* segmentLRIm = conv->_segmentsLRIRIm[i];
 		remaining = irLen - (i * conv->_blockSize);
 		sizeCopy = (remaining >= conv->_blockSize) ? conv->_blockSize : remaining;
 		for (j = 0; j < sizeCopy; j++)
@@ -652,11 +696,9 @@ int FFTConvolver2x4x2LoadImpulseResponse(FFTConvolver2x4x2 *conv, unsigned int b
 			segmentLRRe[j] = conv->_fftBuffer[0][j] + conv->_fftBuffer[0][symIdx];
 			segmentLRIm[j] = conv->_fftBuffer[0][j] - conv->_fftBuffer[0][symIdx];
 		}
-		conv->_segmentsLRIRRe[i] = segmentLRRe;
-		conv->_segmentsLRIRIm[i] = segmentLRIm;
 		//
-		float* segmentRLRe = (float*)malloc(conv->_fftComplexSize * sizeof(float));
-		float* segmentRLIm = (float*)malloc(conv->_fftComplexSize * sizeof(float));
+		float* segmentRLRe = conv->_segmentsRLIRRe[i];
+		float* segmentRLIm = conv->_segmentsRLIRIm[i];
 		remaining = irLen - (i * conv->_blockSize);
 		sizeCopy = (remaining >= conv->_blockSize) ? conv->_blockSize : remaining;
 		for (j = 0; j < sizeCopy; j++)
@@ -672,11 +714,9 @@ int FFTConvolver2x4x2LoadImpulseResponse(FFTConvolver2x4x2 *conv, unsigned int b
 			segmentRLRe[j] = conv->_fftBuffer[0][j] + conv->_fftBuffer[0][symIdx];
 			segmentRLIm[j] = conv->_fftBuffer[0][j] - conv->_fftBuffer[0][symIdx];
 		}
-		conv->_segmentsRLIRRe[i] = segmentRLRe;
-		conv->_segmentsRLIRIm[i] = segmentRLIm;
 		//
-		float* segmentRRRe = (float*)malloc(conv->_fftComplexSize * sizeof(float));
-		float* segmentRRIm = (float*)malloc(conv->_fftComplexSize * sizeof(float));
+		float* segmentRRRe = conv->_segmentsRRIRRe[i];
+		float* segmentRRIm = conv->_segmentsRRIRIm[i];
 		remaining = irLen - (i * conv->_blockSize);
 		sizeCopy = (remaining >= conv->_blockSize) ? conv->_blockSize : remaining;
 		for (j = 0; j < sizeCopy; j++)
@@ -692,9 +732,9 @@ int FFTConvolver2x4x2LoadImpulseResponse(FFTConvolver2x4x2 *conv, unsigned int b
 			segmentRRRe[j] = conv->_fftBuffer[0][j] + conv->_fftBuffer[0][symIdx];
 			segmentRRIm[j] = conv->_fftBuffer[0][j] - conv->_fftBuffer[0][symIdx];
 		}
-		conv->_segmentsRRIRRe[i] = segmentRRRe;
-		conv->_segmentsRRIRIm[i] = segmentRRIm;
 	}
+	if (!irCached)
+		spectrumHookStore(conv->_irArena, 8, conv->_segCount, spectrumStride(conv->_fftComplexSize));
 
 	// Prepare convolution buffers
 	conv->_preMultiplied[0][0] = (float*)malloc(conv->_fftComplexSize * sizeof(float));
@@ -720,6 +760,7 @@ int FFTConvolver2x4x2LoadImpulseResponse(FFTConvolver2x4x2 *conv, unsigned int b
 	// Reset current position
 	conv->_current = 0;
 	conv->gain = 1.0f / ((float)conv->_segSize * 2.0f);
+	conv->mac = spectralMACSelect(SPECTRALMAC_BEST);
 	return 1;
 }
 int FFTConvolver2x2LoadImpulseResponse(FFTConvolver2x2 *conv, unsigned int blockSize, const float* irL, const float* irR, unsigned int irLen)
@@ -739,80 +780,35 @@ int FFTConvolver2x2LoadImpulseResponse(FFTConvolver2x2 *conv, unsigned int block
 	conv->_fftComplexSize = (conv->_segSize >> 1) + 1;
 
 	// FFT
-	if (conv->_segSize == 2)
-		conv->fft = DFT2;
-	else if (conv->_segSize == 4)
-		conv->fft = DFT4;
-	else if (conv->_segSize == 8)
-		conv->fft = DFT8;
-	else if (conv->_segSize == 16)
-		conv->fft = DFT16;
-	else if (conv->_segSize == 32)
-		conv->fft = DFT32;
-	else if (conv->_segSize == 64)
-		conv->fft = DFT64;
-	else if (conv->_segSize == 128)
-		conv->fft = DFT128;
-	else if (conv->_segSize == 256)
-		conv->fft = DFT256;
-	else if (conv->_segSize == 512)
-		conv->fft = DFT512;
-	else if (conv->_segSize == 1024)
-		conv->fft = DFT1024;
-	else if (conv->_segSize == 2048)
-		conv->fft = DFT2048;
-	else if (conv->_segSize == 4096)
-		conv->fft = DFT4096;
-	else if (conv->_segSize == 8192)
-		conv->fft = DFT8192;
-	else if (conv->_segSize == 16384)
-		conv->fft = DFT16384;
-	else if (conv->_segSize == 32768)
-		conv->fft = DFT32768;
-	else if (conv->_segSize == 65536)
-		conv->fft = DFT65536;
-	else if (conv->_segSize == 131072)
-		conv->fft = DFT131072;
-	else if (conv->_segSize == 262144)
-		conv->fft = DFT262144;
-	else if (conv->_segSize == 524288)
-		conv->fft = DFT524288;
-	else if (conv->_segSize == 1048576)
-		conv->fft = DFT1048576;
+	conv->fft = realFFTKernel(realFFTSelect(REALFFT_BEST), conv->_segSize);
 	conv->bit = (unsigned int*)malloc(conv->_segSize * sizeof(unsigned int));
 	conv->sine = (float*)malloc(conv->_segSize * sizeof(float));
 	fhtbitReversalTbl(conv->bit, conv->_segSize);
-	fhtsinHalfTblFloat(conv->sine, conv->_segSize);
+	realFFTTable(conv->sine, conv->_segSize);
 	conv->_fftBuffer[0] = (float*)malloc(conv->_segSize * sizeof(float));
 	conv->_fftBuffer[1] = (float*)malloc(conv->_segSize * sizeof(float));
 
 	// Prepare segments
-	conv->_segmentsReLeft = (float**)malloc(conv->_segCount * sizeof(float*));
-	conv->_segmentsImLeft = (float**)malloc(conv->_segCount * sizeof(float*));
-	conv->_segmentsReRight = (float**)malloc(conv->_segCount * sizeof(float*));
-	conv->_segmentsImRight = (float**)malloc(conv->_segCount * sizeof(float*));
-	for (unsigned int i = 0; i < conv->_segCount; ++i)
 	{
-		conv->_segmentsReLeft[i] = (float*)malloc(conv->_fftComplexSize * sizeof(float));
-		conv->_segmentsImLeft[i] = (float*)malloc(conv->_fftComplexSize * sizeof(float));
-		memset(conv->_segmentsReLeft[i], 0, conv->_fftComplexSize * sizeof(float));
-		memset(conv->_segmentsImLeft[i], 0, conv->_fftComplexSize * sizeof(float));
-		conv->_segmentsReRight[i] = (float*)malloc(conv->_fftComplexSize * sizeof(float));
-		conv->_segmentsImRight[i] = (float*)malloc(conv->_fftComplexSize * sizeof(float));
-		memset(conv->_segmentsReRight[i], 0, conv->_fftComplexSize * sizeof(float));
-		memset(conv->_segmentsImRight[i], 0, conv->_fftComplexSize * sizeof(float));
+		float ***tables[] = { &conv->_segmentsReLeft, &conv->_segmentsImLeft, &conv->_segmentsReRight, &conv->_segmentsImRight };
+		conv->_inputArena = spectrumArenaAlloc(tables, 4, conv->_segCount, spectrumStride(conv->_fftComplexSize));
 	}
 
-	// Prepare IR
-	conv->_segmentsLLIRRe = (float**)malloc(conv->_segCount * sizeof(float*));
-	conv->_segmentsLLIRIm = (float**)malloc(conv->_segCount * sizeof(float*));
-	conv->_segmentsRRIRRe = (float**)malloc(conv->_segCount * sizeof(float*));
-	conv->_segmentsRRIRIm = (float**)malloc(conv->_segCount * sizeof(float*));
-	for (unsigned int i = 0; i < conv->_segCount; ++i)
+	// Prepare IR, both channels multiply the same spectra when they share the kernel
+	conv->_sharedKernel = irL == irR;
+	const unsigned int irPerSeg = conv->_sharedKernel ? 2 : 4;
+	{
+		float ***tables[] = { &conv->_segmentsLLIRRe, &conv->_segmentsLLIRIm, &conv->_segmentsRRIRRe, &conv->_segmentsRRIRIm };
+		conv->_irArena = spectrumArenaIR(tables, irPerSeg, conv->_segCount, spectrumStride(conv->_fftComplexSize), &conv->_irShared);
+		if (conv->_sharedKernel)
+			spectrumArenaAliasPath(tables, conv->_segCount);
+	}
+	const int irCached = conv->_irShared || spectrumHookFill(conv->_irArena, irPerSeg, conv->_segCount, spectrumStride(conv->_fftComplexSize));
+	for (unsigned int i = 0; i < conv->_segCount && !irCached; ++i)
 	{
 		unsigned int j, symIdx;
-		float* segmentLLRe = (float*)malloc(conv->_fftComplexSize * sizeof(float));
-		float* segmentLLIm = (float*)malloc(conv->_fftComplexSize * sizeof(float));
+		float* segmentLLRe = conv->_segmentsLLIRRe[i];
+		float* segmentLLIm = conv->_segmentsLLIRIm[i];
 		unsigned int remaining = irLen - (i * conv->_blockSize);
 		unsigned int sizeCopy = (remaining >= conv->_blockSize) ? conv->_blockSize : remaining;
 		for (j = 0; j < sizeCopy; j++)
@@ -828,11 +824,10 @@ int FFTConvolver2x2LoadImpulseResponse(FFTConvolver2x2 *conv, unsigned int block
 			segmentLLRe[j] = conv->_fftBuffer[0][j] + conv->_fftBuffer[0][symIdx];
 			segmentLLIm[j] = conv->_fftBuffer[0][j] - conv->_fftBuffer[0][symIdx];
 		}
-		conv->_segmentsLLIRRe[i] = segmentLLRe;
-		conv->_segmentsLLIRIm[i] = segmentLLIm;
-		//
-		float* segmentRRRe = (float*)malloc(conv->_fftComplexSize * sizeof(float));
-		float* segmentRRIm = (float*)malloc(conv->_fftComplexSize * sizeof(float));
+		if (conv->_sharedKernel)
+			continue;
+		float* segmentRRRe = conv->_segmentsRRIRRe[i];
+		float* segmentRRIm = conv->_segmentsRRIRIm[i];
 		remaining = irLen - (i * conv->_blockSize);
 		sizeCopy = (remaining >= conv->_blockSize) ? conv->_blockSize : remaining;
 		for (j = 0; j < sizeCopy; j++)
@@ -848,9 +843,9 @@ int FFTConvolver2x2LoadImpulseResponse(FFTConvolver2x2 *conv, unsigned int block
 			segmentRRRe[j] = conv->_fftBuffer[0][j] + conv->_fftBuffer[0][symIdx];
 			segmentRRIm[j] = conv->_fftBuffer[0][j] - conv->_fftBuffer[0][symIdx];
 		}
-		conv->_segmentsRRIRRe[i] = segmentRRRe;
-		conv->_segmentsRRIRIm[i] = segmentRRIm;
 	}
+	if (!irCached)
+		spectrumHookStore(conv->_irArena, irPerSeg, conv->_segCount, spectrumStride(conv->_fftComplexSize));
 
 	// Prepare convolution buffers
 	conv->_preMultiplied[0][0] = (float*)malloc(conv->_fftComplexSize * sizeof(float));
@@ -876,10 +871,15 @@ int FFTConvolver2x2LoadImpulseResponse(FFTConvolver2x2 *conv, unsigned int block
 	// Reset current position
 	conv->_current = 0;
 	conv->gain = 1.0f / ((float)conv->_segSize * 2.0f);
+	conv->mac = spectralMACSelect(SPECTRALMAC_BEST);
 	return 1;
 }
 void FFTConvolver2x2RefreshImpulseResponse(FFTConvolver2x2 *conv1, FFTConvolver2x2 *conv2, const float* irL, const float* irR, unsigned int irLen)
 {
+	// Partitions skipped for the previous spectra may not be silent anymore
+	free(conv2->_activeSegments);
+	conv2->_activeSegments = 0;
+	conv2->_activeCount = 0;
 	for (unsigned int i = 0; i < conv1->_segCount; ++i)
 	{
 		unsigned int j, symIdx;
@@ -901,7 +901,8 @@ void FFTConvolver2x2RefreshImpulseResponse(FFTConvolver2x2 *conv1, FFTConvolver2
 			segmentLLRe[j] = conv1->_fftBuffer[0][j] + conv1->_fftBuffer[0][symIdx];
 			segmentLLIm[j] = conv1->_fftBuffer[0][j] - conv1->_fftBuffer[0][symIdx];
 		}
-		//
+		if (conv2->_sharedKernel)
+			continue;
 		float* segmentRRRe = conv2->_segmentsRRIRRe[i];
 		float* segmentRRIm = conv2->_segmentsRRIRIm[i];
 		remaining = irLen - (i * conv1->_blockSize);
@@ -921,6 +922,63 @@ void FFTConvolver2x2RefreshImpulseResponse(FFTConvolver2x2 *conv1, FFTConvolver2
 		}
 	}
 }
+void FFTConvolver2x2Reset(FFTConvolver2x2 *conv)
+{
+	if (!conv->_segmentsReLeft)
+		return;
+	memset(conv->_inputArena, 0, (size_t)4 * conv->_segCount * spectrumStride(conv->_fftComplexSize) * sizeof(float));
+	for (int i = 0; i < 2; i++)
+	{
+		memset(conv->_preMultiplied[i][0], 0, conv->_fftComplexSize * sizeof(float));
+		memset(conv->_preMultiplied[i][1], 0, conv->_fftComplexSize * sizeof(float));
+		memset(conv->_overlap[i], 0, conv->_blockSize * sizeof(float));
+		memset(conv->_inputBuffer[i], 0, conv->_blockSize * sizeof(float));
+	}
+	conv->_inputBufferFill = 0;
+	conv->_current = 0;
+}
+int FFTConvolver2x2ExchangeImpulseResponse(FFTConvolver2x2 *conv1, FFTConvolver2x2 *conv2)
+{
+	if (conv1->_blockSize == conv2->_blockSize && conv1->_segCount == conv2->_segCount)
+	{
+		float **tmp;
+		tmp = conv1->_segmentsLLIRRe;
+		conv1->_segmentsLLIRRe = conv2->_segmentsLLIRRe;
+		conv2->_segmentsLLIRRe = tmp;
+		tmp = conv1->_segmentsLLIRIm;
+		conv1->_segmentsLLIRIm = conv2->_segmentsLLIRIm;
+		conv2->_segmentsLLIRIm = tmp;
+		tmp = conv1->_segmentsRRIRRe;
+		conv1->_segmentsRRIRRe = conv2->_segmentsRRIRRe;
+		conv2->_segmentsRRIRRe = tmp;
+		tmp = conv1->_segmentsRRIRIm;
+		conv1->_segmentsRRIRIm = conv2->_segmentsRRIRIm;
+		conv2->_segmentsRRIRIm = tmp;
+		float *arena = conv1->_irArena;
+		conv1->_irArena = conv2->_irArena;
+		conv2->_irArena = arena;
+		FFTConvolverSharedSpectra *shared = conv1->_irShared;
+		conv1->_irShared = conv2->_irShared;
+		conv2->_irShared = shared;
+		unsigned int *active = conv1->_activeSegments;
+		conv1->_activeSegments = conv2->_activeSegments;
+		conv2->_activeSegments = active;
+		unsigned int activeCount = conv1->_activeCount;
+		conv1->_activeCount = conv2->_activeCount;
+		conv2->_activeCount = activeCount;
+		int sharedKernel = conv1->_sharedKernel;
+		conv1->_sharedKernel = conv2->_sharedKernel;
+		conv2->_sharedKernel = sharedKernel;
+		return 1;
+	}
+	else
+	{
+		FFTConvolver2x2 tmp = *conv1;
+		*conv1 = *conv2;
+		*conv2 = tmp;
+		return 0;
+	}
+}
 int FFTConvolver1x2LoadImpulseResponse(FFTConvolver1x2 *conv, unsigned int blockSize, const float* irL, const float* irR, unsigned int irLen)
 {
 	if (blockSize == 0)
@@ -938,74 +996,31 @@ int FFTConvolver1x2LoadImpulseResponse(FFTConvolver1x2 *conv, unsigned int block
 	conv->_fftComplexSize = (conv->_segSize >> 1) + 1;
 
 	// FFT
-	if (conv->_segSize == 2)
-		conv->fft = DFT2;
-	else if (conv->_segSize == 4)
-		conv->fft = DFT4;
-	else if (conv->_segSize == 8)
-		conv->fft = DFT8;
-	else if (conv->_segSize == 16)
-		conv->fft = DFT16;
-	else if (conv->_segSize == 32)
-		conv->fft = DFT32;
-	else if (conv->_segSize == 64)
-		conv->fft = DFT64;
-	else if (conv->_segSize == 128)
-		conv->fft = DFT128;
-	else if (conv->_segSize == 256)
-		conv->fft = DFT256;
-	else if (conv->_segSize == 512)
-		conv->fft = DFT512;
-	else if (conv->_segSize == 1024)
-		conv->fft = DFT1024;
-	else if (conv->_segSize == 2048)
-		conv->fft = DFT2048;
-	else if (conv->_segSize == 4096)
-		conv->fft = DFT4096;
-	else if (conv->_segSize == 8192)
-		conv->fft = DFT8192;
-	else if (conv->_segSize == 16384)
-		conv->fft = DFT16384;
-	else if (conv->_segSize == 32768)
-		conv->fft = DFT32768;
-	else if (conv->_segSize == 65536)
-		conv->fft = DFT65536;
-	else if (conv->_segSize == 131072)
-		conv->fft = DFT131072;
-	else if (conv->_segSize == 262144)
-		conv->fft = DFT262144;
-	else if (conv->_segSize == 524288)
-		conv->fft = DFT524288;
-	else if (conv->_segSize == 1048576)
-		conv->fft = DFT1048576;
+	conv->fft = realFFTKernel(realFFTSelect(REALFFT_BEST), conv->_segSize);
 	conv->bit = (unsigned int*)malloc(conv->_segSize * sizeof(unsigned int));
 	conv->sine = (float*)malloc(conv->_segSize * sizeof(float));
 	fhtbitReversalTbl(conv->bit, conv->_segSize);
-	fhtsinHalfTblFloat(conv->sine, conv->_segSize);
+	realFFTTable(conv->sine, conv->_segSize);
 	conv->_fftBuffer[0] = (float*)malloc(conv->_segSize * sizeof(float));
 	conv->_fftBuffer[1] = (float*)malloc(conv->_segSize * sizeof(float));
 
 	// Prepare segments
-	conv->_segmentsRe = (float**)malloc(conv->_segCount * sizeof(float*));
-	conv->_segmentsIm = (float**)malloc(conv->_segCount * sizeof(float*));
-	for (unsigned int i = 0; i < conv->_segCount; ++i)
 	{
-		conv->_segmentsRe[i] = (float*)malloc(conv->_fftComplexSize * sizeof(float));
-		conv->_segmentsIm[i] = (float*)malloc(conv->_fftComplexSize * sizeof(float));
-		memset(conv->_segmentsRe[i], 0, conv->_fftComplexSize * sizeof(float));
-		memset(conv->_segmentsIm[i], 0, conv->_fftComplexSize * sizeof(float));
+		float ***tables[] = { &conv->_segmentsRe, &conv->_segmentsIm };
+		conv->_inputArena = spectrumArenaAlloc(tables, 2, conv->_segCount, spectrumStride(conv->_fftComplexSize));
 	}
 
 	// Prepare IR
-	conv->_segmentsLLIRRe = (float**)malloc(conv->_segCount * sizeof(float*));
-	conv->_segmentsLLIRIm = (float**)malloc(conv->_segCount * sizeof(float*));
-	conv->_segmentsRRIRRe = (float**)malloc(conv->_segCount * sizeof(float*));
-	conv->_segmentsRRIRIm = (float**)malloc(conv->_segCount * sizeof(float*));
-	for (unsigned int i = 0; i < conv->_segCount; ++i)
+	{
+		float ***tables[] = { &conv->_segmentsLLIRRe, &conv->_segmentsLLIRIm, &conv->_segmentsRRIRRe, &conv->_segmentsRRIRIm };
+		conv->_irArena = spectrumArenaIR(tables, 4, conv->_segCount, spectrumStride(conv->_fftComplexSize), &conv->_irShared);
+	}
+	const int irCached = conv->_irShared || spectrumHookFill(conv->_irArena, 4, conv->_segCount, spectrumStride(conv->_fftComplexSize));
+	for (unsigned int i = 0; i < conv->_segCount && !irCached; ++i)
 	{
 		unsigned int j, symIdx;
-		float* segmentLLRe = (float*)malloc(conv->_fftComplexSize * sizeof(float));
-		float* segmentLLIm = (float*)malloc(conv->_fftComplexSize * sizeof(float));
+		float* segmentLLRe = conv->_segmentsLLIRRe[i];
+		float* segmentLLIm = conv->_segmentsLLIRIm[i];
 		unsigned int remaining = irLen - (i * conv->_blockSize);
 		unsigned int sizeCopy = (remaining >= conv->_blockSize) ? conv->_blockSize : remaining;
 		for (j = 0; j < sizeCopy; j++)
@@ -1021,11 +1036,9 @@ int FFTConvolver1x2LoadImpulseResponse(FFTConvolver1x2 *conv, unsigned int block
 			segmentLLRe[j] = conv->_fftBuffer[0][j] + conv->_fftBuffer[0][symIdx];
 			segmentLLIm[j] = conv->_fftBuffer[0][j] - conv->_fftBuffer[0][symIdx];
 		}
-		conv->_segmentsLLIRRe[i] = segmentLLRe;
-		conv->_segmentsLLIRIm[i] = segmentLLIm;
 		//
-		float* segmentRRRe = (float*)malloc(conv->_fftComplexSize * sizeof(float));
-		float* segmentRRIm = (float*)malloc(conv->_fftComplexSize * sizeof(float));
+		float* segmentRRRe = conv->_segmentsRRIRRe[i];
+		float* segmentRRIm = conv->_segmentsRRIRIm[i];
 		remaining = irLen - (i * conv->_blockSize);
 		sizeCopy = (remaining >= conv->_blockSize) ? conv->_blockSize : remaining;
 		for (j = 0; j < sizeCopy; j++)
@@ -1041,9 +1054,9 @@ int FFTConvolver1x2LoadImpulseResponse(FFTConvolver1x2 *conv, unsigned int block
 			segmentRRRe[j] = conv->_fftBuffer[0][j] + conv->_fftBuffer[0][symIdx];
 			segmentRRIm[j] = conv->_fftBuffer[0][j] - conv->_fftBuffer[0][symIdx];
 		}
-		conv->_segmentsRRIRRe[i] = segmentRRRe;
-		conv->_segmentsRRIRIm[i] = segmentRRIm;
 	}
+	if (!irCached)
+		spectrumHookStore(conv->_irArena, 4, conv->_segCount, spectrumStride(conv->_fftComplexSize));
 
 	// Prepare convolution buffers
 	conv->_preMultiplied[0][0] = (float*)malloc(conv->_fftComplexSize * sizeof(float));
@@ -1067,8 +1080,225 @@ int FFTConvolver1x2LoadImpulseResponse(FFTConvolver1x2 *conv, unsigned int block
 	// Reset current position
 	conv->_current = 0;
 	conv->gain = 1.0f / ((float)conv->_segSize * 2.0f);
+	conv->mac = spectralMACSelect(SPECTRALMAC_BEST);
 	return 1;
 }
+int FFTConvolverNxMLoadImpulseResponse(FFTConvolverNxM *conv, unsigned int blockSize, unsigned int inputs, unsigned int outputs, const float *const *ir, unsigned int irLen)
+{
+	unsigned int i, j, c, symIdx;
+	if (blockSize == 0)
+		return 0;
+	if (irLen == 0)
+		return 0;
+	if (!inputs || inputs > FFTCONVOLVER_MAX_CHANNELS || !outputs || outputs > FFTCONVOLVER_MAX_CHANNELS)
+		return 0;
+
+	if (conv->bit)
+		FFTConvolverNxMFree(conv);
+
+	conv->_inputs = inputs;
+	conv->_outputs = outputs;
+	conv->_blockSize = upper_power_of_two(blockSize);
+	conv->_segSize = 2 * conv->_blockSize;
+	conv->_segCount = (unsigned int)ceil((double)irLen / (double)conv->_blockSize);
+	conv->_segCountMinus1 = conv->_segCount - 1;
+	conv->_fftComplexSize = (conv->_segSize >> 1) + 1;
+
+	// FFT
+	conv->fft = realFFTKernel(realFFTSelect(REALFFT_BEST), conv->_segSize);
+	conv->bit = (unsigned int*)malloc(conv->_segSize * sizeof(unsigned int));
+	conv->sine = (float*)malloc(conv->_segSize * sizeof(float));
+	fhtbitReversalTbl(conv->bit, conv->_segSize);
+	realFFTTable(conv->sine, conv->_segSize);
+	for (c = 0; c < outputs; c++)
+		conv->_fftBuffer[c] = (float*)malloc(conv->_segSize * sizeof(float));
+
+	// Prepare segments, Re and Im of every input
+	{
+		float ***tables[2 * FFTCONVOLVER_MAX_CHANNELS];
+		for (c = 0; c < inputs; c++)
+		{
+			tables[2 * c] = &conv->_segmentsRe[c];
+			tables[2 * c + 1] = &conv->_segmentsIm[c];
+		}
+		conv->_inputArena = spectrumArenaAlloc(tables, 2 * inputs, conv->_segCount, spectrumStride(conv->_fftComplexSize));
+	}
+
+	// Prepare IR, Re and Im of every input to output path
+	const unsigned int paths = inputs * outputs;
+	{
+		float ***tables[2 * FFTCONVOLVER_MAX_CHANNELS * FFTCONVOLVER_MAX_CHANNELS];
+		for (c = 0; c < paths; c++)
+		{
+			tables[2 * c] = &conv->_segmentsIRRe[c];
+			tables[2 * c + 1] = &conv->_segmentsIRIm[c];
+		}
+		conv->_irArena = spectrumArenaIR(tables, 2 * paths, conv->_segCount, spectrumStride(conv->_fftComplexSize), &conv->_irShared);
+	}
+	const int irCached = conv->_irShared || spectrumHookFill(conv->_irArena, 2 * paths, conv->_segCount, spectrumStride(conv->_fftComplexSize));
+	for (i = 0; i < conv->_segCount && !irCached; ++i)
+	{
+		const unsigned int remaining = irLen - (i * conv->_blockSize);
+		const unsigned int sizeCopy = (remaining >= conv->_blockSize) ? conv->_blockSize : remaining;
+		for (c = 0; c < paths; c++)
+		{
+			float* segmentRe = conv->_segmentsIRRe[c][i];
+			float* segmentIm = conv->_segmentsIRIm[c][i];
+			for (j = 0; j < sizeCopy; j++)
+				conv->_fftBuffer[0][conv->bit[j]] = ir[c][i*conv->_blockSize + j];
+			for (j = sizeCopy; j < conv->_segSize; j++)
+				conv->_fftBuffer[0][conv->bit[j]] = 0.0f;
+			conv->fft(conv->_fftBuffer[0], conv->sine);
+			segmentRe[0] = conv->_fftBuffer[0][0] * 2.0f;
+			segmentIm[0] = 0.0f;
+			for (j = 1; j < conv->_fftComplexSize; j++)
+			{
+				symIdx = conv->_segSize - j;
+				segmentRe[j] = conv->_fftBuffer[0][j] + conv->_fftBuffer[0][symIdx];
+				segmentIm[j] = conv->_fftBuffer[0][j] - conv->_fftBuffer[0][symIdx];
+			}
+		}
+	}
+	if (!irCached)
+		spectrumHookStore(conv->_irArena, 2 * paths, conv->_segCount, spectrumStride(conv->_fftComplexSize));
+
+	// Prepare convolution buffers
+	for (c = 0; c < outputs; c++)
+	{
+		conv->_preMultiplied[c][0] = (float*)malloc(conv->_fftComplexSize * sizeof(float));
+		conv->_preMultiplied[c][1] = (float*)malloc(conv->_fftComplexSize * sizeof(float));
+		memset(conv->_preMultiplied[c][0], 0, conv->_fftComplexSize * sizeof(float));
+		memset(conv->_preMultiplied[c][1], 0, conv->_fftComplexSize * sizeof(float));
+		conv->_overlap[c] = (float*)malloc(conv->_blockSize * sizeof(float));
+		memset(conv->_overlap[c], 0, conv->_blockSize * sizeof(float));
+	}
+	conv->_accumulator[0] = (float*)malloc(conv->_fftComplexSize * sizeof(float));
+	conv->_accumulator[1] = (float*)malloc(conv->_fftComplexSize * sizeof(float));
+
+	// Prepare input buffer
+	for (c = 0; c < inputs; c++)
+	{
+		conv->_inputBuffer[c] = (float*)malloc(conv->_blockSize * sizeof(float));
+		memset(conv->_inputBuffer[c], 0, conv->_blockSize * sizeof(float));
+	}
+	conv->_inputBufferFill = 0;
+
+	// Reset current position
+	conv->_current = 0;
+	conv->gain = 1.0f / ((float)conv->_segSize * 2.0f);
+	conv->mac = spectralMACSelect(SPECTRALMAC_BEST);
+	return 1;
+}
+// Sum of the products of segments 1..N-1 with the matching input spectra, done once per block
+void FFTConvolver1x1PreMultiply(FFTConvolver1x1 *conv)
+{
+	if (conv->_segCount < 2)
+		return;
+	memset(conv->_preMultiplied[0], 0, conv->_fftComplexSize * sizeof(float));
+	memset(conv->_preMultiplied[1], 0, conv->_fftComplexSize * sizeof(float));
+	unsigned int segFrameIndex = conv->_current;
+	for (unsigned int i = 1; i < conv->_segCount; ++i)
+	{
+		segFrameIndex = (segFrameIndex < conv->_segCountMinus1) ? (segFrameIndex + 1) : 0;
+		conv->mac->cmac(conv->_preMultiplied[0], conv->_preMultiplied[1], conv->_segmentsIRRe[i], conv->_segmentsIRIm[i], conv->_segmentsRe[segFrameIndex], conv->_segmentsIm[segFrameIndex], conv->_fftComplexSize);
+	}
+}
+void FFTConvolver2x4x2PreMultiply(FFTConvolver2x4x2 *conv)
+{
+	if (conv->_segCount < 2)
+		return;
+	for (int c = 0; c < 2; c++)
+	{
+		memset(conv->_preMultiplied[c][0], 0, conv->_fftComplexSize * sizeof(float));
+		memset(conv->_preMultiplied[c][1], 0, conv->_fftComplexSize * sizeof(float));
+	}
+	const unsigned int count = conv->_activeSegments ? conv->_activeCount : conv->_segCountMinus1;
+	for (unsigned int k = 0; k < count; ++k)
+	{
+		const unsigned int i = conv->_activeSegments ? conv->_activeSegments[k] : k + 1;
+		const unsigned int segFrameIndex = conv->_current + i - (conv->_current + i < conv->_segCount ? 0 : conv->_segCount);
+		const float *reBLeft = conv->_segmentsReLeft[segFrameIndex];
+		const float *imBLeft = conv->_segmentsImLeft[segFrameIndex];
+		const float *reBRight = conv->_segmentsReRight[segFrameIndex];
+		const float *imBRight = conv->_segmentsImRight[segFrameIndex];
+		conv->mac->cmac2(conv->_preMultiplied[0][0], conv->_preMultiplied[0][1], conv->_segmentsRLIRRe[i], conv->_segmentsRLIRIm[i], reBRight, imBRight, conv->_segmentsLLIRRe[i], conv->_segmentsLLIRIm[i], reBLeft, imBLeft, conv->_fftComplexSize);
+		conv->mac->cmac2(conv->_preMultiplied[1][0], conv->_preMultiplied[1][1], conv->_segmentsLRIRRe[i], conv->_segmentsLRIRIm[i], reBLeft, imBLeft, conv->_segmentsRRIRRe[i], conv->_segmentsRRIRIm[i], reBRight, imBRight, conv->_fftComplexSize);
+	}
+}
+void FFTConvolver2x2PreMultiply(FFTConvolver2x2 *conv)
+{
+	if (conv->_segCount < 2)
+		return;
+	for (int c = 0; c < 2; c++)
+	{
+		memset(conv->_preMultiplied[c][0], 0, conv->_fftComplexSize * sizeof(float));
+		memset(conv->_preMultiplied[c][1], 0, conv->_fftComplexSize * sizeof(float));
+	}
+	const unsigned int count = conv->_activeSegments ? conv->_activeCount : conv->_segCountMinus1;
+	for (unsigned int k = 0; k < count; ++k)
+	{
+		const unsigned int i = conv->_activeSegments ? conv->_activeSegments[k] : k + 1;
+		const unsigned int segFrameIndex = conv->_current + i - (conv->_current + i < conv->_segCount ? 0 : conv->_segCount);
+		if (conv->_sharedKernel)
+			conv->mac->cmacShared(conv->_preMultiplied[0][0], conv->_preMultiplied[0][1], conv->_preMultiplied[1][0], conv->_preMultiplied[1][1], conv->_segmentsLLIRRe[i], conv->_segmentsLLIRIm[i], conv->_segmentsReLeft[segFrameIndex], conv->_segmentsImLeft[segFrameIndex], conv->_segmentsReRight[segFrameIndex], conv->_segmentsImRight[segFrameIndex], conv->_fftComplexSize);
+		else
+		{
+			conv->mac->cmac(conv->_preMultiplied[0][0], conv->_preMultiplied[0][1], conv->_segmentsLLIRRe[i], conv->_segmentsLLIRIm[i], conv->_segmentsReLeft[segFrameIndex], conv->_segmentsImLeft[segFrameIndex], conv->_fftComplexSize);
+			conv->mac->cmac(conv->_preMultiplied[1][0], conv->_preMultiplied[1][1], conv->_segmentsRRIRRe[i], conv->_segmentsRRIRIm[i], conv->_segmentsReRight[segFrameIndex], conv->_segmentsImRight[segFrameIndex], conv->_fftComplexSize);
+		}
+	}
+}
+void FFTConvolver1x2PreMultiply(FFTConvolver1x2 *conv)
+{
+	if (conv->_segCount < 2)
+		return;
+	for (int c = 0; c < 2; c++)
+	{
+		memset(conv->_preMultiplied[c][0], 0, conv->_fftComplexSize * sizeof(float));
+		memset(conv->_preMultiplied[c][1], 0, conv->_fftComplexSize * sizeof(float));
+	}
+	unsigned int segFrameIndex = conv->_current;
+	for (unsigned int i = 1; i < conv->_segCount; ++i)
+	{
+		segFrameIndex = (segFrameIndex < conv->_segCountMinus1) ? (segFrameIndex + 1) : 0;
+		conv->mac->cmac(conv->_preMultiplied[0][0], conv->_preMultiplied[0][1], conv->_segmentsLLIRRe[i], conv->_segmentsLLIRIm[i], conv->_segmentsRe[segFrameIndex], conv->_segmentsIm[segFrameIndex], conv->_fftComplexSize);
+		conv->mac->cmac(conv->_preMultiplied[1][0], conv->_preMultiplied[1][1], conv->_segmentsRRIRRe[i], conv->_segmentsRRIRIm[i], conv->_segmentsRe[segFrameIndex], conv->_segmentsIm[segFrameIndex], conv->_fftComplexSize);
+	}
+}
+// re + i * im += products of impulse response segment seg of every path into output o with input frame
+static void FFTConvolverNxMAccumulate(FFTConvolverNxM *conv, float *re, float *im, unsigned int o, unsigned int seg, unsigned int frame)
+{
+	unsigned int c = 0;
+	for (; c + 1 < conv->_inputs; c += 2)
+	{
+		const unsigned int p = c * conv->_outputs + o;
+		const unsigned int q = p + conv->_outputs;
+		conv->mac->cmac2(re, im, conv->_segmentsIRRe[p][seg], conv->_segmentsIRIm[p][seg], conv->_segmentsRe[c][frame], conv->_segmentsIm[c][frame], conv->_segmentsIRRe[q][seg], conv->_segmentsIRIm[q][seg], conv->_segmentsRe[c + 1][frame], conv->_segmentsIm[c + 1][frame], conv->_fftComplexSize);
+	}
+	if (c < conv->_inputs)
+	{
+		const unsigned int p = c * conv->_outputs + o;
+		conv->mac->cmac(re, im, conv->_segmentsIRRe[p][seg], conv->_segmentsIRIm[p][seg], conv->_segmentsRe[c][frame], conv->_segmentsIm[c][frame], conv->_fftComplexSize);
+	}
+}
+void FFTConvolverNxMPreMultiply(FFTConvolverNxM *conv)
+{
+	if (conv->_segCount < 2)
+		return;
+	for (unsigned int o = 0; o < conv->_outputs; o++)
+	{
+		memset(conv->_preMultiplied[o][0], 0, conv->_fftComplexSize * sizeof(float));
+		memset(conv->_preMultiplied[o][1], 0, conv->_fftComplexSize * sizeof(float));
+	}
+	const unsigned int count = conv->_activeSegments ? conv->_activeCount : conv->_segCountMinus1;
+	for (unsigned int k = 0; k < count; ++k)
+	{
+		const unsigned int i = conv->_activeSegments ? conv->_activeSegments[k] : k + 1;
+		const unsigned int segFrameIndex = conv->_current + i - (conv->_current + i < conv->_segCount ? 0 : conv->_segCount);
+		for (unsigned int o = 0; o < conv->_outputs; o++)
+			FFTConvolverNxMAccumulate(conv, conv->_preMultiplied[o][0], conv->_preMultiplied[o][1], o, i, segFrameIndex);
+	}
+}
 void FFTConvolver1x1Process(FFTConvolver1x1 *conv, const float* input, float* output, unsigned int len)
 {
 	unsigned int j, symIdx;
@@ -1101,54 +1331,7 @@ void FFTConvolver1x1Process(FFTConvolver1x1 *conv, const float* input, float* ou
 		const float *imB;
 		unsigned int end4 = conv->_fftComplexSize - 1;
 		if (inputBufferWasEmpty)
-		{
-			unsigned int segFrameIndex = (conv->_current + 1) % conv->_segCount;
-			if (conv->_segCount > 1)
-			{
-				float *re = conv->_preMultiplied[0];
-				float *im = conv->_preMultiplied[1];
-				reA = conv->_segmentsIRRe[1];
-				imA = conv->_segmentsIRIm[1];
-				reB = conv->_segmentsRe[segFrameIndex];
-				imB = conv->_segmentsIm[segFrameIndex];
-				for (j = 0; j < end4; j += 4)
-				{
-					re[j + 0] = reA[j + 0] * reB[j + 0] - imA[j + 0] * imB[j + 0];
-					re[j + 1] = reA[j + 1] * reB[j + 1] - imA[j + 1] * imB[j + 1];
-					re[j + 2] = reA[j + 2] * reB[j + 2] - imA[j + 2] * imB[j + 2];
-					re[j + 3] = reA[j + 3] * reB[j + 3] - imA[j + 3] * imB[j + 3];
-					im[j + 0] = reA[j + 0] * imB[j + 0] + imA[j + 0] * reB[j + 0];
-					im[j + 1] = reA[j + 1] * imB[j + 1] + imA[j + 1] * reB[j + 1];
-					im[j + 2] = reA[j + 2] * imB[j + 2] + imA[j + 2] * reB[j + 2];
-					im[j + 3] = reA[j + 3] * imB[j + 3] + imA[j + 3] * reB[j + 3];
-				}
-				re[end4] = reA[end4] * reB[end4] - imA[end4] * imB[end4];
-				im[end4] = reA[end4] * imB[end4] + imA[end4] * reB[end4];
-				for (unsigned int i = 2; i < conv->_segCount; ++i)
-				{
-					segFrameIndex = (conv->_current + i) % conv->_segCount;
-					re = conv->_preMultiplied[0];
-					im = conv->_preMultiplied[1];
-					reA = conv->_segmentsIRRe[i];
-					imA = conv->_segmentsIRIm[i];
-					reB = conv->_segmentsRe[segFrameIndex];
-					imB = conv->_segmentsIm[segFrameIndex];
-					for (j = 0; j < end4; j += 4)
-					{
-						re[j + 0] += reA[j + 0] * reB[j + 0] - imA[j + 0] * imB[j + 0];
-						re[j + 1] += reA[j + 1] * reB[j + 1] - imA[j + 1] * imB[j + 1];
-						re[j + 2] += reA[j + 2] * reB[j + 2] - imA[j + 2] * imB[j + 2];
-						re[j + 3] += reA[j + 3] * reB[j + 3] - imA[j + 3] * imB[j + 3];
-						im[j + 0] += reA[j + 0] * imB[j + 0] + imA[j + 0] * reB[j + 0];
-						im[j + 1] += reA[j + 1] * imB[j + 1] + imA[j + 1] * reB[j + 1];
-						im[j + 2] += reA[j + 2] * imB[j + 2] + imA[j + 2] * reB[j + 2];
-						im[j + 3] += reA[j + 3] * imB[j + 3] + imA[j + 3] * reB[j + 3];
-					}
-					re[end4] += reA[end4] * reB[end4] - imA[end4] * imB[end4];
-					im[end4] += reA[end4] * imB[end4] + imA[end4] * reB[end4];
-				}
-			}
-		}
+			FFTConvolver1x1PreMultiply(conv);
 		reA = conv->_segmentsIRRe[0];
 		imA = conv->_segmentsIRIm[0];
 		reB = conv->_segmentsRe[conv->_current];
@@ -1242,94 +1425,7 @@ void FFTConvolver2x4x2Process(FFTConvolver2x4x2 *conv, const float* x1, const fl
 		const float *imBRight;
 		unsigned int end4 = conv->_fftComplexSize - 1;
 		if (inputBufferWasEmpty)
-		{
-			unsigned int segFrameIndex = (conv->_current + 1) % conv->_segCount;
-			if (conv->_segCount > 1)
-			{
-				float *reLeft = conv->_preMultiplied[0][0];
-				float *imLeft = conv->_preMultiplied[0][1];
-				float *reRight = conv->_preMultiplied[1][0];
-				float *imRight = conv->_preMultiplied[1][1];
-				reALL = conv->_segmentsLLIRRe[1];
-				imALL = conv->_segmentsLLIRIm[1];
-				reALR = conv->_segmentsLRIRRe[1];
-				imALR = conv->_segmentsLRIRIm[1];
-				reARL = conv->_segmentsRLIRRe[1];
-				imARL = conv->_segmentsRLIRIm[1];
-				reARR = conv->_segmentsRRIRRe[1];
-				imARR = conv->_segmentsRRIRIm[1];
-				reBLeft = conv->_segmentsReLeft[segFrameIndex];
-				imBLeft = conv->_segmentsImLeft[segFrameIndex];
-				reBRight = conv->_segmentsReRight[segFrameIndex];
-				imBRight = conv->_segmentsImRight[segFrameIndex];
-				for (j = 0; j < end4; j += 4)
-				{
-					reLeft[j + 0] = (reARL[j + 0] * reBRight[j + 0] - imARL[j + 0] * imBRight[j + 0]) + (reALL[j + 0] * reBLeft[j + 0] - imALL[j + 0] * imBLeft[j + 0]);
-					reLeft[j + 1] = (reARL[j + 1] * reBRight[j + 1] - imARL[j + 1] * imBRight[j + 1]) + (reALL[j + 1] * reBLeft[j + 1] - imALL[j + 1] * imBLeft[j + 1]);
-					reLeft[j + 2] = (reARL[j + 2] * reBRight[j + 2] - imARL[j + 2] * imBRight[j + 2]) + (reALL[j + 2] * reBLeft[j + 2] - imALL[j + 2] * imBLeft[j + 2]);
-					reLeft[j + 3] = (reARL[j + 3] * reBRight[j + 3] - imARL[j + 3] * imBRight[j + 3]) + (reALL[j + 3] * reBLeft[j + 3] - imALL[j + 3] * imBLeft[j + 3]);
-					imLeft[j + 0] = (imARL[j + 0] * reBRight[j + 0] + reARL[j + 0] * imBRight[j + 0]) + (reALL[j + 0] * imBLeft[j + 0] + imALL[j + 0] * reBLeft[j + 0]);
-					imLeft[j + 1] = (imARL[j + 1] * reBRight[j + 1] + reARL[j + 1] * imBRight[j + 1]) + (reALL[j + 1] * imBLeft[j + 1] + imALL[j + 1] * reBLeft[j + 1]);
-					imLeft[j + 2] = (imARL[j + 2] * reBRight[j + 2] + reARL[j + 2] * imBRight[j + 2]) + (reALL[j + 2] * imBLeft[j + 2] + imALL[j + 2] * reBLeft[j + 2]);
-					imLeft[j + 3] = (imARL[j + 3] * reBRight[j + 3] + reARL[j + 3] * imBRight[j + 3]) + (reALL[j + 3] * imBLeft[j + 3] + imALL[j + 3] * reBLeft[j + 3]);
-					reRight[j + 0] = (reALR[j + 0] * reBLeft[j + 0] - imALR[j + 0] * imBLeft[j + 0]) + (reARR[j + 0] * reBRight[j + 0] - imARR[j + 0] * imBRight[j + 0]);
-					reRight[j + 1] = (reALR[j + 1] * reBLeft[j + 1] - imALR[j + 1] * imBLeft[j + 1]) + (reARR[j + 1] * reBRight[j + 1] - imARR[j + 1] * imBRight[j + 1]);
-					reRight[j + 2] = (reALR[j + 2] * reBLeft[j + 2] - imALR[j + 2] * imBLeft[j + 2]) + (reARR[j + 2] * reBRight[j + 2] - imARR[j + 2] * imBRight[j + 2]);
-					reRight[j + 3] = (reALR[j + 3] * reBLeft[j + 3] - imALR[j + 3] * imBLeft[j + 3]) + (reARR[j + 3] * reBRight[j + 3] - imARR[j + 3] * imBRight[j + 3]);
-					imRight[j + 0] = (imALR[j + 0] * reBLeft[j + 0] + reALR[j + 0] * imBLeft[j + 0]) + (reARR[j + 0] * imBRight[j + 0] + imARR[j + 0] * reBRight[j + 0]);
-					imRight[j + 1] = (imALR[j + 1] * reBLeft[j + 1] + reALR[j + 1] * imBLeft[j + 1]) + (reARR[j + 1] * imBRight[j + 1] + imARR[j + 1] * reBRight[j + 1]);
-					imRight[j + 2] = (imALR[j + 2] * reBLeft[j + 2] + reALR[j + 2] * imBLeft[j + 2]) + (reARR[j + 2] * imBRight[j + 2] + imARR[j + 2] * reBRight[j + 2]);
-					imRight[j + 3] = (imALR[j + 3] * reBLeft[j + 3] + reALR[j + 3] * imBLeft[j + 3]) + (reARR[j + 3] * imBRight[j + 3] + imARR[j + 3] * reBRight[j + 3]);
-				}
-				reLeft[end4] = (reARL[end4] * reBRight[end4] - imARL[end4] * imBRight[end4]) + (reALL[end4] * reBLeft[end4] - imALL[end4] * imBLeft[end4]);
-				imLeft[end4] = (imARL[end4] * reBRight[end4] + reARL[end4] * imBRight[end4]) + (reALL[end4] * imBLeft[end4] + imALL[end4] * reBLeft[end4]);
-				reRight[end4] = (reALR[end4] * reBLeft[end4] - imALR[end4] * imBLeft[end4]) + (reARR[end4] * reBRight[end4] - imARR[end4] * imBRight[end4]);
-				imRight[end4] = (imALR[end4] * reBLeft[end4] + reALR[end4] * imBLeft[end4]) + (reARR[end4] * imBRight[end4] + imARR[end4] * reBRight[end4]);
-				for (unsigned int i = 2; i < conv->_segCount; ++i)
-				{
-					segFrameIndex = (conv->_current + i) % conv->_segCount;
-					reLeft = conv->_preMultiplied[0][0];
-					imLeft = conv->_preMultiplied[0][1];
-					reRight = conv->_preMultiplied[1][0];
-					imRight = conv->_preMultiplied[1][1];
-					reALL = conv->_segmentsLLIRRe[i];
-					imALL = conv->_segmentsLLIRIm[i];
-					reALR = conv->_segmentsLRIRRe[i];
-					imALR = conv->_segmentsLRIRIm[i];
-					reARL = conv->_segmentsRLIRRe[i];
-					imARL = conv->_segmentsRLIRIm[i];
-					reARR = conv->_segmentsRRIRRe[i];
-					imARR = conv->_segmentsRRIRIm[i];
-					reBLeft = conv->_segmentsReLeft[segFrameIndex];
-					imBLeft = conv->_segmentsImLeft[segFrameIndex];
-					reBRight = conv->_segmentsReRight[segFrameIndex];
-					imBRight = conv->_segmentsImRight[segFrameIndex];
-					for (j = 0; j < end4; j += 4)
-					{
-						reLeft[j + 0] += (reARL[j + 0] * reBRight[j + 0] - imARL[j + 0] * imBRight[j + 0]) + (reALL[j + 0] * reBLeft[j + 0] - imALL[j + 0] * imBLeft[j + 0]);
-						reLeft[j + 1] += (reARL[j + 1] * reBRight[j + 1] - imARL[j + 1] * imBRight[j + 1]) + (reALL[j + 1] * reBLeft[j + 1] - imALL[j + 1] * imBLeft[j + 1]);
-						reLeft[j + 2] += (reARL[j + 2] * reBRight[j + 2] - imARL[j + 2] * imBRight[j + 2]) + (reALL[j + 2] * reBLeft[j + 2] - imALL[j + 2] * imBLeft[j + 2]);
-						reLeft[j + 3] += (reARL[j + 3] * reBRight[j + 3] - imARL[j + 3] * imBRight[j + 3]) + (reALL[j + 3] * reBLeft[j + 3] - imALL[j + 3] * imBLeft[j + 3]);
-						imLeft[j + 0] += (imARL[j + 0] * reBRight[j + 0] + reARL[j + 0] * imBRight[j + 0]) + (reALL[j + 0] * imBLeft[j + 0] + imALL[j + 0] * reBLeft[j + 0]);
-						imLeft[j + 1] += (imARL[j + 1] * reBRight[j + 1] + reARL[j + 1] * imBRight[j + 1]) + (reALL[j + 1] * imBLeft[j + 1] + imALL[j + 1] * reBLeft[j + 1]);
-						imLeft[j + 2] += (imARL[j + 2] * reBRight[j + 2] + reARL[j + 2] * imBRight[j + 2]) + (reALL[j + 2] * imBLeft[j + 2] + imALL[j + 2] * reBLeft[j + 2]);
-						imLeft[j + 3] += (imARL[j + 3] * reBRight[j + 3] + reARL[j + 3] * imBRight[j + 3]) + (reALL[j + 3] * imBLeft[j + 3] + imALL[j + 3] * reBLeft[j + 3]);
-						reRight[j + 0] += (reALR[j + 0] * reBLeft[j + 0] - imALR[j + 0] * imBLeft[j + 0]) + (reARR[j + 0] * reBRight[j + 0] - imARR[j + 0] * imBRight[j + 0]);
-						reRight[j + 1] += (reALR[j + 1] * reBLeft[j + 1] - imALR[j + 1] * imBLeft[j + 1]) + (reARR[j + 1] * reBRight[j + 1] - imARR[j + 1] * imBRight[j + 1]);
-						reRight[j + 2] += (reALR[j + 2] * reBLeft[j + 2] - imALR[j + 2] * imBLeft[j + 2]) + (reARR[j + 2] * reBRight[j + 2] - imARR[j + 2] * imBRight[j + 2]);
-						reRight[j + 3] += (reALR[j + 3] * reBLeft[j + 3] - imALR[j + 3] * imBLeft[j + 3]) + (reARR[j + 3] * reBRight[j + 3] - imARR[j + 3] * imBRight[j + 3]);
-						imRight[j + 0] += (imALR[j + 0] * reBLeft[j + 0] + reALR[j + 0] * imBLeft[j + 0]) + (reARR[j + 0] * imBRight[j + 0] + imARR[j + 0] * reBRight[j + 0]);
-						imRight[j + 1] += (imALR[j + 1] * reBLeft[j + 1] + reALR[j + 1] * imBLeft[j + 1]) + (reARR[j + 1] * imBRight[j + 1] + imARR[j + 1] * reBRight[j + 1]);
-						imRight[j + 2] += (imALR[j + 2] * reBLeft[j + 2] + reALR[j + 2] * imBLeft[j + 2]) + (reARR[j + 2] * imBRight[j + 2] + imARR[j + 2] * reBRight[j + 2]);
-						imRight[j + 3] += (imALR[j + 3] * reBLeft[j + 3] + reALR[j + 3] * imBLeft[j + 3]) + (reARR[j + 3] * imBRight[j + 3] + imARR[j + 3] * reBRight[j + 3]);
-					}
-					reLeft[end4] += (reARL[end4] * reBRight[end4] - imARL[end4] * imBRight[end4]) + (reALL[end4] * reBLeft[end4] - imALL[end4] * imBLeft[end4]);
-					imLeft[end4] += (imARL[end4] * reBRight[end4] + reARL[end4] * imBRight[end4]) + (reALL[end4] * imBLeft[end4] + imALL[end4] * reBLeft[end4]);
-					reRight[end4] += (reALR[end4] * reBLeft[end4] - imALR[end4] * imBLeft[end4]) + (reARR[end4] * reBRight[end4] - imARR[end4] * imBRight[end4]);
-					imRight[end4] += (imALR[end4] * reBLeft[end4] + reALR[end4] * imBLeft[end4]) + (reARR[end4] * imBRight[end4] + imARR[end4] * reBRight[end4]);
-				}
-			}
-		}
+			FFTConvolver2x4x2PreMultiply(conv);
 		reALL = conv->_segmentsLLIRRe[0];
 		imALL = conv->_segmentsLLIRIm[0];
 		reALR = conv->_segmentsLRIRRe[0];
@@ -1451,86 +1547,7 @@ void FFTConvolver2x2Process(FFTConvolver2x2 *conv, const float* x1, const float*
 		const float *imBRight;
 		unsigned int end4 = conv->_fftComplexSize - 1;
 		if (inputBufferWasEmpty)
-		{
-			unsigned int segFrameIndex = (conv->_current + 1) % conv->_segCount;
-			if (conv->_segCount > 1)
-			{
-				float *reLeft = conv->_preMultiplied[0][0];
-				float *imLeft = conv->_preMultiplied[0][1];
-				float *reRight = conv->_preMultiplied[1][0];
-				float *imRight = conv->_preMultiplied[1][1];
-				reALL = conv->_segmentsLLIRRe[1];
-				imALL = conv->_segmentsLLIRIm[1];
-				reARR = conv->_segmentsRRIRRe[1];
-				imARR = conv->_segmentsRRIRIm[1];
-				reBLeft = conv->_segmentsReLeft[segFrameIndex];
-				imBLeft = conv->_segmentsImLeft[segFrameIndex];
-				reBRight = conv->_segmentsReRight[segFrameIndex];
-				imBRight = conv->_segmentsImRight[segFrameIndex];
-				for (j = 0; j < end4; j += 4)
-				{
-					reLeft[j + 0] = reALL[j + 0] * reBLeft[j + 0] - imALL[j + 0] * imBLeft[j + 0];
-					reLeft[j + 1] = reALL[j + 1] * reBLeft[j + 1] - imALL[j + 1] * imBLeft[j + 1];
-					reLeft[j + 2] = reALL[j + 2] * reBLeft[j + 2] - imALL[j + 2] * imBLeft[j + 2];
-					reLeft[j + 3] = reALL[j + 3] * reBLeft[j + 3] - imALL[j + 3] * imBLeft[j + 3];
-					imLeft[j + 0] = reALL[j + 0] * imBLeft[j + 0] + imALL[j + 0] * reBLeft[j + 0];
-					imLeft[j + 1] = reALL[j + 1] * imBLeft[j + 1] + imALL[j + 1] * reBLeft[j + 1];
-					imLeft[j + 2] = reALL[j + 2] * imBLeft[j + 2] + imALL[j + 2] * reBLeft[j + 2];
-					imLeft[j + 3] = reALL[j + 3] * imBLeft[j + 3] + imALL[j + 3] * reBLeft[j + 3];
-					reRight[j + 0] = reARR[j + 0] * reBRight[j + 0] - imARR[j + 0] * imBRight[j + 0];
-					reRight[j + 1] = reARR[j + 1] * reBRight[j + 1] - imARR[j + 1] * imBRight[j + 1];
-					reRight[j + 2] = reARR[j + 2] * reBRight[j + 2] - imARR[j + 2] * imBRight[j + 2];
-					reRight[j + 3] = reARR[j + 3] * reBRight[j + 3] - imARR[j + 3] * imBRight[j + 3];
-					imRight[j + 0] = reARR[j + 0] * imBRight[j + 0] + imARR[j + 0] * reBRight[j + 0];
-					imRight[j + 1] = reARR[j + 1] * imBRight[j + 1] + imARR[j + 1] * reBRight[j + 1];
-					imRight[j + 2] = reARR[j + 2] * imBRight[j + 2] + imARR[j + 2] * reBRight[j + 2];
-					imRight[j + 3] = reARR[j + 3] * imBRight[j + 3] + imARR[j + 3] * reBRight[j + 3];
-				}
-				reLeft[end4] = reALL[end4] * reBLeft[end4] - imALL[end4] * imBLeft[end4];
-				imLeft[end4] = reALL[end4] * imBLeft[end4] + imALL[end4] * reBLeft[end4];
-				reRight[end4] = reARR[end4] * reBRight[end4] - imARR[end4] * imBRight[end4];
-				imRight[end4] = reARR[end4] * imBRight[end4] + imARR[end4] * reBRight[end4];
-				for (unsigned int i = 2; i < conv->_segCount; ++i)
-				{
-					segFrameIndex = (conv->_current + i) % conv->_segCount;
-					reLeft = conv->_preMultiplied[0][0];
-					imLeft = conv->_preMultiplied[0][1];
-					reRight = conv->_preMultiplied[1][0];
-					imRight = conv->_preMultiplied[1][1];
-					reALL = conv->_segmentsLLIRRe[i];
-					imALL = conv->_segmentsLLIRIm[i];
-					reARR = conv->_segmentsRRIRRe[i];
-					imARR = conv->_segmentsRRIRIm[i];
-					reBLeft = conv->_segmentsReLeft[segFrameIndex];
-					imBLeft = conv->_segmentsImLeft[segFrameIndex];
-					reBRight = conv->_segmentsReRight[segFrameIndex];
-					imBRight = conv->_segmentsImRight[segFrameIndex];
-					for (j = 0; j < end4; j += 4)
-					{
-						reLeft[j + 0] += reALL[j + 0] * reBLeft[j + 0] - imALL[j + 0] * imBLeft[j + 0];
-						reLeft[j + 1] += reALL[j + 1] * reBLeft[j + 1] - imALL[j + 1] * imBLeft[j + 1];
-						reLeft[j + 2] += reALL[j + 2] * reBLeft[j + 2] - imALL[j + 2] * imBLeft[j + 2];
-						reLeft[j + 3] += reALL[j + 3] * reBLeft[j + 3] - imALL[j + 3] * imBLeft[j + 3];
-						imLeft[j + 0] += reALL[j + 0] * imBLeft[j + 0] + imALL[j + 0] * reBLeft[j + 0];
-						imLeft[j + 1] += reALL[j + 1] * imBLeft[j + 1] + imALL[j + 1] * reBLeft[j + 1];
-						imLeft[j + 2] += reALL[j + 2] * imBLeft[j + 2] + imALL[j + 2] * reBLeft[j + 2];
-						imLeft[j + 3] += reALL[j + 3] * imBLeft[j + 3] + imALL[j + 3] * reBLeft[j + 3];
-						reRight[j + 0] += reARR[j + 0] * reBRight[j + 0] - imARR[j + 0] * imBRight[j + 0];
-						reRight[j + 1] += reARR[j + 1] * reBRight[j + 1] - imARR[j + 1] * imBRight[j + 1];
-						reRight[j + 2] += reARR[j + 2] * reBRight[j + 2] - imARR[j + 2] * imBRight[j + 2];
-						reRight[j + 3] += reARR[j + 3] * reBRight[j + 3] - imARR[j + 3] * imBRight[j + 3];
-						imRight[j + 0] += reARR[j + 0] * imBRight[j + 0] + imARR[j + 0] * reBRight[j + 0];
-						imRight[j + 1] += reARR[j + 1] * imBRight[j + 1] + imARR[j + 1] * reBRight[j + 1];
-						imRight[j + 2] += reARR[j + 2] * imBRight[j + 2] + imARR[j + 2] * reBRight[j + 2];
-						imRight[j + 3] += reARR[j + 3] * imBRight[j + 3] + imARR[j + 3] * reBRight[j + 3];
-					}
-					reLeft[end4] += reALL[end4] * reBLeft[end4] - imALL[end4] * imBLeft[end4];
-					imLeft[end4] += reALL[end4] * imBLeft[end4] + imALL[end4] * reBLeft[end4];
-					reRight[end4] += reARR[end4] * reBRight[end4] - imARR[end4] * imBRight[end4];
-					imRight[end4] += reARR[end4] * imBRight[end4] + imARR[end4] * reBRight[end4];
-				}
-			}
-		}
+			FFTConvolver2x2PreMultiply(conv);
 		reALL = conv->_segmentsLLIRRe[0];
 		imALL = conv->_segmentsLLIRIm[0];
 		reARR = conv->_segmentsRRIRRe[0];
@@ -1635,82 +1652,7 @@ void FFTConvolver1x2Process(FFTConvolver1x2 *conv, const float* x, float* y1, fl
 		const float *imB;
 		unsigned int end4 = conv->_fftComplexSize - 1;
 		if (inputBufferWasEmpty)
-		{
-			unsigned int segFrameIndex = (conv->_current + 1) % conv->_segCount;
-			if (conv->_segCount > 1)
-			{
-				float *reLeft = conv->_preMultiplied[0][0];
-				float *imLeft = conv->_preMultiplied[0][1];
-				float *reRight = conv->_preMultiplied[1][0];
-				float *imRight = conv->_preMultiplied[1][1];
-				reALL = conv->_segmentsLLIRRe[1];
-				imALL = conv->_segmentsLLIRIm[1];
-				reARR = conv->_segmentsRRIRRe[1];
-				imARR = conv->_segmentsRRIRIm[1];
-				reB = conv->_segmentsRe[segFrameIndex];
-				imB = conv->_segmentsIm[segFrameIndex];
-				for (j = 0; j < end4; j += 4)
-				{
-					reLeft[j + 0] = reALL[j + 0] * reB[j + 0] - imALL[j + 0] * imB[j + 0];
-					reLeft[j + 1] = reALL[j + 1] * reB[j + 1] - imALL[j + 1] * imB[j + 1];
-					reLeft[j + 2] = reALL[j + 2] * reB[j + 2] - imALL[j + 2] * imB[j + 2];
-					reLeft[j + 3] = reALL[j + 3] * reB[j + 3] - imALL[j + 3] * imB[j + 3];
-					imLeft[j + 0] = reALL[j + 0] * imB[j + 0] + imALL[j + 0] * reB[j + 0];
-					imLeft[j + 1] = reALL[j + 1] * imB[j + 1] + imALL[j + 1] * reB[j + 1];
-					imLeft[j + 2] = reALL[j + 2] * imB[j + 2] + imALL[j + 2] * reB[j + 2];
-					imLeft[j + 3] = reALL[j + 3] * imB[j + 3] + imALL[j + 3] * reB[j + 3];
-					reRight[j + 0] = reARR[j + 0] * reB[j + 0] - imARR[j + 0] * imB[j + 0];
-					reRight[j + 1] = reARR[j + 1] * reB[j + 1] - imARR[j + 1] * imB[j + 1];
-					reRight[j + 2] = reARR[j + 2] * reB[j + 2] - imARR[j + 2] * imB[j + 2];
-					reRight[j + 3] = reARR[j + 3] * reB[j + 3] - imARR[j + 3] * imB[j + 3];
-					imRight[j + 0] = reARR[j + 0] * imB[j + 0] + imARR[j + 0] * reB[j + 0];
-					imRight[j + 1] = reARR[j + 1] * imB[j + 1] + imARR[j + 1] * reB[j + 1];
-					imRight[j + 2] = reARR[j + 2] * imB[j + 2] + imARR[j + 2] * reB[j + 2];
-					imRight[j + 3] = reARR[j + 3] * imB[j + 3] + imARR[j + 3] * reB[j + 3];
-				}
-				reLeft[end4] = reALL[end4] * reB[end4] - imALL[end4] * imB[end4];
-				imLeft[end4] = reALL[end4] * imB[end4] + imALL[end4] * reB[end4];
-				reRight[end4] = reARR[end4] * reB[end4] - imARR[end4] * imB[end4];
-				imRight[end4] = reARR[end4] * imB[end4] + imARR[end4] * reB[end4];
-				for (unsigned int i = 2; i < conv->_segCount; ++i)
-				{
-					segFrameIndex = (conv->_current + i) % conv->_segCount;
-					reLeft = conv->_preMultiplied[0][0];
-					imLeft = conv->_preMultiplied[0][1];
-					reRight = conv->_preMultiplied[1][0];
-					imRight = conv->_preMultiplied[1][1];
-					reALL = conv->_segmentsLLIRRe[i];
-					imALL = conv->_segmentsLLIRIm[i];
-					reARR = conv->_segmentsRRIRRe[i];
-					imARR = conv->_segmentsRRIRIm[i];
-					reB = conv->_segmentsRe[segFrameIndex];
-					imB = conv->_segmentsIm[segFrameIndex];
-					for (j = 0; j < end4; j += 4)
-					{
-						reLeft[j + 0] += reALL[j + 0] * reB[j + 0] - imALL[j + 0] * imB[j + 0];
-						reLeft[j + 1] += reALL[j + 1] * reB[j + 1] - imALL[j + 1] * imB[j + 1];
-						reLeft[j + 2] += reALL[j + 2] * reB[j + 2] - imALL[j + 2] * imB[j + 2];
-						reLeft[j + 3] += reALL[j + 3] * reB[j + 3] - imALL[j + 3] * imB[j + 3];
-						imLeft[j + 0] += reALL[j + 0] * imB[j + 0] + imALL[j + 0] * reB[j + 0];
-						imLeft[j + 1] += reALL[j + 1] * imB[j + 1] + imALL[j + 1] * reB[j + 1];
-						imLeft[j + 2] += reALL[j + 2] * imB[j + 2] + imALL[j + 2] * reB[j + 2];
-						imLeft[j + 3] += reALL[j + 3] * imB[j + 3] + imALL[j + 3] * reB[j + 3];
-						reRight[j + 0] += reARR[j + 0] * reB[j + 0] - imARR[j + 0] * imB[j + 0];
-						reRight[j + 1] += reARR[j + 1] * reB[j + 1] - imARR[j + 1] * imB[j + 1];
-						reRight[j + 2] += reARR[j + 2] * reB[j + 2] - imARR[j + 2] * imB[j + 2];
-						reRight[j + 3] += reARR[j + 3] * reB[j + 3] - imARR[j + 3] * imB[j + 3];
-						imRight[j + 0] += reARR[j + 0] * imB[j + 0] + imARR[j + 0] * reB[j + 0];
-						imRight[j + 1] += reARR[j + 1] * imB[j + 1] + imARR[j + 1] * reB[j + 1];
-						imRight[j + 2] += reARR[j + 2] * imB[j + 2] + imARR[j + 2] * reB[j + 2];
-						imRight[j + 3] += reARR[j + 3] * imB[j + 3] + imARR[j + 3] * reB[j + 3];
-					}
-					reLeft[end4] += reALL[end4] * reB[end4] - imALL[end4] * imB[end4];
-					imLeft[end4] += reALL[end4] * imB[end4] + imALL[end4] * reB[end4];
-					reRight[end4] += reARR[end4] * reB[end4] - imARR[end4] * imB[end4];
-					imRight[end4] += reARR[end4] * imB[end4] + imARR[end4] * reB[end4];
-				}
-			}
-		}
+			FFTConvolver1x2PreMultiply(conv);
 		reALL = conv->_segmentsLLIRRe[0];
 		imALL = conv->_segmentsLLIRIm[0];
 		reARR = conv->_segmentsRRIRRe[0];
@@ -1780,4 +1722,251 @@ void FFTConvolver1x2Process(FFTConvolver1x2 *conv, const float* x, float* y1, fl
 		}
 		processed += processing;
 	}
-}
\ No newline at end of file
+}
+void FFTConvolverNxMProcess(FFTConvolverNxM *conv, const float *const *x, float *const *y, unsigned int len)
+{
+	unsigned int j, c, symIdx;
+	unsigned int processed = 0;
+	while (processed < len)
+	{
+		const int inputBufferWasEmpty = (conv->_inputBufferFill == 0);
+		const unsigned int processing = min(len - processed, conv->_blockSize - conv->_inputBufferFill);
+		const unsigned int inputBufferPos = conv->_inputBufferFill;
+		// Every input is buffered before any output is written, so y may alias x
+		for (c = 0; c < conv->_inputs; c++)
+			memcpy(conv->_inputBuffer[c] + inputBufferPos, x[c] + processed, processing * sizeof(float));
+
+		// Forward FFT, one per input
+		for (c = 0; c < conv->_inputs; c++)
+		{
+			float *segRe = conv->_segmentsRe[c][conv->_current];
+			float *segIm = conv->_segmentsIm[c][conv->_current];
+			for (j = 0; j < conv->_blockSize; j++)
+				conv->_fftBuffer[0][conv->bit[j]] = conv->_inputBuffer[c][j];
+			for (j = conv->_blockSize; j < conv->_segSize; j++)
+				conv->_fftBuffer[0][conv->bit[j]] = 0.0f;
+			conv->fft(conv->_fftBuffer[0], conv->sine);
+			segRe[0] = conv->_fftBuffer[0][0];
+			for (j = 1; j < conv->_fftComplexSize; j++)
+			{
+				symIdx = conv->_segSize - j;
+				segRe[j] = conv->_fftBuffer[0][j] + conv->_fftBuffer[0][symIdx];
+				segIm[j] = conv->_fftBuffer[0][j] - conv->_fftBuffer[0][symIdx];
+			}
+		}
+
+		// Complex multiplication, then one backward FFT per output
+		if (inputBufferWasEmpty)
+			FFTConvolverNxMPreMultiply(conv);
+		float *re = conv->_accumulator[0];
+		float *im = conv->_accumulator[1];
+		for (unsigned int o = 0; o < conv->_outputs; o++)
+		{
+			float *fftBuffer = conv->_fftBuffer[o];
+			memcpy(re, conv->_preMultiplied[o][0], conv->_fftComplexSize * sizeof(float));
+			memcpy(im, conv->_preMultiplied[o][1], conv->_fftComplexSize * sizeof(float));
+			FFTConvolverNxMAccumulate(conv, re, im, o, 0, conv->_current);
+			fftBuffer[0] = re[0];
+			for (j = 1; j < conv->_fftComplexSize; ++j)
+			{
+				symIdx = conv->_segSize - j;
+				fftBuffer[conv->bit[j]] = (re[j] + im[j]) * 0.5f;
+				fftBuffer[conv->bit[symIdx]] = (re[j] - im[j]) * 0.5f;
+			}
+			conv->fft(fftBuffer, conv->sine);
+
+			// Add overlap
+			float *result = y[o] + processed;
+			const float *a = fftBuffer + inputBufferPos;
+			const float *b = conv->_overlap[o] + inputBufferPos;
+			for (j = 0; j < processing; ++j)
+				result[j] = (a[j] + b[j]) * conv->gain;
+		}
+
+		// Input buffer full => Next block
+		conv->_inputBufferFill += processing;
+		if (conv->_inputBufferFill == conv->_blockSize)
+		{
+			// Input buffer is empty again now
+			for (c = 0; c < conv->_inputs; c++)
+				memset(conv->_inputBuffer[c], 0, conv->_blockSize * sizeof(float));
+			conv->_inputBufferFill = 0;
+			// Save the overlap
+			for (c = 0; c < conv->_outputs; c++)
+				memcpy(conv->_overlap[c], conv->_fftBuffer[c] + conv->_blockSize, conv->_blockSize * sizeof(float));
+			// Update current segment
+			conv->_current = (conv->_current > 0) ? (conv->_current - 1) : conv->_segCountMinus1;
+		}
+		processed += processing;
+	}
+}
+// Energy of segment seg summed over the paths, read off the spectra: the transform keeps sum H^2 = segSize * sum h^2
+static double spectrumSegmentEnergy(float **irIndex, unsigned int paths, unsigned int segCount, unsigned int seg, unsigned int fftComplexSize, unsigned int segSize)
+{
+	const unsigned int nyquist = fftComplexSize - 1;
+	double sum = 0.0;
+	for (unsigned int p = 0; p < paths; p++)
+	{
+		const float *re = irIndex[(size_t)2 * p * segCount + seg];
+		const float *im = irIndex[(size_t)(2 * p + 1) * segCount + seg];
+		sum += 0.25 * ((double)re[0] * re[0] + (double)re[nyquist] * re[nyquist]);
+		for (unsigned int j = 1; j < nyquist; j++)
+			sum += 0.5 * ((double)re[j] * re[j] + (double)im[j] * im[j]);
+	}
+	return sum / segSize;
+}
+static double spectrumPowerMax(float **irIndex, unsigned int paths, unsigned int segCount, unsigned int fftComplexSize, unsigned int segSize, unsigned int blockSize)
+{
+	double peak = 0.0;
+	for (unsigned int i = 0; i < segCount; i++)
+	{
+		const double power = spectrumSegmentEnergy(irIndex, paths, segCount, i, fftComplexSize, segSize) / blockSize;
+		if (power > peak)
+			peak = power;
+	}
+	return peak;
+}
+// Lists the segments above floor in *active, NULL when none is dropped, inputs is the number of paths summed into each output
+static void spectrumSkip(float **irIndex, unsigned int paths, unsigned int inputs, unsigned int segCount, unsigned int fftComplexSize, unsigned int segSize, unsigned int blockSize, double floor, unsigned int **active, unsigned int *activeCount, FFTConvolverSkipStats *stats)
+{
+	free(*active);
+	*active = 0;
+	*activeCount = 0;
+	if (!irIndex || segCount < 2)
+		return;
+	unsigned int *list = (unsigned int*)malloc((segCount - 1) * sizeof(unsigned int));
+	unsigned int count = 0;
+	const double segmentMacRate = (double)paths * fftComplexSize / blockSize;
+	for (unsigned int i = 0; i < segCount; i++)
+	{
+		const double energy = spectrumSegmentEnergy(irIndex, paths, segCount, i, fftComplexSize, segSize);
+		const int keep = !i || (energy > 0.0 && energy / blockSize > floor);
+		if (stats)
+		{
+			stats->energy += energy;
+			stats->partitions++;
+			stats->macRate += segmentMacRate;
+			if (!keep)
+			{
+				stats->droppedEnergy += energy;
+				stats->droppedPartitions++;
+				stats->droppedTaps += blockSize * inputs;
+				stats->droppedMacRate += segmentMacRate;
+			}
+		}
+		if (keep && i)
+			list[count++] = i;
+	}
+	if (count == segCount - 1)
+		free(list);
+	else
+	{
+		*active = list;
+		*activeCount = count;
+	}
+}
+double FFTConvolverSkipErrorDb(const FFTConvolverSkipStats *stats)
+{
+	if (stats->droppedEnergy <= 0.0 || stats->energy <= 0.0)
+		return -HUGE_VAL;
+	return 10.0 * log10(stats->droppedEnergy / stats->energy);
+}
+double FFTConvolverSkipPeakError(const FFTConvolverSkipStats *stats)
+{
+	return sqrt(stats->droppedEnergy * stats->droppedTaps);
+}
+double FFTConvolverSkipSaving(const FFTConvolverSkipStats *stats)
+{
+	return stats->macRate > 0.0 ? stats->droppedMacRate / stats->macRate : 0.0;
+}
+double FFTConvolver2x4x2PartitionPowerMax(FFTConvolver2x4x2 *conv)
+{
+	if (!conv->bit)
+		return 0.0;
+	return spectrumPowerMax(conv->_segmentsLLIRRe, 4, conv->_segCount, conv->_fftComplexSize, conv->_segSize, conv->_blockSize);
+}
+double FFTConvolver2x2PartitionPowerMax(FFTConvolver2x2 *conv)
+{
+	if (!conv->bit)
+		return 0.0;
+	return spectrumPowerMax(conv->_segmentsLLIRRe, 2, conv->_segCount, conv->_fftComplexSize, conv->_segSize, conv->_blockSize);
+}
+double FFTConvolverNxMPartitionPowerMax(FFTConvolverNxM *conv)
+{
+	if (!conv->bit)
+		return 0.0;
+	return spectrumPowerMax(conv->_segmentsIRRe[0], conv->_inputs * conv->_outputs, conv->_segCount, conv->_fftComplexSize, conv->_segSize, conv->_blockSize);
+}
+void FFTConvolver2x4x2SkipPartitions(FFTConvolver2x4x2 *conv, double floor, FFTConvolverSkipStats *stats)
+{
+	if (conv->bit)
+		spectrumSkip(conv->_segmentsLLIRRe, 4, 2, conv->_segCount, conv->_fftComplexSize, conv->_segSize, conv->_blockSize, floor, &conv->_activeSegments, &conv->_activeCount, stats);
+}
+void FFTConvolver2x2SkipPartitions(FFTConvolver2x2 *conv, double floor, FFTConvolverSkipStats *stats)
+{
+	if (conv->bit)
+		spectrumSkip(conv->_segmentsLLIRRe, 2, 1, conv->_segCount, conv->_fftComplexSize, conv->_segSize, conv->_blockSize, floor, &conv->_activeSegments, &conv->_activeCount, stats);
+}
+void FFTConvolverNxMSkipPartitions(FFTConvolverNxM *conv, double floor, FFTConvolverSkipStats *stats)
+{
+	if (conv->bit)
+		spectrumSkip(conv->_segmentsIRRe[0], conv->_inputs * conv->_outputs, conv->_inputs, conv->_segCount, conv->_fftComplexSize, conv->_segSize, conv->_blockSize, floor, &conv->_activeSegments, &conv->_activeCount, stats);
+}
+int FFTConvolver2x4x2Symmetric(const float* irLL, const float* irLR, const float* irRL, const float* irRR, unsigned int irLen)
+{
+	double energy = 0.0, diff = 0.0;
+	for (unsigned int i = 0; i < irLen; i++)
+	{
+		const double ipsi = (double)irLL[i] - irRR[i];
+		const double contra = (double)irLR[i] - irRL[i];
+		energy += (double)irLL[i] * irLL[i] + (double)irLR[i] * irLR[i] + (double)irRL[i] * irRL[i] + (double)irRR[i] * irRR[i];
+		diff += ipsi * ipsi + contra * contra;
+	}
+	return energy > 0.0 && diff <= energy * 1e-10;
+}
+void FFTConvolver2x4x2MidSideImpulseResponse(const float* irLL, const float* irLR, float* irMid, float* irSide, unsigned int irLen)
+{
+	for (unsigned int i = 0; i < irLen; i++)
+	{
+		irMid[i] = (irLL[i] + irLR[i]) * 0.5f;
+		irSide[i] = (irLL[i] - irLR[i]) * 0.5f;
+	}
+}
+void FFTConvolverMidSide(float* x1, float* x2, unsigned int len)
+{
+	for (unsigned int i = 0; i < len; i++)
+	{
+		const float a = x1[i], b = x2[i];
+		x1[i] = a + b;
+		x2[i] = a - b;
+	}
+}
+size_t FFTConvolver2x4x2MemoryUsage(FFTConvolver2x4x2 *conv)
+{
+	if (!conv->bit)
+		return 0;
+	// 4 input and 8 impulse response spectra per segment, shared impulse responses are not owned
+	return (size_t)conv->_segCount * 12 * sizeof(float*) + (size_t)conv->_segCount * (conv->_irShared ? 4 : 12) * spectrumStride(conv->_fftComplexSize) * sizeof(float)
+		+ conv->_segSize * (sizeof(unsigned int) + 3 * sizeof(float))
+		+ 4 * (conv->_fftComplexSize + conv->_blockSize) * sizeof(float)
+		+ conv->_activeCount * sizeof(unsigned int);
+}
+size_t FFTConvolver2x2MemoryUsage(FFTConvolver2x2 *conv)
+{
+	if (!conv->bit)
+		return 0;
+	return (size_t)conv->_segCount * 8 * sizeof(float*) + (size_t)conv->_segCount * (4 + (conv->_irShared ? 0 : (conv->_sharedKernel ? 2 : 4))) * spectrumStride(conv->_fftComplexSize) * sizeof(float)
+		+ conv->_segSize * (sizeof(unsigned int) + 3 * sizeof(float))
+		+ 4 * (conv->_fftComplexSize + conv->_blockSize) * sizeof(float)
+		+ conv->_activeCount * sizeof(unsigned int);
+}
+size_t FFTConvolverNxMMemoryUsage(FFTConvolverNxM *conv)
+{
+	if (!conv->bit)
+		return 0;
+	const size_t spectra = 2 * conv->_inputs + 2 * conv->_inputs * conv->_outputs;
+	return (size_t)conv->_segCount * spectra * sizeof(float*) + (size_t)conv->_segCount * (conv->_irShared ? 2 * conv->_inputs : spectra) * spectrumStride(conv->_fftComplexSize) * sizeof(float)
+		+ conv->_segSize * (sizeof(unsigned int) + (1 + conv->_outputs) * sizeof(float))
+		+ (2 * conv->_outputs + 2) * conv->_fftComplexSize * sizeof(float) + (conv->_inputs + conv->_outputs) * conv->_blockSize * sizeof(float)
+		+ conv->_activeCount * sizeof(unsigned int);
+}
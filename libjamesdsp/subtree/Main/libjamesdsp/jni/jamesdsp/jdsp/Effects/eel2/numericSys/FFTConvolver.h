@@ -1,6 +1,57 @@
 #ifndef _FFTCONVOLVER_FFTCONVOLVER_H
 #define _FFTCONVOLVER_FFTCONVOLVER_H
+#include <stddef.h>
+#include "spectralMAC.h"
+#include "realFFT.h"
 extern unsigned int upper_power_of_two(unsigned int v);
+// Read only impulse response spectra shared between convolvers, released once by every convolver using them
+typedef struct FFTConvolverSharedSpectra
+{
+	void(*release)(struct FFTConvolverSharedSpectra *self);
+} FFTConvolverSharedSpectra;
+/**
+* @brief Source of precomputed impulse response spectra
+*
+* share may return read only spectra of the given size that the convolver then uses in
+* place of its own arena, setting owner to what it releases when freed. Otherwise fill
+* gets the impulse response arena of each convolver loaded on the thread the hook is set
+* on and returns 1 when it wrote all bytes, the spectra are transformed otherwise and
+* handed to store.
+*/
+typedef struct
+{
+	const float *(*share)(void *ctx, size_t bytes, FFTConvolverSharedSpectra **owner);
+	int(*fill)(void *ctx, float *arena, size_t bytes);
+	void(*store)(void *ctx, const float *arena, size_t bytes);
+	void *ctx;
+} FFTConvolverSpectrumHook;
+// Applies to the calling thread, NULL detaches
+extern void FFTConvolverSetSpectrumHook(const FFTConvolverSpectrumHook *hook);
+/**
+* @brief Outcome of partition skipping, accumulated over every convolver it ran on
+*
+* Dropping partitions of energy E_d out of E changes the output by E_d / E of its
+* energy for white input, and by at most sqrt(E_d * droppedTaps) per sample for
+* input within [-1, 1]. An output sums one path per input, so droppedTaps counts
+* the dropped taps of every input feeding it. The MAC rates count the complex multiply-accumulates per
+* input sample of the frequency domain delay lines, the FFTs are not affected.
+*/
+typedef struct
+{
+	double energy; // Impulse response energy of all partitions
+	double droppedEnergy;
+	unsigned int partitions;
+	unsigned int droppedPartitions;
+	unsigned int droppedTaps; // Per output, summed over the inputs feeding it
+	double macRate;
+	double droppedMacRate;
+} FFTConvolverSkipStats;
+// Relative output error energy for white input in dB, -inf when nothing was dropped
+extern double FFTConvolverSkipErrorDb(const FFTConvolverSkipStats *stats);
+// Worst case output error per sample for input within [-1, 1]
+extern double FFTConvolverSkipPeakError(const FFTConvolverSkipStats *stats);
+// Share of the spectral MACs saved, 0..1
+extern double FFTConvolverSkipSaving(const FFTConvolverSkipStats *stats);
 /**
 * @class FFTConvolver1x1
 * @brief Implementation of a partitioned FFT convolution algorithm with uniform block size
@@ -27,6 +78,9 @@ typedef struct
 	unsigned int _segCount;
 	unsigned int _segCountMinus1;
 	unsigned int _fftComplexSize;
+	float *_inputArena; // Input spectra of all segments, one 64 byte aligned block used as a ring from _current
+	float *_irArena; // Impulse response spectra, same layout
+	struct FFTConvolverSharedSpectra *_irShared; // Owner of _irArena when it is mapped from a shared cache entry
 	float **_segmentsRe;
 	float **_segmentsIm;
 	float **_segmentsIRRe;
@@ -40,6 +94,7 @@ typedef struct
 	float *_inputBuffer;
 	unsigned int _inputBufferFill;
 	float gain; // float32, it's perfectly safe to have blockSize == 2097152, however, it's impractical to have such large block
+	const SpectralMACKernels *mac;
 	void(*fft)(float*, const float*);
 } FFTConvolver1x1;
 typedef struct
@@ -49,6 +104,9 @@ typedef struct
 	unsigned int _segCount;
 	unsigned int _segCountMinus1;
 	unsigned int _fftComplexSize;
+	float *_inputArena; // Input spectra of all segments, one 64 byte aligned block used as a ring from _current
+	float *_irArena; // Impulse response spectra, same layout
+	struct FFTConvolverSharedSpectra *_irShared; // Owner of _irArena when it is mapped from a shared cache entry
 	float **_segmentsReLeft;
 	float **_segmentsImLeft;
 	float **_segmentsReRight;
@@ -69,7 +127,10 @@ typedef struct
 	unsigned int _current;
 	float *_inputBuffer[2];
 	unsigned int _inputBufferFill;
+	unsigned int *_activeSegments; // Segments 1..N-1 still multiplied after partition skipping, NULL: all of them
+	unsigned int _activeCount;
 	float gain; // float32, it's perfectly safe to have blockSize == 2097152, however, it's impractical to have such large block
+	const SpectralMACKernels *mac;
 	void(*fft)(float*, const float*);
 } FFTConvolver2x4x2;
 typedef struct
@@ -79,6 +140,9 @@ typedef struct
 	unsigned int _segCount;
 	unsigned int _segCountMinus1;
 	unsigned int _fftComplexSize;
+	float *_inputArena; // Input spectra of all segments, one 64 byte aligned block used as a ring from _current
+	float *_irArena; // Impulse response spectra, same layout
+	struct FFTConvolverSharedSpectra *_irShared; // Owner of _irArena when it is mapped from a shared cache entry
 	float **_segmentsReLeft;
 	float **_segmentsImLeft;
 	float **_segmentsReRight;
@@ -87,6 +151,7 @@ typedef struct
 	float **_segmentsLLIRIm;
 	float **_segmentsRRIRRe;
 	float **_segmentsRRIRIm;
+	int _sharedKernel; // Loaded with irL == irR, the RR tables point at the LL spectra and the IR arena holds one spectrum per segment
 	float *_fftBuffer[2];
 	unsigned int *bit;
 	float *sine;
@@ -95,7 +160,10 @@ typedef struct
 	unsigned int _current;
 	float *_inputBuffer[2];
 	unsigned int _inputBufferFill;
+	unsigned int *_activeSegments; // Segments 1..N-1 still multiplied after partition skipping, NULL: all of them
+	unsigned int _activeCount;
 	float gain; // float32, it's perfectly safe to have blockSize == 2097152, however, it's impractical to have such large block
+	const SpectralMACKernels *mac;
 	void(*fft)(float*, const float*);
 } FFTConvolver2x2;
 typedef struct
@@ -105,6 +173,9 @@ typedef struct
 	unsigned int _segCount;
 	unsigned int _segCountMinus1;
 	unsigned int _fftComplexSize;
+	float *_inputArena; // Input spectra of all segments, one 64 byte aligned block used as a ring from _current
+	float *_irArena; // Impulse response spectra, same layout
+	struct FFTConvolverSharedSpectra *_irShared; // Owner of _irArena when it is mapped from a shared cache entry
 	float **_segmentsRe;
 	float **_segmentsIm;
 	float **_segmentsLLIRRe;
@@ -120,12 +191,55 @@ typedef struct
 	float *_inputBuffer;
 	unsigned int _inputBufferFill;
 	float gain; // float32, it's perfectly safe to have blockSize == 2097152, however, it's impractical to have such large block
+	const SpectralMACKernels *mac;
 	void(*fft)(float*, const float*);
 } FFTConvolver1x2;
+#define FFTCONVOLVER_MAX_CHANNELS (8)
+/**
+* @class FFTConvolverNxM
+* @brief Partitioned convolution of N inputs with an N x M matrix of impulse responses
+*
+* Output o is the sum over the inputs i of input i convolved with impulse response
+* i * M + o, the 2x4x2 convolver is the 2 x 2 case (LL, LR, RL, RR). Each block takes
+* one forward FFT per input and one inverse FFT per output, the N x M products are
+* accumulated in the frequency domain.
+*/
+typedef struct
+{
+	unsigned int _inputs;
+	unsigned int _outputs;
+	unsigned int _blockSize;
+	unsigned int _segSize;
+	unsigned int _segCount;
+	unsigned int _segCountMinus1;
+	unsigned int _fftComplexSize;
+	float *_inputArena; // Input spectra of all segments, one 64 byte aligned block used as a ring from _current
+	float *_irArena; // Impulse response spectra, same layout
+	struct FFTConvolverSharedSpectra *_irShared; // Owner of _irArena when it is mapped from a shared cache entry
+	float **_segmentsRe[FFTCONVOLVER_MAX_CHANNELS];
+	float **_segmentsIm[FFTCONVOLVER_MAX_CHANNELS];
+	float **_segmentsIRRe[FFTCONVOLVER_MAX_CHANNELS * FFTCONVOLVER_MAX_CHANNELS];
+	float **_segmentsIRIm[FFTCONVOLVER_MAX_CHANNELS * FFTCONVOLVER_MAX_CHANNELS];
+	float *_fftBuffer[FFTCONVOLVER_MAX_CHANNELS];
+	unsigned int *bit;
+	float *sine;
+	float *_preMultiplied[FFTCONVOLVER_MAX_CHANNELS][2];
+	float *_accumulator[2];
+	float *_overlap[FFTCONVOLVER_MAX_CHANNELS];
+	unsigned int _current;
+	float *_inputBuffer[FFTCONVOLVER_MAX_CHANNELS];
+	unsigned int _inputBufferFill;
+	unsigned int *_activeSegments; // Segments 1..N-1 still multiplied after partition skipping, NULL: all of them
+	unsigned int _activeCount;
+	float gain;
+	const SpectralMACKernels *mac;
+	void(*fft)(float*, const float*);
+} FFTConvolverNxM;
 extern void FFTConvolver1x1Init(FFTConvolver1x1 *conv);
 extern void FFTConvolver2x4x2Init(FFTConvolver2x4x2 *conv);
 extern void FFTConvolver2x2Init(FFTConvolver2x2 *conv);
 extern void FFTConvolver1x2Init(FFTConvolver1x2 *conv);
+extern void FFTConvolverNxMInit(FFTConvolverNxM *conv);
 
 /**
 * @brief Initializes the convolver
@@ -138,6 +252,8 @@ int FFTConvolver1x1LoadImpulseResponse(FFTConvolver1x1 *conv, unsigned int block
 int FFTConvolver2x4x2LoadImpulseResponse(FFTConvolver2x4x2 *conv, unsigned int blockSize, const float* irLL, const float* irLR, const float* irRL, const float* irRR, unsigned int irLen);
 int FFTConvolver2x2LoadImpulseResponse(FFTConvolver2x2 *conv, unsigned int blockSize, const float* irL, const float* irR, unsigned int irLen);
 int FFTConvolver1x2LoadImpulseResponse(FFTConvolver1x2 *conv, unsigned int blockSize, const float* irL, const float* irR, unsigned int irLen);
+// ir[i * outputs + o] runs from input i to output o, inputs and outputs are at most FFTCONVOLVER_MAX_CHANNELS
+int FFTConvolverNxMLoadImpulseResponse(FFTConvolverNxM *conv, unsigned int blockSize, unsigned int inputs, unsigned int outputs, const float *const *ir, unsigned int irLen);
 
 /**
 * @brief Convolves the the given input samples and immediately outputs the result
@@ -149,6 +265,18 @@ extern void FFTConvolver1x1Process(FFTConvolver1x1 *conv, const float* input, fl
 extern void FFTConvolver2x4x2Process(FFTConvolver2x4x2 *conv, const float* x1, const float* x2, float* y1, float* y2, unsigned int len);
 extern void FFTConvolver2x2Process(FFTConvolver2x2 *conv, const float* x1, const float* x2, float* y1, float* y2, unsigned int len);
 extern void FFTConvolver1x2Process(FFTConvolver1x2 *conv, const float* x, float* y1, float* y2, unsigned int len);
+extern void FFTConvolverNxMProcess(FFTConvolverNxM *conv, const float *const *x, float *const *y, unsigned int len);
+
+/**
+* @brief Accumulates segments 1..N-1 of the frequency domain delay line into _preMultiplied
+*
+* Called at the start of every block, the 2-stage convolvers use it for their inlined head.
+*/
+extern void FFTConvolver1x1PreMultiply(FFTConvolver1x1 *conv);
+extern void FFTConvolver2x4x2PreMultiply(FFTConvolver2x4x2 *conv);
+extern void FFTConvolver2x2PreMultiply(FFTConvolver2x2 *conv);
+extern void FFTConvolver1x2PreMultiply(FFTConvolver1x2 *conv);
+extern void FFTConvolverNxMPreMultiply(FFTConvolverNxM *conv);
 
 /**
 * @brief Resets the convolver and discards the set impulse response
@@ -157,11 +285,58 @@ extern void FFTConvolver1x1Free(FFTConvolver1x1 *conv);
 extern void FFTConvolver2x4x2Free(FFTConvolver2x4x2 *conv);
 extern void FFTConvolver2x2Free(FFTConvolver2x2 *conv);
 extern void FFTConvolver1x2Free(FFTConvolver1x2 *conv);
+extern void FFTConvolverNxMFree(FFTConvolverNxM *conv);
+
+/**
+* @brief Heap owned by the convolver, in bytes
+*/
+extern size_t FFTConvolver2x4x2MemoryUsage(FFTConvolver2x4x2 *conv);
+extern size_t FFTConvolver2x2MemoryUsage(FFTConvolver2x2 *conv);
+extern size_t FFTConvolverNxMMemoryUsage(FFTConvolverNxM *conv);
+
+/**
+* @brief Partition skipping for sparse or decaying impulse responses
+*
+* PartitionPowerMax returns the largest mean power (energy per sample) of a partition.
+* SkipPartitions stops multiplying the partitions whose mean power is at most floor,
+* exactly silent ones included, and adds to stats. The first partition is always
+* kept. Calling it again reevaluates every partition.
+*/
+extern double FFTConvolver2x4x2PartitionPowerMax(FFTConvolver2x4x2 *conv);
+extern double FFTConvolver2x2PartitionPowerMax(FFTConvolver2x2 *conv);
+extern double FFTConvolverNxMPartitionPowerMax(FFTConvolverNxM *conv);
+extern void FFTConvolver2x4x2SkipPartitions(FFTConvolver2x4x2 *conv, double floor, FFTConvolverSkipStats *stats);
+extern void FFTConvolver2x2SkipPartitions(FFTConvolver2x2 *conv, double floor, FFTConvolverSkipStats *stats);
+extern void FFTConvolverNxMSkipPartitions(FFTConvolverNxM *conv, double floor, FFTConvolverSkipStats *stats);
+
+/**
+* @brief Mid/side form of left/right mirrored 2x4x2 impulse responses
+*
+* With irLL == irRR and irLR == irRL the 2x4x2 convolution equals a 2x2 one on
+* mid = L + R and side = L - R with the impulse responses (irLL + irLR) / 2 and
+* (irLL - irLR) / 2, followed by the same sum/difference back to left/right. Half
+* the spectra are stored and multiplied. Symmetric accepts differences 100 dB
+* below the impulse response energy.
+*/
+extern int FFTConvolver2x4x2Symmetric(const float* irLL, const float* irLR, const float* irRL, const float* irRR, unsigned int irLen);
+extern void FFTConvolver2x4x2MidSideImpulseResponse(const float* irLL, const float* irLR, float* irMid, float* irSide, unsigned int irLen);
+// In place, the same butterfly encodes before and decodes after the 2x2 convolver
+extern void FFTConvolverMidSide(float* x1, float* x2, unsigned int len);
 
 /**
 * @brief Refreshs the convolver without modify memory pointers
-* blockSize, irLen must be the same as the one in initialization
+* blockSize, irLen must be the same as the one in initialization, a shared kernel 2x2 convolver only takes irL
 */
 extern int FFTConvolver1x1RefreshImpulseResponse(FFTConvolver1x1 *conv, unsigned int blockSize, const float* ir, unsigned int irLen);
 extern void FFTConvolver2x2RefreshImpulseResponse(FFTConvolver2x2 *conv1, FFTConvolver2x2 *conv2, const float *irL, const float *irR, unsigned int irLen);
+/**
+* @brief Exchanges impulse responses between two convolvers
+* Input history of both is kept when the partitioning matches (returns 1), otherwise the convolvers are swapped whole (returns 0)
+*/
+extern int FFTConvolver2x2ExchangeImpulseResponse(FFTConvolver2x2 *conv1, FFTConvolver2x2 *conv2);
+/**
+* @brief Clears the input history and pending output, the impulse response is kept
+* Allocation free, safe on the audio thread
+*/
+extern void FFTConvolver2x2Reset(FFTConvolver2x2 *conv);
 #endif
\ No newline at end of file
@@ -0,0 +1,315 @@
+#include <math.h>
+#include "realFFT.h"
+#include "codelet.h"
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define REALFFT_X86
+#include <immintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define REALFFT_ARM
+#include <arm_neon.h>
+#endif
+#define REALFFT_SQRT1_2 (0.70710678118654752440084436210485f)
+// Cosine and sine twiddles of the stage merging blocks of half points into 2 * half
+static inline void fhtStageTwiddles(const float *table, unsigned int n, unsigned int half, const float **c, const float **s)
+{
+	if (half == (n >> 1))
+	{
+		*c = table + (n >> 2);
+		*s = table;
+	}
+	else
+	{
+		*c = table + (n >> 1) + (half - 8);
+		*s = *c + (half >> 1);
+	}
+}
+// Radix 4 stage and the 8 point stage, no twiddles
+static inline void fhtFirstStagesScalar(float *A, unsigned int n)
+{
+	unsigned int i;
+	float alpha, beta, beta1, beta2, y0, y1, y2, y3;
+	for (i = 0; i < n; i += 4)
+	{
+		alpha = A[i];
+		beta = A[i + 1];
+		beta1 = A[i + 2];
+		beta2 = A[i + 3];
+		y0 = alpha + beta;
+		y1 = alpha - beta;
+		y2 = beta1 + beta2;
+		y3 = beta1 - beta2;
+		A[i] = y0 + y2;
+		A[i + 2] = y0 - y2;
+		A[i + 1] = y1 + y3;
+		A[i + 3] = y1 - y3;
+	}
+	for (i = 0; i < n; i += 8)
+	{
+		alpha = A[i];
+		beta = A[i + 4];
+		A[i] = alpha + beta;
+		A[i + 4] = alpha - beta;
+		alpha = A[i + 2];
+		beta = A[i + 6];
+		A[i + 2] = alpha + beta;
+		A[i + 6] = alpha - beta;
+		alpha = A[i + 1];
+		beta1 = REALFFT_SQRT1_2 * (A[i + 5] + A[i + 7]);
+		beta2 = REALFFT_SQRT1_2 * (A[i + 5] - A[i + 7]);
+		A[i + 1] = alpha + beta1;
+		A[i + 5] = alpha - beta1;
+		alpha = A[i + 3];
+		A[i + 3] = alpha + beta2;
+		A[i + 7] = alpha - beta2;
+	}
+}
+// Twiddle free butterflies at the start and the middle of a block
+static inline void fhtBlockEdges(float *A, unsigned int half)
+{
+	float alpha = A[0], beta = A[half];
+	A[0] = alpha + beta;
+	A[half] = alpha - beta;
+	alpha = A[half >> 1];
+	beta = A[half + (half >> 1)];
+	A[half >> 1] = alpha + beta;
+	A[half + (half >> 1)] = alpha - beta;
+}
+static inline void fhtButterfliesScalar(float *A, unsigned int half, unsigned int j, const float *c, const float *s)
+{
+	float alpha, beta, beta1, beta2;
+	for (; j < (half >> 1); j++)
+	{
+		alpha = A[j];
+		beta = A[half - j];
+		beta1 = A[half + j] * c[j] + A[2 * half - j] * s[j];
+		beta2 = A[half + j] * s[j] - A[2 * half - j] * c[j];
+		A[j] = alpha + beta1;
+		A[half + j] = alpha - beta1;
+		A[half - j] = beta + beta2;
+		A[2 * half - j] = beta - beta2;
+	}
+}
+// Small transforms stay on the unrolled codelets, the loop kernels take over from 64 points
+#define REALFFT_CODELETS DFT2, DFT4, DFT8, DFT16, DFT32
+#define REALFFT_WRAP(N, SET) static void fht##N##SET(float *A, const float *table) { fht##SET(A, N, table); }
+#define REALFFT_WRAPALL(SET) \
+REALFFT_WRAP(64, SET) REALFFT_WRAP(128, SET) REALFFT_WRAP(256, SET) REALFFT_WRAP(512, SET) REALFFT_WRAP(1024, SET) \
+REALFFT_WRAP(2048, SET) REALFFT_WRAP(4096, SET) REALFFT_WRAP(8192, SET) REALFFT_WRAP(16384, SET) REALFFT_WRAP(32768, SET) \
+REALFFT_WRAP(65536, SET) REALFFT_WRAP(131072, SET) REALFFT_WRAP(262144, SET) REALFFT_WRAP(524288, SET) REALFFT_WRAP(1048576, SET)
+#define REALFFT_KERNELS(SET) \
+fht64##SET, fht128##SET, fht256##SET, fht512##SET, fht1024##SET, fht2048##SET, fht4096##SET, fht8192##SET, fht16384##SET, \
+fht32768##SET, fht65536##SET, fht131072##SET, fht262144##SET, fht524288##SET, fht1048576##SET
+static const RealFFTKernels kernelsScalar =
+{
+	REALFFT_SCALAR, "scalar",
+	{
+		0, DFT2, DFT4, DFT8, DFT16, DFT32, DFT64, DFT128, DFT256, DFT512, DFT1024, DFT2048, DFT4096, DFT8192, DFT16384,
+		DFT32768, DFT65536, DFT131072, DFT262144, DFT524288, DFT1048576
+	}
+};
+#ifdef REALFFT_X86
+// Same operation order as the codelets, so the results are bit identical
+#define SSE2_FN __attribute__((target("sse2")))
+SSE2_FN static inline __m128 reverseSSE2(__m128 v)
+{
+	return _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 1, 2, 3));
+}
+// Both stages of four 8 point blocks at once, transposed so every lane holds one block
+SSE2_FN static inline void fhtFirstStagesSSE2(float *A, unsigned int n)
+{
+	const __m128 k = _mm_set1_ps(REALFFT_SQRT1_2);
+	for (unsigned int i = 0; i < n; i += 32)
+	{
+		__m128 l0 = _mm_loadu_ps(A + i), h0 = _mm_loadu_ps(A + i + 4);
+		__m128 l1 = _mm_loadu_ps(A + i + 8), h1 = _mm_loadu_ps(A + i + 12);
+		__m128 l2 = _mm_loadu_ps(A + i + 16), h2 = _mm_loadu_ps(A + i + 20);
+		__m128 l3 = _mm_loadu_ps(A + i + 24), h3 = _mm_loadu_ps(A + i + 28);
+		_MM_TRANSPOSE4_PS(l0, l1, l2, l3);
+		_MM_TRANSPOSE4_PS(h0, h1, h2, h3);
+		__m128 y0 = _mm_add_ps(l0, l1), y1 = _mm_sub_ps(l0, l1), y2 = _mm_add_ps(l2, l3), y3 = _mm_sub_ps(l2, l3);
+		__m128 e0 = _mm_add_ps(y0, y2), e2 = _mm_sub_ps(y0, y2), e1 = _mm_add_ps(y1, y3), e3 = _mm_sub_ps(y1, y3);
+		y0 = _mm_add_ps(h0, h1);
+		y1 = _mm_sub_ps(h0, h1);
+		y2 = _mm_add_ps(h2, h3);
+		y3 = _mm_sub_ps(h2, h3);
+		__m128 f0 = _mm_add_ps(y0, y2), f2 = _mm_sub_ps(y0, y2), f1 = _mm_add_ps(y1, y3), f3 = _mm_sub_ps(y1, y3);
+		__m128 beta1 = _mm_mul_ps(k, _mm_add_ps(f1, f3));
+		__m128 beta2 = _mm_mul_ps(k, _mm_sub_ps(f1, f3));
+		l0 = _mm_add_ps(e0, f0);
+		h0 = _mm_sub_ps(e0, f0);
+		l2 = _mm_add_ps(e2, f2);
+		h2 = _mm_sub_ps(e2, f2);
+		l1 = _mm_add_ps(e1, beta1);
+		h1 = _mm_sub_ps(e1, beta1);
+		l3 = _mm_add_ps(e3, beta2);
+		h3 = _mm_sub_ps(e3, beta2);
+		_MM_TRANSPOSE4_PS(l0, l1, l2, l3);
+		_MM_TRANSPOSE4_PS(h0, h1, h2, h3);
+		_mm_storeu_ps(A + i, l0);
+		_mm_storeu_ps(A + i + 4, h0);
+		_mm_storeu_ps(A + i + 8, l1);
+		_mm_storeu_ps(A + i + 12, h1);
+		_mm_storeu_ps(A + i + 16, l2);
+		_mm_storeu_ps(A + i + 20, h2);
+		_mm_storeu_ps(A + i + 24, l3);
+		_mm_storeu_ps(A + i + 28, h3);
+	}
+}
+SSE2_FN static inline unsigned int fhtButterfliesSSE2(float *A, unsigned int half, unsigned int j, const float *c, const float *s)
+{
+	for (; j + 4 <= (half >> 1); j += 4)
+	{
+		__m128 a = _mm_loadu_ps(A + j), b = reverseSSE2(_mm_loadu_ps(A + half - j - 3));
+		__m128 x = _mm_loadu_ps(A + half + j), y = reverseSSE2(_mm_loadu_ps(A + 2 * half - j - 3));
+		__m128 wc = _mm_loadu_ps(c + j), ws = _mm_loadu_ps(s + j);
+		__m128 beta1 = _mm_add_ps(_mm_mul_ps(x, wc), _mm_mul_ps(y, ws));
+		__m128 beta2 = _mm_sub_ps(_mm_mul_ps(x, ws), _mm_mul_ps(y, wc));
+		_mm_storeu_ps(A + j, _mm_add_ps(a, beta1));
+		_mm_storeu_ps(A + half + j, _mm_sub_ps(a, beta1));
+		_mm_storeu_ps(A + half - j - 3, reverseSSE2(_mm_add_ps(b, beta2)));
+		_mm_storeu_ps(A + 2 * half - j - 3, reverseSSE2(_mm_sub_ps(b, beta2)));
+	}
+	return j;
+}
+SSE2_FN static void fhtSSE2(float *A, unsigned int n, const float *table)
+{
+	const float *c, *s;
+	fhtFirstStagesSSE2(A, n);
+	for (unsigned int half = 8; half < n; half <<= 1)
+	{
+		fhtStageTwiddles(table, n, half, &c, &s);
+		for (unsigned int i = 0; i < n; i += half << 1)
+		{
+			fhtBlockEdges(A + i, half);
+			fhtButterfliesScalar(A + i, half, fhtButterfliesSSE2(A + i, half, 1, c, s), c, s);
+		}
+	}
+}
+REALFFT_WRAPALL(SSE2)
+static const RealFFTKernels kernelsSSE2 =
+{
+	REALFFT_SSE2, "sse2",
+	{ 0, REALFFT_CODELETS, REALFFT_KERNELS(SSE2) }
+};
+// No FMA, the separate rounding keeps the results identical to the codelets
+#define AVX2_FN __attribute__((target("avx2")))
+AVX2_FN static void fhtAVX2(float *A, unsigned int n, const float *table)
+{
+	const __m256i rev = _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+	const float *c, *s;
+	fhtFirstStagesSSE2(A, n);
+	for (unsigned int half = 8; half < n; half <<= 1)
+	{
+		fhtStageTwiddles(table, n, half, &c, &s);
+		for (unsigned int i = 0; i < n; i += half << 1)
+		{
+			float *B = A + i;
+			unsigned int j = 1;
+			fhtBlockEdges(B, half);
+			for (; j + 8 <= (half >> 1); j += 8)
+			{
+				__m256 a = _mm256_loadu_ps(B + j), b = _mm256_permutevar8x32_ps(_mm256_loadu_ps(B + half - j - 7), rev);
+				__m256 x = _mm256_loadu_ps(B + half + j), y = _mm256_permutevar8x32_ps(_mm256_loadu_ps(B + 2 * half - j - 7), rev);
+				__m256 wc = _mm256_loadu_ps(c + j), ws = _mm256_loadu_ps(s + j);
+				__m256 beta1 = _mm256_add_ps(_mm256_mul_ps(x, wc), _mm256_mul_ps(y, ws));
+				__m256 beta2 = _mm256_sub_ps(_mm256_mul_ps(x, ws), _mm256_mul_ps(y, wc));
+				_mm256_storeu_ps(B + j, _mm256_add_ps(a, beta1));
+				_mm256_storeu_ps(B + half + j, _mm256_sub_ps(a, beta1));
+				_mm256_storeu_ps(B + half - j - 7, _mm256_permutevar8x32_ps(_mm256_add_ps(b, beta2), rev));
+				_mm256_storeu_ps(B + 2 * half - j - 7, _mm256_permutevar8x32_ps(_mm256_sub_ps(b, beta2), rev));
+			}
+			fhtButterfliesScalar(B, half, fhtButterfliesSSE2(B, half, j, c, s), c, s);
+		}
+	}
+}
+REALFFT_WRAPALL(AVX2)
+static const RealFFTKernels kernelsAVX2 =
+{
+	REALFFT_AVX2, "avx2",
+	{ 0, REALFFT_CODELETS, REALFFT_KERNELS(AVX2) }
+};
+#endif
+#ifdef REALFFT_ARM
+static inline float32x4_t reverseNEON(float32x4_t v)
+{
+	v = vrev64q_f32(v);
+	return vcombine_f32(vget_high_f32(v), vget_low_f32(v));
+}
+static void fhtNEON(float *A, unsigned int n, const float *table)
+{
+	const float *c, *s;
+	fhtFirstStagesScalar(A, n);
+	for (unsigned int half = 8; half < n; half <<= 1)
+	{
+		fhtStageTwiddles(table, n, half, &c, &s);
+		for (unsigned int i = 0; i < n; i += half << 1)
+		{
+			float *B = A + i;
+			unsigned int j = 1;
+			fhtBlockEdges(B, half);
+			for (; j + 4 <= (half >> 1); j += 4)
+			{
+				float32x4_t a = vld1q_f32(B + j), b = reverseNEON(vld1q_f32(B + half - j - 3));
+				float32x4_t x = vld1q_f32(B + half + j), y = reverseNEON(vld1q_f32(B + 2 * half - j - 3));
+				float32x4_t wc = vld1q_f32(c + j), ws = vld1q_f32(s + j);
+				float32x4_t beta1 = vaddq_f32(vmulq_f32(x, wc), vmulq_f32(y, ws));
+				float32x4_t beta2 = vsubq_f32(vmulq_f32(x, ws), vmulq_f32(y, wc));
+				vst1q_f32(B + j, vaddq_f32(a, beta1));
+				vst1q_f32(B + half + j, vsubq_f32(a, beta1));
+				vst1q_f32(B + half - j - 3, reverseNEON(vaddq_f32(b, beta2)));
+				vst1q_f32(B + 2 * half - j - 3, reverseNEON(vsubq_f32(b, beta2)));
+			}
+			fhtButterfliesScalar(B, half, j, c, s);
+		}
+	}
+}
+REALFFT_WRAPALL(NEON)
+static const RealFFTKernels kernelsNEON =
+{
+	REALFFT_NEON, "neon",
+	{ 0, REALFFT_CODELETS, REALFFT_KERNELS(NEON) }
+};
+#endif
+const RealFFTKernels *realFFTSelect(int maxLevel)
+{
+#ifdef REALFFT_X86
+	__builtin_cpu_init();
+	if (maxLevel >= REALFFT_AVX2 && __builtin_cpu_supports("avx2"))
+		return &kernelsAVX2;
+	if (maxLevel >= REALFFT_SSE2 && __builtin_cpu_supports("sse2"))
+		return &kernelsSSE2;
+#elif defined(REALFFT_ARM)
+	if (maxLevel >= REALFFT_NEON)
+		return &kernelsNEON;
+#endif
+	return &kernelsScalar;
+}
+RealFFTFunc realFFTKernel(const RealFFTKernels *k, unsigned int n)
+{
+	unsigned int log2n = 0;
+	if (n < 2 || (n & (n - 1)))
+		return 0;
+	while ((1U << log2n) < n)
+		log2n++;
+	return log2n <= REALFFT_MAX_LOG2 ? k->fht[log2n] : 0;
+}
+void realFFTTable(float *dst, unsigned int n)
+{
+	const double twopi_over_n = 6.283185307179586476925286766559 / n;
+	unsigned int i, half;
+	float *stage = dst + (n >> 1);
+	for (i = 0; i < (n >> 1); ++i)
+		dst[i] = (float)sin(twopi_over_n * i);
+	for (half = 8; half < (n >> 1); half <<= 1)
+	{
+		const unsigned int step = n / (half << 1);
+		for (i = 0; i < (half >> 1); i++)
+		{
+			stage[i] = dst[i * step + (n >> 2)];
+			stage[(half >> 1) + i] = dst[i * step];
+		}
+		stage += half;
+	}
+	while (stage < dst + n)
+		*stage++ = 0.0f;
+}
@@ -0,0 +1,29 @@
+#ifndef REALFFT_H
+#define REALFFT_H
+// In place Hartley transform of bit reversed input, the real FFT of the convolvers, the compander and the FIR designers
+// The vector kernels use the operation order of the generated codelets, on x86 the results are bit identical
+enum
+{
+	REALFFT_SCALAR = 0,
+	REALFFT_SSE2,
+	REALFFT_AVX2,
+	REALFFT_NEON,
+	REALFFT_BEST
+};
+#define REALFFT_MAX_LOG2 (20)
+typedef void(*RealFFTFunc)(float *A, const float *table);
+typedef struct
+{
+	int level;
+	const char *name;
+	// Transform of 1 << k points, k = 1..REALFFT_MAX_LOG2
+	RealFFTFunc fht[REALFFT_MAX_LOG2 + 1];
+} RealFFTKernels;
+// Best kernel set the CPU supports, not exceeding maxLevel
+extern const RealFFTKernels *realFFTSelect(int maxLevel);
+// NULL unless n is a power of two the kernel set has a transform for
+extern RealFFTFunc realFFTKernel(const RealFFTKernels *k, unsigned int n);
+// Twiddle table of an n point transform, n floats used by every kernel set
+// The first n / 2 are the sine table of the codelets, the contiguous twiddles of the inner stages follow
+extern void realFFTTable(float *dst, unsigned int n);
+#endif
@@ -0,0 +1,358 @@
+#include "spectralMAC.h"
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SPECTRALMAC_X86
+#include <immintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define SPECTRALMAC_ARM
+#include <arm_neon.h>
+#endif
+static void cmacScalar(float *re, float *im, const float *aRe, const float *aIm, const float *bRe, const float *bIm, unsigned int n)
+{
+	for (unsigned int j = 0; j < n; j++)
+	{
+		re[j] += aRe[j] * bRe[j] - aIm[j] * bIm[j];
+		im[j] += aRe[j] * bIm[j] + aIm[j] * bRe[j];
+	}
+}
+static void cmac2Scalar(float *re, float *im, const float *a1Re, const float *a1Im, const float *b1Re, const float *b1Im, const float *a2Re, const float *a2Im, const float *b2Re, const float *b2Im, unsigned int n)
+{
+	for (unsigned int j = 0; j < n; j++)
+	{
+		re[j] += (a1Re[j] * b1Re[j] - a1Im[j] * b1Im[j]) + (a2Re[j] * b2Re[j] - a2Im[j] * b2Im[j]);
+		im[j] += (a1Re[j] * b1Im[j] + a1Im[j] * b1Re[j]) + (a2Re[j] * b2Im[j] + a2Im[j] * b2Re[j]);
+	}
+}
+static void cmacSharedScalar(float *re1, float *im1, float *re2, float *im2, const float *aRe, const float *aIm, const float *b1Re, const float *b1Im, const float *b2Re, const float *b2Im, unsigned int n)
+{
+	for (unsigned int j = 0; j < n; j++)
+	{
+		re1[j] += aRe[j] * b1Re[j] - aIm[j] * b1Im[j];
+		im1[j] += aRe[j] * b1Im[j] + aIm[j] * b1Re[j];
+		re2[j] += aRe[j] * b2Re[j] - aIm[j] * b2Im[j];
+		im2[j] += aRe[j] * b2Im[j] + aIm[j] * b2Re[j];
+	}
+}
+static float dotScalar(const float *a, const float *b, unsigned int n)
+{
+	float sum = 0.0f;
+	for (unsigned int j = 0; j < n; j++)
+		sum += a[j] * b[j];
+	return sum;
+}
+static const SpectralMACKernels kernelsScalar =
+{
+	SPECTRALMAC_SCALAR, "scalar",
+	cmacScalar, cmac2Scalar, cmacSharedScalar, dotScalar
+};
+#ifdef SPECTRALMAC_X86
+// Same operation order as the scalar kernels, so the results are bit identical
+#define SSE2_FN __attribute__((target("sse2")))
+SSE2_FN static void cmacSSE2(float *re, float *im, const float *aRe, const float *aIm, const float *bRe, const float *bIm, unsigned int n)
+{
+	unsigned int j = 0;
+	for (; j + 4 <= n; j += 4)
+	{
+		__m128 ar = _mm_loadu_ps(aRe + j), ai = _mm_loadu_ps(aIm + j);
+		__m128 br = _mm_loadu_ps(bRe + j), bi = _mm_loadu_ps(bIm + j);
+		_mm_storeu_ps(re + j, _mm_add_ps(_mm_loadu_ps(re + j), _mm_sub_ps(_mm_mul_ps(ar, br), _mm_mul_ps(ai, bi))));
+		_mm_storeu_ps(im + j, _mm_add_ps(_mm_loadu_ps(im + j), _mm_add_ps(_mm_mul_ps(ar, bi), _mm_mul_ps(ai, br))));
+	}
+	cmacScalar(re + j, im + j, aRe + j, aIm + j, bRe + j, bIm + j, n - j);
+}
+SSE2_FN static void cmac2SSE2(float *re, float *im, const float *a1Re, const float *a1Im, const float *b1Re, const float *b1Im, const float *a2Re, const float *a2Im, const float *b2Re, const float *b2Im, unsigned int n)
+{
+	unsigned int j = 0;
+	for (; j + 4 <= n; j += 4)
+	{
+		__m128 a1r = _mm_loadu_ps(a1Re + j), a1i = _mm_loadu_ps(a1Im + j);
+		__m128 b1r = _mm_loadu_ps(b1Re + j), b1i = _mm_loadu_ps(b1Im + j);
+		__m128 a2r = _mm_loadu_ps(a2Re + j), a2i = _mm_loadu_ps(a2Im + j);
+		__m128 b2r = _mm_loadu_ps(b2Re + j), b2i = _mm_loadu_ps(b2Im + j);
+		__m128 r = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(a1r, b1r), _mm_mul_ps(a1i, b1i)), _mm_sub_ps(_mm_mul_ps(a2r, b2r), _mm_mul_ps(a2i, b2i)));
+		__m128 i = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a1r, b1i), _mm_mul_ps(a1i, b1r)), _mm_add_ps(_mm_mul_ps(a2r, b2i), _mm_mul_ps(a2i, b2r)));
+		_mm_storeu_ps(re + j, _mm_add_ps(_mm_loadu_ps(re + j), r));
+		_mm_storeu_ps(im + j, _mm_add_ps(_mm_loadu_ps(im + j), i));
+	}
+	cmac2Scalar(re + j, im + j, a1Re + j, a1Im + j, b1Re + j, b1Im + j, a2Re + j, a2Im + j, b2Re + j, b2Im + j, n - j);
+}
+SSE2_FN static void cmacSharedSSE2(float *re1, float *im1, float *re2, float *im2, const float *aRe, const float *aIm, const float *b1Re, const float *b1Im, const float *b2Re, const float *b2Im, unsigned int n)
+{
+	unsigned int j = 0;
+	for (; j + 4 <= n; j += 4)
+	{
+		__m128 ar = _mm_loadu_ps(aRe + j), ai = _mm_loadu_ps(aIm + j);
+		__m128 br = _mm_loadu_ps(b1Re + j), bi = _mm_loadu_ps(b1Im + j);
+		_mm_storeu_ps(re1 + j, _mm_add_ps(_mm_loadu_ps(re1 + j), _mm_sub_ps(_mm_mul_ps(ar, br), _mm_mul_ps(ai, bi))));
+		_mm_storeu_ps(im1 + j, _mm_add_ps(_mm_loadu_ps(im1 + j), _mm_add_ps(_mm_mul_ps(ar, bi), _mm_mul_ps(ai, br))));
+		br = _mm_loadu_ps(b2Re + j);
+		bi = _mm_loadu_ps(b2Im + j);
+		_mm_storeu_ps(re2 + j, _mm_add_ps(_mm_loadu_ps(re2 + j), _mm_sub_ps(_mm_mul_ps(ar, br), _mm_mul_ps(ai, bi))));
+		_mm_storeu_ps(im2 + j, _mm_add_ps(_mm_loadu_ps(im2 + j), _mm_add_ps(_mm_mul_ps(ar, bi), _mm_mul_ps(ai, br))));
+	}
+	cmacSharedScalar(re1 + j, im1 + j, re2 + j, im2 + j, aRe + j, aIm + j, b1Re + j, b1Im + j, b2Re + j, b2Im + j, n - j);
+}
+// Two accumulators hide the add latency, the order of the sum differs from the scalar kernel
+SSE2_FN static float dotSSE2(const float *a, const float *b, unsigned int n)
+{
+	unsigned int j = 0;
+	__m128 s0 = _mm_setzero_ps(), s1 = _mm_setzero_ps();
+	for (; j + 8 <= n; j += 8)
+	{
+		s0 = _mm_add_ps(s0, _mm_mul_ps(_mm_loadu_ps(a + j), _mm_loadu_ps(b + j)));
+		s1 = _mm_add_ps(s1, _mm_mul_ps(_mm_loadu_ps(a + j + 4), _mm_loadu_ps(b + j + 4)));
+	}
+	s0 = _mm_add_ps(s0, s1);
+	s0 = _mm_add_ps(s0, _mm_movehl_ps(s0, s0));
+	s0 = _mm_add_ss(s0, _mm_shuffle_ps(s0, s0, 1));
+	return _mm_cvtss_f32(s0) + dotScalar(a + j, b + j, n - j);
+}
+static const SpectralMACKernels kernelsSSE2 =
+{
+	SPECTRALMAC_SSE2, "sse2",
+	cmacSSE2, cmac2SSE2, cmacSharedSSE2, dotSSE2
+};
+// Products accumulate straight into the running sum with fused multiply-adds
+#define AVX2_FN __attribute__((target("avx2,fma")))
+AVX2_FN static void cmacAVX2(float *re, float *im, const float *aRe, const float *aIm, const float *bRe, const float *bIm, unsigned int n)
+{
+	unsigned int j = 0;
+	for (; j + 8 <= n; j += 8)
+	{
+		__m256 ar = _mm256_loadu_ps(aRe + j), ai = _mm256_loadu_ps(aIm + j);
+		__m256 br = _mm256_loadu_ps(bRe + j), bi = _mm256_loadu_ps(bIm + j);
+		__m256 r = _mm256_fmadd_ps(ar, br, _mm256_loadu_ps(re + j));
+		__m256 i = _mm256_fmadd_ps(ar, bi, _mm256_loadu_ps(im + j));
+		_mm256_storeu_ps(re + j, _mm256_fnmadd_ps(ai, bi, r));
+		_mm256_storeu_ps(im + j, _mm256_fmadd_ps(ai, br, i));
+	}
+	cmacScalar(re + j, im + j, aRe + j, aIm + j, bRe + j, bIm + j, n - j);
+}
+AVX2_FN static void cmac2AVX2(float *re, float *im, const float *a1Re, const float *a1Im, const float *b1Re, const float *b1Im, const float *a2Re, const float *a2Im, const float *b2Re, const float *b2Im, unsigned int n)
+{
+	unsigned int j = 0;
+	for (; j + 8 <= n; j += 8)
+	{
+		__m256 a1r = _mm256_loadu_ps(a1Re + j), a1i = _mm256_loadu_ps(a1Im + j);
+		__m256 b1r = _mm256_loadu_ps(b1Re + j), b1i = _mm256_loadu_ps(b1Im + j);
+		__m256 a2r = _mm256_loadu_ps(a2Re + j), a2i = _mm256_loadu_ps(a2Im + j);
+		__m256 b2r = _mm256_loadu_ps(b2Re + j), b2i = _mm256_loadu_ps(b2Im + j);
+		__m256 r = _mm256_fmadd_ps(a1r, b1r, _mm256_loadu_ps(re + j));
+		__m256 i = _mm256_fmadd_ps(a1r, b1i, _mm256_loadu_ps(im + j));
+		r = _mm256_fnmadd_ps(a1i, b1i, r);
+		i = _mm256_fmadd_ps(a1i, b1r, i);
+		r = _mm256_fmadd_ps(a2r, b2r, r);
+		i = _mm256_fmadd_ps(a2r, b2i, i);
+		_mm256_storeu_ps(re + j, _mm256_fnmadd_ps(a2i, b2i, r));
+		_mm256_storeu_ps(im + j, _mm256_fmadd_ps(a2i, b2r, i));
+	}
+	cmac2Scalar(re + j, im + j, a1Re + j, a1Im + j, b1Re + j, b1Im + j, a2Re + j, a2Im + j, b2Re + j, b2Im + j, n - j);
+}
+AVX2_FN static void cmacSharedAVX2(float *re1, float *im1, float *re2, float *im2, const float *aRe, const float *aIm, const float *b1Re, const float *b1Im, const float *b2Re, const float *b2Im, unsigned int n)
+{
+	unsigned int j = 0;
+	for (; j + 8 <= n; j += 8)
+	{
+		__m256 ar = _mm256_loadu_ps(aRe + j), ai = _mm256_loadu_ps(aIm + j);
+		__m256 br = _mm256_loadu_ps(b1Re + j), bi = _mm256_loadu_ps(b1Im + j);
+		__m256 r = _mm256_fmadd_ps(ar, br, _mm256_loadu_ps(re1 + j));
+		__m256 i = _mm256_fmadd_ps(ar, bi, _mm256_loadu_ps(im1 + j));
+		_mm256_storeu_ps(re1 + j, _mm256_fnmadd_ps(ai, bi, r));
+		_mm256_storeu_ps(im1 + j, _mm256_fmadd_ps(ai, br, i));
+		br = _mm256_loadu_ps(b2Re + j);
+		bi = _mm256_loadu_ps(b2Im + j);
+		r = _mm256_fmadd_ps(ar, br, _mm256_loadu_ps(re2 + j));
+		i = _mm256_fmadd_ps(ar, bi, _mm256_loadu_ps(im2 + j));
+		_mm256_storeu_ps(re2 + j, _mm256_fnmadd_ps(ai, bi, r));
+		_mm256_storeu_ps(im2 + j, _mm256_fmadd_ps(ai, br, i));
+	}
+	cmacSharedScalar(re1 + j, im1 + j, re2 + j, im2 + j, aRe + j, aIm + j, b1Re + j, b1Im + j, b2Re + j, b2Im + j, n - j);
+}
+AVX2_FN static float dotAVX2(const float *a, const float *b, unsigned int n)
+{
+	unsigned int j = 0;
+	__m256 s0 = _mm256_setzero_ps(), s1 = _mm256_setzero_ps();
+	for (; j + 16 <= n; j += 16)
+	{
+		s0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + j), _mm256_loadu_ps(b + j), s0);
+		s1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + j + 8), _mm256_loadu_ps(b + j + 8), s1);
+	}
+	s0 = _mm256_add_ps(s0, s1);
+	__m128 s = _mm_add_ps(_mm256_castps256_ps128(s0), _mm256_extractf128_ps(s0, 1));
+	s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+	s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+	return _mm_cvtss_f32(s) + dotScalar(a + j, b + j, n - j);
+}
+static const SpectralMACKernels kernelsAVX2 =
+{
+	SPECTRALMAC_AVX2, "avx2",
+	cmacAVX2, cmac2AVX2, cmacSharedAVX2, dotAVX2
+};
+#define AVX512_FN __attribute__((target("avx512f")))
+AVX512_FN static void cmacAVX512(float *re, float *im, const float *aRe, const float *aIm, const float *bRe, const float *bIm, unsigned int n)
+{
+	unsigned int j = 0;
+	for (; j + 16 <= n; j += 16)
+	{
+		__m512 ar = _mm512_loadu_ps(aRe + j), ai = _mm512_loadu_ps(aIm + j);
+		__m512 br = _mm512_loadu_ps(bRe + j), bi = _mm512_loadu_ps(bIm + j);
+		__m512 r = _mm512_fmadd_ps(ar, br, _mm512_loadu_ps(re + j));
+		__m512 i = _mm512_fmadd_ps(ar, bi, _mm512_loadu_ps(im + j));
+		_mm512_storeu_ps(re + j, _mm512_fnmadd_ps(ai, bi, r));
+		_mm512_storeu_ps(im + j, _mm512_fmadd_ps(ai, br, i));
+	}
+	cmacScalar(re + j, im + j, aRe + j, aIm + j, bRe + j, bIm + j, n - j);
+}
+AVX512_FN static void cmac2AVX512(float *re, float *im, const float *a1Re, const float *a1Im, const float *b1Re, const float *b1Im, const float *a2Re, const float *a2Im, const float *b2Re, const float *b2Im, unsigned int n)
+{
+	unsigned int j = 0;
+	for (; j + 16 <= n; j += 16)
+	{
+		__m512 a1r = _mm512_loadu_ps(a1Re + j), a1i = _mm512_loadu_ps(a1Im + j);
+		__m512 b1r = _mm512_loadu_ps(b1Re + j), b1i = _mm512_loadu_ps(b1Im + j);
+		__m512 a2r = _mm512_loadu_ps(a2Re + j), a2i = _mm512_loadu_ps(a2Im + j);
+		__m512 b2r = _mm512_loadu_ps(b2Re + j), b2i = _mm512_loadu_ps(b2Im + j);
+		__m512 r = _mm512_fmadd_ps(a1r, b1r, _mm512_loadu_ps(re + j));
+		__m512 i = _mm512_fmadd_ps(a1r, b1i, _mm512_loadu_ps(im + j));
+		r = _mm512_fnmadd_ps(a1i, b1i, r);
+		i = _mm512_fmadd_ps(a1i, b1r, i);
+		r = _mm512_fmadd_ps(a2r, b2r, r);
+		i = _mm512_fmadd_ps(a2r, b2i, i);
+		_mm512_storeu_ps(re + j, _mm512_fnmadd_ps(a2i, b2i, r));
+		_mm512_storeu_ps(im + j, _mm512_fmadd_ps(a2i, b2r, i));
+	}
+	cmac2Scalar(re + j, im + j, a1Re + j, a1Im + j, b1Re + j, b1Im + j, a2Re + j, a2Im + j, b2Re + j, b2Im + j, n - j);
+}
+AVX512_FN static void cmacSharedAVX512(float *re1, float *im1, float *re2, float *im2, const float *aRe, const float *aIm, const float *b1Re, const float *b1Im, const float *b2Re, const float *b2Im, unsigned int n)
+{
+	unsigned int j = 0;
+	for (; j + 16 <= n; j += 16)
+	{
+		__m512 ar = _mm512_loadu_ps(aRe + j), ai = _mm512_loadu_ps(aIm + j);
+		__m512 br = _mm512_loadu_ps(b1Re + j), bi = _mm512_loadu_ps(b1Im + j);
+		__m512 r = _mm512_fmadd_ps(ar, br, _mm512_loadu_ps(re1 + j));
+		__m512 i = _mm512_fmadd_ps(ar, bi, _mm512_loadu_ps(im1 + j));
+		_mm512_storeu_ps(re1 + j, _mm512_fnmadd_ps(ai, bi, r));
+		_mm512_storeu_ps(im1 + j, _mm512_fmadd_ps(ai, br, i));
+		br = _mm512_loadu_ps(b2Re + j);
+		bi = _mm512_loadu_ps(b2Im + j);
+		r = _mm512_fmadd_ps(ar, br, _mm512_loadu_ps(re2 + j));
+		i = _mm512_fmadd_ps(ar, bi, _mm512_loadu_ps(im2 + j));
+		_mm512_storeu_ps(re2 + j, _mm512_fnmadd_ps(ai, bi, r));
+		_mm512_storeu_ps(im2 + j, _mm512_fmadd_ps(ai, br, i));
+	}
+	cmacSharedScalar(re1 + j, im1 + j, re2 + j, im2 + j, aRe + j, aIm + j, b1Re + j, b1Im + j, b2Re + j, b2Im + j, n - j);
+}
+AVX512_FN static float dotAVX512(const float *a, const float *b, unsigned int n)
+{
+	unsigned int j = 0;
+	__m512 s0 = _mm512_setzero_ps(), s1 = _mm512_setzero_ps();
+	for (; j + 32 <= n; j += 32)
+	{
+		s0 = _mm512_fmadd_ps(_mm512_loadu_ps(a + j), _mm512_loadu_ps(b + j), s0);
+		s1 = _mm512_fmadd_ps(_mm512_loadu_ps(a + j + 16), _mm512_loadu_ps(b + j + 16), s1);
+	}
+	return _mm512_reduce_add_ps(_mm512_add_ps(s0, s1)) + dotScalar(a + j, b + j, n - j);
+}
+static const SpectralMACKernels kernelsAVX512 =
+{
+	SPECTRALMAC_AVX512, "avx512",
+	cmacAVX512, cmac2AVX512, cmacSharedAVX512, dotAVX512
+};
+#endif
+#ifdef SPECTRALMAC_ARM
+#if defined(__aarch64__)
+#define neonFma(acc, a, b) vfmaq_f32(acc, a, b)
+#define neonFms(acc, a, b) vfmsq_f32(acc, a, b)
+#else
+#define neonFma(acc, a, b) vmlaq_f32(acc, a, b)
+#define neonFms(acc, a, b) vmlsq_f32(acc, a, b)
+#endif
+static void cmacNEON(float *re, float *im, const float *aRe, const float *aIm, const float *bRe, const float *bIm, unsigned int n)
+{
+	unsigned int j = 0;
+	for (; j + 4 <= n; j += 4)
+	{
+		float32x4_t ar = vld1q_f32(aRe + j), ai = vld1q_f32(aIm + j);
+		float32x4_t br = vld1q_f32(bRe + j), bi = vld1q_f32(bIm + j);
+		float32x4_t r = neonFma(vld1q_f32(re + j), ar, br);
+		float32x4_t i = neonFma(vld1q_f32(im + j), ar, bi);
+		vst1q_f32(re + j, neonFms(r, ai, bi));
+		vst1q_f32(im + j, neonFma(i, ai, br));
+	}
+	cmacScalar(re + j, im + j, aRe + j, aIm + j, bRe + j, bIm + j, n - j);
+}
+static void cmac2NEON(float *re, float *im, const float *a1Re, const float *a1Im, const float *b1Re, const float *b1Im, const float *a2Re, const float *a2Im, const float *b2Re, const float *b2Im, unsigned int n)
+{
+	unsigned int j = 0;
+	for (; j + 4 <= n; j += 4)
+	{
+		float32x4_t a1r = vld1q_f32(a1Re + j), a1i = vld1q_f32(a1Im + j);
+		float32x4_t b1r = vld1q_f32(b1Re + j), b1i = vld1q_f32(b1Im + j);
+		float32x4_t a2r = vld1q_f32(a2Re + j), a2i = vld1q_f32(a2Im + j);
+		float32x4_t b2r = vld1q_f32(b2Re + j), b2i = vld1q_f32(b2Im + j);
+		float32x4_t r = neonFma(vld1q_f32(re + j), a1r, b1r);
+		float32x4_t i = neonFma(vld1q_f32(im + j), a1r, b1i);
+		r = neonFms(r, a1i, b1i);
+		i = neonFma(i, a1i, b1r);
+		r = neonFma(r, a2r, b2r);
+		i = neonFma(i, a2r, b2i);
+		vst1q_f32(re + j, neonFms(r, a2i, b2i));
+		vst1q_f32(im + j, neonFma(i, a2i, b2r));
+	}
+	cmac2Scalar(re + j, im + j, a1Re + j, a1Im + j, b1Re + j, b1Im + j, a2Re + j, a2Im + j, b2Re + j, b2Im + j, n - j);
+}
+static void cmacSharedNEON(float *re1, float *im1, float *re2, float *im2, const float *aRe, const float *aIm, const float *b1Re, const float *b1Im, const float *b2Re, const float *b2Im, unsigned int n)
+{
+	unsigned int j = 0;
+	for (; j + 4 <= n; j += 4)
+	{
+		float32x4_t ar = vld1q_f32(aRe + j), ai = vld1q_f32(aIm + j);
+		float32x4_t br = vld1q_f32(b1Re + j), bi = vld1q_f32(b1Im + j);
+		float32x4_t r = neonFma(vld1q_f32(re1 + j), ar, br);
+		float32x4_t i = neonFma(vld1q_f32(im1 + j), ar, bi);
+		vst1q_f32(re1 + j, neonFms(r, ai, bi));
+		vst1q_f32(im1 + j, neonFma(i, ai, br));
+		br = vld1q_f32(b2Re + j);
+		bi = vld1q_f32(b2Im + j);
+		r = neonFma(vld1q_f32(re2 + j), ar, br);
+		i = neonFma(vld1q_f32(im2 + j), ar, bi);
+		vst1q_f32(re2 + j, neonFms(r, ai, bi));
+		vst1q_f32(im2 + j, neonFma(i, ai, br));
+	}
+	cmacSharedScalar(re1 + j, im1 + j, re2 + j, im2 + j, aRe + j, aIm + j, b1Re + j, b1Im + j, b2Re + j, b2Im + j, n - j);
+}
+static float dotNEON(const float *a, const float *b, unsigned int n)
+{
+	unsigned int j = 0;
+	float32x4_t s0 = vdupq_n_f32(0.0f), s1 = vdupq_n_f32(0.0f);
+	for (; j + 8 <= n; j += 8)
+	{
+		s0 = neonFma(s0, vld1q_f32(a + j), vld1q_f32(b + j));
+		s1 = neonFma(s1, vld1q_f32(a + j + 4), vld1q_f32(b + j + 4));
+	}
+	s0 = vaddq_f32(s0, s1);
+	float32x2_t s = vadd_f32(vget_low_f32(s0), vget_high_f32(s0));
+	return vget_lane_f32(vpadd_f32(s, s), 0) + dotScalar(a + j, b + j, n - j);
+}
+static const SpectralMACKernels kernelsNEON =
+{
+	SPECTRALMAC_NEON, "neon",
+	cmacNEON, cmac2NEON, cmacSharedNEON, dotNEON
+};
+#endif
+const SpectralMACKernels *spectralMACSelect(int maxLevel)
+{
+#ifdef SPECTRALMAC_X86
+	__builtin_cpu_init();
+	if (maxLevel >= SPECTRALMAC_AVX512 && __builtin_cpu_supports("avx512f"))
+		return &kernelsAVX512;
+	if (maxLevel >= SPECTRALMAC_AVX2 && __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+		return &kernelsAVX2;
+	if (maxLevel >= SPECTRALMAC_SSE2 && __builtin_cpu_supports("sse2"))
+		return &kernelsSSE2;
+#elif defined(SPECTRALMAC_ARM)
+	if (maxLevel >= SPECTRALMAC_NEON)
+		return &kernelsNEON;
+#endif
+	return &kernelsScalar;
+}
@@ -0,0 +1,29 @@
+#ifndef SPECTRALMAC_H
+#define SPECTRALMAC_H
+// Complex multiply-accumulate over split re/im spectra, the inner loop of the partitioned convolvers
+// The scalar and SSE2 kernels round exactly like the original loops, the FMA kernels skip the intermediate rounding
+enum
+{
+	SPECTRALMAC_SCALAR = 0,
+	SPECTRALMAC_SSE2,
+	SPECTRALMAC_AVX2,
+	SPECTRALMAC_AVX512,
+	SPECTRALMAC_NEON,
+	SPECTRALMAC_BEST
+};
+typedef struct
+{
+	int level;
+	const char *name;
+	// re + i * im += (aRe + i * aIm) * (bRe + i * bIm)
+	void(*cmac)(float *re, float *im, const float *aRe, const float *aIm, const float *bRe, const float *bIm, unsigned int n);
+	// re + i * im += a1 * b1 + a2 * b2
+	void(*cmac2)(float *re, float *im, const float *a1Re, const float *a1Im, const float *b1Re, const float *b1Im, const float *a2Re, const float *a2Im, const float *b2Re, const float *b2Im, unsigned int n);
+	// re1 + i * im1 += a * b1 and re2 + i * im2 += a * b2, rounds like two cmac calls, a is loaded once
+	void(*cmacShared)(float *re1, float *im1, float *re2, float *im2, const float *aRe, const float *aIm, const float *b1Re, const float *b1Im, const float *b2Re, const float *b2Im, unsigned int n);
+	// Sum of a[j] * b[j], the direct form head of the hybrid convolvers
+	float(*dot)(const float *a, const float *b, unsigned int n);
+} SpectralMACKernels;
+// Best kernel set the CPU supports, not exceeding maxLevel
+extern const SpectralMACKernels *spectralMACSelect(int maxLevel);
+#endif
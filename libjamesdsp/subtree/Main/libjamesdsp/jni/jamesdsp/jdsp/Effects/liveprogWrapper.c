@@ -2,28 +2,43 @@ void NSEEL_HOSTSTUB_EnterMutex() { }
 void NSEEL_HOSTSTUB_LeaveMutex() { }
 #include <math.h>
 #include "../jdsp_header.h"
-void LiveProgConstructor(JamesDSPLib *jdsp)
+typedef struct
+{
+	JParamSnapshot hdr;
+	LiveProg eel;
+} LiveProgSnapshot;
+static void LiveProgVMInit(LiveProg *pg, float fs)
 {
-	LiveProg *pg = &jdsp->eel;
-    pg->active = 1;
 	pg->compileSucessfully = 0;
 	pg->codehandleInit = 0;
 	pg->codehandleProcess = 0;
 	pg->vm = NSEEL_VM_alloc(); // create virtual machine
 	pg->vmFs = NSEEL_VM_regvar(pg->vm, "srate");
-	*pg->vmFs = jdsp->fs;
+	*pg->vmFs = fs;
 	pg->input1 = NSEEL_VM_regvar(pg->vm, "spl0");
 	pg->input2 = NSEEL_VM_regvar(pg->vm, "spl1");
 }
-void LiveProgDestructor(JamesDSPLib *jdsp)
+static void LiveProgVMFree(LiveProg *pg)
 {
-	if (jdsp->eel.vm)
+	if (pg->vm)
 	{
-		NSEEL_code_free(jdsp->eel.codehandleInit);
-		NSEEL_code_free(jdsp->eel.codehandleProcess);
-		NSEEL_VM_free(jdsp->eel.vm);
+		NSEEL_code_free(pg->codehandleInit);
+		NSEEL_code_free(pg->codehandleProcess);
+		NSEEL_VM_free(pg->vm);
+		pg->vm = 0;
 	}
 }
+void LiveProgConstructor(JamesDSPLib *jdsp)
+{
+	LiveProg *pg = &jdsp->eel;
+    pg->active = 1;
+	pg->compileError[0] = '\0';
+	LiveProgVMInit(pg, jdsp->fs);
+}
+void LiveProgDestructor(JamesDSPLib *jdsp)
+{
+	LiveProgVMFree(&jdsp->eel);
+}
 void LiveProgEnable(JamesDSPLib *jdsp)
 {
 	*jdsp->eel.vmFs = jdsp->fs;
@@ -33,28 +48,33 @@ void LiveProgDisable(JamesDSPLib *jdsp)
 {
 	jdsp->liveprogEnabled = 0;
 }
-int LiveProgLoadCode(JamesDSPLib *jdsp, char *codeTextInit, char *codeTextProcess)
+// Only the VM and its code handles are exchanged, active and compileError stay with the control thread
+static void LiveProgSnapshotApply(JamesDSPLib *jdsp, JParamSnapshot *snap)
+{
+	LiveProg *live = &jdsp->eel, *pg = &((LiveProgSnapshot *)snap)->eel;
+	LiveProg tmp = *live;
+	live->vm = pg->vm;
+	live->codehandleInit = pg->codehandleInit;
+	live->codehandleProcess = pg->codehandleProcess;
+	live->vmFs = pg->vmFs;
+	live->input1 = pg->input1;
+	live->input2 = pg->input2;
+	live->compileSucessfully = pg->compileSucessfully;
+	pg->vm = tmp.vm;
+	pg->codehandleInit = tmp.codehandleInit;
+	pg->codehandleProcess = tmp.codehandleProcess;
+	pg->vmFs = tmp.vmFs;
+	pg->input1 = tmp.input1;
+	pg->input2 = tmp.input2;
+	pg->compileSucessfully = tmp.compileSucessfully;
+}
+static void LiveProgSnapshotDestroy(JParamSnapshot *snap)
+{
+	LiveProgVMFree(&((LiveProgSnapshot *)snap)->eel);
+}
+static int LiveProgLoadCode(LiveProg *pg, char *codeTextInit, char *codeTextProcess)
 {
-	LiveProg *pg = &jdsp->eel;
-	pg->compileSucessfully = 0;
 	compileContext *ctx = (compileContext*)pg->vm;
-	NSEEL_VM_freevars(pg->vm);
-	NSEEL_init_memRegion(pg->vm);
-	memset(ctx->ram_state, 0, sizeof(ctx->ram_state));
-	pg->vmFs = NSEEL_VM_regvar(pg->vm, "srate");
-	*pg->vmFs = jdsp->fs;
-	pg->input1 = NSEEL_VM_regvar(pg->vm, "spl0");
-	pg->input2 = NSEEL_VM_regvar(pg->vm, "spl1");
-	if (pg->codehandleInit)
-	{
-		NSEEL_code_free(pg->codehandleInit);
-		pg->codehandleInit = 0;
-	}
-	if (pg->codehandleProcess)
-	{
-		NSEEL_code_free(pg->codehandleProcess);
-		pg->codehandleProcess = 0;
-	}
 	ctx->functions_common = 0;
 	pg->codehandleInit = NSEEL_code_compile_ex(pg->vm, codeTextInit, 0, 1);
 	if (!pg->codehandleInit)
@@ -78,6 +98,10 @@ int LiveProgLoadCode(JamesDSPLib *jdsp, char *codeTextInit, char *codeTextProces
 	}
 	return 1;
 }
+const char *LiveProgGetCompileError(JamesDSPLib *jdsp)
+{
+	return jdsp->eel.compileError[0] ? jdsp->eel.compileError : 0;
+}
 const char* checkErrorCode(int errCode)
 {
 	switch (errCode)
@@ -119,6 +143,12 @@ int LiveProgStringParser(JamesDSPLib *jdsp, char *eelCode)
 	memset(codeTextInit, 0, strLen * sizeof(char));
 	memset(codeTextProcess, 0, strLen * sizeof(char));
 	int errorMsg = 1;
+	// Compiled into a fresh VM off the audio thread, the running script keeps going until the swap
+	LiveProgSnapshot *ls = (LiveProgSnapshot *)malloc(sizeof(LiveProgSnapshot));
+	memset(ls, 0, sizeof(LiveProgSnapshot));
+	ls->hdr.apply = LiveProgSnapshotApply;
+	ls->hdr.destroy = LiveProgSnapshotDestroy;
+	LiveProgVMInit(&ls->eel, jdsp->fs);
 	if (initSegment && processSegment)
 	{
 		if (initSegment < processSegment)
@@ -130,7 +160,7 @@ int LiveProgStringParser(JamesDSPLib *jdsp, char *eelCode)
 			{
 				strcpy(codeTextProcess, processSegment);
 			}
-			errorMsg = LiveProgLoadCode(jdsp, codeTextInit, codeTextProcess);
+			errorMsg = LiveProgLoadCode(&ls->eel, codeTextInit, codeTextProcess);
 		}
 		else
 		{
@@ -138,11 +168,20 @@ int LiveProgStringParser(JamesDSPLib *jdsp, char *eelCode)
 			long long cpyLen = initSegment - processSegment - (6 + 1);
 			if (cpyLen > 0)
 				strncpy(codeTextProcess, processSegment, cpyLen);
-			errorMsg = LiveProgLoadCode(jdsp, codeTextInit, codeTextProcess);
+			errorMsg = LiveProgLoadCode(&ls->eel, codeTextInit, codeTextProcess);
 		}
 	}
 	free(codeTextInit);
 	free(codeTextProcess);
+	const char *err = NSEEL_code_getcodeerror(ls->eel.vm);
+	if (err)
+	{
+		strncpy(jdsp->eel.compileError, err, sizeof(jdsp->eel.compileError) - 1);
+		jdsp->eel.compileError[sizeof(jdsp->eel.compileError) - 1] = '\0';
+	}
+	else
+		jdsp->eel.compileError[0] = '\0';
+	JamesDSPCommitParam(jdsp, JDSP_PARAM_LIVEPROG, &ls->hdr);
 	jdsp_unlock(jdsp);
 	return errorMsg;
 }
@@ -4,6 +4,22 @@
 #include <math.h>
 #include <float.h>
 #include "../jdsp_header.h"
+typedef struct
+{
+	JParamSnapshot hdr;
+	int operatingMode;
+	// FIR
+	int hasConv;
+	FFTConvolver2x2 conv;
+	// IIR
+	int order, nSec;
+	float c1[(NUMPTS - 1) * MAXSECTIONS];
+	float c2[(NUMPTS - 1) * MAXSECTIONS];
+	float d0[(NUMPTS - 1) * MAXSECTIONS];
+	float d1[(NUMPTS - 1) * MAXSECTIONS];
+	float overallGain;
+	char sec[NUMPTS - 1];
+} MultimodalEQSnapshot;
 void MultimodalEqualizerConstructor(JamesDSPLib *jdsp)
 {
 	double freqAx[NUMPTS] = { 25.0, 40.0, 63.0, 100.0, 160.0, 250.0, 400.0, 630.0, 1000.0, 1600.0, 2500.0, 4000.0, 6300.0, 10000.0, 16000.0 };
@@ -16,12 +32,10 @@ void MultimodalEqualizerConstructor(JamesDSPLib *jdsp)
 	initIerper(&jdsp->mEQ.pch1, NUMPTS + 2);
 	initIerper(&jdsp->mEQ.pch2, NUMPTS + 2);
 	jdsp->mEQ.instance.filterLen = InitArbitraryEq(&jdsp->mEQ.instance.coeffGen, 0);
-	FFTConvolver2x2Init(&jdsp->mEQ.instance.convState);
 	FFTConvolver2x2Init(&jdsp->mEQ.conv);
 	float *kDelta = (float*)malloc(jdsp->mEQ.instance.filterLen * sizeof(float));
 	memset(kDelta, 0, jdsp->mEQ.instance.filterLen * sizeof(float));
 	kDelta[0] = 1.0f;
-	FFTConvolver2x2LoadImpulseResponse(&jdsp->mEQ.instance.convState, (unsigned int)jdsp->blockSize, kDelta, kDelta, jdsp->mEQ.instance.filterLen);
 	FFTConvolver2x2LoadImpulseResponse(&jdsp->mEQ.conv, (unsigned int)jdsp->blockSize, kDelta, kDelta, jdsp->mEQ.instance.filterLen);
 	free(kDelta);
 }
@@ -30,7 +44,7 @@ void MultimodalEqualizerDestructor(JamesDSPLib *jdsp)
 	freeIerper(&jdsp->mEQ.pch1);
 	freeIerper(&jdsp->mEQ.pch2);
 	EqNodesFree(&jdsp->mEQ.instance.coeffGen);
-	FFTConvolver2x2Free(&jdsp->mEQ.instance.convState);
+	ArbitraryEqReleaseWork(&jdsp->mEQ.instance.coeffGen);
 	FFTConvolver2x2Free(&jdsp->mEQ.conv);
 }
 void HSHOResponse(double fs, double fc, unsigned int filterOrder, double gain, double overallGainDb, unsigned int queryPts, double *dispFreq, double *cplxRe, double *cplxIm)
@@ -144,25 +158,49 @@ double reverseProjectX(double pos, double MIN_FREQ, double MAX_FREQ)
 	double maxPos = log(MAX_FREQ);
 	return exp(pos * (maxPos - minPos) + minPos);
 }
-void MultimodalEqualizerAxisInterpolation(JamesDSPLib *jdsp, int interpolationMode, int operatingMode, double *freqAx, double *gaindB)
+static void MultimodalEQSnapshotApply(JamesDSPLib *jdsp, JParamSnapshot *snap)
 {
-	memcpy(jdsp->mEQ.freq + 1, freqAx, NUMPTS * sizeof(double));
-	memcpy(jdsp->mEQ.gain + 1, gaindB, NUMPTS * sizeof(double));
-	for (int i = 0; i < NUMPTS; i++)
+	MultimodalEQSnapshot *es = (MultimodalEQSnapshot *)snap;
+	if (es->hasConv)
 	{
-		if (jdsp->mEQ.gain[i] < -64.0)
-			jdsp->mEQ.gain[i] = -64.0;
-		if (jdsp->mEQ.gain[i] > 64.0)
-			jdsp->mEQ.gain[i] = 64.0;
+		if (!FFTConvolver2x2ExchangeImpulseResponse(&jdsp->mEQ.conv, &es->conv) && jdsp->equalizerEnabled && !jdsp->mEQ.operatingMode && es->conv._segCount)
+			JamesDSPDrainStart(jdsp, &jdsp->eqDrain, JDSP_PARAM_EQUALIZER, snap, es->conv._segCount * es->conv._blockSize);
 	}
-	jdsp->mEQ.freq[0] = 0.0;
-	jdsp->mEQ.gain[0] = jdsp->mEQ.gain[1];
-	jdsp->mEQ.freq[NUMPTS + 1] = 24000.0;
-	jdsp->mEQ.gain[NUMPTS + 1] = jdsp->mEQ.gain[NUMPTS];
+	else
+	{
+		jdsp->mEQ.order = es->order;
+		jdsp->mEQ.nSec = es->nSec;
+		memcpy(jdsp->mEQ.c1, es->c1, sizeof(es->c1));
+		memcpy(jdsp->mEQ.c2, es->c2, sizeof(es->c2));
+		memcpy(jdsp->mEQ.d0, es->d0, sizeof(es->d0));
+		memcpy(jdsp->mEQ.d1, es->d1, sizeof(es->d1));
+		memcpy(jdsp->mEQ.sec, es->sec, sizeof(es->sec));
+		jdsp->mEQ.overallGain = es->overallGain;
+	}
+	jdsp->mEQ.operatingMode = es->operatingMode;
+}
+static void MultimodalEQSnapshotDestroy(JParamSnapshot *snap)
+{
+	MultimodalEQSnapshot *es = (MultimodalEQSnapshot *)snap;
+	if (es->hasConv)
+		FFTConvolver2x2Free(&es->conv);
+}
+// Designs the filter for the requested mode from freq/gain and publishes it
+// Returns 0 and keeps the previous filter when memory runs out
+static int MultimodalEqualizerCommit(JamesDSPLib *jdsp)
+{
+	int operatingMode = jdsp->mEQ.requestedMode;
+	MultimodalEQSnapshot *es = (MultimodalEQSnapshot *)malloc(sizeof(MultimodalEQSnapshot));
+	if (!es)
+		return 0;
+	memset(es, 0, sizeof(MultimodalEQSnapshot));
+	es->hdr.apply = MultimodalEQSnapshotApply;
+	es->hdr.destroy = MultimodalEQSnapshotDestroy;
+	es->operatingMode = operatingMode;
+	float *eqFil = 0;
 	if (!operatingMode)
 	{
-		float *eqFil;
-		if (!interpolationMode)
+		if (!jdsp->mEQ.currentInterpolationMode)
 		{
 			pchip(&jdsp->mEQ.pch1, jdsp->mEQ.freq, jdsp->mEQ.gain, NUMPTS + 2, 1, 1);
 			eqFil = InterpolatingEqMinimumPhase(&jdsp->mEQ.instance.coeffGen, (float)jdsp->fs, (void *)(&jdsp->mEQ.pch1));
@@ -172,42 +210,36 @@ void MultimodalEqualizerAxisInterpolation(JamesDSPLib *jdsp, int interpolationMo
 			makima(&jdsp->mEQ.pch2, jdsp->mEQ.freq, jdsp->mEQ.gain, NUMPTS + 2, 1, 1);
 			eqFil = InterpolatingEqMinimumPhase(&jdsp->mEQ.instance.coeffGen, (float)jdsp->fs, (void *)(&jdsp->mEQ.pch2));
 		}
-		FFTConvolver2x2RefreshImpulseResponse(&jdsp->mEQ.instance.convState, &jdsp->mEQ.conv, eqFil, eqFil, jdsp->mEQ.instance.filterLen);
+		jdsp->mEQ.instance.lastDesign = crossPlatformCurTime();
+		if (!eqFil)
+		{
+			free(es);
+			return 1;
+		}
+		es->hasConv = 1;
+		FFTConvolver2x2Init(&es->conv);
+		FFTConvolver2x2LoadImpulseResponse(&es->conv, JamesDSPBlockSize(jdsp), eqFil, eqFil, jdsp->mEQ.instance.filterLen);
 	}
 	else
 	{
 		double *freq = jdsp->mEQ.freq + 1;
 		double *gains = jdsp->mEQ.gain + 1;
 		if (operatingMode == 1)
-			jdsp->mEQ.order = 4;
+			es->order = 4;
 		else if (operatingMode == 2)
-			jdsp->mEQ.order = 6;
+			es->order = 6;
 		else if (operatingMode == 3)
-			jdsp->mEQ.order = 8;
+			es->order = 8;
 		else if (operatingMode == 4)
-			jdsp->mEQ.order = 10;
+			es->order = 10;
 		else if (operatingMode == 5)
-			jdsp->mEQ.order = 12;
-		jdsp->mEQ.nSec = jdsp->mEQ.order >> 1;
-		if (jdsp->mEQ.nSec > MAXSECTIONS)
+			es->order = 12;
+		es->nSec = es->order >> 1;
+		if (es->nSec > MAXSECTIONS)
 		{
-			jdsp->mEQ.order = MAXORDER;
-			jdsp->mEQ.nSec = MAXSECTIONS;
+			es->order = MAXORDER;
+			es->nSec = MAXSECTIONS;
 		}
-		/*double fs = 48000;
-		double MIN_FREQ = 21;
-		double MAX_FREQ = 20000;
-		unsigned int nPts = 131072 / 2 + 1;
-		double *dispFreq = (double *)malloc(nPts * sizeof(double));
-		for (int i = 0; i < nPts; i++)
-			dispFreq[i] = reverseProjectX(i / (double)(nPts - 1), MIN_FREQ, MAX_FREQ);
-		double *cplxRe = (double *)malloc(nPts * sizeof(double));
-		double *cplxIm = (double *)malloc(nPts * sizeof(double));
-		for (int i = 0; i < nPts; i++)
-		{
-			cplxRe[i] = 1;
-			cplxIm[i] = 0;
-		}*/
 		for (int i = 0; i < NUMPTS - 1; i++)
 		{
 			double dB = gains[i + 1] - gains[i];
@@ -217,53 +249,77 @@ void MultimodalEqualizerAxisInterpolation(JamesDSPLib *jdsp, int interpolationMo
 			else
 				designFreq = freq[i];
 			double overallGain = i == 0 ? gains[i] : 0.0;
-			//HSHOResponse(jdsp->fs, designFreq, jdsp->mEQ.order, dB, overallGain, nPts, dispFreq, cplxRe, cplxIm);
 			if (i == 0)
-				jdsp->mEQ.sec[i] = HSHOSVF(jdsp->fs, designFreq, jdsp->mEQ.order, dB, overallGain, jdsp->mEQ.c1 + i * jdsp->mEQ.nSec, jdsp->mEQ.c2 + i * jdsp->mEQ.nSec, jdsp->mEQ.d0 + i * jdsp->mEQ.nSec, jdsp->mEQ.d1 + i * jdsp->mEQ.nSec, &jdsp->mEQ.overallGain);
+				es->sec[i] = HSHOSVF(jdsp->fs, designFreq, es->order, dB, overallGain, es->c1 + i * es->nSec, es->c2 + i * es->nSec, es->d0 + i * es->nSec, es->d1 + i * es->nSec, &es->overallGain);
 			else
 			{
 				float dummy;
-				jdsp->mEQ.sec[i] = HSHOSVF(jdsp->fs, designFreq, jdsp->mEQ.order, dB, overallGain, jdsp->mEQ.c1 + i * jdsp->mEQ.nSec, jdsp->mEQ.c2 + i * jdsp->mEQ.nSec, jdsp->mEQ.d0 + i * jdsp->mEQ.nSec, jdsp->mEQ.d1 + i * jdsp->mEQ.nSec, &dummy);
+				es->sec[i] = HSHOSVF(jdsp->fs, designFreq, es->order, dB, overallGain, es->c1 + i * es->nSec, es->c2 + i * es->nSec, es->d0 + i * es->nSec, es->d1 + i * es->nSec, &dummy);
 			}
-			//printf("nSec: %d\n", jdsp->mEQ.sec[i]);
 		}
 	}
-	jdsp->mEQ.operatingMode = operatingMode;
+	JamesDSPCommitParam(jdsp, JDSP_PARAM_EQUALIZER, &es->hdr);
+	Convolver1DFuseKernel(jdsp, JDSP_FUSED_EQUALIZER, eqFil, jdsp->mEQ.instance.filterLen);
+	return 1;
+}
+void MultimodalEqualizerAxisInterpolation(JamesDSPLib *jdsp, int interpolationMode, int operatingMode, double *freqAx, double *gaindB)
+{
+	jdsp_lock(jdsp);
+	memcpy(jdsp->mEQ.freq + 1, freqAx, NUMPTS * sizeof(double));
+	memcpy(jdsp->mEQ.gain + 1, gaindB, NUMPTS * sizeof(double));
+	for (int i = 0; i < NUMPTS; i++)
+	{
+		if (jdsp->mEQ.gain[i] < -64.0)
+			jdsp->mEQ.gain[i] = -64.0;
+		if (jdsp->mEQ.gain[i] > 64.0)
+			jdsp->mEQ.gain[i] = 64.0;
+	}
+	jdsp->mEQ.freq[0] = 0.0;
+	jdsp->mEQ.gain[0] = jdsp->mEQ.gain[1];
+	jdsp->mEQ.freq[NUMPTS + 1] = 24000.0;
+	jdsp->mEQ.gain[NUMPTS + 1] = jdsp->mEQ.gain[NUMPTS];
+	jdsp->mEQ.requestedMode = operatingMode;
 	jdsp->mEQ.currentInterpolationMode = interpolationMode;
+	MultimodalEqualizerCommit(jdsp);
+	jdsp_unlock(jdsp);
 }
 
 void MultimodalEqualizerEnable(JamesDSPLib *jdsp, char enable)
 {
-	if (jdsp->equalizerForceRefresh)
-	{
-		float *eqFil;
-		if (!jdsp->mEQ.currentInterpolationMode)
-		{
-			pchip(&jdsp->mEQ.pch1, jdsp->mEQ.freq, jdsp->mEQ.gain, NUMPTS + 2, 1, 1);
-			eqFil = InterpolatingEqMinimumPhase(&jdsp->mEQ.instance.coeffGen, (float)jdsp->fs, (void *)(&jdsp->mEQ.pch1));
-		}
-		else
-		{
-			makima(&jdsp->mEQ.pch2, jdsp->mEQ.freq, jdsp->mEQ.gain, NUMPTS + 2, 1, 1);
-			eqFil = InterpolatingEqMinimumPhase(&jdsp->mEQ.instance.coeffGen, (float)jdsp->fs, (void *)(&jdsp->mEQ.pch2));
-		}
-		FFTConvolver2x2Free(&jdsp->mEQ.instance.convState);
-		FFTConvolver2x2Free(&jdsp->mEQ.conv);
-		FFTConvolver2x2LoadImpulseResponse(&jdsp->mEQ.instance.convState, (unsigned int)jdsp->blockSize, eqFil, eqFil, jdsp->mEQ.instance.filterLen);
-		FFTConvolver2x2LoadImpulseResponse(&jdsp->mEQ.conv, (unsigned int)jdsp->blockSize, eqFil, eqFil, jdsp->mEQ.instance.filterLen);
+	jdsp_lock(jdsp);
+	if (jdsp->equalizerForceRefresh && MultimodalEqualizerCommit(jdsp))
 		jdsp->equalizerForceRefresh = 0;
-	}
+	jdsp_unlock(jdsp);
 	if (enable)
 		jdsp->equalizerEnabled = 1;
+	Convolver1DFuseRefresh(jdsp);
 }
 void MultimodalEqualizerDisable(JamesDSPLib *jdsp)
 {
 	jdsp->equalizerEnabled = 0;
+	Convolver1DFuseRefresh(jdsp);
+}
+void MultimodalEqualizerReleaseIdle(JamesDSPLib *jdsp, double now)
+{
+	if (now - jdsp->mEQ.instance.lastDesign >= jdsp->idleRelease)
+		ArbitraryEqReleaseWork(&jdsp->mEQ.instance.coeffGen);
+}
+size_t MultimodalEqualizerMemoryUsage(JamesDSPLib *jdsp)
+{
+	return sizeof(jdsp->mEQ) + ArbitraryEqWorkBytes(&jdsp->mEQ.instance.coeffGen) + FFTConvolver2x2MemoryUsage(&jdsp->mEQ.conv);
 }
 void MultimodalEqualizerProcess(JamesDSPLib *jdsp, size_t n)
 {
 	if (!jdsp->mEQ.operatingMode)
+	{
+		if (jdsp->eqDrain.remaining)
+		{
+			float **y = JamesDSPDrainBuffer(jdsp, n);
+			FFTConvolver2x2Process(&((MultimodalEQSnapshot *)jdsp->eqDrain.snap)->conv, y[0], y[1], y[0], y[1], (unsigned int)n);
+		}
 		FFTConvolver2x2Process(&jdsp->mEQ.conv, jdsp->tmpBuffer[0], jdsp->tmpBuffer[1], jdsp->tmpBuffer[0], jdsp->tmpBuffer[1], (unsigned int)n);
+		JamesDSPDrainFinish(jdsp, &jdsp->eqDrain, n);
+	}
 	else
 	{
 		for (size_t smp = 0; smp < n; smp++)
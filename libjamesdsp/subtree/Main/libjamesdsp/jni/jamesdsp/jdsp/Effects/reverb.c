@@ -9,6 +9,7 @@
 
 #include "../jdsp_header.h"
 #include <math.h>
+#include <stdlib.h>
 #include <string.h>
 
 // utility functions
@@ -926,20 +927,116 @@ void sf_reverb_process(sf_reverb_state_st *rv, float inputL, float inputR, float
     *outputR = outR;
 }
 // Reverb
+typedef struct
+{
+	JParamSnapshot hdr;
+	sf_reverb_state_st *reverb; // Replaces the live instance, NULL hands the idle one back to be freed
+} ReverbSnapshot;
+static void ReverbSnapshotApply(JamesDSPLib *jdsp, JParamSnapshot *snap)
+{
+	ReverbSnapshot *rs = (ReverbSnapshot *)snap;
+	sf_reverb_state_st *old = jdsp->reverb;
+	jdsp->reverb = rs->reverb;
+	rs->reverb = old;
+}
+static void ReverbSnapshotDestroy(JParamSnapshot *snap)
+{
+	free(((ReverbSnapshot *)snap)->reverb);
+}
+static void ReverbApplyParam(JamesDSPLib *jdsp, sf_reverb_state_st *rv)
+{
+	ReverbParam *rp = &jdsp->reverbParam;
+	if (rp->preset >= 0)
+		sf_presetreverb(rv, (int)jdsp->fs, (sf_reverb_preset)rp->preset);
+	else
+		sf_advancereverb(rv, (int)jdsp->fs, rp->oversamplefactor, rp->p[0], rp->p[1], rp->p[2], rp->p[3], rp->p[4], rp->p[5], rp->p[6], rp->p[7],
+			rp->p[8], rp->p[9], rp->p[10], rp->p[11], rp->p[12], rp->p[13], rp->p[14], rp->p[15]);
+}
+static ReverbSnapshot *ReverbSnapshotAlloc(void)
+{
+	ReverbSnapshot *rs = (ReverbSnapshot *)malloc(sizeof(ReverbSnapshot));
+	if (!rs)
+		return 0;
+	rs->hdr.apply = ReverbSnapshotApply;
+	rs->hdr.destroy = ReverbSnapshotDestroy;
+	rs->reverb = 0;
+	return rs;
+}
+// Parameter changes clear the delay lines anyway, so every commit builds a fresh instance
+// Returns 0 and keeps the previous state when memory runs out
+static int ReverbCommit(JamesDSPLib *jdsp)
+{
+	ReverbSnapshot *rs = ReverbSnapshotAlloc();
+	if (!rs)
+		return 0;
+	// About 1 MB of delay lines, only held while the reverb is in use
+	rs->reverb = (sf_reverb_state_st *)malloc(sizeof(sf_reverb_state_st));
+	if (!rs->reverb)
+	{
+		free(rs);
+		return 0;
+	}
+	memset(rs->reverb, 0, sizeof(sf_reverb_state_st));
+	ReverbApplyParam(jdsp, rs->reverb);
+	JamesDSPCommitParam(jdsp, JDSP_PARAM_REVERB, &rs->hdr);
+	jdsp->reverbCommitted = 1;
+	return 1;
+}
 void Reverb_SetParam(JamesDSPLib *jdsp, int presets)
 {
-	sf_presetreverb(&jdsp->reverb, (int)jdsp->fs, (sf_reverb_preset)presets);
+	jdsp_lock(jdsp);
+	jdsp->reverbParam.preset = presets;
+	if (jdsp->reverbCommitted)
+		ReverbCommit(jdsp);
+	jdsp_unlock(jdsp);
+}
+void ReverbSetAdvancedParam(JamesDSPLib *jdsp, int oversamplefactor, float ertolate, float erefwet, float dry, float ereffactor, float erefwidth, float width, float wet, float wander, float bassb, float spin, float inputlpf, float basslpf, float damplpf, float outputlpf, float rt60, float delay)
+{
+	const float p[16] = { ertolate, erefwet, dry, ereffactor, erefwidth, width, wet, wander, bassb, spin, inputlpf, basslpf, damplpf, outputlpf, rt60, delay };
+	jdsp_lock(jdsp);
+	jdsp->reverbParam.preset = -1;
+	jdsp->reverbParam.oversamplefactor = oversamplefactor;
+	memcpy(jdsp->reverbParam.p, p, sizeof(p));
+	if (jdsp->reverbCommitted)
+		ReverbCommit(jdsp);
+	jdsp_unlock(jdsp);
 }
 void ReverbEnable(JamesDSPLib *jdsp)
 {
-	jdsp->reverbEnabled = 1;
+	jdsp_lock(jdsp);
+	if (!jdsp->reverbCommitted)
+		ReverbCommit(jdsp);
+	if (jdsp->reverbCommitted)
+		jdsp->reverbEnabled = 1;
+	jdsp_unlock(jdsp);
 }
 void ReverbDisable(JamesDSPLib *jdsp)
 {
 	jdsp->reverbEnabled = 0;
+	jdsp->reverbIdleSince = crossPlatformCurTime();
+}
+void ReverbReleaseIdle(JamesDSPLib *jdsp, double now)
+{
+	if (!jdsp->reverbEnabled && jdsp->reverbCommitted && now - jdsp->reverbIdleSince >= jdsp->idleRelease)
+	{
+		// The audio thread may still hold the instance, it comes back through the retire ring
+		ReverbSnapshot *rs = ReverbSnapshotAlloc();
+		if (!rs)
+			return;
+		JamesDSPCommitParam(jdsp, JDSP_PARAM_REVERB, &rs->hdr);
+		jdsp->reverbCommitted = 0;
+	}
+}
+void ReverbDestructor(JamesDSPLib *jdsp)
+{
+	if (jdsp->reverb)
+	{
+		free(jdsp->reverb);
+		jdsp->reverb = 0;
+	}
 }
 void ReverbProcess(JamesDSPLib *jdsp, size_t n)
 {
 	for (size_t i = 0; i < n; i++)
-		sf_reverb_process(&jdsp->reverb, jdsp->tmpBuffer[0][i], jdsp->tmpBuffer[1][i], &jdsp->tmpBuffer[0][i], &jdsp->tmpBuffer[1][i]);
+		sf_reverb_process(jdsp->reverb, jdsp->tmpBuffer[0][i], jdsp->tmpBuffer[1][i], &jdsp->tmpBuffer[0][i], &jdsp->tmpBuffer[1][i]);
 }
@@ -235,6 +235,12 @@ int PeakingFilterResampler(DirectForm2 *inputIIR, double inFs, DirectForm2 **res
 	*resampledIIR = temp;
 	return outSOSCount;
 }
+typedef struct
+{
+	JParamSnapshot hdr;
+	int usedSOSCount;
+	DirectForm2 *sosPointer;
+} DDCSnapshot;
 void DDCConstructor(JamesDSPLib *jdsp)
 {
 	jdsp->vdcFl.oldFile = 0;
@@ -254,49 +260,73 @@ void DDCDestructor(JamesDSPLib *jdsp)
 		jdsp->vdcFl.oldFile = 0;
 	}
 }
+static void DDCSnapshotApply(JamesDSPLib *jdsp, JParamSnapshot *snap)
+{
+	DDCSnapshot *ds = (DDCSnapshot *)snap;
+	int usedSOSCount = jdsp->vdcFl.usedSOSCount;
+	DirectForm2 *sosPointer = jdsp->vdcFl.sosPointer;
+	jdsp->vdcFl.usedSOSCount = ds->usedSOSCount;
+	jdsp->vdcFl.sosPointer = ds->sosPointer;
+	ds->usedSOSCount = usedSOSCount;
+	ds->sosPointer = sosPointer;
+}
+static void DDCSnapshotDestroy(JParamSnapshot *snap)
+{
+	DDCSnapshot *ds = (DDCSnapshot *)snap;
+	if (ds->sosPointer)
+		free(ds->sosPointer);
+}
+// Designs the cascade for the current rate and publishes it, an empty cascade is published when inStr is 0
 int DDCRefresh(JamesDSPLib *jdsp, char *inStr)
 {
-	if (!inStr)
+	DDCSnapshot *ds = (DDCSnapshot *)malloc(sizeof(DDCSnapshot));
+	if (!ds)
 		return 0;
+	memset(ds, 0, sizeof(DDCSnapshot));
+	ds->hdr.apply = DDCSnapshotApply;
+	ds->hdr.destroy = DDCSnapshotDestroy;
+	int success = 0;
 	DirectForm2 *df441 = 0, *df48 = 0;
-	int sosCount = DDCParser(inStr, &df441, &df48);
-	if (!sosCount)
-		return 0;
-	DirectForm2 *bk = jdsp->vdcFl.sosPointer;
-	if (jdsp->fs == 44100.0f && df441)
+	int sosCount = inStr ? DDCParser(inStr, &df441, &df48) : 0;
+	if (sosCount)
 	{
-		jdsp->vdcFl.sosPointer = df441;
-		jdsp->vdcFl.usedSOSCount = sosCount;
-		free(df48);
-	}
-	else if (jdsp->fs == 48000.0f && df48)
-	{
-		jdsp->vdcFl.sosPointer = df48;
-		jdsp->vdcFl.usedSOSCount = sosCount;
-		free(df441);
-	}
-	else
-	{
-		DirectForm2 *dfResampled;
-		int resampledSOSCount = PeakingFilterResampler(df48, 48000.0, &dfResampled, jdsp->fs, sosCount);
-		jdsp->vdcFl.usedSOSCount = resampledSOSCount;
-		jdsp->vdcFl.sosPointer = dfResampled;
-		free(df441);
-		free(df48);
+		if (jdsp->fs == 44100.0f && df441)
+		{
+			ds->sosPointer = df441;
+			ds->usedSOSCount = sosCount;
+			free(df48);
+		}
+		else if (jdsp->fs == 48000.0f && df48)
+		{
+			ds->sosPointer = df48;
+			ds->usedSOSCount = sosCount;
+			free(df441);
+		}
+		else
+		{
+			DirectForm2 *dfResampled;
+			int resampledSOSCount = PeakingFilterResampler(df48, 48000.0, &dfResampled, jdsp->fs, sosCount);
+			ds->usedSOSCount = resampledSOSCount;
+			ds->sosPointer = dfResampled;
+			free(df441);
+			free(df48);
+		}
+		success = ds->usedSOSCount && ds->sosPointer;
 	}
-	if (bk)
-		free(bk);
-	return 1;
+	JamesDSPCommitParam(jdsp, JDSP_PARAM_DDC, &ds->hdr);
+	return success;
 }
 int DDCEnable(JamesDSPLib *jdsp, char enable)
 {
 	int success = 1;
+	jdsp_lock(jdsp);
 	if (jdsp->ddcForceRefresh)
 	{
 		success = DDCRefresh(jdsp, jdsp->vdcFl.oldFile);
 		jdsp->ddcForceRefresh = 0;
 	}
-	if (!success || !jdsp->vdcFl.usedSOSCount || !jdsp->vdcFl.sosPointer)
+	jdsp_unlock(jdsp);
+	if (!success || !jdsp->vdcFl.oldFile)
 	{
 		jdsp->ddcEnabled = 0;
 		return -1;
@@ -323,12 +353,6 @@ int DDCStringParser(JamesDSPLib *jdsp, char *newStr)
 			return 0;
 		}
 	}
-	if (jdsp->vdcFl.sosPointer)
-	{
-		free(jdsp->vdcFl.sosPointer);
-		jdsp->vdcFl.usedSOSCount = 0;
-		jdsp->vdcFl.sosPointer = 0;
-	}
 	int success = DDCRefresh(jdsp, newStr);
 	if (!success)
 	{
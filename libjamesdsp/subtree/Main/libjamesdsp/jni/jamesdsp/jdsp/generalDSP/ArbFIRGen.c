@@ -4,6 +4,7 @@
 #include <errno.h>
 #include "../jdsp_header.h"
 #include "ArbFIRGen.h"
+#include "../Effects/eel2/numericSys/realFFT.h"
 #define PI 3.141592653589793
 #define PI2 6.283185307179586
 int get_floatArb(char *val, float *F)
@@ -80,9 +81,43 @@ float gainAtLogGrid(ArbitraryEq *arbEq, float freq)
 	}
 	return dbGain;
 }
+#define ARBEQ_WORKBYTES (MUL2FILTERLEN * (4 * sizeof(float) + sizeof(unsigned int)))
+static int ArbitraryEqAllocWork(ArbitraryEq *arbEq)
+{
+	if (arbEq->timeData)
+		return 1;
+	char *work = (char *)malloc(ARBEQ_WORKBYTES);
+	if (!work)
+		return 0;
+	arbEq->timeData = (float *)work;
+	arbEq->freqData = arbEq->timeData + MUL2FILTERLEN;
+	arbEq->mSineTab = arbEq->freqData + MUL2FILTERLEN;
+	arbEq->impulseResponse = arbEq->mSineTab + MUL2FILTERLEN;
+	arbEq->mBitRev = (unsigned int *)(arbEq->impulseResponse + MUL2FILTERLEN);
+	LLbitReversalTbl(arbEq->mBitRev, MUL2FILTERLEN);
+	realFFTTable(arbEq->mSineTab, MUL2FILTERLEN);
+	arbEq->fht = realFFTKernel(realFFTSelect(REALFFT_BEST), MUL2FILTERLEN);
+	return 1;
+}
+void ArbitraryEqReleaseWork(ArbitraryEq *arbEq)
+{
+	if (arbEq->timeData)
+		free(arbEq->timeData);
+	arbEq->timeData = 0;
+	arbEq->freqData = 0;
+	arbEq->mSineTab = 0;
+	arbEq->impulseResponse = 0;
+	arbEq->mBitRev = 0;
+}
+size_t ArbitraryEqWorkBytes(ArbitraryEq *arbEq)
+{
+	return arbEq->timeData ? ARBEQ_WORKBYTES : 0;
+}
 #define threshdB -100.0f
 float *ArbitraryEqMinimumPhase(ArbitraryEq *arbEq, float fs)
 {
+	if (!ArbitraryEqAllocWork(arbEq))
+		return 0;
 	float* timeData = arbEq->timeData;
 	float* freqData = arbEq->freqData;
 	const float threshold = powf(10.0f, threshdB / 20.0f);
@@ -108,7 +143,7 @@ float *ArbitraryEqMinimumPhase(ArbitraryEq *arbEq, float fs)
 		freqData[arbEq->mBitRev[i]] = gain;
 		freqData[arbEq->mBitRev[MUL2FILTERLEN - i]] = gain;
 	}
-	LLdiscreteHartleyFloat(freqData, MUL2FILTERLEN, arbEq->mSineTab);
+	arbEq->fht(freqData, arbEq->mSineTab);
 	gain = 1.0f / ((float)MUL2FILTERLEN);
 	timeData[0] = freqData[0] * gain;
 	timeData[arbEq->mBitRev[FILTERLEN]] = freqData[FILTERLEN] * gain;
@@ -117,7 +152,7 @@ float *ArbitraryEqMinimumPhase(ArbitraryEq *arbEq, float fs)
 		timeData[arbEq->mBitRev[i]] = (freqData[i] + freqData[MUL2FILTERLEN - i]) * gain;
 		timeData[arbEq->mBitRev[MUL2FILTERLEN - i]] = 0.0f;
 	}
-	LLdiscreteHartleyFloat(timeData, MUL2FILTERLEN, arbEq->mSineTab);
+	arbEq->fht(timeData, arbEq->mSineTab);
 	freqData[0] = expf(timeData[0]);
 	for (i = 1; i < MUL2FILTERLEN; i++)
 	{
@@ -129,7 +164,7 @@ float *ArbitraryEqMinimumPhase(ArbitraryEq *arbEq, float fs)
 		freqData[arbEq->mBitRev[i]] = re + im;
 		freqData[arbEq->mBitRev[MUL2FILTERLEN - i]] = re - im;
 	}
-	LLdiscreteHartleyFloat(freqData, MUL2FILTERLEN, arbEq->mSineTab);
+	arbEq->fht(freqData, arbEq->mSineTab);
 	float *finalImpulse = arbEq->impulseResponse;
 	for (i = 0; i < FILTERLEN; i++)
 		finalImpulse[i] = (1.0f / MUL2FILTERLEN) * freqData[i];
@@ -137,6 +172,8 @@ float *ArbitraryEqMinimumPhase(ArbitraryEq *arbEq, float fs)
 }
 float *ArbitraryEqLinearPhase(ArbitraryEq *arbEq, float fs)
 {
+	if (!ArbitraryEqAllocWork(arbEq))
+		return 0;
 	float* freqData = arbEq->freqData;
 	// Log grid interpolation
 	unsigned int i;
@@ -149,7 +186,7 @@ float *ArbitraryEqLinearPhase(ArbitraryEq *arbEq, float fs)
 		freqData[arbEq->mBitRev[i]] = gain;
 		freqData[arbEq->mBitRev[MUL2FILTERLEN - i]] = gain;
 	}
-	LLdiscreteHartleyFloat(freqData, MUL2FILTERLEN, arbEq->mSineTab);
+	arbEq->fht(freqData, arbEq->mSineTab);
 	float *finalImpulse = arbEq->impulseResponse;
 	for (i = 0; i < FILTERLEN; i++)
 	{
@@ -160,8 +197,7 @@ float *ArbitraryEqLinearPhase(ArbitraryEq *arbEq, float fs)
 }
 unsigned int InitArbitraryEq(ArbitraryEq* arbEq, int isLinearPhase)
 {
-	LLbitReversalTbl(arbEq->mBitRev, MUL2FILTERLEN);
-	fhtsinHalfTblFloat(arbEq->mSineTab, MUL2FILTERLEN);
+	arbEq->timeData = 0;
 	arbEq->nodesCount = 0;
 	if (!isLinearPhase)
 	{
@@ -272,6 +308,8 @@ void ArbitraryEqString2SortedNodes(ArbitraryEq *arbEq, char *frArbitraryEqString
 }
 float *InterpolatingEqMinimumPhase(ArbitraryEq *arbEq, float fs, void *lerper)
 {
+	if (!ArbitraryEqAllocWork(arbEq))
+		return 0;
 	ierper *ptr = (ierper*)lerper;
 	float* timeData = arbEq->timeData;
 	float* freqData = arbEq->freqData;
@@ -298,7 +336,7 @@ float *InterpolatingEqMinimumPhase(ArbitraryEq *arbEq, float fs, void *lerper)
 		freqData[arbEq->mBitRev[i]] = gain;
 		freqData[arbEq->mBitRev[MUL2FILTERLEN - i]] = gain;
 	}
-	LLdiscreteHartleyFloat(freqData, MUL2FILTERLEN, arbEq->mSineTab);
+	arbEq->fht(freqData, arbEq->mSineTab);
 	gain = 1.0f / ((float)MUL2FILTERLEN);
 	timeData[0] = freqData[0] * gain;
 	timeData[arbEq->mBitRev[FILTERLEN]] = freqData[FILTERLEN] * gain;
@@ -307,7 +345,7 @@ float *InterpolatingEqMinimumPhase(ArbitraryEq *arbEq, float fs, void *lerper)
 		timeData[arbEq->mBitRev[i]] = (freqData[i] + freqData[MUL2FILTERLEN - i]) * gain;
 		timeData[arbEq->mBitRev[MUL2FILTERLEN - i]] = 0.0f;
 	}
-	LLdiscreteHartleyFloat(timeData, MUL2FILTERLEN, arbEq->mSineTab);
+	arbEq->fht(timeData, arbEq->mSineTab);
 	freqData[0] = expf(timeData[0]);
 	for (i = 1; i < MUL2FILTERLEN; i++)
 	{
@@ -319,7 +357,7 @@ float *InterpolatingEqMinimumPhase(ArbitraryEq *arbEq, float fs, void *lerper)
 		freqData[arbEq->mBitRev[i]] = re + im;
 		freqData[arbEq->mBitRev[MUL2FILTERLEN - i]] = re - im;
 	}
-	LLdiscreteHartleyFloat(freqData, MUL2FILTERLEN, arbEq->mSineTab);
+	arbEq->fht(freqData, arbEq->mSineTab);
 	float *finalImpulse = arbEq->impulseResponse;
 	for (i = 0; i < FILTERLEN; i++)
 		finalImpulse[i] = (1.0f / MUL2FILTERLEN) * freqData[i];
@@ -327,6 +365,8 @@ float *InterpolatingEqMinimumPhase(ArbitraryEq *arbEq, float fs, void *lerper)
 }
 float *InterpolatingEqLinearPhase(ArbitraryEq *arbEq, float fs, void *lerper)
 {
+	if (!ArbitraryEqAllocWork(arbEq))
+		return 0;
 	ierper *ptr = (ierper*)lerper;
 	float* freqData = arbEq->freqData;
 	// Log grid interpolation
@@ -340,7 +380,7 @@ float *InterpolatingEqLinearPhase(ArbitraryEq *arbEq, float fs, void *lerper)
 		freqData[arbEq->mBitRev[i]] = gain;
 		freqData[arbEq->mBitRev[MUL2FILTERLEN - i]] = gain;
 	}
-	LLdiscreteHartleyFloat(freqData, MUL2FILTERLEN, arbEq->mSineTab);
+	arbEq->fht(freqData, arbEq->mSineTab);
 	float *finalImpulse = arbEq->impulseResponse;
 	for (i = 0; i < FILTERLEN; i++)
 	{
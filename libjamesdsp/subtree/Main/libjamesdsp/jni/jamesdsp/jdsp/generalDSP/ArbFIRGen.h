@@ -1,5 +1,6 @@
 #ifndef ARBFIRGEN_H
 #define ARBFIRGEN_H
+#include <stddef.h>
 typedef struct
 {
 	float freq;
@@ -12,15 +13,19 @@ typedef struct str_ArbitraryEq
 {
 	EqNode **nodes;
 	unsigned int nodesCount;
-	float timeData[MUL2FILTERLEN];
-	float freqData[MUL2FILTERLEN];
-	unsigned int mBitRev[MUL2FILTERLEN];
-	float mSineTab[MUL2FILTERLEN];
-	float impulseResponse[MUL2FILTERLEN];
+	// Design workspace, allocated by the first design and kept until ArbitraryEqReleaseWork()
+	float *timeData;
+	float *freqData;
+	unsigned int *mBitRev;
+	float *mSineTab;
+	void(*fht)(float*, const float*);
+	float *impulseResponse;
 	float* (*GetFilter)(struct str_ArbitraryEq*, float);
 } ArbitraryEq;
 extern void EqNodesFree(ArbitraryEq *arbEq);
 extern unsigned int InitArbitraryEq(ArbitraryEq* arbEq, int isLinearPhase);
+extern void ArbitraryEqReleaseWork(ArbitraryEq *arbEq);
+extern size_t ArbitraryEqWorkBytes(ArbitraryEq *arbEq);
 extern void ArbitraryEqString2SortedNodes(ArbitraryEq *arbEq, char *frArbitraryEqString);
 extern float *InterpolatingEqMinimumPhase(ArbitraryEq *arbEq, float fs, void *lerper);
 extern float *InterpolatingEqLinearPhase(ArbitraryEq *arbEq, float fs, void *lerper);
@@ -0,0 +1,405 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <time.h>
+#ifndef _WIN32
+#include <unistd.h>
+#include <sched.h>
+#endif
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#define CONVPOOL_FUTEX
+#endif
+#include "ConvolverWorkerPool.h"
+#define CONVPOOL_DEFAULT_SPIN (4000)
+enum
+{
+	MODE_INLINE, // No workers, jobs run on the submitting thread
+	MODE_LOCKED,
+	MODE_LOWLATENCY
+};
+static struct
+{
+	int initialized;
+	pthread_mutex_t control; // Serializes register, unregister and configure
+	pthread_mutex_t lock; // Queue, task states and counters, only the workers take it in low latency mode
+	pthread_cond_t work;
+	pthread_cond_t done;
+	pthread_t threads[CONVPOOL_MAX_THREADS];
+	unsigned int running;
+	int quit;
+	ConvolverWorkerPoolConfig cfg;
+	unsigned int tasks;
+	ConvolverPoolTask *queue;
+	// Low latency handoff
+	int mode;
+	int submitting; // Submitters between reading mode and publishing their task
+	ConvolverPoolTask *inbox; // Lock-free stack of submitted tasks, the workers move it to queue
+	int inboxSeq; // Futex word the idle workers sleep on
+	int sleepers;
+	unsigned int spin;
+	unsigned long long submitted;
+	unsigned long long missed;
+	unsigned long long spinResolved;
+} pool;
+static inline void cpuRelax()
+{
+#if defined(__i386__) || defined(__x86_64__)
+	__builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+	__asm__ __volatile__("yield");
+#endif
+}
+#ifdef CONVPOOL_FUTEX
+static void futexWait(int *addr, int val)
+{
+	syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, val, NULL, NULL, 0);
+}
+static void futexWake(int *addr, int n)
+{
+	syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, n, NULL, NULL, 0);
+}
+#endif
+static unsigned long long monotonicNs()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (unsigned long long)ts.tv_sec * 1000000000ULL + (unsigned long long)ts.tv_nsec;
+}
+static unsigned int threadBound(const ConvolverWorkerPoolConfig *cfg)
+{
+	long n = cfg->maxThreads;
+#ifndef _WIN32
+	if (!n)
+		n = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+	if (n < 1)
+		n = 2;
+	return n > CONVPOOL_MAX_THREADS ? CONVPOOL_MAX_THREADS : (unsigned int)n;
+}
+static void applySchedule(const ConvolverWorkerPoolConfig *cfg)
+{
+#ifdef __linux__
+	if (cfg->cpuMask)
+	{
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		for (int i = 0; i < 64; i++)
+			if (cfg->cpuMask & (1ULL << i))
+				CPU_SET(i, &set);
+		sched_setaffinity(0, sizeof(set), &set);
+	}
+#endif
+#ifndef _WIN32
+	if (cfg->rtPriority > 0)
+	{
+		struct sched_param sp;
+		memset(&sp, 0, sizeof(sp));
+		sp.sched_priority = cfg->rtPriority;
+		pthread_setschedparam(pthread_self(), SCHED_FIFO, &sp); // Needs RLIMIT_RTPRIO, falls back to the default policy
+	}
+#endif
+}
+// lock held, moves everything the submitters pushed to the queue
+static void takeInbox()
+{
+	ConvolverPoolTask *list = __atomic_exchange_n(&pool.inbox, (ConvolverPoolTask*)0, __ATOMIC_ACQUIRE);
+	if (!list)
+		return;
+	ConvolverPoolTask *last = list;
+	while (last->next)
+		last = last->next;
+	last->next = pool.queue;
+	pool.queue = list;
+}
+// lock held, earliest deadline first
+static ConvolverPoolTask *pickTask()
+{
+	ConvolverPoolTask **pick = &pool.queue;
+	for (ConvolverPoolTask **p = &pool.queue->next; *p; p = &(*p)->next)
+		if ((*p)->deadline < (*pick)->deadline)
+			pick = p;
+	ConvolverPoolTask *task = *pick;
+	*pick = task->next;
+	return task;
+}
+// lock held, wakes waiters of either kind
+static void completeTask(ConvolverPoolTask *task)
+{
+	__atomic_store_n(&task->state, IDLE, __ATOMIC_SEQ_CST);
+	pthread_cond_broadcast(&pool.done);
+#ifdef CONVPOOL_FUTEX
+	if (__atomic_load_n(&task->waiters, __ATOMIC_SEQ_CST))
+		futexWake((int*)&task->state, INT_MAX);
+#endif
+}
+static void *poolWorker(void *arg)
+{
+	(void)arg;
+	pthread_mutex_lock(&pool.lock);
+	ConvolverWorkerPoolConfig cfg = pool.cfg;
+	const int lowLatency = __atomic_load_n(&pool.mode, __ATOMIC_RELAXED) == MODE_LOWLATENCY;
+	pthread_mutex_unlock(&pool.lock);
+	applySchedule(&cfg);
+	pthread_mutex_lock(&pool.lock);
+	while (1)
+	{
+#ifdef CONVPOOL_FUTEX
+		if (lowLatency)
+		{
+			takeInbox();
+			if (!pool.queue && !pool.quit)
+			{
+				pthread_mutex_unlock(&pool.lock);
+				const int seq = __atomic_load_n(&pool.inboxSeq, __ATOMIC_SEQ_CST);
+				__atomic_add_fetch(&pool.sleepers, 1, __ATOMIC_SEQ_CST);
+				if (!__atomic_load_n(&pool.inbox, __ATOMIC_SEQ_CST) && !__atomic_load_n(&pool.quit, __ATOMIC_SEQ_CST))
+					futexWait(&pool.inboxSeq, seq);
+				__atomic_sub_fetch(&pool.sleepers, 1, __ATOMIC_SEQ_CST);
+				pthread_mutex_lock(&pool.lock);
+				continue;
+			}
+		}
+		else
+#endif
+		{
+			while (!pool.queue && !pool.quit)
+				pthread_cond_wait(&pool.work, &pool.lock);
+		}
+		if (pool.quit)
+			break;
+		ConvolverPoolTask *task = pickTask();
+		pthread_mutex_unlock(&pool.lock);
+		task->run(task->arg);
+		pthread_mutex_lock(&pool.lock);
+		completeTask(task);
+	}
+	pthread_mutex_unlock(&pool.lock);
+	return 0;
+}
+// control held
+static void spawnWorkers()
+{
+	unsigned int want = threadBound(&pool.cfg);
+	if (want > pool.tasks)
+		want = pool.tasks;
+	pthread_mutex_lock(&pool.lock);
+	while (pool.running < want)
+	{
+		if (pthread_create(&pool.threads[pool.running], NULL, poolWorker, 0) != 0)
+			break;
+		pool.running++;
+	}
+	if (pool.running)
+	{
+#ifdef CONVPOOL_FUTEX
+		const int lowLatency = pool.cfg.lowLatency;
+#else
+		const int lowLatency = 0;
+#endif
+		__atomic_store_n(&pool.mode, lowLatency ? MODE_LOWLATENCY : MODE_LOCKED, __ATOMIC_SEQ_CST);
+	}
+	pthread_mutex_unlock(&pool.lock);
+}
+// control held, jobs still queued run on the calling thread
+static void stopWorkers()
+{
+	__atomic_store_n(&pool.mode, MODE_INLINE, __ATOMIC_SEQ_CST);
+	// Lock-free submitters that saw the old mode are about to publish their task
+	while (__atomic_load_n(&pool.submitting, __ATOMIC_SEQ_CST))
+		cpuRelax();
+	pthread_mutex_lock(&pool.lock);
+	unsigned int n = pool.running;
+	__atomic_store_n(&pool.quit, 1, __ATOMIC_SEQ_CST);
+	pthread_cond_broadcast(&pool.work);
+	pthread_mutex_unlock(&pool.lock);
+#ifdef CONVPOOL_FUTEX
+	__atomic_add_fetch(&pool.inboxSeq, 1, __ATOMIC_SEQ_CST);
+	futexWake(&pool.inboxSeq, INT_MAX);
+#endif
+	for (unsigned int i = 0; i < n; i++)
+		pthread_join(pool.threads[i], NULL);
+	pthread_mutex_lock(&pool.lock);
+	pool.running = 0;
+	pool.quit = 0;
+	takeInbox();
+	while (pool.queue)
+	{
+		// Nobody left to run them
+		ConvolverPoolTask *task = pickTask();
+		task->run(task->arg);
+		completeTask(task);
+	}
+	pthread_mutex_unlock(&pool.lock);
+}
+void ConvolverWorkerPoolInit()
+{
+	if (pool.initialized)
+		return;
+	memset(&pool, 0, sizeof(pool));
+	pthread_mutex_init(&pool.control, NULL);
+	pthread_mutex_init(&pool.lock, NULL);
+	pthread_cond_init(&pool.work, NULL);
+	pthread_cond_init(&pool.done, NULL);
+	pool.spin = CONVPOOL_DEFAULT_SPIN;
+	pool.initialized = 1;
+}
+void ConvolverWorkerPoolDeinit()
+{
+	if (!pool.initialized)
+		return;
+	pthread_mutex_lock(&pool.control);
+	stopWorkers();
+	pthread_mutex_unlock(&pool.control);
+	pthread_cond_destroy(&pool.done);
+	pthread_cond_destroy(&pool.work);
+	pthread_mutex_destroy(&pool.lock);
+	pthread_mutex_destroy(&pool.control);
+	pool.initialized = 0;
+}
+void ConvolverWorkerPoolConfigure(const ConvolverWorkerPoolConfig *cfg)
+{
+	if (!pool.initialized)
+		return;
+	pthread_mutex_lock(&pool.control);
+	stopWorkers();
+	pthread_mutex_lock(&pool.lock);
+	pool.cfg = *cfg;
+	unsigned int spin = cfg->spinIterations ? cfg->spinIterations : CONVPOOL_DEFAULT_SPIN;
+#ifndef _WIN32
+	if (sysconf(_SC_NPROCESSORS_ONLN) < 2)
+		spin = 0; // Spinning only keeps the worker off the CPU
+#endif
+	__atomic_store_n(&pool.spin, spin, __ATOMIC_RELAXED);
+	pthread_mutex_unlock(&pool.lock);
+	spawnWorkers();
+	pthread_mutex_unlock(&pool.control);
+}
+void ConvolverWorkerPoolGetStats(ConvolverWorkerPoolStats *stats)
+{
+	memset(stats, 0, sizeof(ConvolverWorkerPoolStats));
+	if (!pool.initialized)
+		return;
+	pthread_mutex_lock(&pool.lock);
+	stats->threads = pool.running;
+	stats->tasks = pool.tasks;
+	stats->lowLatency = __atomic_load_n(&pool.mode, __ATOMIC_RELAXED) == MODE_LOWLATENCY;
+	pthread_mutex_unlock(&pool.lock);
+	stats->submitted = __atomic_load_n(&pool.submitted, __ATOMIC_RELAXED);
+	stats->missedDeadlines = __atomic_load_n(&pool.missed, __ATOMIC_RELAXED);
+	stats->spinResolved = __atomic_load_n(&pool.spinResolved, __ATOMIC_RELAXED);
+}
+void ConvolverPoolTaskRegister(ConvolverPoolTask *task, void(*run)(void *arg), void *arg)
+{
+	task->run = run;
+	task->arg = arg;
+	task->lastSubmit = 0;
+	task->deadline = 0;
+	task->missedDeadlines = 0;
+	task->waiters = 0;
+	task->next = 0;
+	task->state = IDLE;
+	if (!pool.initialized)
+		return;
+	pthread_mutex_lock(&pool.control);
+	pthread_mutex_lock(&pool.lock);
+	pool.tasks++;
+	pthread_mutex_unlock(&pool.lock);
+	spawnWorkers();
+	pthread_mutex_unlock(&pool.control);
+}
+void ConvolverPoolTaskUnregister(ConvolverPoolTask *task)
+{
+	if (__atomic_load_n(&task->state, __ATOMIC_ACQUIRE) == NOTHING)
+		return;
+	if (pool.initialized)
+	{
+		pthread_mutex_lock(&pool.control);
+		pthread_mutex_lock(&pool.lock);
+		while (task->state == WORKING)
+			pthread_cond_wait(&pool.done, &pool.lock);
+		pool.tasks--;
+		unsigned int remaining = pool.tasks;
+		pthread_mutex_unlock(&pool.lock);
+		if (!remaining)
+			stopWorkers();
+		pthread_mutex_unlock(&pool.control);
+	}
+	task->state = NOTHING;
+}
+void ConvolverPoolTaskSubmit(ConvolverPoolTask *task)
+{
+	if (pool.initialized)
+	{
+		const unsigned long long now = monotonicNs();
+		task->deadline = task->lastSubmit ? now + (now - task->lastSubmit) : now;
+		task->lastSubmit = now;
+		__atomic_add_fetch(&pool.submitting, 1, __ATOMIC_SEQ_CST);
+		if (__atomic_load_n(&pool.mode, __ATOMIC_SEQ_CST) == MODE_LOWLATENCY)
+		{
+			__atomic_store_n(&task->state, WORKING, __ATOMIC_RELAXED);
+			ConvolverPoolTask *head = __atomic_load_n(&pool.inbox, __ATOMIC_RELAXED);
+			do
+				task->next = head;
+			while (!__atomic_compare_exchange_n(&pool.inbox, &head, task, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+			__atomic_sub_fetch(&pool.submitting, 1, __ATOMIC_SEQ_CST);
+			__atomic_add_fetch(&pool.submitted, 1, __ATOMIC_RELAXED);
+#ifdef CONVPOOL_FUTEX
+			__atomic_add_fetch(&pool.inboxSeq, 1, __ATOMIC_SEQ_CST);
+			if (__atomic_load_n(&pool.sleepers, __ATOMIC_SEQ_CST))
+				futexWake(&pool.inboxSeq, 1);
+#endif
+			return;
+		}
+		__atomic_sub_fetch(&pool.submitting, 1, __ATOMIC_SEQ_CST);
+		pthread_mutex_lock(&pool.lock);
+		if (pool.running)
+		{
+			task->state = WORKING;
+			task->next = pool.queue;
+			pool.queue = task;
+			__atomic_add_fetch(&pool.submitted, 1, __ATOMIC_RELAXED);
+			pthread_cond_signal(&pool.work);
+			pthread_mutex_unlock(&pool.lock);
+			return;
+		}
+		pthread_mutex_unlock(&pool.lock);
+	}
+	task->run(task->arg);
+}
+void ConvolverPoolTaskWait(ConvolverPoolTask *task)
+{
+	if (__atomic_load_n(&task->state, __ATOMIC_ACQUIRE) != WORKING)
+		return;
+	task->missedDeadlines++;
+	__atomic_add_fetch(&pool.missed, 1, __ATOMIC_RELAXED);
+#ifdef CONVPOOL_FUTEX
+	if (__atomic_load_n(&pool.mode, __ATOMIC_RELAXED) == MODE_LOWLATENCY)
+	{
+		// Bounded spin first, the job is usually about to finish
+		const unsigned int spin = __atomic_load_n(&pool.spin, __ATOMIC_RELAXED);
+		for (unsigned int i = 0; i < spin; i++)
+		{
+			if (__atomic_load_n(&task->state, __ATOMIC_ACQUIRE) != WORKING)
+			{
+				__atomic_add_fetch(&pool.spinResolved, 1, __ATOMIC_RELAXED);
+				return;
+			}
+			cpuRelax();
+		}
+		__atomic_add_fetch(&task->waiters, 1, __ATOMIC_SEQ_CST);
+		while (__atomic_load_n(&task->state, __ATOMIC_SEQ_CST) == WORKING)
+			futexWait((int*)&task->state, WORKING);
+		__atomic_sub_fetch(&task->waiters, 1, __ATOMIC_SEQ_CST);
+		return;
+	}
+#endif
+	pthread_mutex_lock(&pool.lock);
+	while (task->state == WORKING)
+		pthread_cond_wait(&pool.done, &pool.lock);
+	pthread_mutex_unlock(&pool.lock);
+}
@@ -0,0 +1,69 @@
+#ifndef _FFTCONVOLVER_CONVOLVERWORKERPOOL_H
+#define _FFTCONVOLVER_CONVOLVERWORKERPOOL_H
+#include "../Effects/eel2/cpthread.h"
+#define CONVPOOL_MAX_THREADS (16)
+enum pt_state
+{
+	NOTHING,
+	IDLE,
+	WORKING
+};
+typedef struct ConvolverPoolTask
+{
+	enum pt_state state; // NOTHING while unregistered, WORKING from submit until the job has run
+	void(*run)(void *arg);
+	void *arg;
+	unsigned long long lastSubmit; // CLOCK_MONOTONIC ns
+	unsigned long long deadline; // Result is due when the owner submits the next job, one period after this one
+	unsigned int missedDeadlines;
+	int waiters; // Threads asleep on state
+	struct ConvolverPoolTask *next;
+} ConvolverPoolTask;
+typedef struct
+{
+	unsigned int maxThreads; // 0: one per online CPU, never more threads than registered tasks
+	int rtPriority; // SCHED_FIFO priority of the workers, 0 keeps the default policy
+	unsigned long long cpuMask; // Workers only run on these CPUs, 0: any
+	int lowLatency; // Linux: lock-free submit, waiting spins spinIterations times before sleeping on a futex
+	unsigned int spinIterations; // 0: default
+} ConvolverWorkerPoolConfig;
+typedef struct
+{
+	unsigned int threads;
+	unsigned int tasks;
+	unsigned long long submitted;
+	unsigned long long missedDeadlines; // Waits that found the job still queued or running
+	unsigned long long spinResolved; // Missed deadlines the low latency handoff caught while spinning
+	int lowLatency;
+} ConvolverWorkerPoolStats;
+/**
+* @brief Process wide worker threads shared by the tails of every multi-stage convolver
+*
+* Tail convolvers register a task once when their impulse response is loaded, then
+* submit it each time a tail block is full and wait for it right before the result
+* is consumed. Queued jobs run earliest deadline first, the deadline of a job is
+* its submit time plus the time since the previous submit of the same task.
+*
+* Before ConvolverWorkerPoolInit or when no worker could be started, submitted jobs
+* run on the calling thread.
+*
+* By default the handoff uses the pool mutex and condition variables. The optional
+* low latency handoff never locks on the audio thread: submitting pushes to an
+* atomic stack and bumps a sequence counter the idle workers sleep on, waiting
+* spins for a bounded time before it sleeps on the task state with a futex.
+*/
+extern void ConvolverWorkerPoolInit();
+extern void ConvolverWorkerPoolDeinit();
+/**
+* @brief Applies a new configuration, running workers finish the queued jobs and are restarted
+*/
+extern void ConvolverWorkerPoolConfigure(const ConvolverWorkerPoolConfig *cfg);
+extern void ConvolverWorkerPoolGetStats(ConvolverWorkerPoolStats *stats);
+extern void ConvolverPoolTaskRegister(ConvolverPoolTask *task, void(*run)(void *arg), void *arg);
+// Waits for a pending job before detaching the task
+extern void ConvolverPoolTaskUnregister(ConvolverPoolTask *task);
+// Called from the audio thread, the task must not be pending
+extern void ConvolverPoolTaskSubmit(ConvolverPoolTask *task);
+// Returns immediately when no job is pending
+extern void ConvolverPoolTaskWait(ConvolverPoolTask *task);
+#endif
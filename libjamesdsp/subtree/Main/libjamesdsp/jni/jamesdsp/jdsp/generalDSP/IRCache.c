@@ -0,0 +1,484 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#ifndef _WIN32
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#endif
+#include "../Effects/eel2/cpthread.h"
+#include "IRCache.h"
+#define IRCACHE_HEADER (64)
+static const char irCacheMagic[8] = { 'J', 'D', 'S', 'P', 'I', 'R', 'C', '1' };
+static inline uint64_t rotl64(uint64_t x, int r)
+{
+	return (x << r) | (x >> (64 - r));
+}
+static inline uint64_t fmix64(uint64_t x)
+{
+	x ^= x >> 33;
+	x *= 0xff51afd7ed558ccdULL;
+	x ^= x >> 33;
+	x *= 0xc4ceb9fe1a85ec53ULL;
+	x ^= x >> 33;
+	return x;
+}
+static inline void keyWord(IRCacheKey *key, uint64_t w)
+{
+	key->h[0] = rotl64(key->h[0] ^ (w * 0x87c37b91114253d5ULL), 31) * 0x4cf5ad432745937fULL;
+	key->h[1] = rotl64(key->h[1] + (w ^ key->h[0]), 27) * 5 + 0x52dce729;
+}
+void IRCacheKeyInit(IRCacheKey *key, const char *tag)
+{
+	memset(key, 0, sizeof(IRCacheKey));
+	key->h[0] = 0x9e3779b97f4a7c15ULL;
+	key->h[1] = 0x6a09e667f3bcc909ULL;
+	IRCacheKeyUpdate(key, tag, strlen(tag) + 1);
+}
+void IRCacheKeyUpdate(IRCacheKey *key, const void *data, size_t bytes)
+{
+	const unsigned char *p = (const unsigned char *)data;
+	uint64_t w;
+	key->len += bytes;
+	if (key->tailLen)
+	{
+		while (bytes && key->tailLen < 8)
+		{
+			key->tail[key->tailLen++] = *p++;
+			bytes--;
+		}
+		if (key->tailLen < 8)
+			return;
+		memcpy(&w, key->tail, 8);
+		keyWord(key, w);
+		key->tailLen = 0;
+	}
+	for (; bytes >= 8; p += 8, bytes -= 8)
+	{
+		memcpy(&w, p, 8);
+		keyWord(key, w);
+	}
+	memcpy(key->tail, p, bytes);
+	key->tailLen = (unsigned int)bytes;
+}
+int IRCacheKeyUpdateFile(IRCacheKey *key, const char *filename)
+{
+	FILE *f = fopen(filename, "rb");
+	if (!f)
+		return 0;
+	unsigned char *buf = (unsigned char *)malloc(1 << 20);
+	size_t got;
+	while ((got = fread(buf, 1, 1 << 20, f)) > 0)
+		IRCacheKeyUpdate(key, buf, got);
+	int ok = !ferror(f);
+	free(buf);
+	fclose(f);
+	return ok;
+}
+static void keyDigest(const IRCacheKey *key, uint64_t digest[2])
+{
+	IRCacheKey k = *key;
+	uint64_t w = 0;
+	memcpy(&w, k.tail, k.tailLen);
+	keyWord(&k, w ^ ((uint64_t)k.tailLen << 56));
+	digest[0] = fmix64(k.h[0] ^ k.len);
+	digest[1] = fmix64(k.h[1] + digest[0]);
+	digest[0] = fmix64(digest[0] + digest[1]);
+}
+#ifndef _WIN32
+static struct
+{
+	pthread_mutex_t lock;
+	char *dir; // Resolved on first use
+	int resolved;
+	uint64_t limit;
+} irCache = { PTHREAD_MUTEX_INITIALIZER, 0, 0, IRCACHE_DEFAULT_LIMIT };
+static int makeDirs(char *path)
+{
+	for (char *p = path + 1; *p; p++)
+	{
+		if (*p != '/')
+			continue;
+		*p = 0;
+		int r = mkdir(path, 0755);
+		*p = '/';
+		if (r && errno != EEXIST)
+			return 0;
+	}
+	return !mkdir(path, 0755) || errno == EEXIST;
+}
+// Caller holds irCache.lock
+static const char *cacheDir()
+{
+	if (irCache.resolved)
+		return irCache.dir;
+	irCache.resolved = 1;
+	const char *xdg = getenv("XDG_CACHE_HOME");
+	const char *home = getenv("HOME");
+	const char *suffix = (xdg && xdg[0]) ? "/jamesdsp/ir" : "/.cache/jamesdsp/ir";
+	const char *base = (xdg && xdg[0]) ? xdg : home;
+	if (!base || !base[0])
+		return 0;
+	irCache.dir = (char *)malloc(strlen(base) + strlen(suffix) + 1);
+	strcpy(irCache.dir, base);
+	strcat(irCache.dir, suffix);
+	return irCache.dir;
+}
+void IRCacheSetDirectory(const char *dir)
+{
+	pthread_mutex_lock(&irCache.lock);
+	free(irCache.dir);
+	irCache.dir = 0;
+	irCache.resolved = dir != 0;
+	if (dir && dir[0])
+		irCache.dir = strdup(dir);
+	pthread_mutex_unlock(&irCache.lock);
+}
+void IRCacheSetLimit(uint64_t bytes)
+{
+	pthread_mutex_lock(&irCache.lock);
+	irCache.limit = bytes;
+	pthread_mutex_unlock(&irCache.lock);
+}
+// Path of the entry, NULL when the cache is disabled
+static char *entryPath(const uint64_t digest[2], int makeDir)
+{
+	pthread_mutex_lock(&irCache.lock);
+	const char *dir = cacheDir();
+	char *path = 0;
+	if (dir && (!makeDir || makeDirs(irCache.dir)))
+	{
+		path = (char *)malloc(strlen(dir) + 40);
+		sprintf(path, "%s/%016llx%016llx.bin", dir, (unsigned long long)digest[0], (unsigned long long)digest[1]);
+	}
+	pthread_mutex_unlock(&irCache.lock);
+	return path;
+}
+int IRCacheOpen(const IRCacheKey *key, IRCacheEntry *entry)
+{
+	uint64_t digest[2];
+	memset(entry, 0, sizeof(IRCacheEntry));
+	keyDigest(key, digest);
+	char *path = entryPath(digest, 0);
+	if (!path)
+		return 0;
+	int fd = open(path, O_RDONLY | O_CLOEXEC);
+	struct stat st;
+	if (fd < 0 || fstat(fd, &st) || st.st_size < IRCACHE_HEADER)
+	{
+		if (fd >= 0)
+			close(fd);
+		free(path);
+		return 0;
+	}
+	// Entries are opened while an IR loads, fault the whole file in now rather than on the audio thread
+#ifdef MAP_POPULATE
+	void *map = mmap(0, (size_t)st.st_size, PROT_READ, MAP_SHARED | MAP_POPULATE, fd, 0);
+#else
+	void *map = mmap(0, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+#endif
+	close(fd);
+	if (map == MAP_FAILED)
+	{
+		free(path);
+		return 0;
+	}
+#ifndef MAP_POPULATE
+	madvise(map, (size_t)st.st_size, MADV_WILLNEED);
+#endif
+	const unsigned char *hdr = (const unsigned char *)map;
+	uint64_t stored[2], bytes;
+	memcpy(stored, hdr + 8, 16);
+	memcpy(&bytes, hdr + 24, 8);
+	if (memcmp(hdr, irCacheMagic, 8) || stored[0] != digest[0] || stored[1] != digest[1] || bytes != (uint64_t)st.st_size - IRCACHE_HEADER)
+	{
+		munmap(map, (size_t)st.st_size);
+		unlink(path);
+		free(path);
+		return 0;
+	}
+	utimes(path, 0); // Recently used
+	free(path);
+	entry->map = map;
+	entry->mapBytes = (size_t)st.st_size;
+	entry->data = hdr + IRCACHE_HEADER;
+	entry->bytes = (size_t)bytes;
+	return 1;
+}
+void IRCacheClose(IRCacheEntry *entry)
+{
+	if (entry->map)
+		munmap(entry->map, entry->mapBytes);
+	memset(entry, 0, sizeof(IRCacheEntry));
+}
+// Pages the convolvers read in place must not be reclaimed, best effort as RLIMIT_MEMLOCK may not allow it
+static void entryLock(IRCacheEntry *entry)
+{
+	mlock(entry->map, entry->mapBytes);
+}
+int IRCacheWriterOpen(IRCacheWriter *w, const IRCacheKey *key)
+{
+	uint64_t digest[2];
+	memset(w, 0, sizeof(IRCacheWriter));
+	keyDigest(key, digest);
+	w->path = entryPath(digest, 1);
+	if (!w->path)
+		return 0;
+	w->tmpPath = (char *)malloc(strlen(w->path) + 24);
+	sprintf(w->tmpPath, "%s.%ld.tmp", w->path, (long)getpid());
+	w->f = fopen(w->tmpPath, "wb");
+	if (!w->f)
+	{
+		free(w->path);
+		free(w->tmpPath);
+		memset(w, 0, sizeof(IRCacheWriter));
+		return 0;
+	}
+	unsigned char hdr[IRCACHE_HEADER] = { 0 };
+	memcpy(hdr, irCacheMagic, 8);
+	memcpy(hdr + 8, digest, 16);
+	if (fwrite(hdr, 1, IRCACHE_HEADER, w->f) != IRCACHE_HEADER)
+	{
+		IRCacheWriterClose(w, 0);
+		return 0;
+	}
+	return 1;
+}
+int IRCacheWrite(IRCacheWriter *w, const void *data, size_t bytes)
+{
+	if (!w->f)
+		return 0;
+	if (fwrite(data, 1, bytes, w->f) != bytes)
+	{
+		IRCacheWriterClose(w, 0);
+		return 0;
+	}
+	w->bytes += bytes;
+	return 1;
+}
+typedef struct
+{
+	char *name;
+	time_t mtime;
+	off_t size;
+} cacheFile;
+static int olderFirst(const void *a, const void *b)
+{
+	const cacheFile *x = (const cacheFile *)a, *y = (const cacheFile *)b;
+	return x->mtime < y->mtime ? -1 : x->mtime > y->mtime;
+}
+// Deletes the least recently used entries until the directory fits the limit
+static void pruneCache(const char *dir, uint64_t limit)
+{
+	DIR *d = opendir(dir);
+	if (!d)
+		return;
+	cacheFile *files = 0;
+	size_t count = 0, cap = 0;
+	uint64_t total = 0;
+	struct dirent *e;
+	char *path = (char *)malloc(strlen(dir) + 300);
+	while ((e = readdir(d)))
+	{
+		size_t len = strlen(e->d_name);
+		if (len < 4 || strcmp(e->d_name + len - 4, ".bin"))
+			continue;
+		struct stat st;
+		sprintf(path, "%s/%s", dir, e->d_name);
+		if (stat(path, &st))
+			continue;
+		if (count == cap)
+		{
+			cap = cap ? cap * 2 : 64;
+			files = (cacheFile *)realloc(files, cap * sizeof(cacheFile));
+		}
+		files[count].name = strdup(e->d_name);
+		files[count].mtime = st.st_mtime;
+		files[count].size = st.st_size;
+		total += (uint64_t)st.st_size;
+		count++;
+	}
+	closedir(d);
+	if (count)
+		qsort(files, count, sizeof(cacheFile), olderFirst);
+	for (size_t i = 0; i < count; i++)
+	{
+		if (total > limit)
+		{
+			sprintf(path, "%s/%s", dir, files[i].name);
+			if (!unlink(path))
+				total -= (uint64_t)files[i].size;
+		}
+		free(files[i].name);
+	}
+	free(files);
+	free(path);
+}
+void IRCacheWriterClose(IRCacheWriter *w, int keep)
+{
+	if (!w->f)
+		return;
+	uint64_t bytes = (uint64_t)w->bytes;
+	if (keep)
+		keep = !fseek(w->f, 24, SEEK_SET) && fwrite(&bytes, 8, 1, w->f) == 1;
+	if (fclose(w->f))
+		keep = 0;
+	if (!keep || rename(w->tmpPath, w->path))
+		unlink(w->tmpPath);
+	else
+	{
+		pthread_mutex_lock(&irCache.lock);
+		char *dir = irCache.dir ? strdup(irCache.dir) : 0;
+		uint64_t limit = irCache.limit;
+		pthread_mutex_unlock(&irCache.lock);
+		if (dir)
+			pruneCache(dir, limit);
+		free(dir);
+	}
+	free(w->path);
+	free(w->tmpPath);
+	memset(w, 0, sizeof(IRCacheWriter));
+}
+#else
+void IRCacheSetDirectory(const char *dir)
+{
+}
+void IRCacheSetLimit(uint64_t bytes)
+{
+}
+int IRCacheOpen(const IRCacheKey *key, IRCacheEntry *entry)
+{
+	memset(entry, 0, sizeof(IRCacheEntry));
+	return 0;
+}
+void IRCacheClose(IRCacheEntry *entry)
+{
+}
+static void entryLock(IRCacheEntry *entry)
+{
+}
+int IRCacheWriterOpen(IRCacheWriter *w, const IRCacheKey *key)
+{
+	memset(w, 0, sizeof(IRCacheWriter));
+	return 0;
+}
+int IRCacheWrite(IRCacheWriter *w, const void *data, size_t bytes)
+{
+	return 0;
+}
+void IRCacheWriterClose(IRCacheWriter *w, int keep)
+{
+}
+#endif
+static void mappingRelease(FFTConvolverSharedSpectra *self)
+{
+	IRCacheMappingRelease((IRCacheMapping *)self);
+}
+static IRCacheMapping *mappingCreate(IRCacheEntry *entry)
+{
+	IRCacheMapping *m = (IRCacheMapping *)malloc(sizeof(IRCacheMapping));
+	if (!m)
+		return 0;
+	m->base.release = mappingRelease;
+	m->entry = *entry;
+	m->refs = 1;
+	entryLock(&m->entry);
+	return m;
+}
+IRCacheMapping *IRCacheMapOrStore(const IRCacheKey *key, const void *data, size_t bytes)
+{
+	IRCacheEntry entry;
+	if (!IRCacheOpen(key, &entry))
+	{
+		IRCacheWriter w;
+		if (!IRCacheWriterOpen(&w, key))
+			return 0;
+		IRCacheWriterClose(&w, IRCacheWrite(&w, data, bytes));
+		if (!IRCacheOpen(key, &entry))
+			return 0;
+	}
+	if (entry.bytes != bytes)
+	{
+		IRCacheClose(&entry);
+		return 0;
+	}
+	IRCacheMapping *m = mappingCreate(&entry);
+	if (!m)
+		IRCacheClose(&entry);
+	return m;
+}
+void IRCacheMappingRetain(IRCacheMapping *m)
+{
+	__atomic_add_fetch(&m->refs, 1, __ATOMIC_RELAXED);
+}
+void IRCacheMappingRelease(IRCacheMapping *m)
+{
+	if (__atomic_sub_fetch(&m->refs, 1, __ATOMIC_ACQ_REL))
+		return;
+	IRCacheClose(&m->entry);
+	free(m);
+}
+// Spectra of a convolver tree, the arenas in the order the convolvers load them
+static const float *spectraShare(void *ctx, size_t bytes, FFTConvolverSharedSpectra **owner)
+{
+	IRCacheSpectra *s = (IRCacheSpectra *)ctx;
+	if (!s->hit || !s->mapping)
+		return 0;
+	if (s->offset + bytes > s->entry.bytes)
+	{
+		s->hit = 0;
+		return 0;
+	}
+	const float *spectra = (const float *)((const char *)s->entry.data + s->offset);
+	s->offset += bytes;
+	IRCacheMappingRetain(s->mapping);
+	*owner = &s->mapping->base;
+	return spectra;
+}
+static int spectraFill(void *ctx, float *arena, size_t bytes)
+{
+	IRCacheSpectra *s = (IRCacheSpectra *)ctx;
+	if (!s->hit)
+		return 0;
+	if (s->offset + bytes > s->entry.bytes)
+	{
+		s->hit = 0; // Layout does not match, the remaining arenas are transformed
+		return 0;
+	}
+	memcpy(arena, (const char *)s->entry.data + s->offset, bytes);
+	s->offset += bytes;
+	return 1;
+}
+static void spectraStore(void *ctx, const float *arena, size_t bytes)
+{
+	IRCacheSpectra *s = (IRCacheSpectra *)ctx;
+	if (s->writing)
+		s->writing = IRCacheWrite(&s->writer, arena, bytes);
+}
+void IRCacheSpectraBegin(IRCacheSpectra *s, const IRCacheKey *key, int share)
+{
+	memset(s, 0, sizeof(IRCacheSpectra));
+	s->hit = IRCacheOpen(key, &s->entry);
+	if (s->hit && share)
+		s->mapping = mappingCreate(&s->entry);
+	if (!s->hit)
+		s->writing = IRCacheWriterOpen(&s->writer, key);
+	s->hook.share = spectraShare;
+	s->hook.fill = spectraFill;
+	s->hook.store = spectraStore;
+	s->hook.ctx = s;
+	FFTConvolverSetSpectrumHook(&s->hook);
+}
+void IRCacheSpectraEnd(IRCacheSpectra *s, int ok)
+{
+	FFTConvolverSetSpectrumHook(0);
+	if (s->mapping)
+		IRCacheMappingRelease(s->mapping); // Convolvers sharing the spectra keep it mapped
+	else
+		IRCacheClose(&s->entry);
+	IRCacheWriterClose(&s->writer, ok && s->writing);
+}
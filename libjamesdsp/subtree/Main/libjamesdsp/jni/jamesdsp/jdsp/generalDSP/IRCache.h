@@ -0,0 +1,90 @@
+#ifndef _IRCACHE_H
+#define _IRCACHE_H
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include "../Effects/eel2/numericSys/FFTConvolver.h"
+/**
+* @brief On disk cache of preprocessed impulse responses and their partition spectra
+*
+* Entries are named by a 128 bit hash of everything the content depends on and live
+* in $XDG_CACHE_HOME/jamesdsp/ir, falling back to $HOME/.cache/jamesdsp/ir. A hit is
+* memory mapped, the payload starts 64 bytes into the file so it keeps the alignment
+* of the convolver arenas. Entries are written to a temporary file and renamed into
+* place, the least recently used ones are deleted once the directory exceeds the limit.
+*/
+#define IRCACHE_DEFAULT_LIMIT (1024ULL * 1024ULL * 1024ULL)
+typedef struct
+{
+	uint64_t h[2];
+	uint64_t len;
+	unsigned char tail[8];
+	unsigned int tailLen;
+} IRCacheKey;
+typedef struct
+{
+	void *map;
+	size_t mapBytes;
+	const void *data;
+	size_t bytes;
+} IRCacheEntry;
+typedef struct
+{
+	FILE *f;
+	char *path, *tmpPath;
+	size_t bytes;
+} IRCacheWriter;
+// NULL: default location, empty string: cache disabled
+extern void IRCacheSetDirectory(const char *dir);
+extern void IRCacheSetLimit(uint64_t bytes);
+extern void IRCacheKeyInit(IRCacheKey *key, const char *tag);
+extern void IRCacheKeyUpdate(IRCacheKey *key, const void *data, size_t bytes);
+// Hashes the file content, returns 0 when it can not be read
+extern int IRCacheKeyUpdateFile(IRCacheKey *key, const char *filename);
+// Returns 1 and maps the entry on a hit
+extern int IRCacheOpen(const IRCacheKey *key, IRCacheEntry *entry);
+extern void IRCacheClose(IRCacheEntry *entry);
+extern int IRCacheWriterOpen(IRCacheWriter *w, const IRCacheKey *key);
+extern int IRCacheWrite(IRCacheWriter *w, const void *data, size_t bytes);
+// Publishes the entry when keep is set and every write succeeded, discards it otherwise
+extern void IRCacheWriterClose(IRCacheWriter *w, int keep);
+/**
+* @brief Reference counted read only mapping of an entry
+*
+* Every process mapping the same entry shares its pages through the page cache, so
+* convolvers running off a mapping add no resident memory per instance.
+*
+* The convolvers read the mapping on the audio thread, so entries are prefaulted when
+* they are opened and a mapping is locked in memory. Locking fails once RLIMIT_MEMLOCK
+* is exhausted, reclaimed pages then fault back in on the audio thread, which is why
+* sharing is off unless Convolver1DSetSharedSpectra turns it on.
+*/
+typedef struct
+{
+	FFTConvolverSharedSpectra base; // Releases one reference
+	IRCacheEntry entry;
+	int refs;
+} IRCacheMapping;
+// Maps the entry, storing data first when it is missing, NULL when the cache is unavailable
+extern IRCacheMapping *IRCacheMapOrStore(const IRCacheKey *key, const void *data, size_t bytes);
+extern void IRCacheMappingRetain(IRCacheMapping *m);
+extern void IRCacheMappingRelease(IRCacheMapping *m);
+/**
+* @brief Serves the partition spectra of the convolvers loaded on the calling thread between Begin and End
+*
+* On a hit every impulse response arena is copied from the entry instead of being
+* transformed, or with share set the convolvers use the mapped spectra in place. On a
+* miss the computed arenas are recorded and published by End when ok is set.
+*/
+typedef struct
+{
+	IRCacheEntry entry;
+	IRCacheMapping *mapping; // Hit in shared mode, owns entry
+	IRCacheWriter writer;
+	FFTConvolverSpectrumHook hook;
+	size_t offset;
+	int hit, writing;
+} IRCacheSpectra;
+extern void IRCacheSpectraBegin(IRCacheSpectra *s, const IRCacheKey *key, int share);
+extern void IRCacheSpectraEnd(IRCacheSpectra *s, int ok);
+#endif
@@ -0,0 +1,801 @@
+#include "MultiStageFFTConvolver.h"
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+#include <math.h>
+#include "../Effects/eel2/ns-eel.h"
+#include "../jdsp_header.h"
+// The reversed impulse responses are padded with leading zeros to a multiple of 16 taps, maxChunk bounds the samples per call
+static int directHeadLoad(MultiStageDirectHead *h, unsigned int inputs, unsigned int outputs, const float *const *ir, unsigned int irLen, unsigned int maxChunk)
+{
+	unsigned int c, k;
+	h->taps = (irLen + 15) & ~15u;
+	h->inputs = inputs;
+	h->outputs = outputs;
+	for (c = 0; c < inputs * outputs; c++)
+	{
+		h->ir[c] = 0;
+		if (!ir[c])
+			continue;
+		h->ir[c] = (float*)malloc(h->taps * sizeof(float));
+		if (!h->ir[c])
+			return 0;
+		memset(h->ir[c], 0, h->taps * sizeof(float));
+		for (k = 0; k < irLen; k++)
+			h->ir[c][h->taps - 1 - k] = ir[c][k];
+	}
+	for (c = 0; c < inputs; c++)
+	{
+		h->history[c] = (float*)malloc((h->taps - 1 + maxChunk) * sizeof(float));
+		if (!h->history[c])
+			return 0;
+		memset(h->history[c], 0, (h->taps - 1) * sizeof(float));
+	}
+	h->mac = spectralMACSelect(SPECTRALMAC_BEST);
+	return 1;
+}
+static void directHeadFree(MultiStageDirectHead *h)
+{
+	for (unsigned int c = 0; c < 4; c++)
+	{
+		if (c < h->inputs * h->outputs)
+			free(h->ir[c]);
+		h->ir[c] = 0;
+	}
+	for (unsigned int c = 0; c < 2; c++)
+	{
+		if (c < h->inputs)
+			free(h->history[c]);
+		h->history[c] = 0;
+	}
+	h->taps = h->inputs = h->outputs = 0;
+}
+// y may alias x, the inputs are copied to the history first
+static void directHeadProcess(MultiStageDirectHead *h, const float *const *x, float *const *y, unsigned int len)
+{
+	unsigned int c, o, j;
+	for (c = 0; c < h->inputs; c++)
+		memcpy(h->history[c] + h->taps - 1, x[c], len * sizeof(float));
+	for (o = 0; o < h->outputs; o++)
+	{
+		for (j = 0; j < len; j++)
+		{
+			float sum = 0.0f;
+			for (c = 0; c < h->inputs; c++)
+				if (h->ir[c * h->outputs + o])
+					sum += h->mac->dot(h->ir[c * h->outputs + o], h->history[c] + j, h->taps);
+			y[o][j] = sum;
+		}
+	}
+	for (c = 0; c < h->inputs; c++)
+		memmove(h->history[c], h->history[c] + len, (h->taps - 1) * sizeof(float));
+}
+static double directHeadEnergy(MultiStageDirectHead *h)
+{
+	double energy = 0.0;
+	for (unsigned int c = 0; c < h->inputs * h->outputs; c++)
+		for (unsigned int k = 0; h->ir[c] && k < h->taps; k++)
+			energy += (double)h->ir[c][k] * h->ir[c][k];
+	return energy;
+}
+void MultiStageFFTConvolver2x4x2Init(MultiStageFFTConvolver2x4x2 *conv)
+{
+	conv->_headBlockSize = 0;
+	conv->_tailCount = 0;
+	FFTConvolver2x4x2Init(&conv->_headConvolver);
+	memset(&conv->_direct, 0, sizeof(MultiStageDirectHead));
+	for (int i = 0; i < MULTISTAGE_MAX_STAGES - 1; i++)
+	{
+		MultiStageTail2x4x2 *st = &conv->_tail[i];
+		st->_blockSize = 0;
+		FFTConvolver2x4x2Init(&st->_convolver);
+		st->_output[0] = st->_output[1] = 0;
+		st->_precalculated[0] = st->_precalculated[1] = 0;
+		st->_backgroundProcessingInput[0] = st->_backgroundProcessingInput[1] = 0;
+#ifdef THREAD
+		st->shared_info.task.state = NOTHING;
+#endif
+	}
+	conv->_tailInput[0] = conv->_tailInput[1] = 0;
+	conv->_tailInputSize = 0;
+	conv->_tailInputFill = 0;
+}
+void MultiStageFFTConvolver2x2Init(MultiStageFFTConvolver2x2 *conv)
+{
+	conv->_headBlockSize = 0;
+	conv->_tailCount = 0;
+	FFTConvolver2x2Init(&conv->_headConvolver);
+	memset(&conv->_direct, 0, sizeof(MultiStageDirectHead));
+	for (int i = 0; i < MULTISTAGE_MAX_STAGES - 1; i++)
+	{
+		MultiStageTail2x2 *st = &conv->_tail[i];
+		st->_blockSize = 0;
+		FFTConvolver2x2Init(&st->_convolver);
+		st->_output[0] = st->_output[1] = 0;
+		st->_precalculated[0] = st->_precalculated[1] = 0;
+		st->_backgroundProcessingInput[0] = st->_backgroundProcessingInput[1] = 0;
+#ifdef THREAD
+		st->shared_info.task.state = NOTHING;
+#endif
+	}
+	conv->_tailInput[0] = conv->_tailInput[1] = 0;
+	conv->_tailInputSize = 0;
+	conv->_tailInputFill = 0;
+}
+
+void MultiStageFFTConvolverNxMInit(MultiStageFFTConvolverNxM *conv)
+{
+	conv->_inputs = 0;
+	conv->_outputs = 0;
+	conv->_headBlockSize = 0;
+	conv->_tailCount = 0;
+	FFTConvolverNxMInit(&conv->_headConvolver);
+	for (int i = 0; i < MULTISTAGE_MAX_STAGES - 1; i++)
+	{
+		MultiStageTailNxM *st = &conv->_tail[i];
+		st->_blockSize = 0;
+		FFTConvolverNxMInit(&st->_convolver);
+		for (int c = 0; c < FFTCONVOLVER_MAX_CHANNELS; c++)
+			st->_output[c] = st->_precalculated[c] = st->_backgroundProcessingInput[c] = 0;
+#ifdef THREAD
+		st->task.state = NOTHING;
+#endif
+	}
+	for (int c = 0; c < FFTCONVOLVER_MAX_CHANNELS; c++)
+		conv->_tailInput[c] = 0;
+	conv->_tailInputSize = 0;
+	conv->_tailInputFill = 0;
+}
+#ifdef THREAD
+// Tail stages are jobs of the shared convolver worker pool, like the 2-stage tails
+static void stage_init2x4x2(MultiStageTail2x4x2 *st)
+{
+	pt_info2x4x2 *info = &st->shared_info;
+	info->_tailConvolver = &st->_convolver;
+	info->_backgroundProcessingInput[0] = st->_backgroundProcessingInput[0];
+	info->_backgroundProcessingInput[1] = st->_backgroundProcessingInput[1];
+	info->_tailOutput[0] = st->_output[0];
+	info->_tailOutput[1] = st->_output[1];
+	info->_tailBlockSize = st->_blockSize;
+	ConvolverPoolTaskRegister(&info->task, task_type22x4x2, (void *)info);
+}
+static void stage_init2x2(MultiStageTail2x2 *st)
+{
+	pt_info2x2 *info = &st->shared_info;
+	info->_tailConvolver = &st->_convolver;
+	info->_backgroundProcessingInput[0] = st->_backgroundProcessingInput[0];
+	info->_backgroundProcessingInput[1] = st->_backgroundProcessingInput[1];
+	info->_tailOutput[0] = st->_output[0];
+	info->_tailOutput[1] = st->_output[1];
+	info->_tailBlockSize = st->_blockSize;
+	ConvolverPoolTaskRegister(&info->task, task_type22x2, (void *)info);
+}
+// The job reads _output when it runs, the owner swaps it before submitting
+static void stage_runNxM(void *arg)
+{
+	MultiStageTailNxM *st = (MultiStageTailNxM *)arg;
+	FFTConvolverNxMProcess(&st->_convolver, (const float *const *)st->_backgroundProcessingInput, st->_output, st->_blockSize);
+}
+#endif
+void MultiStageFFTConvolver2x4x2Free(MultiStageFFTConvolver2x4x2 *conv)
+{
+	for (unsigned int i = 0; i < conv->_tailCount; i++)
+	{
+		MultiStageTail2x4x2 *st = &conv->_tail[i];
+#ifdef THREAD
+		ConvolverPoolTaskUnregister(&st->shared_info.task);
+#endif
+		if (st->_convolver.bit)
+			FFTConvolver2x4x2Free(&st->_convolver);
+		for (int c = 0; c < 2; c++)
+		{
+			free(st->_output[c]);
+			free(st->_precalculated[c]);
+			free(st->_backgroundProcessingInput[c]);
+			st->_output[c] = st->_precalculated[c] = st->_backgroundProcessingInput[c] = 0;
+		}
+		st->_blockSize = 0;
+	}
+	if (conv->_headConvolver.bit)
+		FFTConvolver2x4x2Free(&conv->_headConvolver);
+	directHeadFree(&conv->_direct);
+	free(conv->_tailInput[0]);
+	free(conv->_tailInput[1]);
+	conv->_tailInput[0] = conv->_tailInput[1] = 0;
+	conv->_headBlockSize = 0;
+	conv->_tailCount = 0;
+	conv->_tailInputSize = 0;
+	conv->_tailInputFill = 0;
+}
+void MultiStageFFTConvolver2x2Free(MultiStageFFTConvolver2x2 *conv)
+{
+	for (unsigned int i = 0; i < conv->_tailCount; i++)
+	{
+		MultiStageTail2x2 *st = &conv->_tail[i];
+#ifdef THREAD
+		ConvolverPoolTaskUnregister(&st->shared_info.task);
+#endif
+		if (st->_convolver.bit)
+			FFTConvolver2x2Free(&st->_convolver);
+		for (int c = 0; c < 2; c++)
+		{
+			free(st->_output[c]);
+			free(st->_precalculated[c]);
+			free(st->_backgroundProcessingInput[c]);
+			st->_output[c] = st->_precalculated[c] = st->_backgroundProcessingInput[c] = 0;
+		}
+		st->_blockSize = 0;
+	}
+	if (conv->_headConvolver.bit)
+		FFTConvolver2x2Free(&conv->_headConvolver);
+	directHeadFree(&conv->_direct);
+	free(conv->_tailInput[0]);
+	free(conv->_tailInput[1]);
+	conv->_tailInput[0] = conv->_tailInput[1] = 0;
+	conv->_headBlockSize = 0;
+	conv->_tailCount = 0;
+	conv->_tailInputSize = 0;
+	conv->_tailInputFill = 0;
+}
+void MultiStageFFTConvolverNxMFree(MultiStageFFTConvolverNxM *conv)
+{
+	for (unsigned int i = 0; i < conv->_tailCount; i++)
+	{
+		MultiStageTailNxM *st = &conv->_tail[i];
+#ifdef THREAD
+		ConvolverPoolTaskUnregister(&st->task);
+#endif
+		if (st->_convolver.bit)
+			FFTConvolverNxMFree(&st->_convolver);
+		for (int c = 0; c < FFTCONVOLVER_MAX_CHANNELS; c++)
+		{
+			free(st->_output[c]);
+			free(st->_precalculated[c]);
+			free(st->_backgroundProcessingInput[c]);
+			st->_output[c] = st->_precalculated[c] = st->_backgroundProcessingInput[c] = 0;
+		}
+		st->_blockSize = 0;
+	}
+	if (conv->_headConvolver.bit)
+		FFTConvolverNxMFree(&conv->_headConvolver);
+	for (int c = 0; c < FFTCONVOLVER_MAX_CHANNELS; c++)
+	{
+		free(conv->_tailInput[c]);
+		conv->_tailInput[c] = 0;
+	}
+	conv->_inputs = 0;
+	conv->_outputs = 0;
+	conv->_headBlockSize = 0;
+	conv->_tailCount = 0;
+	conv->_tailInputSize = 0;
+	conv->_tailInputFill = 0;
+}
+// Rounds the requested block sizes to powers of two and drops stages that would start past the end of the impulse response
+static unsigned int multiStageLayout(const unsigned int *blockSizes, unsigned int stageCount, unsigned int irLen, unsigned int *sizes)
+{
+	if (stageCount == 0 || stageCount > MULTISTAGE_MAX_STAGES)
+		return 0;
+	for (unsigned int i = 0; i < stageCount; i++)
+	{
+		if (blockSizes[i] == 0)
+			return 0;
+		sizes[i] = upper_power_of_two(blockSizes[i]);
+		if (sizes[i] > 524288)
+			sizes[i] = 524288;
+		if (i && sizes[i] <= sizes[i - 1])
+			return 0;
+	}
+	while (stageCount > 1 && 2 * sizes[stageCount - 1] >= irLen)
+		--stageCount;
+	return stageCount;
+}
+static int multiStageLoad2x4x2(MultiStageFFTConvolver2x4x2 *conv, const unsigned int *blockSizes, unsigned int stageCount, int direct, const float* irLL, const float* irLR, const float* irRL, const float* irRR, unsigned int irLen)
+{
+	// Ignore zeros at the end of the impulse response because they only waste computation time
+	while (irLen > 0 && (fabsf(irLL[irLen - 1]) + fabsf(irLR[irLen - 1]) + fabsf(irRL[irLen - 1]) + fabsf(irRR[irLen - 1])) < (FLT_EPSILON * 4.0f))
+		--irLen;
+	if (irLen == 0)
+		return 0;
+	unsigned int sizes[MULTISTAGE_MAX_STAGES];
+	if (direct && stageCount >= MULTISTAGE_MAX_STAGES)
+		return 0;
+	stageCount = multiStageLayout(blockSizes, stageCount, irLen, sizes);
+	if (!stageCount)
+		return 0;
+
+	if (conv->_headConvolver.bit || conv->_direct.taps)
+		MultiStageFFTConvolver2x4x2Free(conv);
+
+	conv->_headBlockSize = sizes[0];
+	// The direct head takes the place of stage 0, the FFT stages all become tails
+	const unsigned int first = direct ? 0 : 1;
+	if (direct && 2 * sizes[0] >= irLen)
+		stageCount = 0;
+	const unsigned int headIrLen = stageCount > first ? min(irLen, 2 * sizes[first]) : irLen;
+	if (direct)
+	{
+		const float *ir[4] = { irLL, irLR, irRL, irRR };
+		if (!directHeadLoad(&conv->_direct, 2, 2, ir, headIrLen, sizes[0]))
+		{
+			MultiStageFFTConvolver2x4x2Free(conv);
+			return 0;
+		}
+	}
+	else if (!FFTConvolver2x4x2LoadImpulseResponse(&conv->_headConvolver, sizes[0], irLL, irLR, irRL, irRR, headIrLen))
+		return 0;
+	for (unsigned int i = first; i < stageCount; i++)
+	{
+		MultiStageTail2x4x2 *st = &conv->_tail[i - first];
+		const unsigned int blockSize = sizes[i];
+		const unsigned int begin = 2 * blockSize;
+		const unsigned int end = i + 1 < stageCount ? min(irLen, 2 * sizes[i + 1]) : irLen;
+		st->_blockSize = blockSize;
+		conv->_tailCount = i - first + 1;
+		if (!FFTConvolver2x4x2LoadImpulseResponse(&st->_convolver, blockSize, irLL + begin, irLR + begin, irRL + begin, irRR + begin, end - begin))
+		{
+			MultiStageFFTConvolver2x4x2Free(conv);
+			return 0;
+		}
+		for (int c = 0; c < 2; c++)
+		{
+			st->_output[c] = (float*)malloc(blockSize * sizeof(float));
+			st->_precalculated[c] = (float*)malloc(blockSize * sizeof(float));
+			st->_backgroundProcessingInput[c] = (float*)malloc(blockSize * sizeof(float));
+			memset(st->_output[c], 0, blockSize * sizeof(float));
+			memset(st->_precalculated[c], 0, blockSize * sizeof(float));
+		}
+#ifdef THREAD
+		stage_init2x4x2(st);
+#endif
+	}
+	if (conv->_tailCount)
+	{
+		conv->_tailInputSize = sizes[stageCount - 1];
+		conv->_tailInput[0] = (float*)malloc(conv->_tailInputSize * sizeof(float));
+		conv->_tailInput[1] = (float*)malloc(conv->_tailInputSize * sizeof(float));
+	}
+	conv->_tailInputFill = 0;
+	return 1;
+}
+int MultiStageFFTConvolver2x4x2LoadImpulseResponse(MultiStageFFTConvolver2x4x2 *conv, const unsigned int *blockSizes, unsigned int stageCount, const float* irLL, const float* irLR, const float* irRL, const float* irRR, unsigned int irLen)
+{
+	return multiStageLoad2x4x2(conv, blockSizes, stageCount, 0, irLL, irLR, irRL, irRR, irLen);
+}
+int MultiStageFFTConvolver2x4x2LoadImpulseResponseHybrid(MultiStageFFTConvolver2x4x2 *conv, const unsigned int *blockSizes, unsigned int stageCount, const float* irLL, const float* irLR, const float* irRL, const float* irRR, unsigned int irLen)
+{
+	return multiStageLoad2x4x2(conv, blockSizes, stageCount, 1, irLL, irLR, irRL, irRR, irLen);
+}
+static int multiStageLoad2x2(MultiStageFFTConvolver2x2 *conv, const unsigned int *blockSizes, unsigned int stageCount, int direct, const float* irL, const float* irR, unsigned int irLen)
+{
+	// Ignore zeros at the end of the impulse response because they only waste computation time
+	while (irLen > 0 && (fabsf(irL[irLen - 1]) + fabsf(irR[irLen - 1])) < (FLT_EPSILON * 2.0f))
+		--irLen;
+	if (irLen == 0)
+		return 0;
+	unsigned int sizes[MULTISTAGE_MAX_STAGES];
+	if (direct && stageCount >= MULTISTAGE_MAX_STAGES)
+		return 0;
+	stageCount = multiStageLayout(blockSizes, stageCount, irLen, sizes);
+	if (!stageCount)
+		return 0;
+
+	if (conv->_headConvolver.bit || conv->_direct.taps)
+		MultiStageFFTConvolver2x2Free(conv);
+
+	conv->_headBlockSize = sizes[0];
+	// The direct head takes the place of stage 0, the FFT stages all become tails
+	const unsigned int first = direct ? 0 : 1;
+	if (direct && 2 * sizes[0] >= irLen)
+		stageCount = 0;
+	const unsigned int headIrLen = stageCount > first ? min(irLen, 2 * sizes[first]) : irLen;
+	if (direct)
+	{
+		const float *ir[4] = { irL, 0, 0, irR };
+		if (!directHeadLoad(&conv->_direct, 2, 2, ir, headIrLen, sizes[0]))
+		{
+			MultiStageFFTConvolver2x2Free(conv);
+			return 0;
+		}
+	}
+	else if (!FFTConvolver2x2LoadImpulseResponse(&conv->_headConvolver, sizes[0], irL, irR, headIrLen))
+		return 0;
+	for (unsigned int i = first; i < stageCount; i++)
+	{
+		MultiStageTail2x2 *st = &conv->_tail[i - first];
+		const unsigned int blockSize = sizes[i];
+		const unsigned int begin = 2 * blockSize;
+		const unsigned int end = i + 1 < stageCount ? min(irLen, 2 * sizes[i + 1]) : irLen;
+		st->_blockSize = blockSize;
+		conv->_tailCount = i - first + 1;
+		if (!FFTConvolver2x2LoadImpulseResponse(&st->_convolver, blockSize, irL + begin, irR + begin, end - begin))
+		{
+			MultiStageFFTConvolver2x2Free(conv);
+			return 0;
+		}
+		for (int c = 0; c < 2; c++)
+		{
+			st->_output[c] = (float*)malloc(blockSize * sizeof(float));
+			st->_precalculated[c] = (float*)malloc(blockSize * sizeof(float));
+			st->_backgroundProcessingInput[c] = (float*)malloc(blockSize * sizeof(float));
+			memset(st->_output[c], 0, blockSize * sizeof(float));
+			memset(st->_precalculated[c], 0, blockSize * sizeof(float));
+		}
+#ifdef THREAD
+		stage_init2x2(st);
+#endif
+	}
+	if (conv->_tailCount)
+	{
+		conv->_tailInputSize = sizes[stageCount - 1];
+		conv->_tailInput[0] = (float*)malloc(conv->_tailInputSize * sizeof(float));
+		conv->_tailInput[1] = (float*)malloc(conv->_tailInputSize * sizeof(float));
+	}
+	conv->_tailInputFill = 0;
+	return 1;
+}
+int MultiStageFFTConvolver2x2LoadImpulseResponse(MultiStageFFTConvolver2x2 *conv, const unsigned int *blockSizes, unsigned int stageCount, const float* irL, const float* irR, unsigned int irLen)
+{
+	return multiStageLoad2x2(conv, blockSizes, stageCount, 0, irL, irR, irLen);
+}
+int MultiStageFFTConvolver2x2LoadImpulseResponseHybrid(MultiStageFFTConvolver2x2 *conv, const unsigned int *blockSizes, unsigned int stageCount, const float* irL, const float* irR, unsigned int irLen)
+{
+	return multiStageLoad2x2(conv, blockSizes, stageCount, 1, irL, irR, irLen);
+}
+int MultiStageFFTConvolverNxMLoadImpulseResponse(MultiStageFFTConvolverNxM *conv, const unsigned int *blockSizes, unsigned int stageCount, unsigned int inputs, unsigned int outputs, const float *const *ir, unsigned int irLen)
+{
+	if (!inputs || inputs > FFTCONVOLVER_MAX_CHANNELS || !outputs || outputs > FFTCONVOLVER_MAX_CHANNELS)
+		return 0;
+	const unsigned int paths = inputs * outputs;
+	unsigned int c;
+	// Ignore zeros at the end of the impulse response because they only waste computation time
+	while (irLen > 0)
+	{
+		float sum = 0.0f;
+		for (c = 0; c < paths; c++)
+			sum += fabsf(ir[c][irLen - 1]);
+		if (sum >= FLT_EPSILON * (float)paths)
+			break;
+		--irLen;
+	}
+	if (irLen == 0)
+		return 0;
+	unsigned int sizes[MULTISTAGE_MAX_STAGES];
+	stageCount = multiStageLayout(blockSizes, stageCount, irLen, sizes);
+	if (!stageCount)
+		return 0;
+
+	if (conv->_headConvolver.bit)
+		MultiStageFFTConvolverNxMFree(conv);
+
+	conv->_inputs = inputs;
+	conv->_outputs = outputs;
+	conv->_headBlockSize = sizes[0];
+	const unsigned int headIrLen = stageCount > 1 ? min(irLen, 2 * sizes[1]) : irLen;
+	if (!FFTConvolverNxMLoadImpulseResponse(&conv->_headConvolver, sizes[0], inputs, outputs, ir, headIrLen))
+		return 0;
+	for (unsigned int i = 1; i < stageCount; i++)
+	{
+		MultiStageTailNxM *st = &conv->_tail[i - 1];
+		const unsigned int blockSize = sizes[i];
+		const unsigned int begin = 2 * blockSize;
+		const unsigned int end = i + 1 < stageCount ? min(irLen, 2 * sizes[i + 1]) : irLen;
+		const float *stageIr[FFTCONVOLVER_MAX_CHANNELS * FFTCONVOLVER_MAX_CHANNELS];
+		for (c = 0; c < paths; c++)
+			stageIr[c] = ir[c] + begin;
+		st->_blockSize = blockSize;
+		conv->_tailCount = i;
+		if (!FFTConvolverNxMLoadImpulseResponse(&st->_convolver, blockSize, inputs, outputs, stageIr, end - begin))
+		{
+			MultiStageFFTConvolverNxMFree(conv);
+			return 0;
+		}
+		for (c = 0; c < outputs; c++)
+		{
+			st->_output[c] = (float*)malloc(blockSize * sizeof(float));
+			st->_precalculated[c] = (float*)malloc(blockSize * sizeof(float));
+			memset(st->_output[c], 0, blockSize * sizeof(float));
+			memset(st->_precalculated[c], 0, blockSize * sizeof(float));
+		}
+		for (c = 0; c < inputs; c++)
+			st->_backgroundProcessingInput[c] = (float*)malloc(blockSize * sizeof(float));
+#ifdef THREAD
+		ConvolverPoolTaskRegister(&st->task, stage_runNxM, (void *)st);
+#endif
+	}
+	if (conv->_tailCount)
+	{
+		conv->_tailInputSize = sizes[stageCount - 1];
+		for (c = 0; c < inputs; c++)
+			conv->_tailInput[c] = (float*)malloc(conv->_tailInputSize * sizeof(float));
+	}
+	conv->_tailInputFill = 0;
+	return 1;
+}
+void MultiStageFFTConvolver2x4x2Process(MultiStageFFTConvolver2x4x2 *conv, const float* x1, const float* x2, float* y1, float* y2, unsigned int len)
+{
+	if (!conv->_tailCount && !conv->_direct.taps)
+	{
+		FFTConvolver2x4x2Process(&conv->_headConvolver, x1, x2, y1, y2, len);
+		return;
+	}
+	unsigned int i, j, processed = 0;
+	while (processed < len)
+	{
+		const unsigned int processing = min(len - processed, conv->_headBlockSize - (conv->_tailInputFill & (conv->_headBlockSize - 1)));
+		const unsigned int fill = conv->_tailInputFill;
+		// Every stage block is a power of two dividing the largest one, so a single history serves them all
+		if (conv->_tailCount)
+		{
+			memcpy(conv->_tailInput[0] + fill, x1 + processed, processing * sizeof(float));
+			memcpy(conv->_tailInput[1] + fill, x2 + processed, processing * sizeof(float));
+		}
+		if (conv->_direct.taps)
+		{
+			const float *x[2] = { x1 + processed, x2 + processed };
+			float *y[2] = { y1 + processed, y2 + processed };
+			directHeadProcess(&conv->_direct, x, y, processing);
+		}
+		else
+			FFTConvolver2x4x2Process(&conv->_headConvolver, x1 + processed, x2 + processed, y1 + processed, y2 + processed, processing);
+		float *out1 = y1 + processed;
+		float *out2 = y2 + processed;
+		for (i = 0; i < conv->_tailCount; i++)
+		{
+			MultiStageTail2x4x2 *st = &conv->_tail[i];
+			const float *p1 = st->_precalculated[0] + (fill & (st->_blockSize - 1));
+			const float *p2 = st->_precalculated[1] + (fill & (st->_blockSize - 1));
+			for (j = 0; j < processing; j++)
+			{
+				out1[j] += p1[j];
+				out2[j] += p2[j];
+			}
+		}
+		conv->_tailInputFill += processing;
+		for (i = 0; i < conv->_tailCount; i++)
+		{
+			MultiStageTail2x4x2 *st = &conv->_tail[i];
+			if (conv->_tailInputFill & (st->_blockSize - 1))
+				continue;
+#ifdef THREAD
+			ConvolverPoolTaskWait(&st->shared_info.task);
+#endif
+			float *tmp = st->_output[0];
+			st->_output[0] = st->_precalculated[0];
+			st->_precalculated[0] = tmp;
+			tmp = st->_output[1];
+			st->_output[1] = st->_precalculated[1];
+			st->_precalculated[1] = tmp;
+			const unsigned int blockOffset = conv->_tailInputFill - st->_blockSize;
+			memcpy(st->_backgroundProcessingInput[0], conv->_tailInput[0] + blockOffset, st->_blockSize * sizeof(float));
+			memcpy(st->_backgroundProcessingInput[1], conv->_tailInput[1] + blockOffset, st->_blockSize * sizeof(float));
+#ifdef THREAD
+			st->shared_info._tailOutput[0] = st->_output[0];
+			st->shared_info._tailOutput[1] = st->_output[1];
+			ConvolverPoolTaskSubmit(&st->shared_info.task);
+#else
+			FFTConvolver2x4x2Process(&st->_convolver, st->_backgroundProcessingInput[0], st->_backgroundProcessingInput[1], st->_output[0], st->_output[1], st->_blockSize);
+#endif
+		}
+		// Without tails the direct head only needs the chunks to stay within one head block
+		if (conv->_tailInputFill >= conv->_tailInputSize)
+			conv->_tailInputFill = 0;
+		processed += processing;
+	}
+}
+void MultiStageFFTConvolver2x2Process(MultiStageFFTConvolver2x2 *conv, const float* x1, const float* x2, float* y1, float* y2, unsigned int len)
+{
+	if (!conv->_tailCount && !conv->_direct.taps)
+	{
+		FFTConvolver2x2Process(&conv->_headConvolver, x1, x2, y1, y2, len);
+		return;
+	}
+	unsigned int i, j, processed = 0;
+	while (processed < len)
+	{
+		const unsigned int processing = min(len - processed, conv->_headBlockSize - (conv->_tailInputFill & (conv->_headBlockSize - 1)));
+		const unsigned int fill = conv->_tailInputFill;
+		// Every stage block is a power of two dividing the largest one, so a single history serves them all
+		if (conv->_tailCount)
+		{
+			memcpy(conv->_tailInput[0] + fill, x1 + processed, processing * sizeof(float));
+			memcpy(conv->_tailInput[1] + fill, x2 + processed, processing * sizeof(float));
+		}
+		if (conv->_direct.taps)
+		{
+			const float *x[2] = { x1 + processed, x2 + processed };
+			float *y[2] = { y1 + processed, y2 + processed };
+			directHeadProcess(&conv->_direct, x, y, processing);
+		}
+		else
+			FFTConvolver2x2Process(&conv->_headConvolver, x1 + processed, x2 + processed, y1 + processed, y2 + processed, processing);
+		float *out1 = y1 + processed;
+		float *out2 = y2 + processed;
+		for (i = 0; i < conv->_tailCount; i++)
+		{
+			MultiStageTail2x2 *st = &conv->_tail[i];
+			const float *p1 = st->_precalculated[0] + (fill & (st->_blockSize - 1));
+			const float *p2 = st->_precalculated[1] + (fill & (st->_blockSize - 1));
+			for (j = 0; j < processing; j++)
+			{
+				out1[j] += p1[j];
+				out2[j] += p2[j];
+			}
+		}
+		conv->_tailInputFill += processing;
+		for (i = 0; i < conv->_tailCount; i++)
+		{
+			MultiStageTail2x2 *st = &conv->_tail[i];
+			if (conv->_tailInputFill & (st->_blockSize - 1))
+				continue;
+#ifdef THREAD
+			ConvolverPoolTaskWait(&st->shared_info.task);
+#endif
+			float *tmp = st->_output[0];
+			st->_output[0] = st->_precalculated[0];
+			st->_precalculated[0] = tmp;
+			tmp = st->_output[1];
+			st->_output[1] = st->_precalculated[1];
+			st->_precalculated[1] = tmp;
+			const unsigned int blockOffset = conv->_tailInputFill - st->_blockSize;
+			memcpy(st->_backgroundProcessingInput[0], conv->_tailInput[0] + blockOffset, st->_blockSize * sizeof(float));
+			memcpy(st->_backgroundProcessingInput[1], conv->_tailInput[1] + blockOffset, st->_blockSize * sizeof(float));
+#ifdef THREAD
+			st->shared_info._tailOutput[0] = st->_output[0];
+			st->shared_info._tailOutput[1] = st->_output[1];
+			ConvolverPoolTaskSubmit(&st->shared_info.task);
+#else
+			FFTConvolver2x2Process(&st->_convolver, st->_backgroundProcessingInput[0], st->_backgroundProcessingInput[1], st->_output[0], st->_output[1], st->_blockSize);
+#endif
+		}
+		// Without tails the direct head only needs the chunks to stay within one head block
+		if (conv->_tailInputFill >= conv->_tailInputSize)
+			conv->_tailInputFill = 0;
+		processed += processing;
+	}
+}
+void MultiStageFFTConvolverNxMProcess(MultiStageFFTConvolverNxM *conv, const float *const *x, float *const *y, unsigned int len)
+{
+	if (!conv->_tailCount)
+	{
+		FFTConvolverNxMProcess(&conv->_headConvolver, x, y, len);
+		return;
+	}
+	unsigned int i, j, c, processed = 0;
+	const float *xs[FFTCONVOLVER_MAX_CHANNELS];
+	float *ys[FFTCONVOLVER_MAX_CHANNELS];
+	while (processed < len)
+	{
+		const unsigned int processing = min(len - processed, conv->_headBlockSize - (conv->_tailInputFill & (conv->_headBlockSize - 1)));
+		const unsigned int fill = conv->_tailInputFill;
+		// Every stage block is a power of two dividing the largest one, so a single history serves them all
+		for (c = 0; c < conv->_inputs; c++)
+		{
+			memcpy(conv->_tailInput[c] + fill, x[c] + processed, processing * sizeof(float));
+			xs[c] = x[c] + processed;
+		}
+		for (c = 0; c < conv->_outputs; c++)
+			ys[c] = y[c] + processed;
+		FFTConvolverNxMProcess(&conv->_headConvolver, xs, ys, processing);
+		for (i = 0; i < conv->_tailCount; i++)
+		{
+			MultiStageTailNxM *st = &conv->_tail[i];
+			for (c = 0; c < conv->_outputs; c++)
+			{
+				const float *p = st->_precalculated[c] + (fill & (st->_blockSize - 1));
+				for (j = 0; j < processing; j++)
+					ys[c][j] += p[j];
+			}
+		}
+		conv->_tailInputFill += processing;
+		for (i = 0; i < conv->_tailCount; i++)
+		{
+			MultiStageTailNxM *st = &conv->_tail[i];
+			if (conv->_tailInputFill & (st->_blockSize - 1))
+				continue;
+#ifdef THREAD
+			ConvolverPoolTaskWait(&st->task);
+#endif
+			for (c = 0; c < conv->_outputs; c++)
+			{
+				float *tmp = st->_output[c];
+				st->_output[c] = st->_precalculated[c];
+				st->_precalculated[c] = tmp;
+			}
+			const unsigned int blockOffset = conv->_tailInputFill - st->_blockSize;
+			for (c = 0; c < conv->_inputs; c++)
+				memcpy(st->_backgroundProcessingInput[c], conv->_tailInput[c] + blockOffset, st->_blockSize * sizeof(float));
+#ifdef THREAD
+			ConvolverPoolTaskSubmit(&st->task);
+#else
+			FFTConvolverNxMProcess(&st->_convolver, (const float *const *)st->_backgroundProcessingInput, st->_output, st->_blockSize);
+#endif
+		}
+		if (conv->_tailInputFill == conv->_tailInputSize)
+			conv->_tailInputFill = 0;
+		processed += processing;
+	}
+}
+size_t MultiStageFFTConvolver2x4x2MemoryUsage(MultiStageFFTConvolver2x4x2 *conv)
+{
+	size_t bytes = FFTConvolver2x4x2MemoryUsage(&conv->_headConvolver) + 2 * conv->_tailInputSize * sizeof(float);
+	if (conv->_direct.taps)
+		bytes += (conv->_direct.inputs * (conv->_direct.taps - 1 + conv->_headBlockSize) + (4) * conv->_direct.taps) * sizeof(float);
+	for (unsigned int i = 0; i < conv->_tailCount; i++)
+		bytes += FFTConvolver2x4x2MemoryUsage(&conv->_tail[i]._convolver) + 6 * conv->_tail[i]._blockSize * sizeof(float);
+	return bytes;
+}
+size_t MultiStageFFTConvolver2x2MemoryUsage(MultiStageFFTConvolver2x2 *conv)
+{
+	size_t bytes = FFTConvolver2x2MemoryUsage(&conv->_headConvolver) + 2 * conv->_tailInputSize * sizeof(float);
+	if (conv->_direct.taps)
+		bytes += (conv->_direct.inputs * (conv->_direct.taps - 1 + conv->_headBlockSize) + (2) * conv->_direct.taps) * sizeof(float);
+	for (unsigned int i = 0; i < conv->_tailCount; i++)
+		bytes += FFTConvolver2x2MemoryUsage(&conv->_tail[i]._convolver) + 6 * conv->_tail[i]._blockSize * sizeof(float);
+	return bytes;
+}
+size_t MultiStageFFTConvolverNxMMemoryUsage(MultiStageFFTConvolverNxM *conv)
+{
+	size_t bytes = FFTConvolverNxMMemoryUsage(&conv->_headConvolver) + conv->_inputs * conv->_tailInputSize * sizeof(float);
+	for (unsigned int i = 0; i < conv->_tailCount; i++)
+		bytes += FFTConvolverNxMMemoryUsage(&conv->_tail[i]._convolver) + (conv->_inputs + 2 * conv->_outputs) * conv->_tail[i]._blockSize * sizeof(float);
+	return bytes;
+}
+void MultiStageFFTConvolver2x4x2SkipPartitions(MultiStageFFTConvolver2x4x2 *conv, float thresholdDb, FFTConvolverSkipStats *stats)
+{
+	unsigned int i;
+	// The direct head is never skipped, it counts as one partition of taps samples
+	const double directEnergy = conv->_direct.taps ? directHeadEnergy(&conv->_direct) : 0.0;
+	double peak = conv->_direct.taps ? directEnergy / conv->_direct.taps : FFTConvolver2x4x2PartitionPowerMax(&conv->_headConvolver);
+	for (i = 0; i < conv->_tailCount; i++)
+	{
+		const double power = FFTConvolver2x4x2PartitionPowerMax(&conv->_tail[i]._convolver);
+		if (power > peak)
+			peak = power;
+	}
+	const double floor = peak * pow(10.0, thresholdDb * 0.1);
+	FFTConvolver2x4x2SkipPartitions(&conv->_headConvolver, floor, stats);
+	for (i = 0; i < conv->_tailCount; i++)
+		FFTConvolver2x4x2SkipPartitions(&conv->_tail[i]._convolver, floor, stats);
+	if (stats && conv->_direct.taps)
+	{
+		stats->energy += directEnergy;
+		stats->partitions++;
+	}
+}
+void MultiStageFFTConvolver2x2SkipPartitions(MultiStageFFTConvolver2x2 *conv, float thresholdDb, FFTConvolverSkipStats *stats)
+{
+	unsigned int i;
+	// The direct head is never skipped, it counts as one partition of taps samples
+	const double directEnergy = conv->_direct.taps ? directHeadEnergy(&conv->_direct) : 0.0;
+	double peak = conv->_direct.taps ? directEnergy / conv->_direct.taps : FFTConvolver2x2PartitionPowerMax(&conv->_headConvolver);
+	for (i = 0; i < conv->_tailCount; i++)
+	{
+		const double power = FFTConvolver2x2PartitionPowerMax(&conv->_tail[i]._convolver);
+		if (power > peak)
+			peak = power;
+	}
+	const double floor = peak * pow(10.0, thresholdDb * 0.1);
+	FFTConvolver2x2SkipPartitions(&conv->_headConvolver, floor, stats);
+	for (i = 0; i < conv->_tailCount; i++)
+		FFTConvolver2x2SkipPartitions(&conv->_tail[i]._convolver, floor, stats);
+	if (stats && conv->_direct.taps)
+	{
+		stats->energy += directEnergy;
+		stats->partitions++;
+	}
+}
+void MultiStageFFTConvolverNxMSkipPartitions(MultiStageFFTConvolverNxM *conv, float thresholdDb, FFTConvolverSkipStats *stats)
+{
+	unsigned int i;
+	double peak = FFTConvolverNxMPartitionPowerMax(&conv->_headConvolver);
+	for (i = 0; i < conv->_tailCount; i++)
+	{
+		const double power = FFTConvolverNxMPartitionPowerMax(&conv->_tail[i]._convolver);
+		if (power > peak)
+			peak = power;
+	}
+	const double floor = peak * pow(10.0, thresholdDb * 0.1);
+	FFTConvolverNxMSkipPartitions(&conv->_headConvolver, floor, stats);
+	for (i = 0; i < conv->_tailCount; i++)
+		FFTConvolverNxMSkipPartitions(&conv->_tail[i]._convolver, floor, stats);
+}
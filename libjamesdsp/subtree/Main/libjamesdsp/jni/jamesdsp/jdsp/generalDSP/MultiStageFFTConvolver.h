@@ -0,0 +1,151 @@
+#ifndef _FFTCONVOLVER_MULTISTAGEFFTCONVOLVER_H
+#define _FFTCONVOLVER_MULTISTAGEFFTCONVOLVER_H
+
+#include "TwoStageFFTConvolver.h"
+#define MULTISTAGE_MAX_STAGES (8)
+// Time domain head of the hybrid convolvers, ir[i * outputs + o] holds the path from input i to output o reversed, NULL when it is silent
+typedef struct
+{
+	unsigned int taps;
+	unsigned int inputs;
+	unsigned int outputs;
+	float *ir[4];
+	float *history[2]; // taps - 1 past samples followed by the current chunk
+	const SpectralMACKernels *mac;
+} MultiStageDirectHead;
+typedef struct
+{
+	unsigned int _blockSize;
+	FFTConvolver2x4x2 _convolver;
+	float *_output[2];
+	float *_precalculated[2];
+	float *_backgroundProcessingInput[2];
+#ifdef THREAD
+	pt_info2x4x2 shared_info;
+#endif
+} MultiStageTail2x4x2;
+typedef struct
+{
+	unsigned int _blockSize;
+	FFTConvolver2x2 _convolver;
+	float *_output[2];
+	float *_precalculated[2];
+	float *_backgroundProcessingInput[2];
+#ifdef THREAD
+	pt_info2x2 shared_info;
+#endif
+} MultiStageTail2x2;
+typedef struct
+{
+	unsigned int _blockSize;
+	FFTConvolverNxM _convolver;
+	float *_output[FFTCONVOLVER_MAX_CHANNELS];
+	float *_precalculated[FFTCONVOLVER_MAX_CHANNELS];
+	float *_backgroundProcessingInput[FFTCONVOLVER_MAX_CHANNELS];
+#ifdef THREAD
+	ConvolverPoolTask task;
+#endif
+} MultiStageTailNxM;
+typedef struct
+{
+	unsigned int _headBlockSize;
+	unsigned int _tailCount;
+	FFTConvolver2x4x2 _headConvolver;
+	MultiStageDirectHead _direct; // Replaces the head convolver when taps is nonzero
+	MultiStageTail2x4x2 _tail[MULTISTAGE_MAX_STAGES - 1];
+	float *_tailInput[2];
+	unsigned int _tailInputSize;
+	unsigned int _tailInputFill;
+} MultiStageFFTConvolver2x4x2;
+typedef struct
+{
+	unsigned int _headBlockSize;
+	unsigned int _tailCount;
+	FFTConvolver2x2 _headConvolver;
+	MultiStageDirectHead _direct; // Replaces the head convolver when taps is nonzero
+	MultiStageTail2x2 _tail[MULTISTAGE_MAX_STAGES - 1];
+	float *_tailInput[2];
+	unsigned int _tailInputSize;
+	unsigned int _tailInputFill;
+} MultiStageFFTConvolver2x2;
+typedef struct
+{
+	unsigned int _inputs;
+	unsigned int _outputs;
+	unsigned int _headBlockSize;
+	unsigned int _tailCount;
+	FFTConvolverNxM _headConvolver;
+	MultiStageTailNxM _tail[MULTISTAGE_MAX_STAGES - 1];
+	float *_tailInput[FFTCONVOLVER_MAX_CHANNELS];
+	unsigned int _tailInputSize;
+	unsigned int _tailInputFill;
+} MultiStageFFTConvolverNxM;
+/**
+* @class MultiStageFFTConvolver2x2
+* @brief FFT convolver using N block sizes that grow along the impulse response
+*
+* Generalizes the 2-stage convolver: stage 0 (the head) runs at the host block
+* size and covers [0, 2 * B1), stage i runs at block size Bi and covers
+* [2 * Bi, 2 * Bi+1), the last stage covers the rest of the impulse response.
+*
+* Every tail stage is double buffered, its block of input is convolved while the
+* previous result is played, which is exactly the 2 * Bi the stage starts at.
+* Tail stages run on their own worker thread when THREAD is defined.
+*
+* The hybrid layout replaces the head by a time domain FIR over [0, 2 * B0) that
+* runs sample by sample, then stage i covers [2 * Bi, 2 * Bi+1) as usual. It has no
+* latency at any host block size, every call costs the same per sample except for
+* the tail stages handed to the worker pool.
+*
+* The NxM variant convolves up to 8 inputs with a matrix of up to 8 x 8 impulse
+* responses, see FFTConvolverNxM, with one block size it is the uniform partitioned
+* convolver and with two the 2-stage one.
+*/
+extern void MultiStageFFTConvolver2x4x2Init(MultiStageFFTConvolver2x4x2 *conv);
+extern void MultiStageFFTConvolver2x2Init(MultiStageFFTConvolver2x2 *conv);
+extern void MultiStageFFTConvolverNxMInit(MultiStageFFTConvolverNxM *conv);
+
+/**
+* @brief Initialization the convolver
+* @param blockSizes Strictly increasing powers of two, blockSizes[0] is the head block size
+* @param stageCount Number of entries in blockSizes, at most MULTISTAGE_MAX_STAGES
+* @param irLen Length of the impulse response in samples
+* @return 1: Success - 0: Failed
+*/
+extern int MultiStageFFTConvolver2x4x2LoadImpulseResponse(MultiStageFFTConvolver2x4x2 *conv, const unsigned int *blockSizes, unsigned int stageCount, const float* irLL, const float* irLR, const float* irRL, const float* irRR, unsigned int irLen);
+extern int MultiStageFFTConvolver2x2LoadImpulseResponse(MultiStageFFTConvolver2x2 *conv, const unsigned int *blockSizes, unsigned int stageCount, const float* irL, const float* irR, unsigned int irLen);
+// Hybrid layout, blockSizes only holds the FFT stages, at most MULTISTAGE_MAX_STAGES - 1
+extern int MultiStageFFTConvolver2x4x2LoadImpulseResponseHybrid(MultiStageFFTConvolver2x4x2 *conv, const unsigned int *blockSizes, unsigned int stageCount, const float* irLL, const float* irLR, const float* irRL, const float* irRR, unsigned int irLen);
+extern int MultiStageFFTConvolver2x2LoadImpulseResponseHybrid(MultiStageFFTConvolver2x2 *conv, const unsigned int *blockSizes, unsigned int stageCount, const float* irL, const float* irR, unsigned int irLen);
+// ir[i * outputs + o] runs from input i to output o
+extern int MultiStageFFTConvolverNxMLoadImpulseResponse(MultiStageFFTConvolverNxM *conv, const unsigned int *blockSizes, unsigned int stageCount, unsigned int inputs, unsigned int outputs, const float *const *ir, unsigned int irLen);
+
+/**
+* @brief Convolves the the given input samples and immediately outputs the result
+*/
+extern void MultiStageFFTConvolver2x4x2Process(MultiStageFFTConvolver2x4x2 *conv, const float* x1, const float* x2, float* y1, float* y2, unsigned int len);
+extern void MultiStageFFTConvolver2x2Process(MultiStageFFTConvolver2x2 *conv, const float* x1, const float* x2, float* y1, float* y2, unsigned int len);
+extern void MultiStageFFTConvolverNxMProcess(MultiStageFFTConvolverNxM *conv, const float *const *x, float *const *y, unsigned int len);
+
+/**
+* @brief Resets the convolver and discards the set impulse response
+*/
+extern void MultiStageFFTConvolver2x4x2Free(MultiStageFFTConvolver2x4x2 *conv);
+extern void MultiStageFFTConvolver2x2Free(MultiStageFFTConvolver2x2 *conv);
+extern void MultiStageFFTConvolverNxMFree(MultiStageFFTConvolverNxM *conv);
+
+/**
+* @brief Heap owned by the stage convolvers and buffers, in bytes
+*/
+extern size_t MultiStageFFTConvolver2x4x2MemoryUsage(MultiStageFFTConvolver2x4x2 *conv);
+extern size_t MultiStageFFTConvolver2x2MemoryUsage(MultiStageFFTConvolver2x2 *conv);
+extern size_t MultiStageFFTConvolverNxMMemoryUsage(MultiStageFFTConvolverNxM *conv);
+
+/**
+* @brief Stops multiplying partitions at least thresholdDb below the loudest one of any stage, in mean power
+* Not while processing, see FFTConvolver2x2SkipPartitions
+*/
+extern void MultiStageFFTConvolver2x4x2SkipPartitions(MultiStageFFTConvolver2x4x2 *conv, float thresholdDb, FFTConvolverSkipStats *stats);
+extern void MultiStageFFTConvolver2x2SkipPartitions(MultiStageFFTConvolver2x2 *conv, float thresholdDb, FFTConvolverSkipStats *stats);
+extern void MultiStageFFTConvolverNxMSkipPartitions(MultiStageFFTConvolverNxM *conv, float thresholdDb, FFTConvolverSkipStats *stats);
+#endif
@@ -21,7 +21,7 @@ void TwoStageFFTConvolver1x1Init(TwoStageFFTConvolver1x1 *conv)
 	conv->_tailPrecalculated = 0;
 	conv->_backgroundProcessingInput = 0;
 #ifdef THREAD
-	conv->shared_info.state = NOTHING;
+	conv->shared_info.task.state = NOTHING;
 #endif
 }
 void TwoStageFFTConvolver2x4x2Init(TwoStageFFTConvolver2x4x2 *conv)
@@ -40,7 +40,7 @@ void TwoStageFFTConvolver2x4x2Init(TwoStageFFTConvolver2x4x2 *conv)
 	conv->_tailPrecalculated[0] = 0;
 	conv->_backgroundProcessingInput[0] = 0;
 #ifdef THREAD
-	conv->shared_info.state = NOTHING;
+	conv->shared_info.task.state = NOTHING;
 #endif
 }
 void TwoStageFFTConvolver2x2Init(TwoStageFFTConvolver2x2 *conv)
@@ -59,7 +59,7 @@ void TwoStageFFTConvolver2x2Init(TwoStageFFTConvolver2x2 *conv)
 	conv->_tailPrecalculated[0] = 0;
 	conv->_backgroundProcessingInput[0] = 0;
 #ifdef THREAD
-	conv->shared_info.state = NOTHING;
+	conv->shared_info.task.state = NOTHING;
 #endif
 }
 void TwoStageFFTConvolver1x2Init(TwoStageFFTConvolver1x2 *conv)
@@ -78,402 +78,131 @@ void TwoStageFFTConvolver1x2Init(TwoStageFFTConvolver1x2 *conv)
 	conv->_tailPrecalculated[0] = 0;
 	conv->_backgroundProcessingInput = 0;
 #ifdef THREAD
-	conv->shared_info.state = NOTHING;
+	conv->shared_info.task.state = NOTHING;
 #endif
 }
 
 #ifdef THREAD
 inline void task_wait1x1(TwoStageFFTConvolver1x1 *conv)
 {
-	pt_info *info = &conv->shared_info;
-	while (1)
-	{
-		pthread_cond_wait(&(info->boss_cond), &(info->boss_mtx));
-		if (IDLE == info->state)
-			break;
-	}
+	ConvolverPoolTaskWait(&conv->shared_info.task);
 }
 inline void task_wait2x4x2(TwoStageFFTConvolver2x4x2 *conv)
 {
-	pt_info2x4x2 *info = &conv->shared_info;
-	while (1)
-	{
-		pthread_cond_wait(&(info->boss_cond), &(info->boss_mtx));
-		if (IDLE == info->state)
-			break;
-	}
+	ConvolverPoolTaskWait(&conv->shared_info.task);
 }
 inline void task_wait2x2(TwoStageFFTConvolver2x2 *conv)
 {
-	pt_info2x2 *info = &conv->shared_info;
-	while (1)
-	{
-		pthread_cond_wait(&(info->boss_cond), &(info->boss_mtx));
-		if (IDLE == info->state)
-			break;
-	}
+	ConvolverPoolTaskWait(&conv->shared_info.task);
 }
 inline void task_wait1x2(TwoStageFFTConvolver1x2 *conv)
 {
-	pt_info1x2 *info = &conv->shared_info;
-	while (1)
-	{
-		pthread_cond_wait(&(info->boss_cond), &(info->boss_mtx));
-		if (IDLE == info->state)
-			break;
-	}
+	ConvolverPoolTaskWait(&conv->shared_info.task);
 }
 void thread_exit1x1(TwoStageFFTConvolver1x1 *conv)
 {
-	pt_info *info = NULL;
-	//		GFT->sa_log_d(TAG, "Thread %d get off from work", i + 1);
-	info = &conv->shared_info;
-	// ensure the worker is waiting
-	pthread_mutex_lock(&(info->work_mtx));
-	info->state = GET_OFF_FROM_WORK;
-	// wake-up signal
-	pthread_cond_signal(&(info->work_cond));
-	pthread_mutex_unlock(&(info->work_mtx));
-	// wait for thread to exit
-	pthread_join(conv->threads, NULL);
-	pthread_mutex_destroy(&(info->work_mtx));
-	pthread_cond_destroy(&(info->work_cond));
-	pthread_mutex_unlock(&(info->boss_mtx));
-	pthread_mutex_destroy(&(info->boss_mtx));
-	pthread_cond_destroy(&(info->boss_cond));
+	ConvolverPoolTaskUnregister(&conv->shared_info.task);
 }
 void thread_exit2x4x2(TwoStageFFTConvolver2x4x2 *conv)
 {
-	pt_info2x4x2 *info = NULL;
-	//		GFT->sa_log_d(TAG, "Thread %d get off from work", i + 1);
-	info = &conv->shared_info;
-	// ensure the worker is waiting
-	pthread_mutex_lock(&(info->work_mtx));
-	info->state = GET_OFF_FROM_WORK;
-	// wake-up signal
-	pthread_cond_signal(&(info->work_cond));
-	pthread_mutex_unlock(&(info->work_mtx));
-	// wait for thread to exit
-	pthread_join(conv->threads, NULL);
-	pthread_mutex_destroy(&(info->work_mtx));
-	pthread_cond_destroy(&(info->work_cond));
-	pthread_mutex_unlock(&(info->boss_mtx));
-	pthread_mutex_destroy(&(info->boss_mtx));
-	pthread_cond_destroy(&(info->boss_cond));
+	ConvolverPoolTaskUnregister(&conv->shared_info.task);
 }
 void thread_exit2x2(TwoStageFFTConvolver2x2 *conv)
 {
-	pt_info2x2 *info = NULL;
-	//		GFT->sa_log_d(TAG, "Thread %d get off from work", i + 1);
-	info = &conv->shared_info;
-	// ensure the worker is waiting
-	pthread_mutex_lock(&(info->work_mtx));
-	info->state = GET_OFF_FROM_WORK;
-	// wake-up signal
-	pthread_cond_signal(&(info->work_cond));
-	pthread_mutex_unlock(&(info->work_mtx));
-	// wait for thread to exit
-	pthread_join(conv->threads, NULL);
-	pthread_mutex_destroy(&(info->work_mtx));
-	pthread_cond_destroy(&(info->work_cond));
-	pthread_mutex_unlock(&(info->boss_mtx));
-	pthread_mutex_destroy(&(info->boss_mtx));
-	pthread_cond_destroy(&(info->boss_cond));
+	ConvolverPoolTaskUnregister(&conv->shared_info.task);
 }
 void thread_exit1x2(TwoStageFFTConvolver1x2 *conv)
 {
-	pt_info1x2 *info = NULL;
-	//		GFT->sa_log_d(TAG, "Thread %d get off from work", i + 1);
-	info = &conv->shared_info;
-	// ensure the worker is waiting
-	pthread_mutex_lock(&(info->work_mtx));
-	info->state = GET_OFF_FROM_WORK;
-	// wake-up signal
-	pthread_cond_signal(&(info->work_cond));
-	pthread_mutex_unlock(&(info->work_mtx));
-	// wait for thread to exit
-	pthread_join(conv->threads, NULL);
-	pthread_mutex_destroy(&(info->work_mtx));
-	pthread_cond_destroy(&(info->work_cond));
-	pthread_mutex_unlock(&(info->boss_mtx));
-	pthread_mutex_destroy(&(info->boss_mtx));
-	pthread_cond_destroy(&(info->boss_cond));
+	ConvolverPoolTaskUnregister(&conv->shared_info.task);
 }
 /**
-* @brief Method called by the convolver if work for background processing is available
+* @brief Job submitted to the worker pool when a tail block is full
 *
-* The default implementation just calls doBackgroundProcessing() to perform the "bulk"
-* convolution. However, if you want to perform the majority of work in some background
-* thread (which is recommended), you can overload this method and trigger the execution
-* of doBackgroundProcessing() really in some background thread.
+* Convolves the block copied to _backgroundProcessingInput into _tailOutput,
+* the audio thread waits for it before it swaps _tailOutput in again.
 */
-void *task_type2(void *arg)
+void task_type2(void *arg)
 {
 	pt_info *conv = (pt_info *)arg;
-	// cond_wait mutex must be locked before we can wait
-	pthread_mutex_lock(&(conv->work_mtx));
-	//	printf("<worker %i> start\n", task);
-		// ensure boss is waiting
-	pthread_mutex_lock(&(conv->boss_mtx));
-	// signal to boss that setup is complete
-	conv->state = IDLE;
-	// wake-up signal
-	pthread_cond_signal(&(conv->boss_cond));
-	pthread_mutex_unlock(&(conv->boss_mtx));
-	while (1)
-	{
-		pthread_cond_wait(&(conv->work_cond), &(conv->work_mtx));
-		if (GET_OFF_FROM_WORK == conv->state)
-			break; // kill thread
-		if (IDLE == conv->state)
-			continue; // accidental wake-up
-		// do blocking task
-		FFTConvolver1x1Process(conv->_tailConvolver, conv->_backgroundProcessingInput, conv->_tailOutput, conv->_tailBlockSize);
-		// ensure boss is waiting
-		pthread_mutex_lock(&(conv->boss_mtx));
-		// indicate that job is done
-		conv->state = IDLE;
-		// wake-up signal
-		pthread_cond_signal(&(conv->boss_cond));
-		pthread_mutex_unlock(&(conv->boss_mtx));
-	}
-	pthread_mutex_unlock(&(conv->work_mtx));
-	pthread_exit(NULL);
-	return 0;
+	FFTConvolver1x1Process(conv->_tailConvolver, conv->_backgroundProcessingInput, conv->_tailOutput, conv->_tailBlockSize);
 }
-void *task_type22x4x2(void *arg)
+void task_type22x4x2(void *arg)
 {
-	pt_info2x4x2 *conv = (pt_info2x4x2*)arg;
-	// cond_wait mutex must be locked before we can wait
-	pthread_mutex_lock(&(conv->work_mtx));
-	//	printf("<worker %i> start\n", task);
-		// ensure boss is waiting
-	pthread_mutex_lock(&(conv->boss_mtx));
-	// signal to boss that setup is complete
-	conv->state = IDLE;
-	// wake-up signal
-	pthread_cond_signal(&(conv->boss_cond));
-	pthread_mutex_unlock(&(conv->boss_mtx));
-	while (1)
-	{
-		pthread_cond_wait(&(conv->work_cond), &(conv->work_mtx));
-		if (GET_OFF_FROM_WORK == conv->state)
-			break; // kill thread
-		if (IDLE == conv->state)
-			continue; // accidental wake-up
-		// do blocking task
-		FFTConvolver2x4x2Process(conv->_tailConvolver, conv->_backgroundProcessingInput[0], conv->_backgroundProcessingInput[1], conv->_tailOutput[0], conv->_tailOutput[1], conv->_tailBlockSize);
-		// ensure boss is waiting
-		pthread_mutex_lock(&(conv->boss_mtx));
-		// indicate that job is done
-		conv->state = IDLE;
-		// wake-up signal
-		pthread_cond_signal(&(conv->boss_cond));
-		pthread_mutex_unlock(&(conv->boss_mtx));
-	}
-	pthread_mutex_unlock(&(conv->work_mtx));
-	pthread_exit(NULL);
-	return 0;
+	pt_info2x4x2 *conv = (pt_info2x4x2 *)arg;
+	FFTConvolver2x4x2Process(conv->_tailConvolver, conv->_backgroundProcessingInput[0], conv->_backgroundProcessingInput[1], conv->_tailOutput[0], conv->_tailOutput[1], conv->_tailBlockSize);
 }
-void *task_type22x2(void *arg)
+void task_type22x2(void *arg)
 {
-	pt_info2x2 *conv = (pt_info2x2*)arg;
-	// cond_wait mutex must be locked before we can wait
-	pthread_mutex_lock(&(conv->work_mtx));
-	//	printf("<worker %i> start\n", task);
-		// ensure boss is waiting
-	pthread_mutex_lock(&(conv->boss_mtx));
-	// signal to boss that setup is complete
-	conv->state = IDLE;
-	// wake-up signal
-	pthread_cond_signal(&(conv->boss_cond));
-	pthread_mutex_unlock(&(conv->boss_mtx));
-	while (1)
-	{
-		pthread_cond_wait(&(conv->work_cond), &(conv->work_mtx));
-		if (GET_OFF_FROM_WORK == conv->state)
-			break; // kill thread
-		if (IDLE == conv->state)
-			continue; // accidental wake-up
-		// do blocking task
-		FFTConvolver2x2Process(conv->_tailConvolver, conv->_backgroundProcessingInput[0], conv->_backgroundProcessingInput[1], conv->_tailOutput[0], conv->_tailOutput[1], conv->_tailBlockSize);
-		// ensure boss is waiting
-		pthread_mutex_lock(&(conv->boss_mtx));
-		// indicate that job is done
-		conv->state = IDLE;
-		// wake-up signal
-		pthread_cond_signal(&(conv->boss_cond));
-		pthread_mutex_unlock(&(conv->boss_mtx));
-	}
-	pthread_mutex_unlock(&(conv->work_mtx));
-	pthread_exit(NULL);
-	return 0;
+	pt_info2x2 *conv = (pt_info2x2 *)arg;
+	FFTConvolver2x2Process(conv->_tailConvolver, conv->_backgroundProcessingInput[0], conv->_backgroundProcessingInput[1], conv->_tailOutput[0], conv->_tailOutput[1], conv->_tailBlockSize);
 }
-void *task_type21x2(void *arg)
+void task_type21x2(void *arg)
 {
-	pt_info1x2 *conv = (pt_info1x2*)arg;
-	// cond_wait mutex must be locked before we can wait
-	pthread_mutex_lock(&(conv->work_mtx));
-	//	printf("<worker %i> start\n", task);
-		// ensure boss is waiting
-	pthread_mutex_lock(&(conv->boss_mtx));
-	// signal to boss that setup is complete
-	conv->state = IDLE;
-	// wake-up signal
-	pthread_cond_signal(&(conv->boss_cond));
-	pthread_mutex_unlock(&(conv->boss_mtx));
-	while (1)
-	{
-		pthread_cond_wait(&(conv->work_cond), &(conv->work_mtx));
-		if (GET_OFF_FROM_WORK == conv->state)
-			break; // kill thread
-		if (IDLE == conv->state)
-			continue; // accidental wake-up
-		// do blocking task
-		FFTConvolver1x2Process(conv->_tailConvolver, conv->_backgroundProcessingInput, conv->_tailOutput[0], conv->_tailOutput[1], conv->_tailBlockSize);
-		// ensure boss is waiting
-		pthread_mutex_lock(&(conv->boss_mtx));
-		// indicate that job is done
-		conv->state = IDLE;
-		// wake-up signal
-		pthread_cond_signal(&(conv->boss_cond));
-		pthread_mutex_unlock(&(conv->boss_mtx));
-	}
-	pthread_mutex_unlock(&(conv->work_mtx));
-	pthread_exit(NULL);
-	return 0;
+	pt_info1x2 *conv = (pt_info1x2 *)arg;
+	FFTConvolver1x2Process(conv->_tailConvolver, conv->_backgroundProcessingInput, conv->_tailOutput[0], conv->_tailOutput[1], conv->_tailBlockSize);
 }
 void thread_init1x1(TwoStageFFTConvolver1x1 *conv)
 {
-	pt_info *info = NULL;
-	info = &conv->shared_info;
-	info->state = SETUP;
-	pthread_cond_init(&(info->work_cond), NULL);
-	pthread_mutex_init(&(info->work_mtx), NULL);
-	pthread_cond_init(&(info->boss_cond), NULL);
-	pthread_mutex_init(&(info->boss_mtx), NULL);
-	pthread_mutex_lock(&(info->boss_mtx));
+	pt_info *info = &conv->shared_info;
 	info->_tailConvolver = &conv->_tailConvolver;
 	info->_backgroundProcessingInput = conv->_backgroundProcessingInput;
 	info->_tailOutput = conv->_tailOutput;
 	info->_tailBlockSize = conv->_tailBlockSize;
-	pthread_create(&conv->threads, NULL, task_type2, (void *)info);
-	task_wait1x1(conv);
+	ConvolverPoolTaskRegister(&info->task, task_type2, (void *)info);
 }
 void thread_init2x4x2(TwoStageFFTConvolver2x4x2 *conv)
 {
-	pt_info2x4x2 *info = NULL;
-	info = &conv->shared_info;
-	info->state = SETUP;
-	pthread_cond_init(&(info->work_cond), NULL);
-	pthread_mutex_init(&(info->work_mtx), NULL);
-	pthread_cond_init(&(info->boss_cond), NULL);
-	pthread_mutex_init(&(info->boss_mtx), NULL);
-	pthread_mutex_lock(&(info->boss_mtx));
+	pt_info2x4x2 *info = &conv->shared_info;
 	info->_tailConvolver = &conv->_tailConvolver;
 	info->_backgroundProcessingInput[0] = conv->_backgroundProcessingInput[0];
 	info->_backgroundProcessingInput[1] = conv->_backgroundProcessingInput[1];
 	info->_tailOutput[0] = conv->_tailOutput[0];
 	info->_tailOutput[1] = conv->_tailOutput[1];
 	info->_tailBlockSize = conv->_tailBlockSize;
-	pthread_create(&conv->threads, NULL, task_type22x4x2, (void *)info);
-	task_wait2x4x2(conv);
+	ConvolverPoolTaskRegister(&info->task, task_type22x4x2, (void *)info);
 }
 void thread_init2x2(TwoStageFFTConvolver2x2 *conv)
 {
-	pt_info2x2 *info = NULL;
-	info = &conv->shared_info;
-	info->state = SETUP;
-	pthread_cond_init(&(info->work_cond), NULL);
-	pthread_mutex_init(&(info->work_mtx), NULL);
-	pthread_cond_init(&(info->boss_cond), NULL);
-	pthread_mutex_init(&(info->boss_mtx), NULL);
-	pthread_mutex_lock(&(info->boss_mtx));
+	pt_info2x2 *info = &conv->shared_info;
 	info->_tailConvolver = &conv->_tailConvolver;
 	info->_backgroundProcessingInput[0] = conv->_backgroundProcessingInput[0];
 	info->_backgroundProcessingInput[1] = conv->_backgroundProcessingInput[1];
 	info->_tailOutput[0] = conv->_tailOutput[0];
 	info->_tailOutput[1] = conv->_tailOutput[1];
 	info->_tailBlockSize = conv->_tailBlockSize;
-	pthread_create(&conv->threads, NULL, task_type22x2, (void *)info);
-	task_wait2x2(conv);
+	ConvolverPoolTaskRegister(&info->task, task_type22x2, (void *)info);
 }
 void thread_init1x2(TwoStageFFTConvolver1x2 *conv)
 {
-	pt_info1x2 *info = NULL;
-	info = &conv->shared_info;
-	info->state = SETUP;
-	pthread_cond_init(&(info->work_cond), NULL);
-	pthread_mutex_init(&(info->work_mtx), NULL);
-	pthread_cond_init(&(info->boss_cond), NULL);
-	pthread_mutex_init(&(info->boss_mtx), NULL);
-	pthread_mutex_lock(&(info->boss_mtx));
+	pt_info1x2 *info = &conv->shared_info;
 	info->_tailConvolver = &conv->_tailConvolver;
 	info->_backgroundProcessingInput = conv->_backgroundProcessingInput;
 	info->_tailOutput[0] = conv->_tailOutput[0];
 	info->_tailOutput[1] = conv->_tailOutput[1];
 	info->_tailBlockSize = conv->_tailBlockSize;
-	pthread_create(&conv->threads, NULL, task_type21x2, (void *)info);
-	task_wait1x2(conv);
+	ConvolverPoolTaskRegister(&info->task, task_type21x2, (void *)info);
 }
 inline void task_start1x1(TwoStageFFTConvolver1x1 *conv)
 {
-	pt_info *info = &(conv->shared_info);
-	// ensure worker is waiting
-	pthread_mutex_lock(&(info->work_mtx));
-	// set job information & state
-	info->state = WORKING;
-	// wake-up signal
-	pthread_cond_signal(&(info->work_cond));
-	pthread_mutex_unlock(&(info->work_mtx));
+	ConvolverPoolTaskSubmit(&conv->shared_info.task);
 }
 inline void task_start2x4x2(TwoStageFFTConvolver2x4x2 *conv)
 {
-	pt_info2x4x2 *info = &(conv->shared_info);
-	// ensure worker is waiting
-	pthread_mutex_lock(&(info->work_mtx));
-	// set job information & state
-	info->state = WORKING;
-	// wake-up signal
-	pthread_cond_signal(&(info->work_cond));
-	pthread_mutex_unlock(&(info->work_mtx));
+	ConvolverPoolTaskSubmit(&conv->shared_info.task);
 }
 inline void task_start2x2(TwoStageFFTConvolver2x2 *conv)
 {
-	pt_info2x2 *info = &(conv->shared_info);
-	// ensure worker is waiting
-	pthread_mutex_lock(&(info->work_mtx));
-	// set job information & state
-	info->state = WORKING;
-	// wake-up signal
-	pthread_cond_signal(&(info->work_cond));
-	pthread_mutex_unlock(&(info->work_mtx));
+	ConvolverPoolTaskSubmit(&conv->shared_info.task);
 }
 inline void task_start1x2(TwoStageFFTConvolver1x2 *conv)
 {
-	pt_info1x2 *info = &(conv->shared_info);
-	// ensure worker is waiting
-	pthread_mutex_lock(&(info->work_mtx));
-	// set job information & state
-	info->state = WORKING;
-	// wake-up signal
-	pthread_cond_signal(&(info->work_cond));
-	pthread_mutex_unlock(&(info->work_mtx));
+	ConvolverPoolTaskSubmit(&conv->shared_info.task);
 }
 #endif
 void TwoStageFFTConvolver1x1Free(TwoStageFFTConvolver1x1 *conv)
 {
 #ifdef THREAD
-	if (conv->shared_info.state != NOTHING)
-	{
-		if (conv->shared_info.state == WORKING)
-		{
-			task_wait1x1(conv);
-			thread_exit1x1(conv);
-		}
-		else
-			thread_exit1x1(conv);
-	}
+	thread_exit1x1(conv);
 #endif
 	conv->_headBlockSize = 0;
 	conv->_tailBlockSize = 0;
@@ -520,16 +249,7 @@ void TwoStageFFTConvolver1x1Free(TwoStageFFTConvolver1x1 *conv)
 void TwoStageFFTConvolver2x4x2Free(TwoStageFFTConvolver2x4x2 *conv)
 {
 #ifdef THREAD
-	if (conv->shared_info.state != NOTHING)
-	{
-		if (conv->shared_info.state == WORKING)
-		{
-			task_wait2x4x2(conv);
-			thread_exit2x4x2(conv);
-		}
-		else
-			thread_exit2x4x2(conv);
-	}
+	thread_exit2x4x2(conv);
 #endif
 	conv->_headBlockSize = 0;
 	conv->_tailBlockSize = 0;
@@ -582,16 +302,7 @@ void TwoStageFFTConvolver2x4x2Free(TwoStageFFTConvolver2x4x2 *conv)
 void TwoStageFFTConvolver2x2Free(TwoStageFFTConvolver2x2 *conv)
 {
 #ifdef THREAD
-	if (conv->shared_info.state != NOTHING)
-	{
-		if (conv->shared_info.state == WORKING)
-		{
-			task_wait2x2(conv);
-			thread_exit2x2(conv);
-		}
-		else
-			thread_exit2x2(conv);
-	}
+	thread_exit2x2(conv);
 #endif
 	conv->_headBlockSize = 0;
 	conv->_tailBlockSize = 0;
@@ -644,16 +355,7 @@ void TwoStageFFTConvolver2x2Free(TwoStageFFTConvolver2x2 *conv)
 void TwoStageFFTConvolver1x2Free(TwoStageFFTConvolver1x2 *conv)
 {
 #ifdef THREAD
-	if (conv->shared_info.state != NOTHING)
-	{
-		if (conv->shared_info.state == WORKING)
-		{
-			task_wait1x2(conv);
-			thread_exit1x2(conv);
-		}
-		else
-			thread_exit1x2(conv);
-	}
+	thread_exit1x2(conv);
 #endif
 	conv->_headBlockSize = 0;
 	conv->_tailBlockSize = 0;
@@ -995,54 +697,7 @@ void TwoStageFFTConvolver1x1Process(TwoStageFFTConvolver1x1 *conv, const float*
 			const float *imB;
 			unsigned int end4 = conv->_headConvolver._fftComplexSize - 1;
 			if (inputBufferWasEmpty)
-			{
-				unsigned int segFrameIndex = (conv->_headConvolver._current + 1) % conv->_headConvolver._segCount;
-				if (conv->_headConvolver._segCount > 1)
-				{
-					float *re = conv->_headConvolver._preMultiplied[0];
-					float *im = conv->_headConvolver._preMultiplied[1];
-					reA = conv->_headConvolver._segmentsIRRe[1];
-					imA = conv->_headConvolver._segmentsIRIm[1];
-					reB = conv->_headConvolver._segmentsRe[segFrameIndex];
-					imB = conv->_headConvolver._segmentsIm[segFrameIndex];
-					for (j = 0; j < end4; j += 4)
-					{
-						re[j + 0] = reA[j + 0] * reB[j + 0] - imA[j + 0] * imB[j + 0];
-						re[j + 1] = reA[j + 1] * reB[j + 1] - imA[j + 1] * imB[j + 1];
-						re[j + 2] = reA[j + 2] * reB[j + 2] - imA[j + 2] * imB[j + 2];
-						re[j + 3] = reA[j + 3] * reB[j + 3] - imA[j + 3] * imB[j + 3];
-						im[j + 0] = reA[j + 0] * imB[j + 0] + imA[j + 0] * reB[j + 0];
-						im[j + 1] = reA[j + 1] * imB[j + 1] + imA[j + 1] * reB[j + 1];
-						im[j + 2] = reA[j + 2] * imB[j + 2] + imA[j + 2] * reB[j + 2];
-						im[j + 3] = reA[j + 3] * imB[j + 3] + imA[j + 3] * reB[j + 3];
-					}
-					re[end4] = reA[end4] * reB[end4] - imA[end4] * imB[end4];
-					im[end4] = reA[end4] * imB[end4] + imA[end4] * reB[end4];
-					for (i = 2; i < conv->_headConvolver._segCount; ++i)
-					{
-						segFrameIndex = (conv->_headConvolver._current + i) % conv->_headConvolver._segCount;
-						re = conv->_headConvolver._preMultiplied[0];
-						im = conv->_headConvolver._preMultiplied[1];
-						reA = conv->_headConvolver._segmentsIRRe[i];
-						imA = conv->_headConvolver._segmentsIRIm[i];
-						reB = conv->_headConvolver._segmentsRe[segFrameIndex];
-						imB = conv->_headConvolver._segmentsIm[segFrameIndex];
-						for (j = 0; j < end4; j += 4)
-						{
-							re[j + 0] += reA[j + 0] * reB[j + 0] - imA[j + 0] * imB[j + 0];
-							re[j + 1] += reA[j + 1] * reB[j + 1] - imA[j + 1] * imB[j + 1];
-							re[j + 2] += reA[j + 2] * reB[j + 2] - imA[j + 2] * imB[j + 2];
-							re[j + 3] += reA[j + 3] * reB[j + 3] - imA[j + 3] * imB[j + 3];
-							im[j + 0] += reA[j + 0] * imB[j + 0] + imA[j + 0] * reB[j + 0];
-							im[j + 1] += reA[j + 1] * imB[j + 1] + imA[j + 1] * reB[j + 1];
-							im[j + 2] += reA[j + 2] * imB[j + 2] + imA[j + 2] * reB[j + 2];
-							im[j + 3] += reA[j + 3] * imB[j + 3] + imA[j + 3] * reB[j + 3];
-						}
-						re[end4] += reA[end4] * reB[end4] - imA[end4] * imB[end4];
-						im[end4] += reA[end4] * imB[end4] + imA[end4] * reB[end4];
-					}
-				}
-			}
+				FFTConvolver1x1PreMultiply(&conv->_headConvolver);
 			reA = conv->_headConvolver._segmentsIRRe[0];
 			imA = conv->_headConvolver._segmentsIRIm[0];
 			reB = conv->_headConvolver._segmentsRe[conv->_headConvolver._current];
@@ -1132,8 +787,7 @@ void TwoStageFFTConvolver1x1Process(TwoStageFFTConvolver1x1 *conv, const float*
 			if (conv->_tailPrecalculated && conv->_tailInputFill == conv->_tailBlockSize && conv->_backgroundProcessingInput && conv->_tailOutput)
 			{
 #ifdef THREAD
-				if (conv->shared_info.state == WORKING)
-					task_wait1x1(conv);
+				task_wait1x1(conv);
 				//        SampleBuffer::Swap(_tailPrecalculated, _tailOutput);
 				float *tmp = conv->_tailOutput;
 				conv->shared_info._tailOutput = conv->_tailOutput = conv->_tailPrecalculated;
@@ -1213,94 +867,7 @@ void TwoStageFFTConvolver2x4x2Process(TwoStageFFTConvolver2x4x2 *conv, const flo
 			const float *imBRight;
 			unsigned int end4 = conv->_headConvolver._fftComplexSize - 1;
 			if (inputBufferWasEmpty)
-			{
-				unsigned int segFrameIndex = (conv->_headConvolver._current + 1) % conv->_headConvolver._segCount;
-				if (conv->_headConvolver._segCount > 1)
-				{
-					float *reLeft = conv->_headConvolver._preMultiplied[0][0];
-					float *imLeft = conv->_headConvolver._preMultiplied[0][1];
-					float *reRight = conv->_headConvolver._preMultiplied[1][0];
-					float *imRight = conv->_headConvolver._preMultiplied[1][1];
-					reALL = conv->_headConvolver._segmentsLLIRRe[1];
-					imALL = conv->_headConvolver._segmentsLLIRIm[1];
-					reALR = conv->_headConvolver._segmentsLRIRRe[1];
-					imALR = conv->_headConvolver._segmentsLRIRIm[1];
-					reARL = conv->_headConvolver._segmentsRLIRRe[1];
-					imARL = conv->_headConvolver._segmentsRLIRIm[1];
-					reARR = conv->_headConvolver._segmentsRRIRRe[1];
-					imARR = conv->_headConvolver._segmentsRRIRIm[1];
-					reBLeft = conv->_headConvolver._segmentsReLeft[segFrameIndex];
-					imBLeft = conv->_headConvolver._segmentsImLeft[segFrameIndex];
-					reBRight = conv->_headConvolver._segmentsReRight[segFrameIndex];
-					imBRight = conv->_headConvolver._segmentsImRight[segFrameIndex];
-					for (j = 0; j < end4; j += 4)
-					{
-						reLeft[j + 0] = (reARL[j + 0] * reBRight[j + 0] - imARL[j + 0] * imBRight[j + 0]) + (reALL[j + 0] * reBLeft[j + 0] - imALL[j + 0] * imBLeft[j + 0]);
-						reLeft[j + 1] = (reARL[j + 1] * reBRight[j + 1] - imARL[j + 1] * imBRight[j + 1]) + (reALL[j + 1] * reBLeft[j + 1] - imALL[j + 1] * imBLeft[j + 1]);
-						reLeft[j + 2] = (reARL[j + 2] * reBRight[j + 2] - imARL[j + 2] * imBRight[j + 2]) + (reALL[j + 2] * reBLeft[j + 2] - imALL[j + 2] * imBLeft[j + 2]);
-						reLeft[j + 3] = (reARL[j + 3] * reBRight[j + 3] - imARL[j + 3] * imBRight[j + 3]) + (reALL[j + 3] * reBLeft[j + 3] - imALL[j + 3] * imBLeft[j + 3]);
-						imLeft[j + 0] = (imARL[j + 0] * reBRight[j + 0] + reARL[j + 0] * imBRight[j + 0]) + (reALL[j + 0] * imBLeft[j + 0] + imALL[j + 0] * reBLeft[j + 0]);
-						imLeft[j + 1] = (imARL[j + 1] * reBRight[j + 1] + reARL[j + 1] * imBRight[j + 1]) + (reALL[j + 1] * imBLeft[j + 1] + imALL[j + 1] * reBLeft[j + 1]);
-						imLeft[j + 2] = (imARL[j + 2] * reBRight[j + 2] + reARL[j + 2] * imBRight[j + 2]) + (reALL[j + 2] * imBLeft[j + 2] + imALL[j + 2] * reBLeft[j + 2]);
-						imLeft[j + 3] = (imARL[j + 3] * reBRight[j + 3] + reARL[j + 3] * imBRight[j + 3]) + (reALL[j + 3] * imBLeft[j + 3] + imALL[j + 3] * reBLeft[j + 3]);
-						reRight[j + 0] = (reALR[j + 0] * reBLeft[j + 0] - imALR[j + 0] * imBLeft[j + 0]) + (reARR[j + 0] * reBRight[j + 0] - imARR[j + 0] * imBRight[j + 0]);
-						reRight[j + 1] = (reALR[j + 1] * reBLeft[j + 1] - imALR[j + 1] * imBLeft[j + 1]) + (reARR[j + 1] * reBRight[j + 1] - imARR[j + 1] * imBRight[j + 1]);
-						reRight[j + 2] = (reALR[j + 2] * reBLeft[j + 2] - imALR[j + 2] * imBLeft[j + 2]) + (reARR[j + 2] * reBRight[j + 2] - imARR[j + 2] * imBRight[j + 2]);
-						reRight[j + 3] = (reALR[j + 3] * reBLeft[j + 3] - imALR[j + 3] * imBLeft[j + 3]) + (reARR[j + 3] * reBRight[j + 3] - imARR[j + 3] * imBRight[j + 3]);
-						imRight[j + 0] = (imALR[j + 0] * reBLeft[j + 0] + reALR[j + 0] * imBLeft[j + 0]) + (reARR[j + 0] * imBRight[j + 0] + imARR[j + 0] * reBRight[j + 0]);
-						imRight[j + 1] = (imALR[j + 1] * reBLeft[j + 1] + reALR[j + 1] * imBLeft[j + 1]) + (reARR[j + 1] * imBRight[j + 1] + imARR[j + 1] * reBRight[j + 1]);
-						imRight[j + 2] = (imALR[j + 2] * reBLeft[j + 2] + reALR[j + 2] * imBLeft[j + 2]) + (reARR[j + 2] * imBRight[j + 2] + imARR[j + 2] * reBRight[j + 2]);
-						imRight[j + 3] = (imALR[j + 3] * reBLeft[j + 3] + reALR[j + 3] * imBLeft[j + 3]) + (reARR[j + 3] * imBRight[j + 3] + imARR[j + 3] * reBRight[j + 3]);
-					}
-					reLeft[end4] = (reARL[end4] * reBRight[end4] - imARL[end4] * imBRight[end4]) + (reALL[end4] * reBLeft[end4] - imALL[end4] * imBLeft[end4]);
-					imLeft[end4] = (imARL[end4] * reBRight[end4] + reARL[end4] * imBRight[end4]) + (reALL[end4] * imBLeft[end4] + imALL[end4] * reBLeft[end4]);
-					reRight[end4] = (reALR[end4] * reBLeft[end4] - imALR[end4] * imBLeft[end4]) + (reARR[end4] * reBRight[end4] - imARR[end4] * imBRight[end4]);
-					imRight[end4] = (imALR[end4] * reBLeft[end4] + reALR[end4] * imBLeft[end4]) + (reARR[end4] * imBRight[end4] + imARR[end4] * reBRight[end4]);
-					for (unsigned int i = 2; i < conv->_headConvolver._segCount; ++i)
-					{
-						segFrameIndex = (conv->_headConvolver._current + i) % conv->_headConvolver._segCount;
-						reLeft = conv->_headConvolver._preMultiplied[0][0];
-						imLeft = conv->_headConvolver._preMultiplied[0][1];
-						reRight = conv->_headConvolver._preMultiplied[1][0];
-						imRight = conv->_headConvolver._preMultiplied[1][1];
-						reALL = conv->_headConvolver._segmentsLLIRRe[i];
-						imALL = conv->_headConvolver._segmentsLLIRIm[i];
-						reALR = conv->_headConvolver._segmentsLRIRRe[i];
-						imALR = conv->_headConvolver._segmentsLRIRIm[i];
-						reARL = conv->_headConvolver._segmentsRLIRRe[i];
-						imARL = conv->_headConvolver._segmentsRLIRIm[i];
-						reARR = conv->_headConvolver._segmentsRRIRRe[i];
-						imARR = conv->_headConvolver._segmentsRRIRIm[i];
-						reBLeft = conv->_headConvolver._segmentsReLeft[segFrameIndex];
-						imBLeft = conv->_headConvolver._segmentsImLeft[segFrameIndex];
-						reBRight = conv->_headConvolver._segmentsReRight[segFrameIndex];
-						imBRight = conv->_headConvolver._segmentsImRight[segFrameIndex];
-						for (j = 0; j < end4; j += 4)
-						{
-							reLeft[j + 0] += (reARL[j + 0] * reBRight[j + 0] - imARL[j + 0] * imBRight[j + 0]) + (reALL[j + 0] * reBLeft[j + 0] - imALL[j + 0] * imBLeft[j + 0]);
-							reLeft[j + 1] += (reARL[j + 1] * reBRight[j + 1] - imARL[j + 1] * imBRight[j + 1]) + (reALL[j + 1] * reBLeft[j + 1] - imALL[j + 1] * imBLeft[j + 1]);
-							reLeft[j + 2] += (reARL[j + 2] * reBRight[j + 2] - imARL[j + 2] * imBRight[j + 2]) + (reALL[j + 2] * reBLeft[j + 2] - imALL[j + 2] * imBLeft[j + 2]);
-							reLeft[j + 3] += (reARL[j + 3] * reBRight[j + 3] - imARL[j + 3] * imBRight[j + 3]) + (reALL[j + 3] * reBLeft[j + 3] - imALL[j + 3] * imBLeft[j + 3]);
-							imLeft[j + 0] += (imARL[j + 0] * reBRight[j + 0] + reARL[j + 0] * imBRight[j + 0]) + (reALL[j + 0] * imBLeft[j + 0] + imALL[j + 0] * reBLeft[j + 0]);
-							imLeft[j + 1] += (imARL[j + 1] * reBRight[j + 1] + reARL[j + 1] * imBRight[j + 1]) + (reALL[j + 1] * imBLeft[j + 1] + imALL[j + 1] * reBLeft[j + 1]);
-							imLeft[j + 2] += (imARL[j + 2] * reBRight[j + 2] + reARL[j + 2] * imBRight[j + 2]) + (reALL[j + 2] * imBLeft[j + 2] + imALL[j + 2] * reBLeft[j + 2]);
-							imLeft[j + 3] += (imARL[j + 3] * reBRight[j + 3] + reARL[j + 3] * imBRight[j + 3]) + (reALL[j + 3] * imBLeft[j + 3] + imALL[j + 3] * reBLeft[j + 3]);
-							reRight[j + 0] += (reALR[j + 0] * reBLeft[j + 0] - imALR[j + 0] * imBLeft[j + 0]) + (reARR[j + 0] * reBRight[j + 0] - imARR[j + 0] * imBRight[j + 0]);
-							reRight[j + 1] += (reALR[j + 1] * reBLeft[j + 1] - imALR[j + 1] * imBLeft[j + 1]) + (reARR[j + 1] * reBRight[j + 1] - imARR[j + 1] * imBRight[j + 1]);
-							reRight[j + 2] += (reALR[j + 2] * reBLeft[j + 2] - imALR[j + 2] * imBLeft[j + 2]) + (reARR[j + 2] * reBRight[j + 2] - imARR[j + 2] * imBRight[j + 2]);
-							reRight[j + 3] += (reALR[j + 3] * reBLeft[j + 3] - imALR[j + 3] * imBLeft[j + 3]) + (reARR[j + 3] * reBRight[j + 3] - imARR[j + 3] * imBRight[j + 3]);
-							imRight[j + 0] += (imALR[j + 0] * reBLeft[j + 0] + reALR[j + 0] * imBLeft[j + 0]) + (reARR[j + 0] * imBRight[j + 0] + imARR[j + 0] * reBRight[j + 0]);
-							imRight[j + 1] += (imALR[j + 1] * reBLeft[j + 1] + reALR[j + 1] * imBLeft[j + 1]) + (reARR[j + 1] * imBRight[j + 1] + imARR[j + 1] * reBRight[j + 1]);
-							imRight[j + 2] += (imALR[j + 2] * reBLeft[j + 2] + reALR[j + 2] * imBLeft[j + 2]) + (reARR[j + 2] * imBRight[j + 2] + imARR[j + 2] * reBRight[j + 2]);
-							imRight[j + 3] += (imALR[j + 3] * reBLeft[j + 3] + reALR[j + 3] * imBLeft[j + 3]) + (reARR[j + 3] * imBRight[j + 3] + imARR[j + 3] * reBRight[j + 3]);
-						}
-						reLeft[end4] += (reARL[end4] * reBRight[end4] - imARL[end4] * imBRight[end4]) + (reALL[end4] * reBLeft[end4] - imALL[end4] * imBLeft[end4]);
-						imLeft[end4] += (imARL[end4] * reBRight[end4] + reARL[end4] * imBRight[end4]) + (reALL[end4] * imBLeft[end4] + imALL[end4] * reBLeft[end4]);
-						reRight[end4] += (reALR[end4] * reBLeft[end4] - imALR[end4] * imBLeft[end4]) + (reARR[end4] * reBRight[end4] - imARR[end4] * imBRight[end4]);
-						imRight[end4] += (imALR[end4] * reBLeft[end4] + reALR[end4] * imBLeft[end4]) + (reARR[end4] * imBRight[end4] + imARR[end4] * reBRight[end4]);
-					}
-				}
-			}
+				FFTConvolver2x4x2PreMultiply(&conv->_headConvolver);
 			reALL = conv->_headConvolver._segmentsLLIRRe[0];
 			imALL = conv->_headConvolver._segmentsLLIRIm[0];
 			reALR = conv->_headConvolver._segmentsLRIRRe[0];
@@ -1409,8 +976,7 @@ void TwoStageFFTConvolver2x4x2Process(TwoStageFFTConvolver2x4x2 *conv, const flo
 			if (conv->_tailPrecalculated[0] && conv->_tailInputFill == conv->_tailBlockSize && conv->_backgroundProcessingInput[0])
 			{
 #ifdef THREAD
-				if (conv->shared_info.state == WORKING)
-					task_wait2x4x2(conv);
+				task_wait2x4x2(conv);
 				//        SampleBuffer::Swap(_tailPrecalculated, _tailOutput);
 				float *tmp = conv->_tailOutput[0];
 				conv->shared_info._tailOutput[0] = conv->_tailOutput[0] = conv->_tailPrecalculated[0];
@@ -1512,86 +1078,7 @@ void TwoStageFFTConvolver2x2Process(TwoStageFFTConvolver2x2 *conv, const float*
 			const float *imBRight;
 			unsigned int end4 = conv->_headConvolver._fftComplexSize - 1;
 			if (inputBufferWasEmpty)
-			{
-				unsigned int segFrameIndex = (conv->_headConvolver._current + 1) % conv->_headConvolver._segCount;
-				if (conv->_headConvolver._segCount > 1)
-				{
-					float *reLeft = conv->_headConvolver._preMultiplied[0][0];
-					float *imLeft = conv->_headConvolver._preMultiplied[0][1];
-					float *reRight = conv->_headConvolver._preMultiplied[1][0];
-					float *imRight = conv->_headConvolver._preMultiplied[1][1];
-					reALL = conv->_headConvolver._segmentsLLIRRe[1];
-					imALL = conv->_headConvolver._segmentsLLIRIm[1];
-					reARR = conv->_headConvolver._segmentsRRIRRe[1];
-					imARR = conv->_headConvolver._segmentsRRIRIm[1];
-					reBLeft = conv->_headConvolver._segmentsReLeft[segFrameIndex];
-					imBLeft = conv->_headConvolver._segmentsImLeft[segFrameIndex];
-					reBRight = conv->_headConvolver._segmentsReRight[segFrameIndex];
-					imBRight = conv->_headConvolver._segmentsImRight[segFrameIndex];
-					for (j = 0; j < end4; j += 4)
-					{
-						reLeft[j + 0] = reALL[j + 0] * reBLeft[j + 0] - imALL[j + 0] * imBLeft[j + 0];
-						reLeft[j + 1] = reALL[j + 1] * reBLeft[j + 1] - imALL[j + 1] * imBLeft[j + 1];
-						reLeft[j + 2] = reALL[j + 2] * reBLeft[j + 2] - imALL[j + 2] * imBLeft[j + 2];
-						reLeft[j + 3] = reALL[j + 3] * reBLeft[j + 3] - imALL[j + 3] * imBLeft[j + 3];
-						imLeft[j + 0] = reALL[j + 0] * imBLeft[j + 0] + imALL[j + 0] * reBLeft[j + 0];
-						imLeft[j + 1] = reALL[j + 1] * imBLeft[j + 1] + imALL[j + 1] * reBLeft[j + 1];
-						imLeft[j + 2] = reALL[j + 2] * imBLeft[j + 2] + imALL[j + 2] * reBLeft[j + 2];
-						imLeft[j + 3] = reALL[j + 3] * imBLeft[j + 3] + imALL[j + 3] * reBLeft[j + 3];
-						reRight[j + 0] = reARR[j + 0] * reBRight[j + 0] - imARR[j + 0] * imBRight[j + 0];
-						reRight[j + 1] = reARR[j + 1] * reBRight[j + 1] - imARR[j + 1] * imBRight[j + 1];
-						reRight[j + 2] = reARR[j + 2] * reBRight[j + 2] - imARR[j + 2] * imBRight[j + 2];
-						reRight[j + 3] = reARR[j + 3] * reBRight[j + 3] - imARR[j + 3] * imBRight[j + 3];
-						imRight[j + 0] = reARR[j + 0] * imBRight[j + 0] + imARR[j + 0] * reBRight[j + 0];
-						imRight[j + 1] = reARR[j + 1] * imBRight[j + 1] + imARR[j + 1] * reBRight[j + 1];
-						imRight[j + 2] = reARR[j + 2] * imBRight[j + 2] + imARR[j + 2] * reBRight[j + 2];
-						imRight[j + 3] = reARR[j + 3] * imBRight[j + 3] + imARR[j + 3] * reBRight[j + 3];
-					}
-					reLeft[end4] = reALL[end4] * reBLeft[end4] - imALL[end4] * imBLeft[end4];
-					imLeft[end4] = reALL[end4] * imBLeft[end4] + imALL[end4] * reBLeft[end4];
-					reRight[end4] = reARR[end4] * reBRight[end4] - imARR[end4] * imBRight[end4];
-					imRight[end4] = reARR[end4] * imBRight[end4] + imARR[end4] * reBRight[end4];
-					for (unsigned int i = 2; i < conv->_headConvolver._segCount; ++i)
-					{
-						segFrameIndex = (conv->_headConvolver._current + i) % conv->_headConvolver._segCount;
-						reLeft = conv->_headConvolver._preMultiplied[0][0];
-						imLeft = conv->_headConvolver._preMultiplied[0][1];
-						reRight = conv->_headConvolver._preMultiplied[1][0];
-						imRight = conv->_headConvolver._preMultiplied[1][1];
-						reALL = conv->_headConvolver._segmentsLLIRRe[i];
-						imALL = conv->_headConvolver._segmentsLLIRIm[i];
-						reARR = conv->_headConvolver._segmentsRRIRRe[i];
-						imARR = conv->_headConvolver._segmentsRRIRIm[i];
-						reBLeft = conv->_headConvolver._segmentsReLeft[segFrameIndex];
-						imBLeft = conv->_headConvolver._segmentsImLeft[segFrameIndex];
-						reBRight = conv->_headConvolver._segmentsReRight[segFrameIndex];
-						imBRight = conv->_headConvolver._segmentsImRight[segFrameIndex];
-						for (j = 0; j < end4; j += 4)
-						{
-							reLeft[j + 0] += reALL[j + 0] * reBLeft[j + 0] - imALL[j + 0] * imBLeft[j + 0];
-							reLeft[j + 1] += reALL[j + 1] * reBLeft[j + 1] - imALL[j + 1] * imBLeft[j + 1];
-							reLeft[j + 2] += reALL[j + 2] * reBLeft[j + 2] - imALL[j + 2] * imBLeft[j + 2];
-							reLeft[j + 3] += reALL[j + 3] * reBLeft[j + 3] - imALL[j + 3] * imBLeft[j + 3];
-							imLeft[j + 0] += reALL[j + 0] * imBLeft[j + 0] + imALL[j + 0] * reBLeft[j + 0];
-							imLeft[j + 1] += reALL[j + 1] * imBLeft[j + 1] + imALL[j + 1] * reBLeft[j + 1];
-							imLeft[j + 2] += reALL[j + 2] * imBLeft[j + 2] + imALL[j + 2] * reBLeft[j + 2];
-							imLeft[j + 3] += reALL[j + 3] * imBLeft[j + 3] + imALL[j + 3] * reBLeft[j + 3];
-							reRight[j + 0] += reARR[j + 0] * reBRight[j + 0] - imARR[j + 0] * imBRight[j + 0];
-							reRight[j + 1] += reARR[j + 1] * reBRight[j + 1] - imARR[j + 1] * imBRight[j + 1];
-							reRight[j + 2] += reARR[j + 2] * reBRight[j + 2] - imARR[j + 2] * imBRight[j + 2];
-							reRight[j + 3] += reARR[j + 3] * reBRight[j + 3] - imARR[j + 3] * imBRight[j + 3];
-							imRight[j + 0] += reARR[j + 0] * imBRight[j + 0] + imARR[j + 0] * reBRight[j + 0];
-							imRight[j + 1] += reARR[j + 1] * imBRight[j + 1] + imARR[j + 1] * reBRight[j + 1];
-							imRight[j + 2] += reARR[j + 2] * imBRight[j + 2] + imARR[j + 2] * reBRight[j + 2];
-							imRight[j + 3] += reARR[j + 3] * imBRight[j + 3] + imARR[j + 3] * reBRight[j + 3];
-						}
-						reLeft[end4] += reALL[end4] * reBLeft[end4] - imALL[end4] * imBLeft[end4];
-						imLeft[end4] += reALL[end4] * imBLeft[end4] + imALL[end4] * reBLeft[end4];
-						reRight[end4] += reARR[end4] * reBRight[end4] - imARR[end4] * imBRight[end4];
-						imRight[end4] += reARR[end4] * imBRight[end4] + imARR[end4] * reBRight[end4];
-					}
-				}
-			}
+				FFTConvolver2x2PreMultiply(&conv->_headConvolver);
 			reALL = conv->_headConvolver._segmentsLLIRRe[0];
 			imALL = conv->_headConvolver._segmentsLLIRIm[0];
 			reARR = conv->_headConvolver._segmentsRRIRRe[0];
@@ -1710,8 +1197,7 @@ void TwoStageFFTConvolver2x2Process(TwoStageFFTConvolver2x2 *conv, const float*
 			if (conv->_tailPrecalculated[0] && conv->_tailInputFill == conv->_tailBlockSize && conv->_backgroundProcessingInput[0])
 			{
 #ifdef THREAD
-				if (conv->shared_info.state == WORKING)
-					task_wait2x2(conv);
+				task_wait2x2(conv);
 				//        SampleBuffer::Swap(_tailPrecalculated, _tailOutput);
 				float *tmp = conv->_tailOutput[0];
 				conv->shared_info._tailOutput[0] = conv->_tailOutput[0] = conv->_tailPrecalculated[0];
@@ -1784,82 +1270,7 @@ void TwoStageFFTConvolver1x2Process(TwoStageFFTConvolver1x2 *conv, const float*
 			const float *imB;
 			unsigned int end4 = conv->_headConvolver._fftComplexSize - 1;
 			if (inputBufferWasEmpty)
-			{
-				unsigned int segFrameIndex = (conv->_headConvolver._current + 1) % conv->_headConvolver._segCount;
-				if (conv->_headConvolver._segCount > 1)
-				{
-					float *reLeft = conv->_headConvolver._preMultiplied[0][0];
-					float *imLeft = conv->_headConvolver._preMultiplied[0][1];
-					float *reRight = conv->_headConvolver._preMultiplied[1][0];
-					float *imRight = conv->_headConvolver._preMultiplied[1][1];
-					reALL = conv->_headConvolver._segmentsLLIRRe[1];
-					imALL = conv->_headConvolver._segmentsLLIRIm[1];
-					reARR = conv->_headConvolver._segmentsRRIRRe[1];
-					imARR = conv->_headConvolver._segmentsRRIRIm[1];
-					reB = conv->_headConvolver._segmentsRe[segFrameIndex];
-					imB = conv->_headConvolver._segmentsIm[segFrameIndex];
-					for (j = 0; j < end4; j += 4)
-					{
-						reLeft[j + 0] = reALL[j + 0] * reB[j + 0] - imALL[j + 0] * imB[j + 0];
-						reLeft[j + 1] = reALL[j + 1] * reB[j + 1] - imALL[j + 1] * imB[j + 1];
-						reLeft[j + 2] = reALL[j + 2] * reB[j + 2] - imALL[j + 2] * imB[j + 2];
-						reLeft[j + 3] = reALL[j + 3] * reB[j + 3] - imALL[j + 3] * imB[j + 3];
-						imLeft[j + 0] = reALL[j + 0] * imB[j + 0] + imALL[j + 0] * reB[j + 0];
-						imLeft[j + 1] = reALL[j + 1] * imB[j + 1] + imALL[j + 1] * reB[j + 1];
-						imLeft[j + 2] = reALL[j + 2] * imB[j + 2] + imALL[j + 2] * reB[j + 2];
-						imLeft[j + 3] = reALL[j + 3] * imB[j + 3] + imALL[j + 3] * reB[j + 3];
-						reRight[j + 0] = reARR[j + 0] * reB[j + 0] - imARR[j + 0] * imB[j + 0];
-						reRight[j + 1] = reARR[j + 1] * reB[j + 1] - imARR[j + 1] * imB[j + 1];
-						reRight[j + 2] = reARR[j + 2] * reB[j + 2] - imARR[j + 2] * imB[j + 2];
-						reRight[j + 3] = reARR[j + 3] * reB[j + 3] - imARR[j + 3] * imB[j + 3];
-						imRight[j + 0] = reARR[j + 0] * imB[j + 0] + imARR[j + 0] * reB[j + 0];
-						imRight[j + 1] = reARR[j + 1] * imB[j + 1] + imARR[j + 1] * reB[j + 1];
-						imRight[j + 2] = reARR[j + 2] * imB[j + 2] + imARR[j + 2] * reB[j + 2];
-						imRight[j + 3] = reARR[j + 3] * imB[j + 3] + imARR[j + 3] * reB[j + 3];
-					}
-					reLeft[end4] = reALL[end4] * reB[end4] - imALL[end4] * imB[end4];
-					imLeft[end4] = reALL[end4] * imB[end4] + imALL[end4] * reB[end4];
-					reRight[end4] = reARR[end4] * reB[end4] - imARR[end4] * imB[end4];
-					imRight[end4] = reARR[end4] * imB[end4] + imARR[end4] * reB[end4];
-					for (unsigned int i = 2; i < conv->_headConvolver._segCount; ++i)
-					{
-						segFrameIndex = (conv->_headConvolver._current + i) % conv->_headConvolver._segCount;
-						reLeft = conv->_headConvolver._preMultiplied[0][0];
-						imLeft = conv->_headConvolver._preMultiplied[0][1];
-						reRight = conv->_headConvolver._preMultiplied[1][0];
-						imRight = conv->_headConvolver._preMultiplied[1][1];
-						reALL = conv->_headConvolver._segmentsLLIRRe[i];
-						imALL = conv->_headConvolver._segmentsLLIRIm[i];
-						reARR = conv->_headConvolver._segmentsRRIRRe[i];
-						imARR = conv->_headConvolver._segmentsRRIRIm[i];
-						reB = conv->_headConvolver._segmentsRe[segFrameIndex];
-						imB = conv->_headConvolver._segmentsIm[segFrameIndex];
-						for (j = 0; j < end4; j += 4)
-						{
-							reLeft[j + 0] += reALL[j + 0] * reB[j + 0] - imALL[j + 0] * imB[j + 0];
-							reLeft[j + 1] += reALL[j + 1] * reB[j + 1] - imALL[j + 1] * imB[j + 1];
-							reLeft[j + 2] += reALL[j + 2] * reB[j + 2] - imALL[j + 2] * imB[j + 2];
-							reLeft[j + 3] += reALL[j + 3] * reB[j + 3] - imALL[j + 3] * imB[j + 3];
-							imLeft[j + 0] += reALL[j + 0] * imB[j + 0] + imALL[j + 0] * reB[j + 0];
-							imLeft[j + 1] += reALL[j + 1] * imB[j + 1] + imALL[j + 1] * reB[j + 1];
-							imLeft[j + 2] += reALL[j + 2] * imB[j + 2] + imALL[j + 2] * reB[j + 2];
-							imLeft[j + 3] += reALL[j + 3] * imB[j + 3] + imALL[j + 3] * reB[j + 3];
-							reRight[j + 0] += reARR[j + 0] * reB[j + 0] - imARR[j + 0] * imB[j + 0];
-							reRight[j + 1] += reARR[j + 1] * reB[j + 1] - imARR[j + 1] * imB[j + 1];
-							reRight[j + 2] += reARR[j + 2] * reB[j + 2] - imARR[j + 2] * imB[j + 2];
-							reRight[j + 3] += reARR[j + 3] * reB[j + 3] - imARR[j + 3] * imB[j + 3];
-							imRight[j + 0] += reARR[j + 0] * imB[j + 0] + imARR[j + 0] * reB[j + 0];
-							imRight[j + 1] += reARR[j + 1] * imB[j + 1] + imARR[j + 1] * reB[j + 1];
-							imRight[j + 2] += reARR[j + 2] * imB[j + 2] + imARR[j + 2] * reB[j + 2];
-							imRight[j + 3] += reARR[j + 3] * imB[j + 3] + imARR[j + 3] * reB[j + 3];
-						}
-						reLeft[end4] += reALL[end4] * reB[end4] - imALL[end4] * imB[end4];
-						imLeft[end4] += reALL[end4] * imB[end4] + imALL[end4] * reB[end4];
-						reRight[end4] += reARR[end4] * reB[end4] - imARR[end4] * imB[end4];
-						imRight[end4] += reARR[end4] * imB[end4] + imARR[end4] * reB[end4];
-					}
-				}
-			}
+				FFTConvolver1x2PreMultiply(&conv->_headConvolver);
 			reALL = conv->_headConvolver._segmentsLLIRRe[0];
 			imALL = conv->_headConvolver._segmentsLLIRIm[0];
 			reARR = conv->_headConvolver._segmentsRRIRRe[0];
@@ -1975,8 +1386,7 @@ void TwoStageFFTConvolver1x2Process(TwoStageFFTConvolver1x2 *conv, const float*
 			if (conv->_tailPrecalculated[0] && conv->_tailInputFill == conv->_tailBlockSize && conv->_backgroundProcessingInput)
 			{
 #ifdef THREAD
-				if (conv->shared_info.state == WORKING)
-					task_wait1x2(conv);
+				task_wait1x2(conv);
 				//        SampleBuffer::Swap(_tailPrecalculated, _tailOutput);
 				float *tmp = conv->_tailOutput[0];
 				conv->shared_info._tailOutput[0] = conv->_tailOutput[0] = conv->_tailPrecalculated[0];
@@ -2012,3 +1422,40 @@ void TwoStageFFTConvolver1x2Process(TwoStageFFTConvolver1x2 *conv, const float*
 		FFTConvolver1x2Process(&conv->_headConvolver, x, y1, y2, len);
 	}
 }
+size_t TwoStageFFTConvolver2x4x2MemoryUsage(TwoStageFFTConvolver2x4x2 *conv)
+{
+	size_t bytes = FFTConvolver2x4x2MemoryUsage(&conv->_headConvolver) + FFTConvolver2x4x2MemoryUsage(&conv->_tailConvolver0) + FFTConvolver2x4x2MemoryUsage(&conv->_tailConvolver);
+	for (int i = 0; i < 2; i++)
+		bytes += ((conv->_tailOutput0[i] != 0) * 2 + (conv->_tailOutput[i] != 0) * 3 + (conv->_tailInput[i] != 0)) * conv->_tailBlockSize * sizeof(float);
+	return bytes;
+}
+size_t TwoStageFFTConvolver2x2MemoryUsage(TwoStageFFTConvolver2x2 *conv)
+{
+	size_t bytes = FFTConvolver2x2MemoryUsage(&conv->_headConvolver) + FFTConvolver2x2MemoryUsage(&conv->_tailConvolver0) + FFTConvolver2x2MemoryUsage(&conv->_tailConvolver);
+	for (int i = 0; i < 2; i++)
+		bytes += ((conv->_tailOutput0[i] != 0) * 2 + (conv->_tailOutput[i] != 0) * 3 + (conv->_tailInput[i] != 0)) * conv->_tailBlockSize * sizeof(float);
+	return bytes;
+}
+// The floor is shared by all three convolvers, partitions of every block size are compared by mean power
+void TwoStageFFTConvolver2x4x2SkipPartitions(TwoStageFFTConvolver2x4x2 *conv, float thresholdDb, FFTConvolverSkipStats *stats)
+{
+	const double head = FFTConvolver2x4x2PartitionPowerMax(&conv->_headConvolver);
+	const double tail0 = FFTConvolver2x4x2PartitionPowerMax(&conv->_tailConvolver0);
+	const double tail = FFTConvolver2x4x2PartitionPowerMax(&conv->_tailConvolver);
+	const double peak = head > tail0 ? (head > tail ? head : tail) : (tail0 > tail ? tail0 : tail);
+	const double floor = peak * pow(10.0, thresholdDb * 0.1);
+	FFTConvolver2x4x2SkipPartitions(&conv->_headConvolver, floor, stats);
+	FFTConvolver2x4x2SkipPartitions(&conv->_tailConvolver0, floor, stats);
+	FFTConvolver2x4x2SkipPartitions(&conv->_tailConvolver, floor, stats);
+}
+void TwoStageFFTConvolver2x2SkipPartitions(TwoStageFFTConvolver2x2 *conv, float thresholdDb, FFTConvolverSkipStats *stats)
+{
+	const double head = FFTConvolver2x2PartitionPowerMax(&conv->_headConvolver);
+	const double tail0 = FFTConvolver2x2PartitionPowerMax(&conv->_tailConvolver0);
+	const double tail = FFTConvolver2x2PartitionPowerMax(&conv->_tailConvolver);
+	const double peak = head > tail0 ? (head > tail ? head : tail) : (tail0 > tail ? tail0 : tail);
+	const double floor = peak * pow(10.0, thresholdDb * 0.1);
+	FFTConvolver2x2SkipPartitions(&conv->_headConvolver, floor, stats);
+	FFTConvolver2x2SkipPartitions(&conv->_tailConvolver0, floor, stats);
+	FFTConvolver2x2SkipPartitions(&conv->_tailConvolver, floor, stats);
+}
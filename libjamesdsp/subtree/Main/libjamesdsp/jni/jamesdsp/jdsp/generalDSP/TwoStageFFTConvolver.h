@@ -4,22 +4,10 @@
 #include "../Effects/eel2/numericSys/FFTConvolver.h"
 #define THREAD
 #ifdef THREAD
-#include "../Effects/eel2/cpthread.h"
-enum pt_state
-{
-	NOTHING,
-	SETUP,
-	IDLE,
-	WORKING,
-	GET_OFF_FROM_WORK
-};
+#include "ConvolverWorkerPool.h"
 typedef struct
 {
-	enum pt_state state;
-	pthread_cond_t work_cond;
-	pthread_mutex_t work_mtx;
-	pthread_cond_t boss_cond;
-	pthread_mutex_t boss_mtx;
+	ConvolverPoolTask task;
 	FFTConvolver1x1 *_tailConvolver;
 	float *_backgroundProcessingInput;
 	float *_tailOutput;
@@ -27,11 +15,7 @@ typedef struct
 } pt_info;
 typedef struct
 {
-	enum pt_state state;
-	pthread_cond_t work_cond;
-	pthread_mutex_t work_mtx;
-	pthread_cond_t boss_cond;
-	pthread_mutex_t boss_mtx;
+	ConvolverPoolTask task;
 	FFTConvolver2x4x2 *_tailConvolver;
 	float *_backgroundProcessingInput[2];
 	float *_tailOutput[2];
@@ -39,11 +23,7 @@ typedef struct
 } pt_info2x4x2;
 typedef struct
 {
-	enum pt_state state;
-	pthread_cond_t work_cond;
-	pthread_mutex_t work_mtx;
-	pthread_cond_t boss_cond;
-	pthread_mutex_t boss_mtx;
+	ConvolverPoolTask task;
 	FFTConvolver2x2 *_tailConvolver;
 	float *_backgroundProcessingInput[2];
 	float *_tailOutput[2];
@@ -51,16 +31,15 @@ typedef struct
 } pt_info2x2;
 typedef struct
 {
-	enum pt_state state;
-	pthread_cond_t work_cond;
-	pthread_mutex_t work_mtx;
-	pthread_cond_t boss_cond;
-	pthread_mutex_t boss_mtx;
+	ConvolverPoolTask task;
 	FFTConvolver1x2 *_tailConvolver;
 	float *_backgroundProcessingInput;
 	float *_tailOutput[2];
 	unsigned int _tailBlockSize;
 } pt_info1x2;
+// Pool jobs, each runs one block of the tail convolver its pt_info points to
+extern void task_type22x4x2(void *arg);
+extern void task_type22x2(void *arg);
 #endif
 typedef struct
 {
@@ -78,8 +57,6 @@ typedef struct
 	unsigned int _tailInputFill;
 	unsigned int _precalculatedPos;
 #ifdef THREAD
-	// Thread
-	pthread_t threads;
 	pt_info shared_info;
 #endif
 } TwoStageFFTConvolver1x1;
@@ -99,8 +76,6 @@ typedef struct
 	unsigned int _tailInputFill;
 	unsigned int _precalculatedPos;
 #ifdef THREAD
-	// Thread
-	pthread_t threads;
 	pt_info2x4x2 shared_info;
 #endif
 } TwoStageFFTConvolver2x4x2;
@@ -120,8 +95,6 @@ typedef struct
 	unsigned int _tailInputFill;
 	unsigned int _precalculatedPos;
 #ifdef THREAD
-	// Thread
-	pthread_t threads;
 	pt_info2x2 shared_info;
 #endif
 } TwoStageFFTConvolver2x2;
@@ -141,8 +114,6 @@ typedef struct
 	unsigned int _tailInputFill;
 	unsigned int _precalculatedPos;
 #ifdef THREAD
-	// Thread
-	pthread_t threads;
 	pt_info1x2 shared_info;
 #endif
 } TwoStageFFTConvolver1x2;
@@ -205,4 +176,17 @@ extern void TwoStageFFTConvolver1x1Free(TwoStageFFTConvolver1x1 *conv);
 extern void TwoStageFFTConvolver2x4x2Free(TwoStageFFTConvolver2x4x2 *conv);
 extern void TwoStageFFTConvolver2x2Free(TwoStageFFTConvolver2x2 *conv);
 extern void TwoStageFFTConvolver1x2Free(TwoStageFFTConvolver1x2 *conv);
+
+/**
+* @brief Heap owned by the head and tail convolvers and the tail buffers, in bytes
+*/
+extern size_t TwoStageFFTConvolver2x4x2MemoryUsage(TwoStageFFTConvolver2x4x2 *conv);
+extern size_t TwoStageFFTConvolver2x2MemoryUsage(TwoStageFFTConvolver2x2 *conv);
+
+/**
+* @brief Stops multiplying partitions at least thresholdDb below the loudest one, in mean power
+* Not while processing, see FFTConvolver2x2SkipPartitions
+*/
+extern void TwoStageFFTConvolver2x4x2SkipPartitions(TwoStageFFTConvolver2x4x2 *conv, float thresholdDb, FFTConvolverSkipStats *stats);
+extern void TwoStageFFTConvolver2x2SkipPartitions(TwoStageFFTConvolver2x2 *conv, float thresholdDb, FFTConvolverSkipStats *stats);
 #endif
@@ -0,0 +1,970 @@
+#include <stdint.h>
+#include <string.h>
+#include "sampleConv.h"
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define JSAMPLE_X86
+#include <immintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define JSAMPLE_ARM
+#include <arm_neon.h>
+#endif
+// Per sample reference, the vector kernels below reproduce these exactly
+// float to int16 goes through 384.0f, at that exponent the low mantissa bits hold the sample rounded to nearest even
+#define S16_OFFSET (384.0f)
+#define S16_ZERO (0x43c00000)
+#define S16_LIMNEG (S16_ZERO - 32768)
+#define S16_LIMPOS (S16_ZERO + 32767)
+#define P24_LIMPOS (8388607.0f / 8388608.0f)
+static inline int16_t s16FromFloat(float f)
+{
+	union {
+		float f;
+		int32_t i;
+	} u;
+	u.f = f + S16_OFFSET;
+	if (u.i < S16_LIMNEG)
+		return -32768;
+	else if (u.i > S16_LIMPOS)
+		return 32767;
+	return (int16_t)(u.i - S16_ZERO);
+}
+static inline int32_t roundFromScaled(float f)
+{
+	return (int32_t)(f > 0 ? f + 0.5f : f - 0.5f);
+}
+static inline int32_t s32FromFloat(float x)
+{
+	if (x <= -1.0f)
+		return INT32_MIN;
+	else if (x >= 1.0f)
+		return INT32_MAX;
+	return roundFromScaled(x * 2147483648.0f);
+}
+static inline int32_t s24FromFloat(float x)
+{
+	if (x <= -1.0f)
+		return -0x800000;
+	else if (x >= P24_LIMPOS)
+		return 0x7fffff;
+	return roundFromScaled(x * 8388608.0f);
+}
+// Packed 24 bit sample placed in the top 24 bits of an int32
+static inline int32_t p24Load(const uint8_t *p)
+{
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+	return (int32_t)(((uint32_t)p[2] << 8) | ((uint32_t)p[1] << 16) | ((uint32_t)p[0] << 24));
+#else
+	return (int32_t)(((uint32_t)p[0] << 8) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 24));
+#endif
+}
+static inline void p24Store(int32_t v, uint8_t *p)
+{
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+	p[0] = (uint8_t)(v >> 16);
+	p[1] = (uint8_t)(v >> 8);
+	p[2] = (uint8_t)v;
+#else
+	p[0] = (uint8_t)v;
+	p[1] = (uint8_t)(v >> 8);
+	p[2] = (uint8_t)(v >> 16);
+#endif
+}
+#define P24_SCALE (1.0f / 2147483648.0f)
+#define S16_SCALE (1.0f / 32768.0f)
+// Scalar
+static void s16ToFloatScalar(const int16_t *x1, const int16_t *x2, float *y1, float *y2, size_t n)
+{
+	for (size_t i = 0; i < n; i++)
+	{
+		y1[i] = x1[i] * S16_SCALE;
+		y2[i] = x2[i] * S16_SCALE;
+	}
+}
+static void s16iToFloatScalar(const int16_t *x, float *y1, float *y2, size_t n)
+{
+	for (size_t i = 0; i < n; i++)
+	{
+		y1[i] = x[i << 1] * S16_SCALE;
+		y2[i] = x[(i << 1) + 1] * S16_SCALE;
+	}
+}
+static void floatToS16Scalar(const float *x1, const float *x2, int16_t *y1, int16_t *y2, size_t n)
+{
+	for (size_t i = 0; i < n; i++)
+	{
+		y1[i] = s16FromFloat(x1[i]);
+		y2[i] = s16FromFloat(x2[i]);
+	}
+}
+static void floatToS16iScalar(const float *x1, const float *x2, int16_t *y, size_t n)
+{
+	for (size_t i = 0; i < n; i++)
+	{
+		y[i << 1] = s16FromFloat(x1[i]);
+		y[(i << 1) + 1] = s16FromFloat(x2[i]);
+	}
+}
+static void s32ToFloatScalar(const int32_t *x1, const int32_t *x2, float *y1, float *y2, size_t n, float scale)
+{
+	for (size_t i = 0; i < n; i++)
+	{
+		y1[i] = (float)x1[i] * scale;
+		y2[i] = (float)x2[i] * scale;
+	}
+}
+static void s32iToFloatScalar(const int32_t *x, float *y1, float *y2, size_t n, float scale)
+{
+	for (size_t i = 0; i < n; i++)
+	{
+		y1[i] = (float)x[i << 1] * scale;
+		y2[i] = (float)x[(i << 1) + 1] * scale;
+	}
+}
+static void floatToS32Scalar(const float *x1, const float *x2, int32_t *y1, int32_t *y2, size_t n)
+{
+	for (size_t i = 0; i < n; i++)
+	{
+		y1[i] = s32FromFloat(x1[i]);
+		y2[i] = s32FromFloat(x2[i]);
+	}
+}
+static void floatToS32iScalar(const float *x1, const float *x2, int32_t *y, size_t n)
+{
+	for (size_t i = 0; i < n; i++)
+	{
+		y[i << 1] = s32FromFloat(x1[i]);
+		y[(i << 1) + 1] = s32FromFloat(x2[i]);
+	}
+}
+static void floatToS8_24Scalar(const float *x1, const float *x2, int32_t *y1, int32_t *y2, size_t n)
+{
+	for (size_t i = 0; i < n; i++)
+	{
+		y1[i] = roundFromScaled(x1[i] * 8388608.0f);
+		y2[i] = roundFromScaled(x2[i] * 8388608.0f);
+	}
+}
+static void floatToS8_24iScalar(const float *x1, const float *x2, int32_t *y, size_t n)
+{
+	for (size_t i = 0; i < n; i++)
+	{
+		y[i << 1] = roundFromScaled(x1[i] * 8388608.0f);
+		y[(i << 1) + 1] = roundFromScaled(x2[i] * 8388608.0f);
+	}
+}
+static void p24ToFloatScalar(const uint8_t *x1, const uint8_t *x2, float *y1, float *y2, size_t n)
+{
+	for (size_t i = 0; i < n; i++)
+	{
+		y1[i] = p24Load(x1 + i * 3) * P24_SCALE;
+		y2[i] = p24Load(x2 + i * 3) * P24_SCALE;
+	}
+}
+static void p24iToFloatScalar(const uint8_t *x, float *y1, float *y2, size_t n)
+{
+	for (size_t i = 0; i < n; i++)
+	{
+		y1[i] = p24Load(x + (i << 1) * 3) * P24_SCALE;
+		y2[i] = p24Load(x + ((i << 1) + 1) * 3) * P24_SCALE;
+	}
+}
+static void floatToP24Scalar(const float *x1, const float *x2, uint8_t *y1, uint8_t *y2, size_t n)
+{
+	for (size_t i = 0; i < n; i++)
+	{
+		p24Store(s24FromFloat(x1[i]), y1 + i * 3);
+		p24Store(s24FromFloat(x2[i]), y2 + i * 3);
+	}
+}
+static void floatToP24iScalar(const float *x1, const float *x2, uint8_t *y, size_t n)
+{
+	for (size_t i = 0; i < n; i++)
+	{
+		p24Store(s24FromFloat(x1[i]), y + (i << 1) * 3);
+		p24Store(s24FromFloat(x2[i]), y + ((i << 1) + 1) * 3);
+	}
+}
+static void floatDeinterleaveScalar(const float *x, float *y1, float *y2, size_t n)
+{
+	for (size_t i = 0; i < n; i++)
+	{
+		y1[i] = x[i << 1];
+		y2[i] = x[(i << 1) + 1];
+	}
+}
+static void floatInterleaveScalar(const float *x1, const float *x2, float *y, size_t n)
+{
+	for (size_t i = 0; i < n; i++)
+	{
+		y[i << 1] = x1[i];
+		y[(i << 1) + 1] = x2[i];
+	}
+}
+static const JSampleKernels kernelsScalar =
+{
+	JSAMPLE_SCALAR, "scalar",
+	s16ToFloatScalar, s16iToFloatScalar, floatToS16Scalar, floatToS16iScalar,
+	s32ToFloatScalar, s32iToFloatScalar, floatToS32Scalar, floatToS32iScalar, floatToS8_24Scalar, floatToS8_24iScalar,
+	p24ToFloatScalar, p24iToFloatScalar, floatToP24Scalar, floatToP24iScalar,
+	floatDeinterleaveScalar, floatInterleaveScalar
+};
+#ifdef JSAMPLE_X86
+// SSE2
+#define SSE2_FN __attribute__((target("sse2")))
+static inline SSE2_FN __m128i sse2Blend(__m128i a, __m128i b, __m128i mask)
+{
+	return _mm_or_si128(_mm_andnot_si128(mask, a), _mm_and_si128(mask, b));
+}
+static inline SSE2_FN __m128i sse2S16FromFloat(__m128 x)
+{
+	__m128i u = _mm_castps_si128(_mm_add_ps(x, _mm_set1_ps(S16_OFFSET)));
+	u = sse2Blend(u, _mm_set1_epi32(S16_LIMNEG), _mm_cmplt_epi32(u, _mm_set1_epi32(S16_LIMNEG)));
+	u = sse2Blend(u, _mm_set1_epi32(S16_LIMPOS), _mm_cmpgt_epi32(u, _mm_set1_epi32(S16_LIMPOS)));
+	return _mm_sub_epi32(u, _mm_set1_epi32(S16_ZERO));
+}
+// Truncation after adding 0.5 with the sign of f, as roundFromScaled
+static inline SSE2_FN __m128i sse2RoundFromScaled(__m128 f)
+{
+	__m128 half = _mm_or_ps(_mm_set1_ps(0.5f), _mm_and_ps(f, _mm_set1_ps(-0.0f)));
+	return _mm_cvttps_epi32(_mm_add_ps(f, half));
+}
+static inline SSE2_FN __m128i sse2S32FromFloat(__m128 x)
+{
+	__m128i r = sse2RoundFromScaled(_mm_mul_ps(x, _mm_set1_ps(2147483648.0f)));
+	r = sse2Blend(r, _mm_set1_epi32(INT32_MAX), _mm_castps_si128(_mm_cmpge_ps(x, _mm_set1_ps(1.0f))));
+	return sse2Blend(r, _mm_set1_epi32(INT32_MIN), _mm_castps_si128(_mm_cmple_ps(x, _mm_set1_ps(-1.0f))));
+}
+static SSE2_FN void s16ToFloatSSE2(const int16_t *x1, const int16_t *x2, float *y1, float *y2, size_t n)
+{
+	const __m128 scale = _mm_set1_ps(S16_SCALE);
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8)
+	{
+		__m128i a = _mm_loadu_si128((const __m128i *)(x1 + i));
+		__m128i b = _mm_loadu_si128((const __m128i *)(x2 + i));
+		_mm_storeu_ps(y1 + i, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(a, a), 16)), scale));
+		_mm_storeu_ps(y1 + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(a, a), 16)), scale));
+		_mm_storeu_ps(y2 + i, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(b, b), 16)), scale));
+		_mm_storeu_ps(y2 + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(b, b), 16)), scale));
+	}
+	s16ToFloatScalar(x1 + i, x2 + i, y1 + i, y2 + i, n - i);
+}
+static SSE2_FN void s16iToFloatSSE2(const int16_t *x, float *y1, float *y2, size_t n)
+{
+	const __m128 scale = _mm_set1_ps(S16_SCALE);
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		__m128i v = _mm_loadu_si128((const __m128i *)(x + (i << 1)));
+		_mm_storeu_ps(y1 + i, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_slli_epi32(v, 16), 16)), scale));
+		_mm_storeu_ps(y2 + i, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(v, 16)), scale));
+	}
+	s16iToFloatScalar(x + (i << 1), y1 + i, y2 + i, n - i);
+}
+static SSE2_FN void floatToS16SSE2(const float *x1, const float *x2, int16_t *y1, int16_t *y2, size_t n)
+{
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8)
+	{
+		_mm_storeu_si128((__m128i *)(y1 + i), _mm_packs_epi32(sse2S16FromFloat(_mm_loadu_ps(x1 + i)), sse2S16FromFloat(_mm_loadu_ps(x1 + i + 4))));
+		_mm_storeu_si128((__m128i *)(y2 + i), _mm_packs_epi32(sse2S16FromFloat(_mm_loadu_ps(x2 + i)), sse2S16FromFloat(_mm_loadu_ps(x2 + i + 4))));
+	}
+	floatToS16Scalar(x1 + i, x2 + i, y1 + i, y2 + i, n - i);
+}
+static SSE2_FN void floatToS16iSSE2(const float *x1, const float *x2, int16_t *y, size_t n)
+{
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		// Both results are already in int16 range, one frame per 32 bit lane
+		__m128i l = sse2S16FromFloat(_mm_loadu_ps(x1 + i));
+		__m128i r = sse2S16FromFloat(_mm_loadu_ps(x2 + i));
+		__m128i v = _mm_or_si128(_mm_and_si128(l, _mm_set1_epi32(0xffff)), _mm_slli_epi32(r, 16));
+		_mm_storeu_si128((__m128i *)(y + (i << 1)), v);
+	}
+	floatToS16iScalar(x1 + i, x2 + i, y + (i << 1), n - i);
+}
+static SSE2_FN void s32ToFloatSSE2(const int32_t *x1, const int32_t *x2, float *y1, float *y2, size_t n, float scale)
+{
+	const __m128 s = _mm_set1_ps(scale);
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		_mm_storeu_ps(y1 + i, _mm_mul_ps(_mm_cvtepi32_ps(_mm_loadu_si128((const __m128i *)(x1 + i))), s));
+		_mm_storeu_ps(y2 + i, _mm_mul_ps(_mm_cvtepi32_ps(_mm_loadu_si128((const __m128i *)(x2 + i))), s));
+	}
+	s32ToFloatScalar(x1 + i, x2 + i, y1 + i, y2 + i, n - i, scale);
+}
+static SSE2_FN void s32iToFloatSSE2(const int32_t *x, float *y1, float *y2, size_t n, float scale)
+{
+	const __m128 s = _mm_set1_ps(scale);
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		__m128 a = _mm_cvtepi32_ps(_mm_loadu_si128((const __m128i *)(x + (i << 1))));
+		__m128 b = _mm_cvtepi32_ps(_mm_loadu_si128((const __m128i *)(x + (i << 1) + 4)));
+		_mm_storeu_ps(y1 + i, _mm_mul_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)), s));
+		_mm_storeu_ps(y2 + i, _mm_mul_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)), s));
+	}
+	s32iToFloatScalar(x + (i << 1), y1 + i, y2 + i, n - i, scale);
+}
+static SSE2_FN void floatToS32SSE2(const float *x1, const float *x2, int32_t *y1, int32_t *y2, size_t n)
+{
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		_mm_storeu_si128((__m128i *)(y1 + i), sse2S32FromFloat(_mm_loadu_ps(x1 + i)));
+		_mm_storeu_si128((__m128i *)(y2 + i), sse2S32FromFloat(_mm_loadu_ps(x2 + i)));
+	}
+	floatToS32Scalar(x1 + i, x2 + i, y1 + i, y2 + i, n - i);
+}
+static SSE2_FN void floatToS32iSSE2(const float *x1, const float *x2, int32_t *y, size_t n)
+{
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		__m128i l = sse2S32FromFloat(_mm_loadu_ps(x1 + i));
+		__m128i r = sse2S32FromFloat(_mm_loadu_ps(x2 + i));
+		_mm_storeu_si128((__m128i *)(y + (i << 1)), _mm_unpacklo_epi32(l, r));
+		_mm_storeu_si128((__m128i *)(y + (i << 1) + 4), _mm_unpackhi_epi32(l, r));
+	}
+	floatToS32iScalar(x1 + i, x2 + i, y + (i << 1), n - i);
+}
+static SSE2_FN void floatToS8_24SSE2(const float *x1, const float *x2, int32_t *y1, int32_t *y2, size_t n)
+{
+	const __m128 s = _mm_set1_ps(8388608.0f);
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		_mm_storeu_si128((__m128i *)(y1 + i), sse2RoundFromScaled(_mm_mul_ps(_mm_loadu_ps(x1 + i), s)));
+		_mm_storeu_si128((__m128i *)(y2 + i), sse2RoundFromScaled(_mm_mul_ps(_mm_loadu_ps(x2 + i), s)));
+	}
+	floatToS8_24Scalar(x1 + i, x2 + i, y1 + i, y2 + i, n - i);
+}
+static SSE2_FN void floatToS8_24iSSE2(const float *x1, const float *x2, int32_t *y, size_t n)
+{
+	const __m128 s = _mm_set1_ps(8388608.0f);
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		__m128i l = sse2RoundFromScaled(_mm_mul_ps(_mm_loadu_ps(x1 + i), s));
+		__m128i r = sse2RoundFromScaled(_mm_mul_ps(_mm_loadu_ps(x2 + i), s));
+		_mm_storeu_si128((__m128i *)(y + (i << 1)), _mm_unpacklo_epi32(l, r));
+		_mm_storeu_si128((__m128i *)(y + (i << 1) + 4), _mm_unpackhi_epi32(l, r));
+	}
+	floatToS8_24iScalar(x1 + i, x2 + i, y + (i << 1), n - i);
+}
+static SSE2_FN void floatDeinterleaveSSE2(const float *x, float *y1, float *y2, size_t n)
+{
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		__m128 a = _mm_loadu_ps(x + (i << 1));
+		__m128 b = _mm_loadu_ps(x + (i << 1) + 4);
+		_mm_storeu_ps(y1 + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+		_mm_storeu_ps(y2 + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+	}
+	floatDeinterleaveScalar(x + (i << 1), y1 + i, y2 + i, n - i);
+}
+static SSE2_FN void floatInterleaveSSE2(const float *x1, const float *x2, float *y, size_t n)
+{
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		__m128 l = _mm_loadu_ps(x1 + i);
+		__m128 r = _mm_loadu_ps(x2 + i);
+		_mm_storeu_ps(y + (i << 1), _mm_unpacklo_ps(l, r));
+		_mm_storeu_ps(y + (i << 1) + 4, _mm_unpackhi_ps(l, r));
+	}
+	floatInterleaveScalar(x1 + i, x2 + i, y + (i << 1), n - i);
+}
+static const JSampleKernels kernelsSSE2 =
+{
+	JSAMPLE_SSE2, "sse2",
+	s16ToFloatSSE2, s16iToFloatSSE2, floatToS16SSE2, floatToS16iSSE2,
+	s32ToFloatSSE2, s32iToFloatSSE2, floatToS32SSE2, floatToS32iSSE2, floatToS8_24SSE2, floatToS8_24iSSE2,
+	p24ToFloatScalar, p24iToFloatScalar, floatToP24Scalar, floatToP24iScalar, // Byte shuffles need SSSE3, see the AVX2 set
+	floatDeinterleaveSSE2, floatInterleaveSSE2
+};
+// AVX2
+#define AVX2_FN __attribute__((target("avx2")))
+static inline AVX2_FN __m256i avx2S16FromFloat(__m256 x)
+{
+	__m256i u = _mm256_castps_si256(_mm256_add_ps(x, _mm256_set1_ps(S16_OFFSET)));
+	u = _mm256_min_epi32(_mm256_max_epi32(u, _mm256_set1_epi32(S16_LIMNEG)), _mm256_set1_epi32(S16_LIMPOS));
+	return _mm256_sub_epi32(u, _mm256_set1_epi32(S16_ZERO));
+}
+static inline AVX2_FN __m256i avx2RoundFromScaled(__m256 f)
+{
+	__m256 half = _mm256_or_ps(_mm256_set1_ps(0.5f), _mm256_and_ps(f, _mm256_set1_ps(-0.0f)));
+	return _mm256_cvttps_epi32(_mm256_add_ps(f, half));
+}
+static inline AVX2_FN __m256i avx2S32FromFloat(__m256 x)
+{
+	__m256i r = avx2RoundFromScaled(_mm256_mul_ps(x, _mm256_set1_ps(2147483648.0f)));
+	r = _mm256_blendv_epi8(r, _mm256_set1_epi32(INT32_MAX), _mm256_castps_si256(_mm256_cmp_ps(x, _mm256_set1_ps(1.0f), _CMP_GE_OQ)));
+	return _mm256_blendv_epi8(r, _mm256_set1_epi32(INT32_MIN), _mm256_castps_si256(_mm256_cmp_ps(x, _mm256_set1_ps(-1.0f), _CMP_LE_OQ)));
+}
+// Frames in 32 bit lanes to interleaved stereo, lane order is kept
+static inline AVX2_FN void avx2StoreInterleaved(int32_t *y, __m256i l, __m256i r)
+{
+	__m256i lo = _mm256_unpacklo_epi32(l, r);
+	__m256i hi = _mm256_unpackhi_epi32(l, r);
+	_mm256_storeu_si256((__m256i *)y, _mm256_permute2x128_si256(lo, hi, 0x20));
+	_mm256_storeu_si256((__m256i *)(y + 8), _mm256_permute2x128_si256(lo, hi, 0x31));
+}
+static inline AVX2_FN void avx2LoadDeinterleaved(const float *x, __m256 *l, __m256 *r)
+{
+	__m256 a = _mm256_loadu_ps(x);
+	__m256 b = _mm256_loadu_ps(x + 8);
+	*l = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0))), _MM_SHUFFLE(3, 1, 2, 0)));
+	*r = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1))), _MM_SHUFFLE(3, 1, 2, 0)));
+}
+static AVX2_FN void s16ToFloatAVX2(const int16_t *x1, const int16_t *x2, float *y1, float *y2, size_t n)
+{
+	const __m256 scale = _mm256_set1_ps(S16_SCALE);
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8)
+	{
+		_mm256_storeu_ps(y1 + i, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *)(x1 + i)))), scale));
+		_mm256_storeu_ps(y2 + i, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *)(x2 + i)))), scale));
+	}
+	s16ToFloatScalar(x1 + i, x2 + i, y1 + i, y2 + i, n - i);
+}
+static AVX2_FN void s16iToFloatAVX2(const int16_t *x, float *y1, float *y2, size_t n)
+{
+	const __m256 scale = _mm256_set1_ps(S16_SCALE);
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8)
+	{
+		__m256i v = _mm256_loadu_si256((const __m256i *)(x + (i << 1)));
+		_mm256_storeu_ps(y1 + i, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srai_epi32(_mm256_slli_epi32(v, 16), 16)), scale));
+		_mm256_storeu_ps(y2 + i, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srai_epi32(v, 16)), scale));
+	}
+	s16iToFloatScalar(x + (i << 1), y1 + i, y2 + i, n - i);
+}
+static AVX2_FN void floatToS16AVX2(const float *x1, const float *x2, int16_t *y1, int16_t *y2, size_t n)
+{
+	size_t i = 0;
+	for (; i + 16 <= n; i += 16)
+	{
+		__m256i a = _mm256_packs_epi32(avx2S16FromFloat(_mm256_loadu_ps(x1 + i)), avx2S16FromFloat(_mm256_loadu_ps(x1 + i + 8)));
+		__m256i b = _mm256_packs_epi32(avx2S16FromFloat(_mm256_loadu_ps(x2 + i)), avx2S16FromFloat(_mm256_loadu_ps(x2 + i + 8)));
+		_mm256_storeu_si256((__m256i *)(y1 + i), _mm256_permute4x64_epi64(a, _MM_SHUFFLE(3, 1, 2, 0)));
+		_mm256_storeu_si256((__m256i *)(y2 + i), _mm256_permute4x64_epi64(b, _MM_SHUFFLE(3, 1, 2, 0)));
+	}
+	floatToS16SSE2(x1 + i, x2 + i, y1 + i, y2 + i, n - i);
+}
+static AVX2_FN void floatToS16iAVX2(const float *x1, const float *x2, int16_t *y, size_t n)
+{
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8)
+	{
+		__m256i l = avx2S16FromFloat(_mm256_loadu_ps(x1 + i));
+		__m256i r = avx2S16FromFloat(_mm256_loadu_ps(x2 + i));
+		__m256i v = _mm256_or_si256(_mm256_and_si256(l, _mm256_set1_epi32(0xffff)), _mm256_slli_epi32(r, 16));
+		_mm256_storeu_si256((__m256i *)(y + (i << 1)), v);
+	}
+	floatToS16iSSE2(x1 + i, x2 + i, y + (i << 1), n - i);
+}
+static AVX2_FN void s32ToFloatAVX2(const int32_t *x1, const int32_t *x2, float *y1, float *y2, size_t n, float scale)
+{
+	const __m256 s = _mm256_set1_ps(scale);
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8)
+	{
+		_mm256_storeu_ps(y1 + i, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_loadu_si256((const __m256i *)(x1 + i))), s));
+		_mm256_storeu_ps(y2 + i, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_loadu_si256((const __m256i *)(x2 + i))), s));
+	}
+	s32ToFloatScalar(x1 + i, x2 + i, y1 + i, y2 + i, n - i, scale);
+}
+static AVX2_FN void s32iToFloatAVX2(const int32_t *x, float *y1, float *y2, size_t n, float scale)
+{
+	const __m256 s = _mm256_set1_ps(scale);
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8)
+	{
+		__m256 l, r;
+		avx2LoadDeinterleaved((const float *)(x + (i << 1)), &l, &r);
+		_mm256_storeu_ps(y1 + i, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_castps_si256(l)), s));
+		_mm256_storeu_ps(y2 + i, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_castps_si256(r)), s));
+	}
+	s32iToFloatScalar(x + (i << 1), y1 + i, y2 + i, n - i, scale);
+}
+static AVX2_FN void floatToS32AVX2(const float *x1, const float *x2, int32_t *y1, int32_t *y2, size_t n)
+{
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8)
+	{
+		_mm256_storeu_si256((__m256i *)(y1 + i), avx2S32FromFloat(_mm256_loadu_ps(x1 + i)));
+		_mm256_storeu_si256((__m256i *)(y2 + i), avx2S32FromFloat(_mm256_loadu_ps(x2 + i)));
+	}
+	floatToS32Scalar(x1 + i, x2 + i, y1 + i, y2 + i, n - i);
+}
+static AVX2_FN void floatToS32iAVX2(const float *x1, const float *x2, int32_t *y, size_t n)
+{
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8)
+		avx2StoreInterleaved(y + (i << 1), avx2S32FromFloat(_mm256_loadu_ps(x1 + i)), avx2S32FromFloat(_mm256_loadu_ps(x2 + i)));
+	floatToS32iScalar(x1 + i, x2 + i, y + (i << 1), n - i);
+}
+static AVX2_FN void floatToS8_24AVX2(const float *x1, const float *x2, int32_t *y1, int32_t *y2, size_t n)
+{
+	const __m256 s = _mm256_set1_ps(8388608.0f);
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8)
+	{
+		_mm256_storeu_si256((__m256i *)(y1 + i), avx2RoundFromScaled(_mm256_mul_ps(_mm256_loadu_ps(x1 + i), s)));
+		_mm256_storeu_si256((__m256i *)(y2 + i), avx2RoundFromScaled(_mm256_mul_ps(_mm256_loadu_ps(x2 + i), s)));
+	}
+	floatToS8_24Scalar(x1 + i, x2 + i, y1 + i, y2 + i, n - i);
+}
+static AVX2_FN void floatToS8_24iAVX2(const float *x1, const float *x2, int32_t *y, size_t n)
+{
+	const __m256 s = _mm256_set1_ps(8388608.0f);
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8)
+		avx2StoreInterleaved(y + (i << 1), avx2RoundFromScaled(_mm256_mul_ps(_mm256_loadu_ps(x1 + i), s)), avx2RoundFromScaled(_mm256_mul_ps(_mm256_loadu_ps(x2 + i), s)));
+	floatToS8_24iScalar(x1 + i, x2 + i, y + (i << 1), n - i);
+}
+// Packed 24 bit, four samples per 128 bit lane, 12 bytes in or out
+// Loads read and stores write 4 bytes past the 12, loops stop early enough to stay inside the buffers
+static inline AVX2_FN __m128i p24Unpack4(const uint8_t *p)
+{
+	const __m128i shuf = _mm_setr_epi8(-1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11);
+	return _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)p), shuf);
+}
+static inline AVX2_FN void p24Pack4(__m128i v, uint8_t *p)
+{
+	const __m128i shuf = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+	_mm_storeu_si128((__m128i *)p, _mm_shuffle_epi8(v, shuf));
+}
+static inline AVX2_FN __m128i p24FromFloat4(__m128 x)
+{
+	__m128 f = _mm_mul_ps(x, _mm_set1_ps(8388608.0f));
+	__m128 half = _mm_or_ps(_mm_set1_ps(0.5f), _mm_and_ps(f, _mm_set1_ps(-0.0f)));
+	__m128i r = _mm_cvttps_epi32(_mm_add_ps(f, half));
+	r = _mm_blendv_epi8(r, _mm_set1_epi32(0x7fffff), _mm_castps_si128(_mm_cmpge_ps(x, _mm_set1_ps(P24_LIMPOS))));
+	return _mm_blendv_epi8(r, _mm_set1_epi32(-0x800000), _mm_castps_si128(_mm_cmple_ps(x, _mm_set1_ps(-1.0f))));
+}
+static AVX2_FN void p24ToFloatAVX2(const uint8_t *x1, const uint8_t *x2, float *y1, float *y2, size_t n)
+{
+	const __m128 scale = _mm_set1_ps(P24_SCALE);
+	size_t i = 0;
+	for (; i + 6 <= n; i += 4)
+	{
+		_mm_storeu_ps(y1 + i, _mm_mul_ps(_mm_cvtepi32_ps(p24Unpack4(x1 + i * 3)), scale));
+		_mm_storeu_ps(y2 + i, _mm_mul_ps(_mm_cvtepi32_ps(p24Unpack4(x2 + i * 3)), scale));
+	}
+	p24ToFloatScalar(x1 + i * 3, x2 + i * 3, y1 + i, y2 + i, n - i);
+}
+static AVX2_FN void p24iToFloatAVX2(const uint8_t *x, float *y1, float *y2, size_t n)
+{
+	const __m128 scale = _mm_set1_ps(P24_SCALE);
+	size_t i = 0;
+	for (; i + 5 <= n; i += 4)
+	{
+		__m128 a = _mm_cvtepi32_ps(p24Unpack4(x + i * 6));
+		__m128 b = _mm_cvtepi32_ps(p24Unpack4(x + i * 6 + 12));
+		_mm_storeu_ps(y1 + i, _mm_mul_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)), scale));
+		_mm_storeu_ps(y2 + i, _mm_mul_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)), scale));
+	}
+	p24iToFloatScalar(x + i * 6, y1 + i, y2 + i, n - i);
+}
+static AVX2_FN void floatToP24AVX2(const float *x1, const float *x2, uint8_t *y1, uint8_t *y2, size_t n)
+{
+	size_t i = 0;
+	for (; i + 6 <= n; i += 4)
+	{
+		p24Pack4(p24FromFloat4(_mm_loadu_ps(x1 + i)), y1 + i * 3);
+		p24Pack4(p24FromFloat4(_mm_loadu_ps(x2 + i)), y2 + i * 3);
+	}
+	floatToP24Scalar(x1 + i, x2 + i, y1 + i * 3, y2 + i * 3, n - i);
+}
+static AVX2_FN void floatToP24iAVX2(const float *x1, const float *x2, uint8_t *y, size_t n)
+{
+	size_t i = 0;
+	for (; i + 5 <= n; i += 4)
+	{
+		__m128i l = p24FromFloat4(_mm_loadu_ps(x1 + i));
+		__m128i r = p24FromFloat4(_mm_loadu_ps(x2 + i));
+		p24Pack4(_mm_unpacklo_epi32(l, r), y + i * 6);
+		p24Pack4(_mm_unpackhi_epi32(l, r), y + i * 6 + 12);
+	}
+	floatToP24iScalar(x1 + i, x2 + i, y + i * 6, n - i);
+}
+static AVX2_FN void floatDeinterleaveAVX2(const float *x, float *y1, float *y2, size_t n)
+{
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8)
+	{
+		__m256 l, r;
+		avx2LoadDeinterleaved(x + (i << 1), &l, &r);
+		_mm256_storeu_ps(y1 + i, l);
+		_mm256_storeu_ps(y2 + i, r);
+	}
+	floatDeinterleaveScalar(x + (i << 1), y1 + i, y2 + i, n - i);
+}
+static AVX2_FN void floatInterleaveAVX2(const float *x1, const float *x2, float *y, size_t n)
+{
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8)
+		avx2StoreInterleaved((int32_t *)(y + (i << 1)), _mm256_castps_si256(_mm256_loadu_ps(x1 + i)), _mm256_castps_si256(_mm256_loadu_ps(x2 + i)));
+	floatInterleaveScalar(x1 + i, x2 + i, y + (i << 1), n - i);
+}
+static const JSampleKernels kernelsAVX2 =
+{
+	JSAMPLE_AVX2, "avx2",
+	s16ToFloatAVX2, s16iToFloatAVX2, floatToS16AVX2, floatToS16iAVX2,
+	s32ToFloatAVX2, s32iToFloatAVX2, floatToS32AVX2, floatToS32iAVX2, floatToS8_24AVX2, floatToS8_24iAVX2,
+	p24ToFloatAVX2, p24iToFloatAVX2, floatToP24AVX2, floatToP24iAVX2,
+	floatDeinterleaveAVX2, floatInterleaveAVX2
+};
+// AVX-512
+#define AVX512_FN __attribute__((target("avx512f")))
+static inline AVX512_FN __m512i avx512S16FromFloat(__m512 x)
+{
+	__m512i u = _mm512_castps_si512(_mm512_add_ps(x, _mm512_set1_ps(S16_OFFSET)));
+	u = _mm512_min_epi32(_mm512_max_epi32(u, _mm512_set1_epi32(S16_LIMNEG)), _mm512_set1_epi32(S16_LIMPOS));
+	return _mm512_sub_epi32(u, _mm512_set1_epi32(S16_ZERO));
+}
+static inline AVX512_FN __m512i avx512RoundFromScaled(__m512 f)
+{
+	__m512i half = _mm512_or_si512(_mm512_set1_epi32(0x3f000000), _mm512_and_si512(_mm512_castps_si512(f), _mm512_set1_epi32(INT32_MIN)));
+	return _mm512_cvttps_epi32(_mm512_add_ps(f, _mm512_castsi512_ps(half)));
+}
+static inline AVX512_FN __m512i avx512S32FromFloat(__m512 x)
+{
+	__m512i r = avx512RoundFromScaled(_mm512_mul_ps(x, _mm512_set1_ps(2147483648.0f)));
+	r = _mm512_mask_mov_epi32(r, _mm512_cmp_ps_mask(x, _mm512_set1_ps(1.0f), _CMP_GE_OQ), _mm512_set1_epi32(INT32_MAX));
+	return _mm512_mask_mov_epi32(r, _mm512_cmp_ps_mask(x, _mm512_set1_ps(-1.0f), _CMP_LE_OQ), _mm512_set1_epi32(INT32_MIN));
+}
+static inline AVX512_FN void avx512StoreInterleaved(int32_t *y, __m512i l, __m512i r)
+{
+	const __m512i lo = _mm512_setr_epi32(0, 16, 1, 17, 2, 18, 3, 19, 4, 20, 5, 21, 6, 22, 7, 23);
+	const __m512i hi = _mm512_setr_epi32(8, 24, 9, 25, 10, 26, 11, 27, 12, 28, 13, 29, 14, 30, 15, 31);
+	_mm512_storeu_si512(y, _mm512_permutex2var_epi32(l, lo, r));
+	_mm512_storeu_si512(y + 16, _mm512_permutex2var_epi32(l, hi, r));
+}
+static inline AVX512_FN void avx512LoadDeinterleaved(const int32_t *x, __m512i *l, __m512i *r)
+{
+	const __m512i even = _mm512_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30);
+	const __m512i odd = _mm512_setr_epi32(1, 3, 5, 7, 9, 11, 13, 15, 17, 19, 21, 23, 25, 27, 29, 31);
+	__m512i a = _mm512_loadu_si512(x);
+	__m512i b = _mm512_loadu_si512(x + 16);
+	*l = _mm512_permutex2var_epi32(a, even, b);
+	*r = _mm512_permutex2var_epi32(a, odd, b);
+}
+static AVX512_FN void s16ToFloatAVX512(const int16_t *x1, const int16_t *x2, float *y1, float *y2, size_t n)
+{
+	const __m512 scale = _mm512_set1_ps(S16_SCALE);
+	size_t i = 0;
+	for (; i + 16 <= n; i += 16)
+	{
+		_mm512_storeu_ps(y1 + i, _mm512_mul_ps(_mm512_cvtepi32_ps(_mm512_cvtepi16_epi32(_mm256_loadu_si256((const __m256i *)(x1 + i)))), scale));
+		_mm512_storeu_ps(y2 + i, _mm512_mul_ps(_mm512_cvtepi32_ps(_mm512_cvtepi16_epi32(_mm256_loadu_si256((const __m256i *)(x2 + i)))), scale));
+	}
+	s16ToFloatAVX2(x1 + i, x2 + i, y1 + i, y2 + i, n - i);
+}
+static AVX512_FN void s16iToFloatAVX512(const int16_t *x, float *y1, float *y2, size_t n)
+{
+	const __m512 scale = _mm512_set1_ps(S16_SCALE);
+	size_t i = 0;
+	for (; i + 16 <= n; i += 16)
+	{
+		__m512i v = _mm512_loadu_si512(x + (i << 1));
+		_mm512_storeu_ps(y1 + i, _mm512_mul_ps(_mm512_cvtepi32_ps(_mm512_srai_epi32(_mm512_slli_epi32(v, 16), 16)), scale));
+		_mm512_storeu_ps(y2 + i, _mm512_mul_ps(_mm512_cvtepi32_ps(_mm512_srai_epi32(v, 16)), scale));
+	}
+	s16iToFloatAVX2(x + (i << 1), y1 + i, y2 + i, n - i);
+}
+static AVX512_FN void floatToS16AVX512(const float *x1, const float *x2, int16_t *y1, int16_t *y2, size_t n)
+{
+	size_t i = 0;
+	for (; i + 16 <= n; i += 16)
+	{
+		_mm256_storeu_si256((__m256i *)(y1 + i), _mm512_cvtepi32_epi16(avx512S16FromFloat(_mm512_loadu_ps(x1 + i))));
+		_mm256_storeu_si256((__m256i *)(y2 + i), _mm512_cvtepi32_epi16(avx512S16FromFloat(_mm512_loadu_ps(x2 + i))));
+	}
+	floatToS16AVX2(x1 + i, x2 + i, y1 + i, y2 + i, n - i);
+}
+static AVX512_FN void floatToS16iAVX512(const float *x1, const float *x2, int16_t *y, size_t n)
+{
+	size_t i = 0;
+	for (; i + 16 <= n; i += 16)
+	{
+		__m512i l = avx512S16FromFloat(_mm512_loadu_ps(x1 + i));
+		__m512i r = avx512S16FromFloat(_mm512_loadu_ps(x2 + i));
+		_mm512_storeu_si512(y + (i << 1), _mm512_or_si512(_mm512_and_si512(l, _mm512_set1_epi32(0xffff)), _mm512_slli_epi32(r, 16)));
+	}
+	floatToS16iAVX2(x1 + i, x2 + i, y + (i << 1), n - i);
+}
+static AVX512_FN void s32ToFloatAVX512(const int32_t *x1, const int32_t *x2, float *y1, float *y2, size_t n, float scale)
+{
+	const __m512 s = _mm512_set1_ps(scale);
+	size_t i = 0;
+	for (; i + 16 <= n; i += 16)
+	{
+		_mm512_storeu_ps(y1 + i, _mm512_mul_ps(_mm512_cvtepi32_ps(_mm512_loadu_si512(x1 + i)), s));
+		_mm512_storeu_ps(y2 + i, _mm512_mul_ps(_mm512_cvtepi32_ps(_mm512_loadu_si512(x2 + i)), s));
+	}
+	s32ToFloatAVX2(x1 + i, x2 + i, y1 + i, y2 + i, n - i, scale);
+}
+static AVX512_FN void s32iToFloatAVX512(const int32_t *x, float *y1, float *y2, size_t n, float scale)
+{
+	const __m512 s = _mm512_set1_ps(scale);
+	size_t i = 0;
+	for (; i + 16 <= n; i += 16)
+	{
+		__m512i l, r;
+		avx512LoadDeinterleaved(x + (i << 1), &l, &r);
+		_mm512_storeu_ps(y1 + i, _mm512_mul_ps(_mm512_cvtepi32_ps(l), s));
+		_mm512_storeu_ps(y2 + i, _mm512_mul_ps(_mm512_cvtepi32_ps(r), s));
+	}
+	s32iToFloatAVX2(x + (i << 1), y1 + i, y2 + i, n - i, scale);
+}
+static AVX512_FN void floatToS32AVX512(const float *x1, const float *x2, int32_t *y1, int32_t *y2, size_t n)
+{
+	size_t i = 0;
+	for (; i + 16 <= n; i += 16)
+	{
+		_mm512_storeu_si512(y1 + i, avx512S32FromFloat(_mm512_loadu_ps(x1 + i)));
+		_mm512_storeu_si512(y2 + i, avx512S32FromFloat(_mm512_loadu_ps(x2 + i)));
+	}
+	floatToS32AVX2(x1 + i, x2 + i, y1 + i, y2 + i, n - i);
+}
+static AVX512_FN void floatToS32iAVX512(const float *x1, const float *x2, int32_t *y, size_t n)
+{
+	size_t i = 0;
+	for (; i + 16 <= n; i += 16)
+		avx512StoreInterleaved(y + (i << 1), avx512S32FromFloat(_mm512_loadu_ps(x1 + i)), avx512S32FromFloat(_mm512_loadu_ps(x2 + i)));
+	floatToS32iAVX2(x1 + i, x2 + i, y + (i << 1), n - i);
+}
+static AVX512_FN void floatToS8_24AVX512(const float *x1, const float *x2, int32_t *y1, int32_t *y2, size_t n)
+{
+	const __m512 s = _mm512_set1_ps(8388608.0f);
+	size_t i = 0;
+	for (; i + 16 <= n; i += 16)
+	{
+		_mm512_storeu_si512(y1 + i, avx512RoundFromScaled(_mm512_mul_ps(_mm512_loadu_ps(x1 + i), s)));
+		_mm512_storeu_si512(y2 + i, avx512RoundFromScaled(_mm512_mul_ps(_mm512_loadu_ps(x2 + i), s)));
+	}
+	floatToS8_24AVX2(x1 + i, x2 + i, y1 + i, y2 + i, n - i);
+}
+static AVX512_FN void floatToS8_24iAVX512(const float *x1, const float *x2, int32_t *y, size_t n)
+{
+	const __m512 s = _mm512_set1_ps(8388608.0f);
+	size_t i = 0;
+	for (; i + 16 <= n; i += 16)
+		avx512StoreInterleaved(y + (i << 1), avx512RoundFromScaled(_mm512_mul_ps(_mm512_loadu_ps(x1 + i), s)), avx512RoundFromScaled(_mm512_mul_ps(_mm512_loadu_ps(x2 + i), s)));
+	floatToS8_24iAVX2(x1 + i, x2 + i, y + (i << 1), n - i);
+}
+static AVX512_FN void floatDeinterleaveAVX512(const float *x, float *y1, float *y2, size_t n)
+{
+	size_t i = 0;
+	for (; i + 16 <= n; i += 16)
+	{
+		__m512i l, r;
+		avx512LoadDeinterleaved((const int32_t *)(x + (i << 1)), &l, &r);
+		_mm512_storeu_si512(y1 + i, l);
+		_mm512_storeu_si512(y2 + i, r);
+	}
+	floatDeinterleaveAVX2(x + (i << 1), y1 + i, y2 + i, n - i);
+}
+static AVX512_FN void floatInterleaveAVX512(const float *x1, const float *x2, float *y, size_t n)
+{
+	size_t i = 0;
+	for (; i + 16 <= n; i += 16)
+		avx512StoreInterleaved((int32_t *)(y + (i << 1)), _mm512_loadu_si512(x1 + i), _mm512_loadu_si512(x2 + i));
+	floatInterleaveAVX2(x1 + i, x2 + i, y + (i << 1), n - i);
+}
+static const JSampleKernels kernelsAVX512 =
+{
+	JSAMPLE_AVX512, "avx512",
+	s16ToFloatAVX512, s16iToFloatAVX512, floatToS16AVX512, floatToS16iAVX512,
+	s32ToFloatAVX512, s32iToFloatAVX512, floatToS32AVX512, floatToS32iAVX512, floatToS8_24AVX512, floatToS8_24iAVX512,
+	p24ToFloatAVX2, p24iToFloatAVX2, floatToP24AVX2, floatToP24iAVX2,
+	floatDeinterleaveAVX512, floatInterleaveAVX512
+};
+#endif
+#ifdef JSAMPLE_ARM
+// NEON, float to int truncation saturates here, which matches the scalar conversion on the same CPU
+static inline int32x4_t neonS16FromFloat(float32x4_t x)
+{
+	int32x4_t u = vreinterpretq_s32_f32(vaddq_f32(x, vdupq_n_f32(S16_OFFSET)));
+	u = vminq_s32(vmaxq_s32(u, vdupq_n_s32(S16_LIMNEG)), vdupq_n_s32(S16_LIMPOS));
+	return vsubq_s32(u, vdupq_n_s32(S16_ZERO));
+}
+static inline int32x4_t neonRoundFromScaled(float32x4_t f)
+{
+	uint32x4_t half = vorrq_u32(vreinterpretq_u32_f32(vdupq_n_f32(0.5f)), vandq_u32(vreinterpretq_u32_f32(f), vdupq_n_u32(0x80000000U)));
+	return vcvtq_s32_f32(vaddq_f32(f, vreinterpretq_f32_u32(half)));
+}
+static inline int32x4_t neonS32FromFloat(float32x4_t x)
+{
+	int32x4_t r = neonRoundFromScaled(vmulq_f32(x, vdupq_n_f32(2147483648.0f)));
+	r = vbslq_s32(vcgeq_f32(x, vdupq_n_f32(1.0f)), vdupq_n_s32(INT32_MAX), r);
+	return vbslq_s32(vcleq_f32(x, vdupq_n_f32(-1.0f)), vdupq_n_s32(INT32_MIN), r);
+}
+static void s16ToFloatNEON(const int16_t *x1, const int16_t *x2, float *y1, float *y2, size_t n)
+{
+	const float32x4_t scale = vdupq_n_f32(S16_SCALE);
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		vst1q_f32(y1 + i, vmulq_f32(vcvtq_f32_s32(vmovl_s16(vld1_s16(x1 + i))), scale));
+		vst1q_f32(y2 + i, vmulq_f32(vcvtq_f32_s32(vmovl_s16(vld1_s16(x2 + i))), scale));
+	}
+	s16ToFloatScalar(x1 + i, x2 + i, y1 + i, y2 + i, n - i);
+}
+static void s16iToFloatNEON(const int16_t *x, float *y1, float *y2, size_t n)
+{
+	const float32x4_t scale = vdupq_n_f32(S16_SCALE);
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		int16x4x2_t v = vld2_s16(x + (i << 1));
+		vst1q_f32(y1 + i, vmulq_f32(vcvtq_f32_s32(vmovl_s16(v.val[0])), scale));
+		vst1q_f32(y2 + i, vmulq_f32(vcvtq_f32_s32(vmovl_s16(v.val[1])), scale));
+	}
+	s16iToFloatScalar(x + (i << 1), y1 + i, y2 + i, n - i);
+}
+static void floatToS16NEON(const float *x1, const float *x2, int16_t *y1, int16_t *y2, size_t n)
+{
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		vst1_s16(y1 + i, vmovn_s32(neonS16FromFloat(vld1q_f32(x1 + i))));
+		vst1_s16(y2 + i, vmovn_s32(neonS16FromFloat(vld1q_f32(x2 + i))));
+	}
+	floatToS16Scalar(x1 + i, x2 + i, y1 + i, y2 + i, n - i);
+}
+static void floatToS16iNEON(const float *x1, const float *x2, int16_t *y, size_t n)
+{
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		int16x4x2_t v;
+		v.val[0] = vmovn_s32(neonS16FromFloat(vld1q_f32(x1 + i)));
+		v.val[1] = vmovn_s32(neonS16FromFloat(vld1q_f32(x2 + i)));
+		vst2_s16(y + (i << 1), v);
+	}
+	floatToS16iScalar(x1 + i, x2 + i, y + (i << 1), n - i);
+}
+static void s32ToFloatNEON(const int32_t *x1, const int32_t *x2, float *y1, float *y2, size_t n, float scale)
+{
+	const float32x4_t s = vdupq_n_f32(scale);
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		vst1q_f32(y1 + i, vmulq_f32(vcvtq_f32_s32(vld1q_s32(x1 + i)), s));
+		vst1q_f32(y2 + i, vmulq_f32(vcvtq_f32_s32(vld1q_s32(x2 + i)), s));
+	}
+	s32ToFloatScalar(x1 + i, x2 + i, y1 + i, y2 + i, n - i, scale);
+}
+static void s32iToFloatNEON(const int32_t *x, float *y1, float *y2, size_t n, float scale)
+{
+	const float32x4_t s = vdupq_n_f32(scale);
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		int32x4x2_t v = vld2q_s32(x + (i << 1));
+		vst1q_f32(y1 + i, vmulq_f32(vcvtq_f32_s32(v.val[0]), s));
+		vst1q_f32(y2 + i, vmulq_f32(vcvtq_f32_s32(v.val[1]), s));
+	}
+	s32iToFloatScalar(x + (i << 1), y1 + i, y2 + i, n - i, scale);
+}
+static void floatToS32NEON(const float *x1, const float *x2, int32_t *y1, int32_t *y2, size_t n)
+{
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		vst1q_s32(y1 + i, neonS32FromFloat(vld1q_f32(x1 + i)));
+		vst1q_s32(y2 + i, neonS32FromFloat(vld1q_f32(x2 + i)));
+	}
+	floatToS32Scalar(x1 + i, x2 + i, y1 + i, y2 + i, n - i);
+}
+static void floatToS32iNEON(const float *x1, const float *x2, int32_t *y, size_t n)
+{
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		int32x4x2_t v;
+		v.val[0] = neonS32FromFloat(vld1q_f32(x1 + i));
+		v.val[1] = neonS32FromFloat(vld1q_f32(x2 + i));
+		vst2q_s32(y + (i << 1), v);
+	}
+	floatToS32iScalar(x1 + i, x2 + i, y + (i << 1), n - i);
+}
+static void floatToS8_24NEON(const float *x1, const float *x2, int32_t *y1, int32_t *y2, size_t n)
+{
+	const float32x4_t s = vdupq_n_f32(8388608.0f);
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		vst1q_s32(y1 + i, neonRoundFromScaled(vmulq_f32(vld1q_f32(x1 + i), s)));
+		vst1q_s32(y2 + i, neonRoundFromScaled(vmulq_f32(vld1q_f32(x2 + i), s)));
+	}
+	floatToS8_24Scalar(x1 + i, x2 + i, y1 + i, y2 + i, n - i);
+}
+static void floatToS8_24iNEON(const float *x1, const float *x2, int32_t *y, size_t n)
+{
+	const float32x4_t s = vdupq_n_f32(8388608.0f);
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		int32x4x2_t v;
+		v.val[0] = neonRoundFromScaled(vmulq_f32(vld1q_f32(x1 + i), s));
+		v.val[1] = neonRoundFromScaled(vmulq_f32(vld1q_f32(x2 + i), s));
+		vst2q_s32(y + (i << 1), v);
+	}
+	floatToS8_24iScalar(x1 + i, x2 + i, y + (i << 1), n - i);
+}
+static void floatDeinterleaveNEON(const float *x, float *y1, float *y2, size_t n)
+{
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		float32x4x2_t v = vld2q_f32(x + (i << 1));
+		vst1q_f32(y1 + i, v.val[0]);
+		vst1q_f32(y2 + i, v.val[1]);
+	}
+	floatDeinterleaveScalar(x + (i << 1), y1 + i, y2 + i, n - i);
+}
+static void floatInterleaveNEON(const float *x1, const float *x2, float *y, size_t n)
+{
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		float32x4x2_t v;
+		v.val[0] = vld1q_f32(x1 + i);
+		v.val[1] = vld1q_f32(x2 + i);
+		vst2q_f32(y + (i << 1), v);
+	}
+	floatInterleaveScalar(x1 + i, x2 + i, y + (i << 1), n - i);
+}
+static const JSampleKernels kernelsNEON =
+{
+	JSAMPLE_NEON, "neon",
+	s16ToFloatNEON, s16iToFloatNEON, floatToS16NEON, floatToS16iNEON,
+	s32ToFloatNEON, s32iToFloatNEON, floatToS32NEON, floatToS32iNEON, floatToS8_24NEON, floatToS8_24iNEON,
+	p24ToFloatScalar, p24iToFloatScalar, floatToP24Scalar, floatToP24iScalar,
+	floatDeinterleaveNEON, floatInterleaveNEON
+};
+#endif
+const JSampleKernels *sampleKernelsSelect(int maxLevel)
+{
+#ifdef JSAMPLE_X86
+	__builtin_cpu_init();
+	if (maxLevel >= JSAMPLE_AVX512 && __builtin_cpu_supports("avx512f"))
+		return &kernelsAVX512;
+	if (maxLevel >= JSAMPLE_AVX2 && __builtin_cpu_supports("avx2"))
+		return &kernelsAVX2;
+	if (maxLevel >= JSAMPLE_SSE2 && __builtin_cpu_supports("sse2"))
+		return &kernelsSSE2;
+#elif defined(JSAMPLE_ARM)
+	if (maxLevel >= JSAMPLE_NEON)
+		return &kernelsNEON;
+#endif
+	return &kernelsScalar;
+}
@@ -0,0 +1,43 @@
+#ifndef SAMPLECONV_H
+#define SAMPLECONV_H
+#include <stddef.h>
+#include <stdint.h>
+// Conversion between host sample formats and the planar float stereo pair the effects run on
+// Every variant produces bit-identical output to the scalar kernels, including saturation
+enum
+{
+	JSAMPLE_SCALAR = 0,
+	JSAMPLE_SSE2,
+	JSAMPLE_AVX2,
+	JSAMPLE_AVX512,
+	JSAMPLE_NEON,
+	JSAMPLE_BEST
+};
+typedef struct
+{
+	int level;
+	const char *name;
+	// int16, full scale 32768
+	void(*s16ToFloat)(const int16_t *x1, const int16_t *x2, float *y1, float *y2, size_t n);
+	void(*s16iToFloat)(const int16_t *x, float *y1, float *y2, size_t n);
+	void(*floatToS16)(const float *x1, const float *x2, int16_t *y1, int16_t *y2, size_t n);
+	void(*floatToS16i)(const float *x1, const float *x2, int16_t *y, size_t n);
+	// int32 containers, scale is 1 / full scale
+	void(*s32ToFloat)(const int32_t *x1, const int32_t *x2, float *y1, float *y2, size_t n, float scale);
+	void(*s32iToFloat)(const int32_t *x, float *y1, float *y2, size_t n, float scale);
+	void(*floatToS32)(const float *x1, const float *x2, int32_t *y1, int32_t *y2, size_t n); // Saturating, full scale 2^31
+	void(*floatToS32i)(const float *x1, const float *x2, int32_t *y, size_t n);
+	void(*floatToS8_24)(const float *x1, const float *x2, int32_t *y1, int32_t *y2, size_t n); // Full scale 2^23, not clamped
+	void(*floatToS8_24i)(const float *x1, const float *x2, int32_t *y, size_t n);
+	// Packed 24 bit in host byte order
+	void(*p24ToFloat)(const uint8_t *x1, const uint8_t *x2, float *y1, float *y2, size_t n);
+	void(*p24iToFloat)(const uint8_t *x, float *y1, float *y2, size_t n);
+	void(*floatToP24)(const float *x1, const float *x2, uint8_t *y1, uint8_t *y2, size_t n);
+	void(*floatToP24i)(const float *x1, const float *x2, uint8_t *y, size_t n);
+	// float32
+	void(*floatDeinterleave)(const float *x, float *y1, float *y2, size_t n);
+	void(*floatInterleave)(const float *x1, const float *x2, float *y, size_t n);
+} JSampleKernels;
+// Best kernel set the CPU supports, not exceeding maxLevel
+extern const JSampleKernels *sampleKernelsSelect(int maxLevel);
+#endif
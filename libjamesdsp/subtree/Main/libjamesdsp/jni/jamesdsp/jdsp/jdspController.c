@@ -66,25 +66,25 @@ double crossPlatformCurTime(void)
 	t = GetTickCount();
 	return (double)t * 0.001;
 #else
-	struct timeval tv;
+	struct timespec ts;
 
-	gettimeofday(&tv, NULL);
-	return tv.tv_sec + tv.tv_usec * 0.000001;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 0.000000001;
 #endif
 }
-double getProcTime(int flen, int num, double dur)
+static int cmpDouble(const void *a, const void *b)
 {
-	int pos;
-	double t_start, t_diff;
-	int counter = 0.0;
-	double proc_time;
-
-	int xlen = 2048 * 2048;
-	float *x = (float *)malloc(sizeof(float) * xlen);
+	double x = *(const double *)a, y = *(const double *)b;
+	return (x > y) - (x < y);
+}
+// Median time per block of a uniformly partitioned convolver, flen: partition size, num: partition count
+double getProcTime(int flen, int num, int trials)
+{
+	float *x = (float *)malloc(sizeof(float) * flen);
 	float lin = (float)pow(10.0, -100.0 / 20.0);	// 0.00001 = -100dB
-	float mul = (float)pow(lin, 1.0 / (double)xlen);
+	float mul = (float)pow(lin, 1.0 / (double)flen);
 	x[0] = 1.0;
-	for (int n = 1; n < xlen; n++)
+	for (int n = 1; n < flen; n++)
 		x[n] = -mul * x[n - 1];
 
 	int hlen = flen * num;
@@ -101,23 +101,35 @@ double getProcTime(int flen, int num, double dur)
 	FFTConvolver1x1Init(&filter);
 	FFTConvolver1x1LoadImpulseResponse(&filter, flen, h, hlen);
 
-	t_diff = 0.0;
-	t_start = crossPlatformCurTime();
-	pos = 0;
-	while (t_diff < dur)
-	{
-		FFTConvolver1x1Process(&filter, &x[pos], y, flen);
-		pos += flen;
-		if (pos >= xlen)
-			pos = 0;
-		counter++;
-		t_diff = crossPlatformCurTime() - t_start;
-	}
+	// Warm up caches and fill the whole frequency domain delay line once
+	for (int i = 0; i <= num; i++)
+		FFTConvolver1x1Process(&filter, x, y, flen);
+	// Size each trial to roughly 1 ms so timer resolution does not dominate small partitions
+	double t_start = crossPlatformCurTime();
+	FFTConvolver1x1Process(&filter, x, y, flen);
+	double single = crossPlatformCurTime() - t_start;
+	int reps = single > 0.0 ? (int)(0.001 / single) : 256;
+	if (reps < 1)
+		reps = 1;
+	if (reps > 256)
+		reps = 256;
+	double *trial = (double *)malloc(sizeof(double) * trials);
+	for (int k = 0; k < trials; k++)
+	{
+		t_start = crossPlatformCurTime();
+		for (int r = 0; r < reps; r++)
+			FFTConvolver1x1Process(&filter, x, y, flen);
+		trial[k] = (crossPlatformCurTime() - t_start) / (double)reps;
+	}
+	// Median rejects trials hit by preemption or frequency ramps
+	qsort(trial, trials, sizeof(double), cmpDouble);
+	double proc_time = trial[trials >> 1];
 	FFTConvolver1x1Free(&filter);
+	free(trial);
 	free(x);
 	free(h);
 	free(y);
-	return t_diff / (double)counter;
+	return proc_time;
 }
 char benchmarkEnable = 0;
 char benchmarkCompletionFlag = 0;
@@ -135,42 +147,42 @@ void JamesDSP_Save_benchmark(double *_c0, double *_c1)
 	memcpy(_c0, convbench_c0, sizeof(convbench_c0));
 	memcpy(_c1, convbench_c1, sizeof(convbench_c1));
 }
+// Fit the c0 + c1 * num cost model for every partition size, takes a few hundred milliseconds
 void JamesDSP_Start_benchmark()
 {
-    benchmarkEnable = 1;
+	benchmarkEnable = 1;
 
 	const int sflen_start = 64;
-	int s, m;
-	int sflen_best = sflen_start;
-	int mflen_best = 256;
-	int counter = 0;
+	const int trials = 7;
 	double _c0[MAX_BENCHMARK];
 	double _c1[MAX_BENCHMARK];
-	for (s = 0; s < MAX_BENCHMARK; s++)
+	for (int s = 0; s < MAX_BENCHMARK; s++)
 	{
 		int sflen = sflen_start << s;
-		int num = 1;
-		double tau_1 = getProcTime(sflen, num, 1.0);
-		counter++;
-		num = 16;
-		double tau_16 = getProcTime(sflen, num, 1.0);
-		counter++;
+		double tau_1 = getProcTime(sflen, 1, trials);
+		double tau_16 = getProcTime(sflen, 16, trials);
 		_c1[s] = (tau_16 - tau_1) / 15.0;
-		_c0[s] = tau_1 - convbench_c1[s];
+		if (_c1[s] < 0.0)
+			_c1[s] = 0.0;
+		_c0[s] = tau_1 - _c1[s];
+		if (_c0[s] < 0.0)
+			_c0[s] = 0.0;
 	}
 	JamesDSP_Load_benchmark(_c0, _c1);
 #ifdef DEBUG
 	__android_log_print(ANDROID_LOG_INFO, TAG, "Benchmark done");
 #endif
 }
+// Stable across rebuilds, only a change to what the benchmark measures invalidates cached fits
+const char *JamesDSPGetBuildId()
+{
+	static char buildId[32] = { 0 };
+	if (!buildId[0])
+		snprintf(buildId, sizeof(buildId), "layout %d", JDSP_BENCHMARK_LAYOUT);
+	return buildId;
+}
 void *convBench(void *arg)
 {
-	size_t sleepMs = 30000; // 30 second after library being loaded
-#ifdef _WIN32
-	Sleep(sleepMs);
-#else
-	usleep(sleepMs * 1000ULL);
-#endif
 #ifdef DEBUG
 	__android_log_print(ANDROID_LOG_INFO, TAG, "Benchmark start");
 #endif
@@ -178,12 +190,12 @@ void *convBench(void *arg)
 	pthread_exit(NULL);
 	return 0;
 }
-int selectConvPartitions(JamesDSPLib *jdsp, unsigned int impulseLengthActual, unsigned int *seg2Len)
+int selectConvPartitions(JamesDSPLib *jdsp, unsigned int blockSize, unsigned int impulseLengthActual, unsigned int *seg2Len)
 {
 	double tau_s, tau_m;
 	int mflen_best = 256;
 	int num_s, num_m;
-	int latency = jdsp->blockSize;
+	int latency = blockSize;
 	int type_best, begin_m, end_m;
 	int s = (int)log2(latency) - 6;
 	if (s < 0)
@@ -225,10 +237,66 @@ int selectConvPartitions(JamesDSPLib *jdsp, unsigned int impulseLengthActual, un
 	*seg2Len = mflen_best;
 	return type_best;
 }
+// Predicted load of a non-uniform layout, stage i runs at blockSizes[i] and starts at 2 * blockSizes[i]
+static double stageLayoutLoad(JamesDSPLib *jdsp, unsigned int impulseLengthActual, const unsigned int *blockSizes, unsigned int stageCount)
+{
+	double tau = 0.0;
+	for (unsigned int i = 0; i < stageCount; i++)
+	{
+		unsigned int flen = blockSizes[i];
+		unsigned int begin = i ? 2 * flen : 0;
+		int num = (i + 1 < stageCount) ? (int)((2 * blockSizes[i + 1] - begin) / flen) : (int)ceil((impulseLengthActual - begin) / (double)flen);
+		int s = (int)log2(flen) - 6;
+		tau += (convbench_c0[s] + convbench_c1[s] * num) / (double)flen;
+	}
+	return 400.0 * tau * jdsp->fs;
+}
+// Cheapest layout of up to MULTISTAGE_MAX_STAGES block sizes starting at the host block size, returns the stage count
+unsigned int selectConvStages(JamesDSPLib *jdsp, unsigned int blockSize, unsigned int impulseLengthActual, unsigned int *blockSizes)
+{
+	unsigned int latency = blockSize;
+	unsigned int maxStages = MULTISTAGE_MAX_STAGES;
+	// Smaller hosts get the FFT stages of the hybrid layout, the direct form head takes the first stage slot
+	if (latency < CONV_DIRECT_HEAD_BELOW)
+	{
+		latency = CONV_DIRECT_HEAD_BELOW;
+		maxStages--;
+	}
+	int s = (int)log2(latency) - 6;
+	blockSizes[0] = latency;
+	if (s < 0 || s >= MAX_BENCHMARK)
+		return 1;
+	// Every subset of the benchmarked sizes above the head is a candidate, the last stage must start inside the IR
+	unsigned int candidates = MAX_BENCHMARK - 1 - s;
+	unsigned int layout[MULTISTAGE_MAX_STAGES];
+	double cpu_load_best = stageLayoutLoad(jdsp, impulseLengthActual, blockSizes, 1);
+	unsigned int stagesBest = 1;
+	layout[0] = latency;
+	for (unsigned int mask = 1; mask < (1u << candidates); mask++)
+	{
+		if (__builtin_popcount(mask) + 1 > maxStages)
+			continue;
+		unsigned int stages = 1;
+		for (unsigned int m = 0; m < candidates; m++)
+			if (mask & (1u << m))
+				layout[stages++] = latency << (m + 1);
+		if (2 * layout[stages - 1] >= impulseLengthActual)
+			continue;
+		double cpu_load = stageLayoutLoad(jdsp, impulseLengthActual, layout, stages);
+		if (cpu_load < cpu_load_best)
+		{
+			cpu_load_best = cpu_load;
+			stagesBest = stages;
+			memcpy(blockSizes, layout, stages * sizeof(unsigned int));
+		}
+	}
+	return stagesBest;
+}
 void JamesDSPGlobalMemoryAllocation()
 {
 	benchmarkCompletionFlag = 0;
 	NSEEL_start();
+	ConvolverWorkerPoolInit();
 #ifdef JAMESDSP_REFERENCE_IMPL
 	pthread_t benchmarkThread;
 	pthread_create(&benchmarkThread, NULL, convBench, 0);
@@ -236,6 +304,7 @@ void JamesDSPGlobalMemoryAllocation()
 }
 void JamesDSPGlobalMemoryDeallocation()
 {
+	ConvolverWorkerPoolDeinit();
 	NSEEL_quit();
 }
 unsigned int next_pow_2(unsigned int x)
@@ -250,13 +319,9 @@ void JamesDSPReallocateBlock(JamesDSPLib *jdsp, size_t n)
 {
 	// Init buffer
 	float *tmp1 = jdsp->tmpBuffer[0];
-	float *tmp2 = jdsp->tmpBuffer[1];
-	float *tmp3 = jdsp->tmpBuffer[2];
-	float *tmp4 = jdsp->tmpBuffer[3];
-	float *tmp5 = jdsp->tmpBuffer[4];
-	float *tmp6 = jdsp->tmpBuffer[5];
 	double ratio = (double)jdsp->fs / (double)jdsp->trueSampleRate;
-	jdsp->blockSizeMax = n;
+	// Grow in powers of two, a host wandering between block sizes then reallocates rarely
+	jdsp->blockSizeMax = next_pow_2((unsigned int)n);
 	unsigned int maxDecimatedLength = (unsigned int)ceil(jdsp->blockSizeMax * ratio);
 	if (!jdsp->enableASRC)
 		maxDecimatedLength = 0;
@@ -264,13 +329,20 @@ void JamesDSPReallocateBlock(JamesDSPLib *jdsp, size_t n)
 	jdsp->pw2BlockMemSize = next_pow_2(maxInterpolatedLength);
 	if (!jdsp->enableASRC)
 		jdsp->pw2BlockMemSize = 0;
-	size_t ctMemBlk = jdsp->blockSizeMax * 2 + maxInterpolatedLength * 2 + jdsp->pw2BlockMemSize * 2;
+	size_t drainLen = max(jdsp->blockSizeMax, maxDecimatedLength);
+	size_t ctMemBlk = jdsp->blockSizeMax * 2 + maxInterpolatedLength * 2 + jdsp->pw2BlockMemSize * 2 + drainLen * 4;
 	jdsp->tmpBuffer[0] = (float *)malloc(ctMemBlk * sizeof(float));
 	jdsp->tmpBuffer[1] = jdsp->tmpBuffer[0] + jdsp->blockSizeMax;
 	jdsp->tmpBuffer[2] = jdsp->tmpBuffer[1] + jdsp->blockSizeMax;
 	jdsp->tmpBuffer[3] = jdsp->tmpBuffer[2] + maxInterpolatedLength;
 	jdsp->tmpBuffer[4] = jdsp->tmpBuffer[3] + maxInterpolatedLength;
 	jdsp->tmpBuffer[5] = jdsp->tmpBuffer[4] + jdsp->pw2BlockMemSize;
+	// Outgoing convolver tails
+	jdsp->tmpBuffer[6] = jdsp->tmpBuffer[5] + jdsp->pw2BlockMemSize;
+	jdsp->tmpBuffer[7] = jdsp->tmpBuffer[6] + drainLen;
+	// Input of the outgoing convolver while the fused stages change
+	jdsp->tmpBuffer[8] = jdsp->tmpBuffer[7] + drainLen;
+	jdsp->tmpBuffer[9] = jdsp->tmpBuffer[8] + drainLen;
 	if (tmp1)
 		free(tmp1);
 }
@@ -287,7 +359,9 @@ void JamesDSPRefreshConvolutions(JamesDSPLib *jdsp, char refreshAll)
 #ifdef DEBUG
 	__android_log_print(ANDROID_LOG_INFO, TAG, "Buffer size changed, update convolution object to maximize performance");
 #endif
-	if (jdsp->impulseResponseStorage.impulseResponse)
+	// The refresh flags belong to the control side, set them under the lock the Enable calls clear them in
+	jdsp_lock(jdsp);
+	if (jdsp->impulseResponseStorage.impulseResponse || jdsp->convFusedCommitted)
 		Convolver1DLoadImpulseResponse(jdsp, jdsp->impulseResponseStorage.impulseResponse, jdsp->impulseResponseStorage.impChannels, jdsp->impulseResponseStorage.impulseLengthActual, 0);
 	jdsp->crossfeedForceRefresh = 1;
 	CrossfeedEnable(jdsp, jdsp->crossfeedEnabled);
@@ -298,6 +372,139 @@ void JamesDSPRefreshConvolutions(JamesDSPLib *jdsp, char refreshAll)
 		jdsp->equalizerForceRefresh = 1;
 		MultimodalEqualizerEnable(jdsp, jdsp->equalizerEnabled);
 	}
+	jdsp_unlock(jdsp);
+}
+// Convolution rebuild worker
+// A block size change keeps the current partitioning running, the convolvers buffer internally for any block
+// length, while the partitioning chosen for the new size is built here and committed like a parameter change
+#define JDSP_REBUILD_CONVOLUTIONS (1)
+#define JDSP_REBUILD_ALL (3)
+static void rebuildWait(JamesDSPLib *jdsp, long ms)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_REALTIME, &ts);
+	ts.tv_sec += ms / 1000;
+	ts.tv_nsec += (ms % 1000) * 1000000L;
+	if (ts.tv_nsec >= 1000000000L)
+	{
+		ts.tv_sec++;
+		ts.tv_nsec -= 1000000000L;
+	}
+	pthread_cond_timedwait(&jdsp->rebuildCond, &jdsp->rebuildMutex, &ts);
+}
+// Free state of effects that have been disabled for longer than idleRelease, runs on the worker between rebuilds
+static void releaseIdleState(JamesDSPLib *jdsp)
+{
+	if (jdsp->idleRelease < 0.0)
+		return;
+	double now = crossPlatformCurTime();
+	jdsp_lock(jdsp);
+	CompressorReleaseIdle(jdsp, now);
+	ReverbReleaseIdle(jdsp, now);
+	MultimodalEqualizerReleaseIdle(jdsp, now);
+	ArbitraryResponseEqualizerReleaseIdle(jdsp, now);
+	jdsp_unlock(jdsp);
+	// Released instances sit in the retire rings once the audio thread has let go of them
+	JamesDSPReclaimParams(jdsp);
+}
+static void *rebuildWorker(void *arg)
+{
+	JamesDSPLib *jdsp = (JamesDSPLib *)arg;
+	pthread_mutex_lock(&jdsp->rebuildMutex);
+	while (!jdsp->rebuildStop)
+	{
+		__atomic_store_n(&jdsp->rebuildBusy, 1, __ATOMIC_RELEASE);
+		int req = __atomic_exchange_n(&jdsp->rebuildRequest, 0, __ATOMIC_ACQ_REL);
+		if (!req)
+		{
+			__atomic_store_n(&jdsp->rebuildBusy, 0, __ATOMIC_RELEASE);
+			pthread_mutex_unlock(&jdsp->rebuildMutex);
+			releaseIdleState(jdsp);
+			pthread_mutex_lock(&jdsp->rebuildMutex);
+			if (jdsp->rebuildStop)
+				break;
+			// The audio thread signals without taking the mutex, the timeout bounds a missed wakeup
+			rebuildWait(jdsp, 200);
+			continue;
+		}
+		// Let the block size settle, hosts with variable buffers would otherwise rebuild on every change
+		int more;
+		do
+		{
+			rebuildWait(jdsp, 20);
+			more = __atomic_exchange_n(&jdsp->rebuildRequest, 0, __ATOMIC_ACQ_REL);
+			req |= more;
+		} while (more && !jdsp->rebuildStop);
+		if (jdsp->rebuildStop)
+			break;
+		pthread_mutex_unlock(&jdsp->rebuildMutex);
+		JamesDSPRefreshConvolutions(jdsp, (req & JDSP_REBUILD_ALL) == JDSP_REBUILD_ALL);
+		pthread_mutex_lock(&jdsp->rebuildMutex);
+	}
+	__atomic_store_n(&jdsp->rebuildBusy, 0, __ATOMIC_RELEASE);
+	pthread_mutex_unlock(&jdsp->rebuildMutex);
+	return 0;
+}
+// Audio thread
+static void requestRebuild(JamesDSPLib *jdsp, int what)
+{
+	if (!jdsp->rebuildThreadActive)
+	{
+		JamesDSPRefreshConvolutions(jdsp, what == JDSP_REBUILD_ALL);
+		return;
+	}
+	__atomic_or_fetch(&jdsp->rebuildRequest, what, __ATOMIC_RELEASE);
+	pthread_cond_signal(&jdsp->rebuildCond);
+}
+static void startRebuildWorker(JamesDSPLib *jdsp)
+{
+	jdsp->rebuildThreadActive = 0;
+	if (pthread_mutex_init(&jdsp->rebuildMutex, NULL) != 0)
+		return;
+	if (pthread_cond_init(&jdsp->rebuildCond, NULL) != 0)
+	{
+		pthread_mutex_destroy(&jdsp->rebuildMutex);
+		return;
+	}
+	if (pthread_create(&jdsp->rebuildThread, NULL, rebuildWorker, jdsp) != 0)
+	{
+		pthread_cond_destroy(&jdsp->rebuildCond);
+		pthread_mutex_destroy(&jdsp->rebuildMutex);
+		return;
+	}
+	jdsp->rebuildThreadActive = 1;
+}
+static void stopRebuildWorker(JamesDSPLib *jdsp)
+{
+	if (!jdsp->rebuildThreadActive)
+		return;
+	pthread_mutex_lock(&jdsp->rebuildMutex);
+	jdsp->rebuildStop = 1;
+	pthread_cond_broadcast(&jdsp->rebuildCond);
+	pthread_mutex_unlock(&jdsp->rebuildMutex);
+	pthread_join(jdsp->rebuildThread, NULL);
+	pthread_cond_destroy(&jdsp->rebuildCond);
+	pthread_mutex_destroy(&jdsp->rebuildMutex);
+	jdsp->rebuildThreadActive = 0;
+}
+void JamesDSPSetIdleRelease(JamesDSPLib *jdsp, double seconds)
+{
+	jdsp->idleRelease = seconds;
+}
+// Last block length the audio thread processed, for control and worker threads
+unsigned int JamesDSPBlockSize(JamesDSPLib *jdsp)
+{
+	return (unsigned int)__atomic_load_n(&jdsp->blockSize, __ATOMIC_ACQUIRE);
+}
+// Nonzero while a repartitioning is queued, being built, or waiting for the audio thread to swap it in
+int JamesDSPRebuildPending(JamesDSPLib *jdsp)
+{
+	if (__atomic_load_n(&jdsp->rebuildRequest, __ATOMIC_ACQUIRE) || __atomic_load_n(&jdsp->rebuildBusy, __ATOMIC_ACQUIRE))
+		return 1;
+	for (int i = 0; i < JDSP_PARAM_COUNT; i++)
+		if (JamesDSPParamPending(jdsp, i))
+			return 1;
+	return 0;
 }
 void jdsp_lock(JamesDSPLib *jdsp)
 {
@@ -309,130 +516,465 @@ void jdsp_unlock(JamesDSPLib *jdsp)
 	if (jdsp->isMutexSuccess)
 		pthread_mutex_unlock(&jdsp->m_in_processing);
 }
-// Process
-void JamesDSPProcess(JamesDSPLib *jdsp, size_t n)
+// Parameter commits
+// Setters build a complete snapshot away from the audio thread and publish it, the audio thread swaps it in
+// at the next block boundary and hands the previous state back through a small retire ring for the
+// control thread to free. Publishing and reclaiming must be serialized by jdsp_lock.
+static void reclaimParamSlot(JParamSlot *ps)
+{
+	unsigned int head = __atomic_load_n(&ps->retireHead, __ATOMIC_ACQUIRE);
+	while (ps->retireTail != head)
+	{
+		JParamSnapshot *snap = ps->retired[ps->retireTail % JDSP_PARAM_RETIRESLOTS];
+		snap->destroy(snap);
+		free(snap);
+		__atomic_store_n(&ps->retireTail, ps->retireTail + 1, __ATOMIC_RELEASE);
+	}
+}
+void JamesDSPCommitParam(JamesDSPLib *jdsp, int slot, JParamSnapshot *snap)
+{
+	JParamSlot *ps = &jdsp->param[slot];
+	reclaimParamSlot(ps);
+	snap->seq = ++ps->published;
+	JParamSnapshot *old = __atomic_exchange_n(&ps->pending, snap, __ATOMIC_ACQ_REL);
+	if (old) // Superseded before the audio thread saw it
+	{
+		old->destroy(old);
+		free(old);
+	}
+}
+int JamesDSPParamPending(JamesDSPLib *jdsp, int slot)
+{
+	return __atomic_load_n(&jdsp->param[slot].applied, __ATOMIC_ACQUIRE) != jdsp->param[slot].published;
+}
+void JamesDSPReclaimParams(JamesDSPLib *jdsp)
 {
-	// Analog modelling
-	if (jdsp->tubeEnabled)
-		VacuumTubeProcess(jdsp, n);
-	// Input / Compressor
-	if (jdsp->compEnabled)
-		CompressorProcess(jdsp, n);
-	// IIR bass boost
-	if (jdsp->bassBoostEnabled)
-		BassBoostProcess(jdsp, n);
-	// Equalizer
-	if (jdsp->equalizerEnabled)
-		MultimodalEqualizerProcess(jdsp, n);
-	// Arbitrary magnitude eq
-	if (jdsp->arbitraryMagEnabled)
-		ArbitraryResponseEqualizerProcess(jdsp, n);
 	jdsp_lock(jdsp);
-	// Convolver
-	if (jdsp->convolverEnabled)
-		if (jdsp->conv.process)
-			jdsp->conv.process(jdsp, n);
-	// Viper DDC
-	if (jdsp->ddcEnabled)
-		DDCProcess(jdsp, n);
-	// Live programmable
-	if (jdsp->liveprogEnabled)
-		LiveProgProcess(jdsp, n);
+	for (int i = 0; i < JDSP_PARAM_COUNT; i++)
+		reclaimParamSlot(&jdsp->param[i]);
 	jdsp_unlock(jdsp);
-	// BS2B
-	if (jdsp->crossfeedEnabled)
-		CrossfeedProcess(jdsp, n);
-	// Stereo widening
-	if (jdsp->sterEnhEnabled)
-		StereoEnhancementProcess(jdsp, n);
-	// Reverb
-	if (jdsp->reverbEnabled)
-		ReverbProcess(jdsp, n);
-	// Output
-	for (size_t i = 0; i < n; i++)
-	{
-		float xL = jdsp->tmpBuffer[0][i] * jdsp->postGain;
-		float xR = jdsp->tmpBuffer[1][i] * jdsp->postGain;
-		float rect1 = fabsf(xL);
-		float rect2 = fabsf(xR);
-		float maxLR = max(rect1, rect2);
-		if (maxLR < jdsp->limiter.threshold)
-			maxLR = jdsp->limiter.threshold;
-		if (maxLR > jdsp->limiter.envOverThreshold)
-			jdsp->limiter.envOverThreshold = maxLR;
-		else
-			jdsp->limiter.envOverThreshold = maxLR + jdsp->limiter.relCoef * (jdsp->limiter.envOverThreshold - maxLR);
-		float gR = jdsp->limiter.threshold / jdsp->limiter.envOverThreshold;
-		rect1 = xL * gR;
-		rect2 = xR * gR;
-		jdsp->tmpBuffer[0][i] = rect1;
-		jdsp->tmpBuffer[1][i] = rect2;
+}
+static int retireParam(JParamSlot *ps, JParamSnapshot *snap)
+{
+	unsigned int head = ps->retireHead;
+	if (head - __atomic_load_n(&ps->retireTail, __ATOMIC_ACQUIRE) >= JDSP_PARAM_RETIRESLOTS)
+		return 0;
+	ps->retired[head % JDSP_PARAM_RETIRESLOTS] = snap;
+	__atomic_store_n(&ps->retireHead, head + 1, __ATOMIC_RELEASE);
+	return 1;
+}
+static void applyParams(JamesDSPLib *jdsp)
+{
+	for (int i = 0; i < JDSP_PARAM_COUNT; i++)
+	{
+		JParamSlot *ps = &jdsp->param[i];
+		if (!__atomic_load_n(&ps->pending, __ATOMIC_RELAXED))
+			continue;
+		if (ps->retireHead - __atomic_load_n(&ps->retireTail, __ATOMIC_ACQUIRE) >= JDSP_PARAM_RETIRESLOTS)
+			continue; // Retire ring full, keep the current state for another block
+		JParamSnapshot *snap = __atomic_exchange_n(&ps->pending, 0, __ATOMIC_ACQ_REL);
+		if (!snap)
+			continue;
+		snap->held = 0;
+		snap->apply(jdsp, snap);
+		if (!snap->held)
+			retireParam(ps, snap);
+		__atomic_store_n(&ps->applied, snap->seq, __ATOMIC_RELEASE);
 	}
 }
-void JamesDSPProcessCheckBenchmarkReady(JamesDSPLib *jdsp, size_t n)
+static void releaseParams(JamesDSPLib *jdsp)
+{
+	JParamDrain *drains[4] = { &jdsp->eqDrain, &jdsp->arbMagDrain, &jdsp->convDrain, &jdsp->xfDrain };
+	for (int i = 0; i < 4; i++)
+	{
+		if (drains[i]->snap)
+		{
+			drains[i]->snap->destroy(drains[i]->snap);
+			free(drains[i]->snap);
+			drains[i]->snap = 0;
+		}
+	}
+	for (int i = 0; i < JDSP_PARAM_COUNT; i++)
+	{
+		JParamSlot *ps = &jdsp->param[i];
+		reclaimParamSlot(ps);
+		JParamSnapshot *snap = __atomic_exchange_n(&ps->pending, 0, __ATOMIC_ACQ_REL);
+		if (snap)
+		{
+			snap->destroy(snap);
+			free(snap);
+		}
+	}
+}
+// Outgoing convolver tails
+// A repartitioned convolver starts from an empty delay line, so the previous instance keeps running on silence
+// until its tail has played out and both outputs are summed. The partitioned convolvers are zero latency, which
+// makes the handoff sample exact where a crossfade would only approximate it.
+void JamesDSPDrainStart(JamesDSPLib *jdsp, JParamDrain *drain, int slot, JParamSnapshot *snap, unsigned int len)
+{
+	if (drain->snap) // Previous tail cut short, applyParams left room to retire it
+		retireParam(&jdsp->param[drain->slot], drain->snap);
+	drain->snap = snap;
+	drain->slot = slot;
+	drain->remaining = len;
+	drain->fadeLen = 0;
+	snap->held = 1;
+}
+float **JamesDSPDrainBuffer(JamesDSPLib *jdsp, size_t n)
+{
+	memset(jdsp->tmpBuffer[6], 0, n * sizeof(float));
+	memset(jdsp->tmpBuffer[7], 0, n * sizeof(float));
+	return &jdsp->tmpBuffer[6];
+}
+void JamesDSPDrainFinish(JamesDSPLib *jdsp, JParamDrain *drain, size_t n)
+{
+	if (drain->remaining && drain->fadeLen)
+	{
+		// Raised cosine, the gains sum to one since both instances see the same input
+		const double w = M_PI / (double)drain->fadeLen;
+		unsigned int pos = drain->fadeLen - drain->remaining;
+		for (size_t i = 0; i < n; i++, pos++)
+		{
+			float g = pos < drain->fadeLen ? (float)(0.5 - 0.5 * cos(w * pos)) : 1.0f;
+			jdsp->tmpBuffer[0][i] = jdsp->tmpBuffer[6][i] + g * (jdsp->tmpBuffer[0][i] - jdsp->tmpBuffer[6][i]);
+			jdsp->tmpBuffer[1][i] = jdsp->tmpBuffer[7][i] + g * (jdsp->tmpBuffer[1][i] - jdsp->tmpBuffer[7][i]);
+		}
+		drain->remaining = drain->remaining > n ? drain->remaining - (unsigned int)n : 0;
+	}
+	else if (drain->remaining)
+	{
+		for (size_t i = 0; i < n; i++)
+		{
+			jdsp->tmpBuffer[0][i] += jdsp->tmpBuffer[6][i];
+			jdsp->tmpBuffer[1][i] += jdsp->tmpBuffer[7][i];
+		}
+		drain->remaining = drain->remaining > n ? drain->remaining - (unsigned int)n : 0;
+	}
+	if (!drain->remaining && drain->snap)
+		if (retireParam(&jdsp->param[drain->slot], drain->snap))
+			drain->snap = 0;
+}
+// Outgoing instance replaced by a different response
+// Both instances process the live input and the output fades from the old to the new one over len samples,
+// the old instance is retired afterwards. The tail of the old response is cut at the end of the fade.
+void JamesDSPCrossfadeStart(JamesDSPLib *jdsp, JParamDrain *drain, int slot, JParamSnapshot *snap, unsigned int len)
+{
+	JamesDSPDrainStart(jdsp, drain, slot, snap, len);
+	drain->fadeLen = len;
+}
+// Input of the block for the outgoing instance, call before the live instance processes in place
+float **JamesDSPCrossfadeBuffer(JamesDSPLib *jdsp, size_t n)
+{
+	memcpy(jdsp->tmpBuffer[6], jdsp->tmpBuffer[0], n * sizeof(float));
+	memcpy(jdsp->tmpBuffer[7], jdsp->tmpBuffer[1], n * sizeof(float));
+	return &jdsp->tmpBuffer[6];
+}
+// Stage profiler
+static const char *stageNames[JDSP_STAGE_COUNT] = { "tube", "compressor", "bassboost", "equalizer", "arbeq", "convolver", "ddc", "liveprog", "crossfeed", "stereoenh", "reverb", "limiter", "total" };
+static inline uint64_t stageClock(JamesDSPLib *jdsp)
+{
+	if (!jdsp->profiler.enabled)
+		return 0;
+#ifdef WIN32
+	return (uint64_t)(crossPlatformCurTime() * 1e9);
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+#endif
+}
+static inline int stageBlockBin(size_t n)
+{
+	int bin = 0;
+	size_t sz = 32;
+	while (sz < n && bin < JDSP_STAGE_BLOCKBINS - 1)
+	{
+		sz <<= 1;
+		bin++;
+	}
+	return bin;
+}
+static inline int stageHistBin(double ns)
+{
+	if (ns < 16.0)
+		return 0;
+	int e;
+	double m = frexp(ns / 16.0, &e); // ns / 16 = m * 2^e, m in [0.5, 1)
+	int bin = (e - 1) * 4 + (int)((m * 2.0 - 1.0) * 4.0);
+	return bin < JDSP_STAGE_HISTBINS ? bin : (JDSP_STAGE_HISTBINS - 1);
+}
+static inline double stageHistUpperEdge(int bin)
+{
+	return 16.0 * (double)(1ULL << (bin >> 2)) * (1.0 + ((bin & 3) + 1) * 0.25);
+}
+static uint64_t stageRecord(JamesDSPLib *jdsp, int stage, size_t n, uint64_t t0)
+{
+	uint64_t t1 = stageClock(jdsp);
+	if (!t0 || !t1)
+		return t1;
+	double ns = (double)(t1 - t0);
+	JStageTimer *t = &jdsp->profiler.timer[stage][stageBlockBin(n)];
+	if (!t->count || ns < t->minNs)
+		t->minNs = ns;
+	if (ns > t->maxNs)
+		t->maxNs = ns;
+	t->sumNs += ns;
+	t->count++;
+	t->hist[stageHistBin(ns)]++;
+	return t1;
+}
+void JamesDSPStageProfilerEnable(JamesDSPLib *jdsp, int enable)
+{
+	jdsp->profiler.enabled = enable ? 1 : 0;
+}
+void JamesDSPStageProfilerReset(JamesDSPLib *jdsp)
+{
+	memset(jdsp->profiler.timer, 0, sizeof(jdsp->profiler.timer));
+}
+const char *JamesDSPStageName(int stage)
+{
+	if (stage < 0 || stage >= JDSP_STAGE_COUNT)
+		return "unknown";
+	return stageNames[stage];
+}
+// Fill stats with every (stage, block size) pair that has samples, returns number of entries written
+// Statistics are read without synchronisation, a snapshot may be off by the block currently in flight
+int JamesDSPGetStageStats(JamesDSPLib *jdsp, JStageStats *stats, int maxStats)
+{
+	int cnt = 0;
+	for (int i = 0; i < JDSP_STAGE_COUNT; i++)
+	{
+		for (int j = 0; j < JDSP_STAGE_BLOCKBINS; j++)
+		{
+			JStageTimer t = jdsp->profiler.timer[i][j];
+			if (!t.count)
+				continue;
+			if (cnt >= maxStats)
+				return cnt;
+			JStageStats *st = &stats[cnt++];
+			st->stage = i;
+			st->blockSize = 32U << j;
+			st->count = t.count;
+			st->minNs = t.minNs;
+			st->maxNs = t.maxNs;
+			st->meanNs = t.sumNs / (double)t.count;
+			uint64_t target = t.count - t.count / 100;
+			uint64_t acc = 0;
+			st->p99Ns = t.maxNs;
+			for (int k = 0; k < JDSP_STAGE_HISTBINS; k++)
+			{
+				acc += t.hist[k];
+				if (acc >= target)
+				{
+					double edge = stageHistUpperEdge(k);
+					st->p99Ns = edge < t.maxNs ? edge : t.maxNs;
+					break;
+				}
+			}
+		}
+	}
+	return cnt;
+}
+// Memory footprint
+static const char *memItemNames[JDSP_MEM_COUNT] = { "core", "compressor", "bassboost", "equalizer", "arbeq", "convolver", "ddc", "liveprog", "crossfeed", "stereoenh", "reverb", "tube", "profiler" };
+const char *JamesDSPMemoryItemName(int item)
+{
+	if (item < 0 || item >= JDSP_MEM_COUNT)
+		return "unknown";
+	return memItemNames[item];
+}
+// Bytes held per effect, embedded state plus heap, returns the total and fills usage with JDSP_MEM_COUNT entries when not NULL
+// Convolver heap is derived from the partitioning, the liveprog script VM and parameter snapshots in flight are not counted
+size_t JamesDSPGetMemoryUsage(JamesDSPLib *jdsp, JMemoryUsage *usage)
+{
+	size_t bytes[JDSP_MEM_COUNT] = { 0 };
+	int allocated[JDSP_MEM_COUNT] = { 0 };
+	int i;
+	jdsp_lock(jdsp);
+	bytes[JDSP_MEM_COMPRESSOR] = sizeof(jdsp->compParam);
+	if (jdsp->compCommitted)
+	{
+		bytes[JDSP_MEM_COMPRESSOR] += sizeof(FFTCompander);
+		allocated[JDSP_MEM_COMPRESSOR] = 1;
+	}
+	bytes[JDSP_MEM_BASSBOOST] = sizeof(jdsp->dbb);
+	bytes[JDSP_MEM_EQUALIZER] = MultimodalEqualizerMemoryUsage(jdsp);
+	allocated[JDSP_MEM_EQUALIZER] = bytes[JDSP_MEM_EQUALIZER] > sizeof(jdsp->mEQ);
+	bytes[JDSP_MEM_ARBEQ] = ArbitraryResponseEqualizerMemoryUsage(jdsp);
+	allocated[JDSP_MEM_ARBEQ] = bytes[JDSP_MEM_ARBEQ] > sizeof(jdsp->arbMag);
+	Convolver1D *cv = &jdsp->conv;
+	bytes[JDSP_MEM_CONVOLVER] = sizeof(Convolver1D);
+	if (cv->conv1d2x2_S_S)
+		bytes[JDSP_MEM_CONVOLVER] += sizeof(FFTConvolver2x2) + FFTConvolver2x2MemoryUsage(cv->conv1d2x2_S_S);
+	if (cv->conv1d2x2_T_S)
+		bytes[JDSP_MEM_CONVOLVER] += sizeof(TwoStageFFTConvolver2x2) + TwoStageFFTConvolver2x2MemoryUsage(cv->conv1d2x2_T_S);
+	if (cv->conv1d2x4x2_S_S)
+		bytes[JDSP_MEM_CONVOLVER] += sizeof(FFTConvolver2x4x2) + FFTConvolver2x4x2MemoryUsage(cv->conv1d2x4x2_S_S);
+	if (cv->conv1d2x4x2_T_S)
+		bytes[JDSP_MEM_CONVOLVER] += sizeof(TwoStageFFTConvolver2x4x2) + TwoStageFFTConvolver2x4x2MemoryUsage(cv->conv1d2x4x2_T_S);
+	if (cv->conv1d2x2_M_S)
+		bytes[JDSP_MEM_CONVOLVER] += sizeof(MultiStageFFTConvolver2x2) + MultiStageFFTConvolver2x2MemoryUsage(cv->conv1d2x2_M_S);
+	if (cv->conv1d2x4x2_M_S)
+		bytes[JDSP_MEM_CONVOLVER] += sizeof(MultiStageFFTConvolver2x4x2) + MultiStageFFTConvolver2x4x2MemoryUsage(cv->conv1d2x4x2_M_S);
+	if (jdsp->impulseResponseStorage.impulseResponse && !jdsp->impulseResponseStorage.shared)
+		bytes[JDSP_MEM_CONVOLVER] += (size_t)jdsp->impulseResponseStorage.impChannels * jdsp->impulseResponseStorage.impulseLengthActual * sizeof(float);
+	for (i = 0; i < 2; i++)
+		bytes[JDSP_MEM_CONVOLVER] += jdsp->convFusedKernelLen[i] * sizeof(float);
+	allocated[JDSP_MEM_CONVOLVER] = bytes[JDSP_MEM_CONVOLVER] > sizeof(Convolver1D);
+	bytes[JDSP_MEM_DDC] = sizeof(jdsp->vdcFl);
+	if (jdsp->vdcFl.sosPointer)
+	{
+		bytes[JDSP_MEM_DDC] += jdsp->vdcFl.usedSOSCount * sizeof(DirectForm2);
+		allocated[JDSP_MEM_DDC] = 1;
+	}
+	if (jdsp->vdcFl.oldFile)
+		bytes[JDSP_MEM_DDC] += strlen(jdsp->vdcFl.oldFile) + 1;
+	bytes[JDSP_MEM_LIVEPROG] = sizeof(jdsp->eel);
+	allocated[JDSP_MEM_LIVEPROG] = jdsp->eel.vm != 0;
+	Crossfeed *xf = &jdsp->advXF;
+	bytes[JDSP_MEM_CROSSFEED] = sizeof(Crossfeed);
+	for (i = 0; i < 3; i++)
+	{
+		if (xf->conv[i])
+			bytes[JDSP_MEM_CROSSFEED] += sizeof(FFTConvolver2x4x2) + FFTConvolver2x4x2MemoryUsage(xf->conv[i]);
+		if (xf->convMS[i])
+			bytes[JDSP_MEM_CROSSFEED] += sizeof(FFTConvolver2x2) + FFTConvolver2x2MemoryUsage(xf->convMS[i]);
+	}
+	if (xf->convLong_S_S)
+		bytes[JDSP_MEM_CROSSFEED] += sizeof(FFTConvolver2x4x2) + FFTConvolver2x4x2MemoryUsage(xf->convLong_S_S);
+	if (xf->convLong_T_S)
+		bytes[JDSP_MEM_CROSSFEED] += sizeof(TwoStageFFTConvolver2x4x2) + TwoStageFFTConvolver2x4x2MemoryUsage(xf->convLong_T_S);
+	if (xf->convLong_M_S)
+		bytes[JDSP_MEM_CROSSFEED] += sizeof(MultiStageFFTConvolver2x4x2) + MultiStageFFTConvolver2x4x2MemoryUsage(xf->convLong_M_S);
+	if (xf->convLongMS_S_S)
+		bytes[JDSP_MEM_CROSSFEED] += sizeof(FFTConvolver2x2) + FFTConvolver2x2MemoryUsage(xf->convLongMS_S_S);
+	if (xf->convLongMS_T_S)
+		bytes[JDSP_MEM_CROSSFEED] += sizeof(TwoStageFFTConvolver2x2) + TwoStageFFTConvolver2x2MemoryUsage(xf->convLongMS_T_S);
+	if (xf->convLongMS_M_S)
+		bytes[JDSP_MEM_CROSSFEED] += sizeof(MultiStageFFTConvolver2x2) + MultiStageFFTConvolver2x2MemoryUsage(xf->convLongMS_M_S);
+	allocated[JDSP_MEM_CROSSFEED] = bytes[JDSP_MEM_CROSSFEED] > sizeof(Crossfeed);
+	// Resampled HRTF sets, kept for the crossfeed modes
+	if (jdsp->blobsCh1[0])
+		bytes[JDSP_MEM_CROSSFEED] += (size_t)jdsp->blobsResampledLen * 12 * sizeof(float);
+	if (jdsp->hrtfblobsResampled[0])
+		bytes[JDSP_MEM_CROSSFEED] += (size_t)jdsp->frameLenSVirResampled * 4 * sizeof(float);
+	bytes[JDSP_MEM_STEREOENH] = sizeof(jdsp->sterEnh);
+	bytes[JDSP_MEM_REVERB] = sizeof(jdsp->reverbParam);
+	if (jdsp->reverbCommitted)
+	{
+		bytes[JDSP_MEM_REVERB] += sizeof(sf_reverb_state_st);
+		allocated[JDSP_MEM_REVERB] = 1;
+	}
+	bytes[JDSP_MEM_TUBE] = sizeof(jdsp->tube);
+	bytes[JDSP_MEM_PROFILER] = sizeof(jdsp->profiler);
+	// Whatever the effects do not account for, plus the block buffers
+	size_t embedded = sizeof(jdsp->compParam) + sizeof(jdsp->dbb) + sizeof(jdsp->mEQ) + sizeof(jdsp->arbMag) + sizeof(Convolver1D) + sizeof(jdsp->vdcFl)
+		+ sizeof(jdsp->eel) + sizeof(Crossfeed) + sizeof(jdsp->sterEnh) + sizeof(jdsp->reverbParam) + sizeof(jdsp->tube) + sizeof(jdsp->profiler);
+	bytes[JDSP_MEM_CORE] = sizeof(JamesDSPLib) - embedded;
+	if (jdsp->tmpBuffer[0])
+		bytes[JDSP_MEM_CORE] += ((jdsp->tmpBuffer[9] - jdsp->tmpBuffer[0]) + (jdsp->tmpBuffer[9] - jdsp->tmpBuffer[8])) * sizeof(float);
+	allocated[JDSP_MEM_CORE] = jdsp->tmpBuffer[0] != 0;
+	jdsp_unlock(jdsp);
+	size_t total = 0;
+	for (i = 0; i < JDSP_MEM_COUNT; i++)
+	{
+		total += bytes[i];
+		if (usage)
+		{
+			usage[i].item = i;
+			usage[i].bytes = bytes[i];
+			usage[i].allocated = allocated[i];
+		}
+	}
+	return total;
+}
+// Process
+void JamesDSPProcess(JamesDSPLib *jdsp, size_t n)
 {
+	applyParams(jdsp);
+	uint64_t tStart = stageClock(jdsp);
+	uint64_t t = tStart;
 	// Analog modelling
 	if (jdsp->tubeEnabled)
+	{
 		VacuumTubeProcess(jdsp, n);
+		t = stageRecord(jdsp, JDSP_STAGE_TUBE, n, t);
+	}
 	// Input / Compressor
-	if (jdsp->compEnabled)
+	if (jdsp->compEnabled && jdsp->comp)
+	{
 		CompressorProcess(jdsp, n);
+		t = stageRecord(jdsp, JDSP_STAGE_COMPRESSOR, n, t);
+	}
 	// IIR bass boost
 	if (jdsp->bassBoostEnabled)
+	{
 		BassBoostProcess(jdsp, n);
-	// Equalizer
-	if (jdsp->equalizerEnabled)
+		t = stageRecord(jdsp, JDSP_STAGE_BASSBOOST, n, t);
+	}
+	// Equalizer, unless the convolver runs it, the convolver stage feeds it to whichever instance still needs it
+	const int convFused = jdsp->convFused | jdsp->convFusedOut;
+	if (jdsp->equalizerEnabled && !(convFused & JDSP_FUSED_EQUALIZER))
+	{
 		MultimodalEqualizerProcess(jdsp, n);
-	// Arbitrary magnitude eq
-	if (jdsp->arbitraryMagEnabled)
+		t = stageRecord(jdsp, JDSP_STAGE_EQUALIZER, n, t);
+	}
+	// Arbitrary magnitude eq, unless the convolver runs it
+	if (jdsp->arbitraryMagEnabled && !(convFused & JDSP_FUSED_ARBEQ))
+	{
 		ArbitraryResponseEqualizerProcess(jdsp, n);
-	jdsp_lock(jdsp);
+		t = stageRecord(jdsp, JDSP_STAGE_ARBEQ, n, t);
+	}
 	// Convolver
-	if (jdsp->convolverEnabled)
-		if (jdsp->conv.process)
-			jdsp->conv.process(jdsp, n);
+	if (((jdsp->convolverEnabled || jdsp->convFused) && jdsp->conv.process) || (jdsp->convDrain.remaining && jdsp->convDrain.fadeLen))
+	{
+		Convolver1DProcess(jdsp, n);
+		t = stageRecord(jdsp, JDSP_STAGE_CONVOLVER, n, t);
+	}
 	// Viper DDC
 	if (jdsp->ddcEnabled)
+	{
 		DDCProcess(jdsp, n);
+		t = stageRecord(jdsp, JDSP_STAGE_DDC, n, t);
+	}
 	// Live programmable
 	if (jdsp->liveprogEnabled)
+	{
 		LiveProgProcess(jdsp, n);
-	jdsp_unlock(jdsp);
+		t = stageRecord(jdsp, JDSP_STAGE_LIVEPROG, n, t);
+	}
 	// BS2B
 	if (jdsp->crossfeedEnabled)
+	{
 		CrossfeedProcess(jdsp, n);
+		t = stageRecord(jdsp, JDSP_STAGE_CROSSFEED, n, t);
+	}
 	// Stereo widening
 	if (jdsp->sterEnhEnabled)
+	{
 		StereoEnhancementProcess(jdsp, n);
+		t = stageRecord(jdsp, JDSP_STAGE_STEREOENH, n, t);
+	}
 	// Reverb
-	if (jdsp->reverbEnabled)
+	if (jdsp->reverbEnabled && jdsp->reverb)
+	{
 		ReverbProcess(jdsp, n);
-	// Output
-	for (size_t i = 0; i < n; i++)
-	{
-		float xL = jdsp->tmpBuffer[0][i] * jdsp->postGain;
-		float xR = jdsp->tmpBuffer[1][i] * jdsp->postGain;
-		float rect1 = fabsf(xL);
-		float rect2 = fabsf(xR);
-		float maxLR = max(rect1, rect2);
-		if (maxLR < jdsp->limiter.threshold)
-			maxLR = jdsp->limiter.threshold;
-		if (maxLR > jdsp->limiter.envOverThreshold)
-			jdsp->limiter.envOverThreshold = maxLR;
-		else
-			jdsp->limiter.envOverThreshold = maxLR + jdsp->limiter.relCoef * (jdsp->limiter.envOverThreshold - maxLR);
-		float gR = jdsp->limiter.threshold / jdsp->limiter.envOverThreshold;
-		rect1 = xL * gR;
-		rect2 = xR * gR;
-		jdsp->tmpBuffer[0][i] = rect1;
-		jdsp->tmpBuffer[1][i] = rect2;
+		t = stageRecord(jdsp, JDSP_STAGE_REVERB, n, t);
 	}
+	// Output
+	JLimiterProcess(jdsp, n);
+	stageRecord(jdsp, JDSP_STAGE_LIMITER, n, t);
+	stageRecord(jdsp, JDSP_STAGE_TOTAL, n, tStart);
+}
+void JamesDSPProcessCheckBenchmarkReady(JamesDSPLib *jdsp, size_t n)
+{
+	JamesDSPProcess(jdsp, n);
 	if (benchmarkCompletionFlag == 1)
 	{
 #ifdef DEBUG
 		__android_log_print(ANDROID_LOG_INFO, TAG, "Benchmark flag == 1, refreshing convolutions");
 #endif
-		JamesDSPRefreshConvolutions(jdsp, 0);
+		requestRebuild(jdsp, JDSP_REBUILD_CONVOLUTIONS);
 		jdsp->processInternal = JamesDSPProcess;
 	}
 }
@@ -567,29 +1109,47 @@ void DoASRC_bwd(JamesDSPLib *jdsp, unsigned int curDecimatedLen, size_t n)
 	const int howManyItemsLeft1 = (int)jdsp->asrc[0].intermediateRing.in - (int)jdsp->asrc[0].intermediateRing.out;
 	const int howManyItemsLeft2 = (int)jdsp->asrc[0].intermediateRing.in - (int)jdsp->asrc[0].intermediateRing.out;
 }
+// Nothing engaged and no true-peak limiting asked for, the I/O wrappers then hand the input back untouched instead of converting, limiting and resampling it
+static int passthrough(JamesDSPLib *jdsp)
+{
+	int engaged = jdsp->tubeEnabled | jdsp->compEnabled | jdsp->bassBoostEnabled | jdsp->equalizerEnabled | jdsp->arbitraryMagEnabled | jdsp->convolverEnabled
+		| jdsp->ddcEnabled | jdsp->liveprogEnabled | jdsp->crossfeedEnabled | jdsp->sterEnhEnabled | jdsp->reverbEnabled
+		| __atomic_load_n(&jdsp->limiter.truePeakRequest, __ATOMIC_RELAXED);
+	if (engaged || jdsp->postGain != 1.0f)
+	{
+		if (jdsp->passthrough)
+		{
+			// Limiter state predates the passthrough, start over from a released envelope
+			JLimiterReset(jdsp);
+			jdsp->passthrough = 0;
+		}
+		return 0;
+	}
+	applyParams(jdsp);
+	jdsp->passthrough = 1;
+	return 1;
+}
+static inline void passthroughCopy(void *y, const void *x, size_t bytes)
+{
+	if (y != x)
+		memcpy(y, x, bytes);
+}
 void pint16(JamesDSPLib *jdsp, int16_t *x1, int16_t *x2, int16_t *y1, int16_t *y2, size_t n)
 {
 	if (jdsp->blockSizeMax < n)
 		JamesDSPReallocateBlock(jdsp, n);
 	if (jdsp->blockSize != n)
 	{
-		jdsp->blockSize = n;
-		JamesDSPRefreshConvolutions(jdsp, 1);
+		__atomic_store_n(&jdsp->blockSize, n, __ATOMIC_RELEASE);
+		requestRebuild(jdsp, JDSP_REBUILD_ALL);
 	}
-	static const float scale = (float)(1UL << 15UL);
-	static const float offset = (float)(3 << (22 - 15));
-	/* zero = (0x10f << 22) =  0x43c00000 (not directly used) */
-	static const int32_t limneg = (0x10f << 22) /*zero*/ - 32768; /* 0x43bf8000 */
-	static const int32_t limpos = (0x10f << 22) /*zero*/ + 32767; /* 0x43c07fff */
-	union {
-		float f;
-		int32_t i;
-	} u;
-	for (size_t i = 0; i < n; i++)
+	if (passthrough(jdsp))
 	{
-		jdsp->tmpBuffer[0][i] = x1[i] / scale;
-		jdsp->tmpBuffer[1][i] = x2[i] / scale;
+		passthroughCopy(y1, x1, n * sizeof(int16_t));
+		passthroughCopy(y2, x2, n * sizeof(int16_t));
+		return;
 	}
+	jdsp->sampleConv->s16ToFloat(x1, x2, jdsp->tmpBuffer[0], jdsp->tmpBuffer[1], n);
 	if (jdsp->enableASRC)
 	{
 		unsigned int curDecimatedLen = DoASRC_fwd(jdsp, n);
@@ -598,21 +1158,7 @@ void pint16(JamesDSPLib *jdsp, int16_t *x1, int16_t *x2, int16_t *y1, int16_t *y
 	}
 	else
 		jdsp->processInternal(jdsp, n);
-	for (size_t i = 0; i < n; i++)
-	{
-		u.f = jdsp->tmpBuffer[0][i] + offset;
-		if (u.i < limneg)
-			u.i = -32768;
-		else if (u.i > limpos)
-			u.i = 32767;
-		y1[i] = u.i;
-		u.f = jdsp->tmpBuffer[1][i] + offset;
-		if (u.i < limneg)
-			u.i = -32768;
-		else if (u.i > limpos)
-			u.i = 32767;
-		y2[i] = u.i;
-	}
+	jdsp->sampleConv->floatToS16(jdsp->tmpBuffer[0], jdsp->tmpBuffer[1], y1, y2, n);
 }
 void pint16Multiplexed(JamesDSPLib *jdsp, int16_t *x, int16_t *y, size_t n)
 {
@@ -620,22 +1166,15 @@ void pint16Multiplexed(JamesDSPLib *jdsp, int16_t *x, int16_t *y, size_t n)
 		JamesDSPReallocateBlock(jdsp, n);
 	if (jdsp->blockSize != n)
 	{
-		jdsp->blockSize = n;
-		JamesDSPRefreshConvolutions(jdsp, 1);
+		__atomic_store_n(&jdsp->blockSize, n, __ATOMIC_RELEASE);
+		requestRebuild(jdsp, JDSP_REBUILD_ALL);
 	}
-	static const float offset = (float)(3 << (22 - 15));
-	/* zero = (0x10f << 22) =  0x43c00000 (not directly used) */
-	static const int32_t limneg = (0x10f << 22) /*zero*/ - 32768; /* 0x43bf8000 */
-	static const int32_t limpos = (0x10f << 22) /*zero*/ + 32767; /* 0x43c07fff */
-	union {
-		float f;
-		int32_t i;
-	} u;
-	for (size_t i = 0; i < n; i++)
+	if (passthrough(jdsp))
 	{
-		jdsp->tmpBuffer[0][i] = x[i << 1] * 0.000030517578125f;
-		jdsp->tmpBuffer[1][i] = x[(i << 1) + 1] * 0.000030517578125f;
+		passthroughCopy(y, x, (n << 1) * sizeof(int16_t));
+		return;
 	}
+	jdsp->sampleConv->s16iToFloat(x, jdsp->tmpBuffer[0], jdsp->tmpBuffer[1], n);
 	if (jdsp->enableASRC)
 	{
 		unsigned int curDecimatedLen = DoASRC_fwd(jdsp, n);
@@ -644,21 +1183,7 @@ void pint16Multiplexed(JamesDSPLib *jdsp, int16_t *x, int16_t *y, size_t n)
 	}
 	else
 		jdsp->processInternal(jdsp, n);
-	for (size_t i = 0; i < n; i++)
-	{
-		u.f = jdsp->tmpBuffer[0][i] + offset;
-		if (u.i < limneg)
-			u.i = -32768;
-		else if (u.i > limpos)
-			u.i = 32767;
-		y[i << 1] = (int16_t)u.i;
-		u.f = jdsp->tmpBuffer[1][i] + offset;
-		if (u.i < limneg)
-			u.i = -32768;
-		else if (u.i > limpos)
-			u.i = 32767;
-		y[(i << 1) + 1] = (int16_t)u.i;
-	}
+	jdsp->sampleConv->floatToS16i(jdsp->tmpBuffer[0], jdsp->tmpBuffer[1], y, n);
 }
 void pint32(JamesDSPLib *jdsp, int32_t *x1, int32_t *x2, int32_t *y1, int32_t *y2, size_t n)
 {
@@ -666,15 +1191,16 @@ void pint32(JamesDSPLib *jdsp, int32_t *x1, int32_t *x2, int32_t *y1, int32_t *y
 		JamesDSPReallocateBlock(jdsp, n);
 	if (jdsp->blockSize != n)
 	{
-		jdsp->blockSize = n;
-		JamesDSPRefreshConvolutions(jdsp, 1);
+		__atomic_store_n(&jdsp->blockSize, n, __ATOMIC_RELEASE);
+		requestRebuild(jdsp, JDSP_REBUILD_ALL);
 	}
-	static const float scale = (float)(1UL << 31UL);
-	for (size_t i = 0; i < n; i++)
+	if (passthrough(jdsp))
 	{
-		jdsp->tmpBuffer[0][i] = (float)((double)x1[i] / scale);
-		jdsp->tmpBuffer[1][i] = (float)((double)x2[i] / scale);
+		passthroughCopy(y1, x1, n * sizeof(int32_t));
+		passthroughCopy(y2, x2, n * sizeof(int32_t));
+		return;
 	}
+	jdsp->sampleConv->s32ToFloat(x1, x2, jdsp->tmpBuffer[0], jdsp->tmpBuffer[1], n, 1.0f / 2147483648.0f);
 	if (jdsp->enableASRC)
 	{
 		unsigned int curDecimatedLen = DoASRC_fwd(jdsp, n);
@@ -683,28 +1209,7 @@ void pint32(JamesDSPLib *jdsp, int32_t *x1, int32_t *x2, int32_t *y1, int32_t *y
 	}
 	else
 		jdsp->processInternal(jdsp, n);
-	float f;
-	for (size_t i = 0; i < n; i++)
-	{
-		if (jdsp->tmpBuffer[0][i] <= -1.0f)
-			y1[i] = INT32_MIN;
-		else if (jdsp->tmpBuffer[0][i] >= 1.0f)
-			y1[i] = INT32_MAX;
-		else
-		{
-			f = jdsp->tmpBuffer[0][i] * scale;
-			y1[i] = (int32_t)(f > 0 ? f + 0.5f : f - 0.5f);
-		}
-		if (jdsp->tmpBuffer[1][i] <= -1.0f)
-			y2[i] = INT32_MIN;
-		else if (jdsp->tmpBuffer[1][i] >= 1.0f)
-			y2[i] = INT32_MAX;
-		else
-		{
-			f = jdsp->tmpBuffer[1][i] * scale;
-			y2[i] = (int32_t)(f > 0 ? f + 0.5f : f - 0.5f);
-		}
-	}
+	jdsp->sampleConv->floatToS32(jdsp->tmpBuffer[0], jdsp->tmpBuffer[1], y1, y2, n);
 }
 void pint32Multiplexed(JamesDSPLib *jdsp, int32_t *x, int32_t *y, size_t n)
 {
@@ -712,15 +1217,15 @@ void pint32Multiplexed(JamesDSPLib *jdsp, int32_t *x, int32_t *y, size_t n)
 		JamesDSPReallocateBlock(jdsp, n);
 	if (jdsp->blockSize != n)
 	{
-		jdsp->blockSize = n;
-		JamesDSPRefreshConvolutions(jdsp, 1);
+		__atomic_store_n(&jdsp->blockSize, n, __ATOMIC_RELEASE);
+		requestRebuild(jdsp, JDSP_REBUILD_ALL);
 	}
-	static const float scale = (float)(1UL << 31UL);
-	for (size_t i = 0; i < n; i++)
+	if (passthrough(jdsp))
 	{
-		jdsp->tmpBuffer[0][i] = (float)((double)x[i << 1] / scale);
-		jdsp->tmpBuffer[1][i] = (float)((double)x[(i << 1) + 1] / scale);
+		passthroughCopy(y, x, (n << 1) * sizeof(int32_t));
+		return;
 	}
+	jdsp->sampleConv->s32iToFloat(x, jdsp->tmpBuffer[0], jdsp->tmpBuffer[1], n, 1.0f / 2147483648.0f);
 	if (jdsp->enableASRC)
 	{
 		unsigned int curDecimatedLen = DoASRC_fwd(jdsp, n);
@@ -729,28 +1234,7 @@ void pint32Multiplexed(JamesDSPLib *jdsp, int32_t *x, int32_t *y, size_t n)
 	}
 	else
 		jdsp->processInternal(jdsp, n);
-	float f;
-	for (size_t i = 0; i < n; i++)
-	{
-		if (jdsp->tmpBuffer[0][i] <= -1.0f)
-			y[i << 1] = INT32_MIN;
-		else if (jdsp->tmpBuffer[0][i] >= 1.0f)
-			y[i << 1] = INT32_MAX;
-		else
-		{
-			f = jdsp->tmpBuffer[0][i] * scale;
-			y[i << 1] = (int32_t)(f > 0 ? f + 0.5f : f - 0.5f);
-		}
-		if (jdsp->tmpBuffer[1][i] <= -1.0f)
-			y[(i << 1) + 1] = INT32_MIN;
-		else if (jdsp->tmpBuffer[1][i] >= 1.0f)
-			y[(i << 1) + 1] = INT32_MAX;
-		else
-		{
-			f = jdsp->tmpBuffer[1][i] * scale;
-			y[(i << 1) + 1] = (int32_t)(f > 0 ? f + 0.5f : f - 0.5f);
-		}
-	}
+	jdsp->sampleConv->floatToS32i(jdsp->tmpBuffer[0], jdsp->tmpBuffer[1], y, n);
 }
 void pint8_24(JamesDSPLib *jdsp, int32_t *x1, int32_t *x2, int32_t *y1, int32_t *y2, size_t n)
 {
@@ -758,17 +1242,16 @@ void pint8_24(JamesDSPLib *jdsp, int32_t *x1, int32_t *x2, int32_t *y1, int32_t
 		JamesDSPReallocateBlock(jdsp, n);
 	if (jdsp->blockSize != n)
 	{
-		jdsp->blockSize = n;
-		JamesDSPRefreshConvolutions(jdsp, 1);
+		__atomic_store_n(&jdsp->blockSize, n, __ATOMIC_RELEASE);
+		requestRebuild(jdsp, JDSP_REBUILD_ALL);
 	}
-	static const float scale = (float)(1 << 23);
-	float limpos = 0x7fffff / scale;
-	float limneg = -0x800000 / scale;
-	for (size_t i = 0; i < n; i++)
+	if (passthrough(jdsp))
 	{
-		jdsp->tmpBuffer[0][i] = (float)((double)x1[i] / scale);
-		jdsp->tmpBuffer[1][i] = (float)((double)x2[i] / scale);
+		passthroughCopy(y1, x1, n * sizeof(int32_t));
+		passthroughCopy(y2, x2, n * sizeof(int32_t));
+		return;
 	}
+	jdsp->sampleConv->s32ToFloat(x1, x2, jdsp->tmpBuffer[0], jdsp->tmpBuffer[1], n, 1.0f / 8388608.0f);
 	if (jdsp->enableASRC)
 	{
 		unsigned int curDecimatedLen = DoASRC_fwd(jdsp, n);
@@ -777,14 +1260,7 @@ void pint8_24(JamesDSPLib *jdsp, int32_t *x1, int32_t *x2, int32_t *y1, int32_t
 	}
 	else
 		jdsp->processInternal(jdsp, n);
-	float f;
-	for (size_t i = 0; i < n; i++)
-	{
-		f = jdsp->tmpBuffer[0][i] * scale;
-		y1[i] = (int32_t)(f > 0 ? f + 0.5f : f - 0.5f);
-		f = jdsp->tmpBuffer[1][i] * scale;
-		y2[i] = (int32_t)(f > 0 ? f + 0.5f : f - 0.5f);
-	}
+	jdsp->sampleConv->floatToS8_24(jdsp->tmpBuffer[0], jdsp->tmpBuffer[1], y1, y2, n);
 }
 void pint8_24Multiplexed(JamesDSPLib *jdsp, int32_t *x, int32_t *y, size_t n)
 {
@@ -792,17 +1268,15 @@ void pint8_24Multiplexed(JamesDSPLib *jdsp, int32_t *x, int32_t *y, size_t n)
 		JamesDSPReallocateBlock(jdsp, n);
 	if (jdsp->blockSize != n)
 	{
-		jdsp->blockSize = n;
-		JamesDSPRefreshConvolutions(jdsp, 1);
+		__atomic_store_n(&jdsp->blockSize, n, __ATOMIC_RELEASE);
+		requestRebuild(jdsp, JDSP_REBUILD_ALL);
 	}
-	static const float scale = (float)(1 << 23);
-	float limpos = 0x7fffff / scale;
-	float limneg = -0x800000 / scale;
-	for (size_t i = 0; i < n; i++)
+	if (passthrough(jdsp))
 	{
-		jdsp->tmpBuffer[0][i] = (float)((double)x[i << 1] / scale);
-		jdsp->tmpBuffer[1][i] = (float)((double)x[(i << 1) + 1] / scale);
+		passthroughCopy(y, x, (n << 1) * sizeof(int32_t));
+		return;
 	}
+	jdsp->sampleConv->s32iToFloat(x, jdsp->tmpBuffer[0], jdsp->tmpBuffer[1], n, 1.0f / 8388608.0f);
 	if (jdsp->enableASRC)
 	{
 		unsigned int curDecimatedLen = DoASRC_fwd(jdsp, n);
@@ -811,14 +1285,7 @@ void pint8_24Multiplexed(JamesDSPLib *jdsp, int32_t *x, int32_t *y, size_t n)
 	}
 	else
 		jdsp->processInternal(jdsp, n);
-	float f;
-	for (size_t i = 0; i < n; i++)
-	{
-		f = jdsp->tmpBuffer[0][i] * scale;
-		y[i << 1] = (int32_t)(f > 0 ? f + 0.5f : f - 0.5f);
-		f = jdsp->tmpBuffer[1][i] * scale;
-		y[(i << 1) + 1] = (int32_t)(f > 0 ? f + 0.5f : f - 0.5f);
-	}
+	jdsp->sampleConv->floatToS8_24i(jdsp->tmpBuffer[0], jdsp->tmpBuffer[1], y, n);
 }
 void pintp24(JamesDSPLib *jdsp, uint8_t *x1, uint8_t *x2, uint8_t *y1, uint8_t *y2, size_t n)
 {
@@ -826,15 +1293,16 @@ void pintp24(JamesDSPLib *jdsp, uint8_t *x1, uint8_t *x2, uint8_t *y1, uint8_t *
 		JamesDSPReallocateBlock(jdsp, n);
 	if (jdsp->blockSize != n)
 	{
-		jdsp->blockSize = n;
-		JamesDSPRefreshConvolutions(jdsp, 1);
+		__atomic_store_n(&jdsp->blockSize, n, __ATOMIC_RELEASE);
+		requestRebuild(jdsp, JDSP_REBUILD_ALL);
 	}
-	static const float scale = 1.0f / (float)(1UL << 31);
-	for (size_t i = 0; i < n; i++)
+	if (passthrough(jdsp))
 	{
-		jdsp->tmpBuffer[0][i] = jdsp->i32_from_p24(x1 + i * 3) * scale;
-		jdsp->tmpBuffer[1][i] = jdsp->i32_from_p24(x2 + i * 3) * scale;
+		passthroughCopy(y1, x1, n * 3);
+		passthroughCopy(y2, x2, n * 3);
+		return;
 	}
+	jdsp->sampleConv->p24ToFloat(x1, x2, jdsp->tmpBuffer[0], jdsp->tmpBuffer[1], n);
 	if (jdsp->enableASRC)
 	{
 		unsigned int curDecimatedLen = DoASRC_fwd(jdsp, n);
@@ -843,11 +1311,7 @@ void pintp24(JamesDSPLib *jdsp, uint8_t *x1, uint8_t *x2, uint8_t *y1, uint8_t *
 	}
 	else
 		jdsp->processInternal(jdsp, n);
-	for (size_t i = 0; i < n; i++)
-	{
-		jdsp->p24_from_i32(clamp24_from_float(jdsp->tmpBuffer[0][i]), y1 + i * 3);
-		jdsp->p24_from_i32(clamp24_from_float(jdsp->tmpBuffer[1][i]), y2 + i * 3);
-	}
+	jdsp->sampleConv->floatToP24(jdsp->tmpBuffer[0], jdsp->tmpBuffer[1], y1, y2, n);
 }
 void pintp24Multiplexed(JamesDSPLib *jdsp, uint8_t *x, uint8_t *y, size_t n)
 {
@@ -855,15 +1319,15 @@ void pintp24Multiplexed(JamesDSPLib *jdsp, uint8_t *x, uint8_t *y, size_t n)
 		JamesDSPReallocateBlock(jdsp, n);
 	if (jdsp->blockSize != n)
 	{
-		jdsp->blockSize = n;
-		JamesDSPRefreshConvolutions(jdsp, 1);
+		__atomic_store_n(&jdsp->blockSize, n, __ATOMIC_RELEASE);
+		requestRebuild(jdsp, JDSP_REBUILD_ALL);
 	}
-	static const float scale = 1.0f / (float)(1UL << 31);
-	for (size_t i = 0; i < n; i++)
+	if (passthrough(jdsp))
 	{
-		jdsp->tmpBuffer[0][i] = jdsp->i32_from_p24(x + (i << 1) * 3) * scale;
-		jdsp->tmpBuffer[1][i] = jdsp->i32_from_p24(x + ((i << 1) + 1) * 3) * scale;
+		passthroughCopy(y, x, n * 6);
+		return;
 	}
+	jdsp->sampleConv->p24iToFloat(x, jdsp->tmpBuffer[0], jdsp->tmpBuffer[1], n);
 	if (jdsp->enableASRC)
 	{
 		unsigned int curDecimatedLen = DoASRC_fwd(jdsp, n);
@@ -872,11 +1336,7 @@ void pintp24Multiplexed(JamesDSPLib *jdsp, uint8_t *x, uint8_t *y, size_t n)
 	}
 	else
 		jdsp->processInternal(jdsp, n);
-	for (size_t i = 0; i < n; i++)
-	{
-		jdsp->p24_from_i32(clamp24_from_float(jdsp->tmpBuffer[0][i]), y + (i << 1) * 3);
-		jdsp->p24_from_i32(clamp24_from_float(jdsp->tmpBuffer[1][i]), y + ((i << 1) + 1) * 3);
-	}
+	jdsp->sampleConv->floatToP24i(jdsp->tmpBuffer[0], jdsp->tmpBuffer[1], y, n);
 }
 void pfloat32(JamesDSPLib *jdsp, float *x1, float *x2, float *y1, float *y2, size_t n)
 {
@@ -884,14 +1344,17 @@ void pfloat32(JamesDSPLib *jdsp, float *x1, float *x2, float *y1, float *y2, siz
 		JamesDSPReallocateBlock(jdsp, n);
 	if (jdsp->blockSize != n)
 	{
-		jdsp->blockSize = n;
-		JamesDSPRefreshConvolutions(jdsp, 1);
+		__atomic_store_n(&jdsp->blockSize, n, __ATOMIC_RELEASE);
+		requestRebuild(jdsp, JDSP_REBUILD_ALL);
 	}
-	for (size_t i = 0; i < n; i++)
+	if (passthrough(jdsp))
 	{
-		jdsp->tmpBuffer[0][i] = x1[i];
-		jdsp->tmpBuffer[1][i] = x2[i];
+		passthroughCopy(y1, x1, n * sizeof(float));
+		passthroughCopy(y2, x2, n * sizeof(float));
+		return;
 	}
+	memcpy(jdsp->tmpBuffer[0], x1, n * sizeof(float));
+	memcpy(jdsp->tmpBuffer[1], x2, n * sizeof(float));
 	if (jdsp->enableASRC)
 	{
 		unsigned int curDecimatedLen = DoASRC_fwd(jdsp, n);
@@ -900,11 +1363,8 @@ void pfloat32(JamesDSPLib *jdsp, float *x1, float *x2, float *y1, float *y2, siz
 	}
 	else
 		jdsp->processInternal(jdsp, n);
-	for (size_t i = 0; i < n; i++)
-	{
-		y1[i] = jdsp->tmpBuffer[0][i];
-		y2[i] = jdsp->tmpBuffer[1][i];
-	}
+	memcpy(y1, jdsp->tmpBuffer[0], n * sizeof(float));
+	memcpy(y2, jdsp->tmpBuffer[1], n * sizeof(float));
 }
 void pfloat32Multiplexed(JamesDSPLib *jdsp, float *x, float *y, size_t n)
 {
@@ -912,14 +1372,15 @@ void pfloat32Multiplexed(JamesDSPLib *jdsp, float *x, float *y, size_t n)
 		JamesDSPReallocateBlock(jdsp, n);
 	if (jdsp->blockSize != n)
 	{
-		jdsp->blockSize = n;
-		JamesDSPRefreshConvolutions(jdsp, 1);
+		__atomic_store_n(&jdsp->blockSize, n, __ATOMIC_RELEASE);
+		requestRebuild(jdsp, JDSP_REBUILD_ALL);
 	}
-	for (size_t i = 0; i < n; i++)
+	if (passthrough(jdsp))
 	{
-		jdsp->tmpBuffer[0][i] = x[i << 1];
-		jdsp->tmpBuffer[1][i] = x[(i << 1) + 1];
+		passthroughCopy(y, x, (n << 1) * sizeof(float));
+		return;
 	}
+	jdsp->sampleConv->floatDeinterleave(x, jdsp->tmpBuffer[0], jdsp->tmpBuffer[1], n);
 	if (jdsp->enableASRC)
 	{
 		unsigned int curDecimatedLen = DoASRC_fwd(jdsp, n);
@@ -928,11 +1389,7 @@ void pfloat32Multiplexed(JamesDSPLib *jdsp, float *x, float *y, size_t n)
 	}
 	else
 		jdsp->processInternal(jdsp, n);
-	for (size_t i = 0; i < n; i++)
-	{
-		y[i << 1] = jdsp->tmpBuffer[0][i];
-		y[(i << 1) + 1] = jdsp->tmpBuffer[1][i];
-	}
+	jdsp->sampleConv->floatInterleave(jdsp->tmpBuffer[0], jdsp->tmpBuffer[1], y, n);
 }
 extern void JamesDSPOfflineResampling(float const *in, float *out, size_t lenIn, size_t lenOut, int channels, double src_ratio);
 // Binary blobs
@@ -1048,11 +1505,17 @@ void JamesDSPInit(JamesDSPLib *jdsp, int n, float sample_rate)
 		jdsp->i32_from_p24 = i32_from_p24_big_endian;
 		jdsp->p24_from_i32 = p24_from_i32_big_endian;
 	}
+	jdsp->sampleConv = sampleKernelsSelect(JSAMPLE_BEST);
 	//
-	if (pthread_mutex_init(&jdsp->m_in_processing, NULL) != 0)
+	// Setters nest (sample rate change refreshes every effect), so the control lock is recursive
+	pthread_mutexattr_t attr;
+	pthread_mutexattr_init(&attr);
+	pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+	if (pthread_mutex_init(&jdsp->m_in_processing, &attr) != 0)
 		jdsp->isMutexSuccess = 0;
 	else
 		jdsp->isMutexSuccess = 1;
+	pthread_mutexattr_destroy(&attr);
 	// Init buffer
 	jdsp->blockSize = n;
 	jdsp->blockSizeMax = n;
@@ -1084,26 +1547,14 @@ void JamesDSPInit(JamesDSPLib *jdsp, int n, float sample_rate)
 			jdsp->fs = 48000;
 		InitIntegerASRCHandler(&jdsp->asrc[0], (unsigned long long)jdsp->fs, (unsigned long long)jdsp->trueSampleRate, asrc_taps, isminphase, 0, 0);
 		InitIntegerASRCHandler(&jdsp->asrc[1], (unsigned long long)jdsp->fs, (unsigned long long)jdsp->trueSampleRate, asrc_taps, isminphase, &jdsp->asrc[0].polyphaseDecimator, &jdsp->asrc[0].polyphaseInterpolator);
-		double ratio = (double)jdsp->fs / (double)jdsp->trueSampleRate;
-		unsigned int maxDecimatedLength = (unsigned int)ceil(n * ratio);
-		unsigned int maxInterpolatedLength = (unsigned int)ceil(maxDecimatedLength / ratio);
-		jdsp->pw2BlockMemSize = next_pow_2(maxInterpolatedLength);
-		size_t ctMemBlk = jdsp->blockSizeMax * 2 + maxInterpolatedLength * 2 + jdsp->pw2BlockMemSize * 2;
-		jdsp->tmpBuffer[0] = (float *)malloc(ctMemBlk * sizeof(float));
-		jdsp->tmpBuffer[1] = jdsp->tmpBuffer[0] + jdsp->blockSizeMax;
-		jdsp->tmpBuffer[2] = jdsp->tmpBuffer[1] + jdsp->blockSizeMax;
-		jdsp->tmpBuffer[3] = jdsp->tmpBuffer[2] + maxInterpolatedLength;
-		jdsp->tmpBuffer[4] = jdsp->tmpBuffer[3] + maxInterpolatedLength;
-		jdsp->tmpBuffer[5] = jdsp->tmpBuffer[4] + jdsp->pw2BlockMemSize;
+		JamesDSPReallocateBlock(jdsp, n);
 	}
 	else
 	{
-		size_t ctMemBlk = jdsp->blockSizeMax * 2;
-		jdsp->tmpBuffer[0] = (float *)malloc(ctMemBlk * sizeof(float));
-		jdsp->tmpBuffer[1] = jdsp->tmpBuffer[0] + jdsp->blockSizeMax;
 		jdsp->trueSampleRate = sample_rate;
 		jdsp->fs = sample_rate;
 		jdsp->enableASRC = 0;
+		JamesDSPReallocateBlock(jdsp, n);
 	}
 	// Init IO control
 	JLimiterInit(jdsp);
@@ -1115,6 +1566,8 @@ void JamesDSPInit(JamesDSPLib *jdsp, int n, float sample_rate)
 	CompressorDisable(jdsp);
 	BassBoostConstructor(jdsp);
 	BassBoostDisable(jdsp);
+	jdsp->reverb = 0;
+	jdsp->reverbCommitted = 0;
 	ReverbDisable(jdsp);
 	StereoEnhancementConstructor(jdsp);
 	StereoEnhancementDisable(jdsp);
@@ -1142,6 +1595,8 @@ void JamesDSPInit(JamesDSPLib *jdsp, int n, float sample_rate)
 	}
 	JamesDSPRefreshBlob(jdsp, (double)jdsp->fs);
 	jdsp->rndstate[1] = (uint64_t)(randXorshift(jdsp->rndstate) * 2.0);
+	jdsp->idleRelease = 30.0;
+	startRebuildWorker(jdsp);
 #ifdef DEBUG
 	__android_log_print(ANDROID_LOG_INFO, TAG, "Printing benchmark data start");
 	for (int s = 0; s < MAX_BENCHMARK; s++)
@@ -1186,19 +1641,7 @@ void JamesDSPSetSampleRate(JamesDSPLib *jdsp, float new_sample_rate, int forceRe
 			jdsp->fs = 48000;
 		InitIntegerASRCHandler(&jdsp->asrc[0], (unsigned long long)jdsp->fs, (unsigned long long)jdsp->trueSampleRate, asrc_taps, isminphase, 0, 0);
 		InitIntegerASRCHandler(&jdsp->asrc[1], (unsigned long long)jdsp->fs, (unsigned long long)jdsp->trueSampleRate, asrc_taps, isminphase, &jdsp->asrc[0].polyphaseDecimator, &jdsp->asrc[0].polyphaseInterpolator);
-		double ratio = (double)jdsp->fs / (double)jdsp->trueSampleRate;
-		unsigned int maxDecimatedLength = (unsigned int)ceil(jdsp->blockSizeMax * ratio);
-		unsigned int maxInterpolatedLength = (unsigned int)ceil(maxDecimatedLength / ratio);
-		jdsp->pw2BlockMemSize = next_pow_2(maxInterpolatedLength);
-		if (jdsp->tmpBuffer[0])
-			free(jdsp->tmpBuffer[0]);
-		size_t ctMemBlk = jdsp->blockSizeMax * 2 + maxInterpolatedLength * 2 + jdsp->pw2BlockMemSize * 2;
-		jdsp->tmpBuffer[0] = (float *)malloc(ctMemBlk * sizeof(float));
-		jdsp->tmpBuffer[1] = jdsp->tmpBuffer[0] + jdsp->blockSizeMax;
-		jdsp->tmpBuffer[2] = jdsp->tmpBuffer[1] + jdsp->blockSizeMax;
-		jdsp->tmpBuffer[3] = jdsp->tmpBuffer[2] + maxInterpolatedLength;
-		jdsp->tmpBuffer[4] = jdsp->tmpBuffer[3] + maxInterpolatedLength;
-		jdsp->tmpBuffer[5] = jdsp->tmpBuffer[4] + jdsp->pw2BlockMemSize;
+		JamesDSPReallocateBlock(jdsp, jdsp->blockSizeMax);
 	}
 	else
 	{
@@ -1225,9 +1668,12 @@ void JamesDSPSetSampleRate(JamesDSPLib *jdsp, float new_sample_rate, int forceRe
 }
 void JamesDSPFree(JamesDSPLib *jdsp)
 {
+	stopRebuildWorker(jdsp);
 	jdsp_lock(jdsp);
+	releaseParams(jdsp);
 	StereoEnhancementDestructor(jdsp);
 	CompressorDestructor(jdsp);
+	ReverbDestructor(jdsp);
 	LiveProgDestructor(jdsp);
 	DDCDestructor(jdsp);
 	CrossfeedDestructor(jdsp);
@@ -1252,8 +1698,7 @@ void JamesDSPFree(JamesDSPLib *jdsp)
 		for (i = 0; i < 4; i++)
 			free(jdsp->hrtfblobsResampled[i]);
 	}
-	if (jdsp->impulseResponseStorage.impulseResponse)
-		free(jdsp->impulseResponseStorage.impulseResponse);
+	Convolver1DReleaseStorage(&jdsp->impulseResponseStorage);
 	if (jdsp->isMutexSuccess)
 		pthread_mutex_destroy(&jdsp->m_in_processing);
 	if (jdsp->enableASRC)
@@ -5,11 +5,16 @@
 #include "generalDSP/interpolation.h"
 #include "Effects/eel2/numericSys/libsamplerate/samplerate.h"
 #include "generalDSP/TwoStageFFTConvolver.h"
+#include "generalDSP/MultiStageFFTConvolver.h"
+#include "generalDSP/IRCache.h"
 #include "generalDSP/digitalFilters.h"
 #include "Effects/eel2/numericSys/FilterDesign/fdesign.h"
 #include "Effects/eel2/eelCommon.h"
 #include "generalDSP/ArbFIRGen.h"
+#include "generalDSP/sampleConv.h"
 #define MAX_BENCHMARK (10)
+#define JDSP_BENCHMARK_LAYOUT (1) // Bump when the timed convolver changes, hosts then discard their cached fits
+#define CONV_DIRECT_HEAD_BELOW (64) // Host block sizes below this run the convolver with a time domain head
 // Misc
 extern double mapVal(double x, double in_min, double in_max, double out_min, double out_max);
 extern double mag2dB(double lin);
@@ -29,12 +34,26 @@ extern size_t fast_lower_bound(double *a, size_t n, double x);
 extern void fhtsinHalfTblFloat(float *dst, unsigned int n);
 extern void LLdiscreteHartleyFloat(float *A, const int nPoints, const float *sinTab);
 extern double randXorshift(uint64_t s[2]);
+extern double crossPlatformCurTime(void);
 // Misc end
+#define JLIMITER_TP_TAPS (12)
+#define JLIMITER_LOOKAHEAD_MAX (256)
+#define JLIMITER_FADE (256)
 typedef struct
 {
 	float threshold;
 	float relCoef;
 	float envOverThreshold;
+	// True peak mode, 4x polyphase peak detection ahead of a delayed output
+	int truePeak, truePeakRequest;
+	unsigned int lookahead, lookaheadRequest;
+	float tpCoeffs[3][JLIMITER_TP_TAPS];
+	float tpHist[2][JLIMITER_TP_TAPS - 1];
+	float delay[2][JLIMITER_LOOKAHEAD_MAX]; // Last post gain input samples of either mode, the lookahead delay line
+	unsigned int fadeFrom, fadePos; // Delay of the outgoing configuration and progress of the crossfade away from it
+	float holdVal[JLIMITER_LOOKAHEAD_MAX];
+	uint32_t holdPos[JLIMITER_LOOKAHEAD_MAX];
+	uint32_t holdHead, holdTail, clock;
 } JLimiter;
 #define FFTSIZE_DRS (8192)
 #define ANALYSIS_OVERLAP_DRS_MAX (8)
@@ -62,7 +81,7 @@ typedef struct str_dynfreqdomain
 	unsigned int fftLen, minus_fftLen, ovpLen, ovpCount, halfLen, smpShift, procUpTo;
 	void(*fft)(float*, const float*);
 	unsigned int mBitRev[FFTSIZE_DRS];
-	float 	mSineTab[FFTSIZE_DRS >> 1];
+	float 	mSineTab[FFTSIZE_DRS];
 	float synthesisWnd[FFTSIZE_DRS];
 	// Shared variable between all FFT length and modes and channel config
 	int  mOutputReadSampleOffset;
@@ -82,13 +101,9 @@ typedef struct str_dynfreqdomain
 	unsigned int smallGridSize;
 	char octaveSmooth[sizeof(unsigned int) + sizeof(float) + sizeof(unsigned int) + ((HALFWNDLEN_DRS + 1) << 1) * sizeof(unsigned int) + (HALFWNDLEN_DRS + 1) * sizeof(float) + ((HALFWNDLEN_DRS + 1) + 3) * 2 * sizeof(float)];
 	float finalGain[HALFWNDLEN_DRS];
-	double freq2[NUMPTS_DRS + 2];
 	float freq3[DYN_BANDS_GAMMATONE + 2];
-	double gains2[NUMPTS_DRS + 2];
-	float DREmultUniform[HALFWNDLEN_DRS];
 	float DREmult[HALFWNDLEN_DRS];
 	float oldBuf[HALFWNDLEN_DRS];
-	ierper pch;
 	float headRoomdB;
 	float fgt_fac, fgt_facT;
 	float spectralRate;
@@ -136,6 +151,12 @@ typedef struct str_dynfreqdomain
 	cplx tmp[2][PREPAD + HALFWNDLEN_DRS + POSPAD - 1];
 } FFTCompander;
 typedef struct
+{
+	float fgt_facT;
+	int granularity, tfresolution;
+	double freq[NUMPTS_DRS], gains[NUMPTS_DRS];
+} CompressorParam;
+typedef struct
 {
 	int needOversample;
 	samplerateTool smp[2];
@@ -382,6 +403,12 @@ typedef enum
 	SF_REVERB_PRESET_LONGREVERB2
 } sf_reverb_preset;
 extern void sf_advancereverb(sf_reverb_state_st *rv, int rate, int oversamplefactor, float ertolate, float erefwet, float dry, float ereffactor, float erefwidth, float width, float wet, float wander, float bassb, float spin, float inputlpf, float basslpf, float damplpf, float outputlpf, float rt60, float delay);
+typedef struct
+{
+	int preset; // -1 when set through ReverbSetAdvancedParam
+	int oversamplefactor;
+	float p[16]; // sf_advancereverb arguments, ertolate to delay
+} ReverbParam;
 
 typedef struct
 {
@@ -398,6 +425,7 @@ typedef struct
 	float *vmFs, *input1, *input2;
 	int compileSucessfully;
     int active;
+	char compileError[256]; // Last compile error, kept on the control side
 } LiveProg;
 typedef struct
 {
@@ -448,6 +476,12 @@ typedef struct
 	FFTConvolver2x4x2 *conv[3];
 	TwoStageFFTConvolver2x4x2 *convLong_T_S;
 	FFTConvolver2x4x2 *convLong_S_S;
+	MultiStageFFTConvolver2x4x2 *convLong_M_S; // Hybrid layout for hosts below CONV_DIRECT_HEAD_BELOW
+	// Mid/side convolvers replacing the ones above for left/right mirrored HRTFs
+	FFTConvolver2x2 *convMS[3];
+	TwoStageFFTConvolver2x2 *convLongMS_T_S;
+	FFTConvolver2x2 *convLongMS_S_S;
+	MultiStageFFTConvolver2x2 *convLongMS_M_S;
 	void(*process)(struct dspsys *, size_t);
 } Crossfeed;
 typedef struct
@@ -456,19 +490,25 @@ typedef struct
 	TwoStageFFTConvolver2x2 *conv1d2x2_T_S;
 	FFTConvolver2x4x2 *conv1d2x4x2_S_S;
 	TwoStageFFTConvolver2x4x2 *conv1d2x4x2_T_S;
+	MultiStageFFTConvolver2x2 *conv1d2x2_M_S;
+	MultiStageFFTConvolver2x4x2 *conv1d2x4x2_M_S;
 	void(*process)(struct dspsys*, size_t);
 } Convolver1D;
+#define JDSP_FUSED_EQUALIZER (1)
+#define JDSP_FUSED_ARBEQ (2)
+#define JDSP_FUSED_CONVOLVER (4)
 typedef struct
 {
 	ArbitraryEq coeffGen;
 	unsigned int filterLen;
-	FFTConvolver2x2 convState;
+	double lastDesign; // Design workspace is released once idle for JamesDSPLib.idleRelease
 } ArbEqConv;
 #define NUMPTS 15
 typedef struct
 {
 	// FIR
 	int currentInterpolationMode, operatingMode;
+	int requestedMode; // Control side, operatingMode follows once the snapshot is applied
 	ierper pch1, pch2;
 	ArbEqConv instance;
 	FFTConvolver2x2 conv;
@@ -496,8 +536,106 @@ typedef struct
 typedef struct
 {
 	float *impulseResponse;
+	IRCacheMapping *shared; // Owns impulseResponse when it is mapped from the cache
 	unsigned int impChannels, impulseLengthActual;
 } tmpIRData;
+// Stage profiler
+enum
+{
+	JDSP_STAGE_TUBE = 0,
+	JDSP_STAGE_COMPRESSOR,
+	JDSP_STAGE_BASSBOOST,
+	JDSP_STAGE_EQUALIZER,
+	JDSP_STAGE_ARBEQ,
+	JDSP_STAGE_CONVOLVER,
+	JDSP_STAGE_DDC,
+	JDSP_STAGE_LIVEPROG,
+	JDSP_STAGE_CROSSFEED,
+	JDSP_STAGE_STEREOENH,
+	JDSP_STAGE_REVERB,
+	JDSP_STAGE_LIMITER,
+	JDSP_STAGE_TOTAL,
+	JDSP_STAGE_COUNT
+};
+#define JDSP_STAGE_BLOCKBINS (9) // 32, 64, ..., 8192 samples
+#define JDSP_STAGE_HISTBINS (96) // 4 bins per octave, starting at 16 ns
+typedef struct
+{
+	uint64_t count;
+	double sumNs, minNs, maxNs;
+	uint32_t hist[JDSP_STAGE_HISTBINS];
+} JStageTimer;
+typedef struct
+{
+	int enabled;
+	JStageTimer timer[JDSP_STAGE_COUNT][JDSP_STAGE_BLOCKBINS];
+} JStageProfiler;
+typedef struct
+{
+	int stage;
+	unsigned int blockSize;
+	uint64_t count;
+	double minNs, meanNs, maxNs, p99Ns;
+} JStageStats;
+// Memory footprint
+enum
+{
+	JDSP_MEM_CORE = 0,
+	JDSP_MEM_COMPRESSOR,
+	JDSP_MEM_BASSBOOST,
+	JDSP_MEM_EQUALIZER,
+	JDSP_MEM_ARBEQ,
+	JDSP_MEM_CONVOLVER,
+	JDSP_MEM_DDC,
+	JDSP_MEM_LIVEPROG,
+	JDSP_MEM_CROSSFEED,
+	JDSP_MEM_STEREOENH,
+	JDSP_MEM_REVERB,
+	JDSP_MEM_TUBE,
+	JDSP_MEM_PROFILER,
+	JDSP_MEM_COUNT
+};
+typedef struct
+{
+	int item;
+	size_t bytes;
+	int allocated; // Nonzero when the effect currently owns heap state
+} JMemoryUsage;
+// Double-buffered parameter commits
+enum
+{
+	JDSP_PARAM_EQUALIZER = 0,
+	JDSP_PARAM_ARBEQ,
+	JDSP_PARAM_CONVOLVER,
+	JDSP_PARAM_DDC,
+	JDSP_PARAM_LIVEPROG,
+	JDSP_PARAM_CROSSFEED,
+	JDSP_PARAM_COMPRESSOR,
+	JDSP_PARAM_REVERB,
+	JDSP_PARAM_COUNT
+};
+#define JDSP_PARAM_RETIRESLOTS (4)
+typedef struct JParamSnapshot
+{
+	void(*apply)(struct dspsys *, struct JParamSnapshot *); // Audio thread, exchanges snapshot contents with the live state
+	void(*destroy)(struct JParamSnapshot *); // Control thread, releases whatever the snapshot holds after apply
+	unsigned int seq;
+	char held; // Set by apply when the effect keeps the snapshot past the block boundary
+} JParamSnapshot;
+typedef struct
+{
+	JParamSnapshot *pending;
+	JParamSnapshot *retired[JDSP_PARAM_RETIRESLOTS];
+	unsigned int retireHead, retireTail; // Head written by audio thread, tail by control thread
+	unsigned int published, applied;
+} JParamSlot;
+typedef struct
+{
+	JParamSnapshot *snap; // Holds the outgoing convolver until its tail has played out
+	int slot;
+	unsigned int remaining;
+	unsigned int fadeLen; // Nonzero while crossfading, the outgoing instance then runs on the live input
+} JParamDrain;
 typedef struct dspsys
 {
 	// Sys var
@@ -507,16 +645,24 @@ typedef struct dspsys
 	// Effect
 	// Compressor
 	int compEnabled, compForceRefresh;
-	FFTCompander comp;
+	FFTCompander *comp; // Allocated on first enable, swapped in by parameter snapshots
+	int compCommitted; // An instance is playing or pending, control thread
+	CompressorParam compParam;
+	ierper compPch; // Gain curve design, control thread
+	double compIdleSince;
 	// Bass boost
 	int bassBoostEnabled;
 	DBB dbb;
 	// Equalizer
 	int equalizerEnabled, equalizerForceRefresh;
 	MultimodalEQ mEQ;
+	JParamDrain eqDrain;
 	// Reverb
 	int reverbEnabled;
-	sf_reverb_state_st reverb;
+	sf_reverb_state_st *reverb; // Allocated on first enable, swapped in by parameter snapshots
+	int reverbCommitted; // An instance is playing or pending, control thread
+	ReverbParam reverbParam;
+	double reverbIdleSince;
 	// Stereo enhancement
 	int sterEnhEnabled;
 	stereoEnhancement sterEnh;
@@ -526,27 +672,42 @@ typedef struct dspsys
 	// Crossfeed
 	int crossfeedEnabled, crossfeedForceRefresh;
 	Crossfeed advXF;
+	JParamDrain xfDrain;
 	// DDC
 	int ddcEnabled, ddcForceRefresh;
 	DDC vdcFl;
 	// Convolver
 	int convolverEnabled;
 	Convolver1D conv;
+	JParamDrain convDrain;
+	float convCrossfadeMs;
+	int convShareSpectra;
+	float convSkipThresholdDb; // 0: every partition is multiplied
+	FFTConvolverSkipStats convSkipStats; // Of the last loaded IR
+	int convFusedLTI; // Fold the FIR equalizer and arbitrary magnitude kernels into the convolver IR
+	int convFused; // JDSP_FUSED_* stages the playing convolver runs in place of their own
+	int convFusedOut; // Of the instance fading out, its input skips the stages as well, audio thread
+	int convFusedCommitted; // Of the last committed IR, control thread
+	float *convFusedKernel[2]; // Last designed equalizer and arbitrary magnitude kernels, NULL: IIR or none
+	unsigned int convFusedKernelLen[2];
 	// Live programmable effect
 	int liveprogEnabled;
 	LiveProg eel;
 	// Arbitrary magnitude response
 	int arbitraryMagEnabled, arbMagForceRefresh;
 	arbitraryMagnitude arbMag;
+	JParamDrain arbMagDrain;
 	// Output limiter
 	float postGain;
 	JLimiter limiter;
-	size_t blockSize, blockSizeMax, pw2BlockMemSize;
-	float *tmpBuffer[6];
+	size_t blockSize, blockSizeMax, pw2BlockMemSize; // blockSize is published by the audio thread, read it with JamesDSPBlockSize elsewhere
+	int passthrough;
+	float *tmpBuffer[10];
 	// Internal function pointer
 	void(*processInternal)(struct dspsys *, size_t);
 	int32_t(*i32_from_p24)(const uint8_t *);
 	void (*p24_from_i32)(int32_t, uint8_t *);
+	const JSampleKernels *sampleConv;
 	// I/O function pointer
 	void(*processInt16Deinterleaved)(struct dspsys*, int16_t*, int16_t*, int16_t*, int16_t*, size_t);
 	void(*processInt32Deinterleaved)(struct dspsys*, int32_t*, int32_t*, int32_t*, int32_t*, size_t);
@@ -567,11 +728,22 @@ typedef struct dspsys
 	int frameLenSVirResampled;
 	float *hrtfblobsResampled[4];
 	tmpIRData impulseResponseStorage;
-	// Mutex lock(pthread)
+	// Parameter snapshots waiting for a block boundary
+	JParamSlot param[JDSP_PARAM_COUNT];
+	// Convolution rebuild worker, block size changes are repartitioned off the audio thread
+	int rebuildThreadActive, rebuildStop, rebuildRequest, rebuildBusy;
+	pthread_t rebuildThread;
+	pthread_mutex_t rebuildMutex;
+	pthread_cond_t rebuildCond;
+	// Seconds a disabled effect keeps its state before the worker frees it, negative keeps it forever
+	double idleRelease;
+	// Mutex lock(pthread), serializes control threads only
 	int isMutexSuccess;
 	pthread_mutex_t m_in_processing;
 	// Random number and related
 	uint64_t rndstate[2];
+	// Per stage timing
+	JStageProfiler profiler;
 } JamesDSPLib;
 // JamesDSP controller
 extern void JamesDSPGlobalMemoryAllocation();
@@ -580,6 +752,7 @@ extern void JamesDSPReallocateBlock(JamesDSPLib *jdsp, size_t blockSizeMax);
 extern void JamesDSP_Load_benchmark(double *_c0, double *_c1);
 extern void JamesDSP_Save_benchmark(double *_c0, double *_c1);
 extern void JamesDSP_Start_benchmark();
+extern const char *JamesDSPGetBuildId();
 extern void jdsp_lock(JamesDSPLib *jdsp);
 extern void jdsp_unlock(JamesDSPLib *jdsp);
 extern void JamesDSPFree(JamesDSPLib *jdsp);
@@ -587,10 +760,34 @@ extern void JamesDSPInit(JamesDSPLib *jdsp, int blockSizeMax, float sample_rate)
 extern void JamesDSPSetPostGain(JamesDSPLib *jdsp, double pGaindB);
 extern int JamesDSPGetMutexStatus(JamesDSPLib *jdsp);
 extern void JamesDSPSetSampleRate(JamesDSPLib *jdsp, float new_sample_rate, int forceRefresh);
-extern int selectConvPartitions(JamesDSPLib *jdsp, unsigned int impulseLengthActual, unsigned int *seg2Len);
+extern unsigned int JamesDSPBlockSize(JamesDSPLib *jdsp);
+extern int selectConvPartitions(JamesDSPLib *jdsp, unsigned int blockSize, unsigned int impulseLengthActual, unsigned int *seg2Len);
+extern unsigned int selectConvStages(JamesDSPLib *jdsp, unsigned int blockSize, unsigned int impulseLengthActual, unsigned int *blockSizes);
+// Parameter commits
+extern void JamesDSPCommitParam(JamesDSPLib *jdsp, int slot, JParamSnapshot *snap);
+extern int JamesDSPParamPending(JamesDSPLib *jdsp, int slot);
+extern void JamesDSPReclaimParams(JamesDSPLib *jdsp);
+extern void JamesDSPDrainStart(JamesDSPLib *jdsp, JParamDrain *drain, int slot, JParamSnapshot *snap, unsigned int len);
+extern float **JamesDSPDrainBuffer(JamesDSPLib *jdsp, size_t n);
+extern void JamesDSPDrainFinish(JamesDSPLib *jdsp, JParamDrain *drain, size_t n);
+extern void JamesDSPCrossfadeStart(JamesDSPLib *jdsp, JParamDrain *drain, int slot, JParamSnapshot *snap, unsigned int len);
+extern float **JamesDSPCrossfadeBuffer(JamesDSPLib *jdsp, size_t n);
+extern int JamesDSPRebuildPending(JamesDSPLib *jdsp);
+extern void JamesDSPSetIdleRelease(JamesDSPLib *jdsp, double seconds);
+// Memory footprint
+extern const char *JamesDSPMemoryItemName(int item);
+extern size_t JamesDSPGetMemoryUsage(JamesDSPLib *jdsp, JMemoryUsage *usage);
+// Stage profiler
+extern void JamesDSPStageProfilerEnable(JamesDSPLib *jdsp, int enable);
+extern void JamesDSPStageProfilerReset(JamesDSPLib *jdsp);
+extern const char *JamesDSPStageName(int stage);
+extern int JamesDSPGetStageStats(JamesDSPLib *jdsp, JStageStats *stats, int maxStats);
 // Limiter
 extern void JLimiterSetCoefficients(JamesDSPLib *jdsp, double thresholddB, double msRelease);
 extern void JLimiterInit(JamesDSPLib *jdsp);
+extern void JLimiterReset(JamesDSPLib *jdsp);
+extern void JLimiterSetTruePeak(JamesDSPLib *jdsp, int enable);
+extern void JLimiterProcess(JamesDSPLib *jdsp, size_t n);
 // Compressor
 extern void CompressorConstructor(JamesDSPLib *jdsp);
 extern void CompressorDestructor(JamesDSPLib *jdsp);
@@ -598,6 +795,7 @@ extern void CompressorSetParam(JamesDSPLib *jdsp, float fgt_facT, int granularit
 extern void CompressorSetGain(JamesDSPLib *jdsp, double *freq, double *gains, char cpy);
 extern void CompressorEnable(JamesDSPLib *jdsp, char enable);
 extern void CompressorDisable(JamesDSPLib *jdsp);
+extern void CompressorReleaseIdle(JamesDSPLib *jdsp, double now);
 extern void CompressorProcess(JamesDSPLib *jdsp, size_t n);
 // Bass boost
 extern void BassBoostEnable(JamesDSPLib *jdsp);
@@ -607,8 +805,11 @@ extern void BassBoostSetParam(JamesDSPLib *jdsp, float maxG);
 extern void BassBoostProcess(JamesDSPLib *jdsp, size_t n);
 // Reverb
 extern void Reverb_SetParam(JamesDSPLib *jdsp, int presets);
+extern void ReverbSetAdvancedParam(JamesDSPLib *jdsp, int oversamplefactor, float ertolate, float erefwet, float dry, float ereffactor, float erefwidth, float width, float wet, float wander, float bassb, float spin, float inputlpf, float basslpf, float damplpf, float outputlpf, float rt60, float delay);
 extern void ReverbEnable(JamesDSPLib *jdsp);
 extern void ReverbDisable(JamesDSPLib *jdsp);
+extern void ReverbReleaseIdle(JamesDSPLib *jdsp, double now);
+extern void ReverbDestructor(JamesDSPLib *jdsp);
 extern void ReverbProcess(JamesDSPLib *jdsp, size_t n);
 // Stereo enhancement
 extern void StereoEnhancementDestructor(JamesDSPLib *jdsp);
@@ -628,6 +829,7 @@ extern const char* checkErrorCode(int errCode);
 extern void LiveProgConstructor(JamesDSPLib *jdsp);
 extern void LiveProgDestructor(JamesDSPLib *jdsp);
 extern int LiveProgStringParser(JamesDSPLib *jdsp, char *eelCode);
+extern const char *LiveProgGetCompileError(JamesDSPLib *jdsp);
 extern void LiveProgEnable(JamesDSPLib *jdsp);
 extern void LiveProgDisable(JamesDSPLib *jdsp);
 extern void LiveProgProcess(JamesDSPLib *jdsp, size_t n);
@@ -650,13 +852,24 @@ extern void Convolver1DEnable(JamesDSPLib *jdsp);
 extern void Convolver1DDisable(JamesDSPLib *jdsp);
 extern void Convolver1DConstructor(JamesDSPLib *jdsp);
 extern void Convolver1DDestructor(JamesDSPLib *jdsp);
+extern void Convolver1DProcess(JamesDSPLib *jdsp, size_t n);
 extern int Convolver1DLoadImpulseResponse(JamesDSPLib *jdsp, float *tempImpulseFloat, unsigned int impChannels, size_t impulseLengthActual, char updateOld);
+extern void Convolver1DSetCrossfade(JamesDSPLib *jdsp, float ms);
+extern void Convolver1DSetSharedSpectra(JamesDSPLib *jdsp, int enable);
+extern void Convolver1DSetPartitionSkip(JamesDSPLib *jdsp, float thresholdDb);
+extern void Convolver1DGetPartitionSkipStats(JamesDSPLib *jdsp, FFTConvolverSkipStats *stats);
+extern void Convolver1DSetFusedLTI(JamesDSPLib *jdsp, int enable);
+extern void Convolver1DFuseKernel(JamesDSPLib *jdsp, int stage, const float *kernel, unsigned int len);
+extern void Convolver1DFuseRefresh(JamesDSPLib *jdsp);
+extern void Convolver1DReleaseStorage(tmpIRData *ir);
 // Arbitrary magnitude response
 extern void ArbitraryResponseEqualizerConstructor(JamesDSPLib *jdsp);
 extern void ArbitraryResponseEqualizerDestructor(JamesDSPLib *jdsp);
 extern void ArbitraryResponseEqualizerStringParser(JamesDSPLib *jdsp, char *stringEq);
 extern void ArbitraryResponseEqualizerEnable(JamesDSPLib *jdsp, char enable);
 extern void ArbitraryResponseEqualizerDisable(JamesDSPLib *jdsp);
+extern void ArbitraryResponseEqualizerReleaseIdle(JamesDSPLib *jdsp, double now);
+extern size_t ArbitraryResponseEqualizerMemoryUsage(JamesDSPLib *jdsp);
 extern void ArbitraryResponseEqualizerProcess(JamesDSPLib *jdsp, size_t n);
 // FIR Equalizer
 extern void MultimodalEqualizerConstructor(JamesDSPLib *jdsp);
@@ -664,6 +877,8 @@ extern void MultimodalEqualizerDestructor(JamesDSPLib *jdsp);
 extern void MultimodalEqualizerAxisInterpolation(JamesDSPLib *jdsp, int interpolationMode, int operatingMode, double *freqAx, double *gaindB);
 extern void MultimodalEqualizerEnable(JamesDSPLib *jdsp, char enable);
 extern void MultimodalEqualizerDisable(JamesDSPLib *jdsp);
+extern void MultimodalEqualizerReleaseIdle(JamesDSPLib *jdsp, double now);
+extern size_t MultimodalEqualizerMemoryUsage(JamesDSPLib *jdsp);
 extern void MultimodalEqualizerProcess(JamesDSPLib *jdsp, size_t n);
 extern void HSHOResponse(double fs, double fc, unsigned int filterOrder, double gain, double overallGainDb, unsigned int queryPts, double *dispFreq, double *cplxRe, double *cplxIm);
 #endif
@@ -3,33 +3,131 @@
 #include "config/AppConfig.h"
 #include "utils/Log.h"
 
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSysInfo>
+#include <QThread>
+
 extern "C" {
 #include <jdsp_header.h>
 }
 
+static QString readFirstLine(const QString& path)
+{
+    QFile f(path);
+    if(!f.open(QFile::ReadOnly | QFile::Text))
+        return QString();
+    return QString::fromUtf8(f.readLine()).trimmed();
+}
+
+static QString cpuModel()
+{
+    QFile f("/proc/cpuinfo");
+    if(f.open(QFile::ReadOnly | QFile::Text))
+    {
+        // x86 exposes 'model name', most ARM kernels only expose implementer/part ids
+        QStringList fields = {"model name", "Hardware", "CPU implementer", "CPU part"};
+        QStringList found;
+        while(!f.atEnd())
+        {
+            QString line = QString::fromUtf8(f.readLine());
+            int sep = line.indexOf(':');
+            if(sep < 0)
+                continue;
+            QString name = line.left(sep).trimmed();
+            if(fields.contains(name) && !found.contains(name + "=" + line.mid(sep + 1).trimmed()))
+                found.append(name + "=" + line.mid(sep + 1).trimmed());
+        }
+        if(!found.isEmpty())
+            return found.join(',');
+    }
+    return QSysInfo::currentCpuArchitecture();
+}
+
 BenchmarkWorker::BenchmarkWorker(QObject *parent) : QObject{parent} {}
 
-void BenchmarkWorker::writeCache(int num, double* data) {
-    QString result = QString::number(data[0]);
+QString BenchmarkWorker::hardwareKey()
+{
+    QString governor = readFirstLine("/sys/devices/system/cpu/cpu0/cpufreq/scaling_governor");
+    if(governor.isEmpty())
+        governor = "unknown";
+
+    return QString("%1|%2 threads|%3|%4")
+            .arg(cpuModel())
+            .arg(QThread::idealThreadCount())
+            .arg(governor)
+            .arg(JamesDSPGetBuildId());
+}
+
+bool BenchmarkWorker::readCache(double* c0, double* c1)
+{
+    QJsonObject cache = QJsonDocument::fromJson(AppConfig::instance().get<QByteArray>(AppConfig::BenchmarkCache)).object();
+    QJsonObject entry = cache.value(hardwareKey()).toObject();
+    QJsonArray arr0 = entry.value("c0").toArray();
+    QJsonArray arr1 = entry.value("c1").toArray();
+    if(arr0.size() != MAX_BENCHMARK || arr1.size() != MAX_BENCHMARK)
+        return false;
 
-    for(int i = 1; i < MAX_BENCHMARK; i++)
-        result.append(";" + QString::number(data[i]));
+    for(int i = 0; i < MAX_BENCHMARK; i++) {
+        c0[i] = arr0[i].toDouble();
+        c1[i] = arr1[i].toDouble();
+    }
+    return true;
+}
+
+bool BenchmarkWorker::hasCache()
+{
+    double c0[MAX_BENCHMARK];
+    double c1[MAX_BENCHMARK];
+    return readCache(c0, c1);
+}
+
+void BenchmarkWorker::clearCache()
+{
+    AppConfig::instance().setBytes(AppConfig::BenchmarkCache, QByteArray());
+}
+
+void BenchmarkWorker::writeCache(double* c0, double* c1) {
+    QJsonArray arr0;
+    QJsonArray arr1;
+    for(int i = 0; i < MAX_BENCHMARK; i++) {
+        arr0.append(c0[i]);
+        arr1.append(c1[i]);
+    }
 
-    AppConfig::instance().set(num == 0 ? AppConfig::BenchmarkCacheC0 : AppConfig::BenchmarkCacheC1, result);
+    QJsonObject entry;
+    entry["c0"] = arr0;
+    entry["c1"] = arr1;
+
+    // Entries of other machines/governors are kept, a shared home directory may see several of them
+    // Entries of another benchmark layout are never read again, drop them
+    const QString layoutSuffix = QString("|") + JamesDSPGetBuildId();
+    QJsonObject cache = QJsonDocument::fromJson(AppConfig::instance().get<QByteArray>(AppConfig::BenchmarkCache)).object();
+    for(auto it = cache.begin(); it != cache.end();)
+    {
+        if(!it.key().endsWith(layoutSuffix))
+            it = cache.erase(it);
+        else
+            ++it;
+    }
+    cache[hardwareKey()] = entry;
+    AppConfig::instance().setBytes(AppConfig::BenchmarkCache, QJsonDocument(cache).toJson(QJsonDocument::Compact));
 }
 
 void BenchmarkWorker::process() {
-    Log::debug("Starting benchmark...");
+    Log::debug("Starting convolver autotuning for " + hardwareKey());
+    QElapsedTimer timer;
+    timer.start();
     JamesDSP_Start_benchmark();
 
-    double* c0 = new double[MAX_BENCHMARK];
-    double* c1 = new double[MAX_BENCHMARK];
+    double c0[MAX_BENCHMARK];
+    double c1[MAX_BENCHMARK];
     JamesDSP_Save_benchmark(c0, c1);
+    writeCache(c0, c1);
 
-    writeCache(0, c0);
-    writeCache(1, c1);
-    delete[] c0;
-    delete[] c1;
-
+    Log::debug(QString("Convolver autotuning finished after %1ms").arg(timer.elapsed()));
     emit finished();
 }
@@ -8,6 +8,12 @@ class BenchmarkWorker : public QObject {
 public:
     BenchmarkWorker(QObject *parent = nullptr);
 
+    /* Identifies the CPU model, frequency governor and library build the cost model was measured on */
+    static QString hardwareKey();
+    static bool readCache(double* c0, double* c1);
+    static bool hasCache();
+    static void clearCache();
+
 public slots:
     void process();
 
@@ -15,7 +21,7 @@ signals:
     void finished();
 
 private:
-    void writeCache(int num, double *data);
+    static void writeCache(double* c0, double* c1);
 
 };
 
@@ -1,8 +1,8 @@
+#include "config/AppConfig.h"
 #include "config/DspConfig.h"
 #include "Utils.h"
 #include "BenchmarkWorker.h"
 
-#include <QTimer>
 #include <sstream>
 #include <string>
 
@@ -10,6 +10,9 @@
 #include "EventArgs.h"
 
 #include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
 #include <QTextStream>
 #include <QThread>
 #include <QDebug>
@@ -58,15 +61,36 @@ DspHost::DspHost(void* dspPtr, MessageHandlerFunc&& extraHandler) : _extraFunc(s
         dispatch(Message::BenchmarkDone, nullptr);
     });
 
-    loadBenchmarkData();
+    // Autotuning only takes a fraction of a second, so re-tune right away if the cache does not match this machine
+    if(!loadBenchmarkData() && AppConfig::instance().get<bool>(AppConfig::BenchmarkOnBoot))
+        runBenchmarks();
 
-    if(AppConfig::instance().get<bool>(AppConfig::BenchmarkOnBoot))
-        QTimer::singleShot(30000, [this]{ runBenchmarks(); });
+    updateWorkerPool();
+    updateIrCache();
+    appConfigConnection = QObject::connect(&AppConfig::instance(), &AppConfig::updated, [this](const AppConfig::Key& key, const QVariant&) {
+        switch(key)
+        {
+            case AppConfig::ConvolverThreads:
+            case AppConfig::ConvolverRtPriority:
+            case AppConfig::ConvolverCpuAffinity:
+            case AppConfig::ConvolverLowLatency:
+                updateWorkerPool();
+                break;
+            case AppConfig::ConvolverCacheEnabled:
+            case AppConfig::ConvolverCacheDirectory:
+            case AppConfig::ConvolverCacheLimit:
+                updateIrCache();
+                break;
+            default:
+                break;
+        }
+    });
 }
 
 DspHost::~DspHost()
 {
     setStdOutHandler(NULL, NULL);
+    QObject::disconnect(appConfigConnection);
 
     _cache->deleteLater();
     benchmarkThread->deleteLater();
@@ -88,42 +112,59 @@ void DspHost::runBenchmarks()
     benchmarkThread->start();
 }
 
-void DspHost::loadBenchmarkData()
+bool DspHost::loadBenchmarkData()
 {
-    // Empty cache = no benchmark data stored
-    if(AppConfig::instance().get<QString>(AppConfig::BenchmarkCacheC0).isEmpty() &&
-       AppConfig::instance().get<QString>(AppConfig::BenchmarkCacheC1).isEmpty())
-        return;
+    double c0[MAX_BENCHMARK];
+    double c1[MAX_BENCHMARK];
 
-    auto loadFromCache = [](int num, double* output){
-        auto values = AppConfig::instance().get<QString>(num == 0 ? AppConfig::BenchmarkCacheC0 : AppConfig::BenchmarkCacheC1).split(';', Qt::SkipEmptyParts);
-        if(values.size() != MAX_BENCHMARK)
-            return false;
+    if(!BenchmarkWorker::readCache(c0, c1)) {
+        Log::debug("No cached convolver benchmark data for this hardware");
+        return false;
+    }
 
-        for(int i = 0; i < values.size(); i++) {
-            bool ok = false;
-            output[i] = values[i].toDouble(&ok);
-            if(!ok)
-                return false;
-        }
-        return true;
-    };
+    JamesDSP_Load_benchmark(c0, c1);
+    return true;
+}
 
-    double* c0 = new double[MAX_BENCHMARK];
-    double* c1 = new double[MAX_BENCHMARK];
+void DspHost::updateWorkerPool()
+{
+    auto& appConfig = AppConfig::instance();
 
-    bool ok0 = loadFromCache(0, c0);
-    bool ok1 = loadFromCache(1, c1);
+    ConvolverWorkerPoolConfig cfg;
+    memset(&cfg, 0, sizeof(cfg));
+    int threads = appConfig.get<int>(AppConfig::ConvolverThreads);
+    cfg.maxThreads = threads > 0 ? threads : 0;
+    cfg.rtPriority = appConfig.get<int>(AppConfig::ConvolverRtPriority);
+    cfg.lowLatency = appConfig.get<bool>(AppConfig::ConvolverLowLatency);
 
-    if(!ok0 || !ok1) {
-        Log::error("Failed to parse cached benchmark data");
-        return;
+    // List of CPU indices the tail workers may run on, empty for any CPU
+    for(const auto& cpu : appConfig.get<QStringList>(AppConfig::ConvolverCpuAffinity))
+    {
+        bool ok;
+        int index = cpu.trimmed().toInt(&ok);
+        if(ok && index >= 0 && index < 64)
+            cfg.cpuMask |= 1ULL << index;
     }
 
-    JamesDSP_Load_benchmark(c0, c1);
+    ConvolverWorkerPoolConfigure(&cfg);
+}
+
+void DspHost::updateIrCache()
+{
+    auto& appConfig = AppConfig::instance();
+
+    // An empty directory disables the cache
+    QString directory;
+    if(appConfig.get<bool>(AppConfig::ConvolverCacheEnabled))
+    {
+        directory = chopDoubleQuotes(appConfig.get<QString>(AppConfig::ConvolverCacheDirectory));
+        if(directory.isEmpty())
+            directory = appConfig.getCachePath("ir");
+    }
 
-    delete[] c0;
-    delete[] c1;
+    IRCacheSetDirectory(directory.toLocal8Bit().constData());
+    int limitMiB = appConfig.get<int>(AppConfig::ConvolverCacheLimit);
+    IRCacheSetLimit(limitMiB > 0 ? (uint64_t)limitMiB << 20 : 0);
 }
 
 void DspHost::updateLimiter(DspConfig* config)
@@ -152,6 +193,7 @@ void DspHost::updateLimiter(DspConfig* config)
     }
 
     JLimiterSetCoefficients(cast(this->_dsp), limThreshold, limRelease);
+    JLimiterSetTruePeak(cast(this->_dsp), config->get<bool>(DspConfig::master_limtruepeak));
 }
 
 void DspHost::updateFirEqualizer(DspConfig *config)
@@ -319,9 +361,9 @@ void DspHost::updateReverb(DspConfig* config)
     GET_PARAM(wet, float, 0, msg);
     GET_PARAM(width, float, 1.0, msg);
 
-    sf_advancereverb(&cast(this->_dsp)->reverb, cast(this->_dsp)->fs, osf, reflection_amount, finalwet, finaldry,
-                     reflection_factor, reflection_width, width, wet, lfo_wander, bassboost, lfo_spin,
-                     lpf_input, lpf_bass, lpf_damp, lpf_output, decay, delay / 1000.0f);
+    ReverbSetAdvancedParam(cast(this->_dsp), osf, reflection_amount, finalwet, finaldry,
+                           reflection_factor, reflection_width, width, wet, lfo_wander, bassboost, lfo_spin,
+                           lpf_input, lpf_bass, lpf_damp, lpf_output, decay, delay / 1000.0f);
 #undef GET_PARAM
 }
 
@@ -427,8 +469,12 @@ void DspHost::updateConvolver(DspConfig *config)
 
         util::debug("Impulse response loaded: channels=" + std::to_string(impInfo[0]) + ", frames=" + std::to_string(impInfo[1]));
 
-        Convolver1DDisable(cast(this->_dsp));
+        // Takes effect with the next load, so set it right before
+        Convolver1DSetSharedSpectra(cast(this->_dsp), config->get<bool>(DspConfig::convolver_share_spectra));
+
+        // The playing IR stays enabled, the library crossfades to the new one
         success = Convolver1DLoadImpulseResponse(cast(this->_dsp), impulse, impInfo[0], impInfo[1], 1);
+        reportPartitionSkip();
     }
 
     delete[] impInfo;
@@ -445,6 +491,20 @@ void DspHost::updateConvolver(DspConfig *config)
     }
 }
 
+void DspHost::reportPartitionSkip()
+{
+    FFTConvolverSkipStats stats;
+    Convolver1DGetPartitionSkipStats(cast(this->_dsp), &stats);
+    if(stats.partitions == 0)
+        return;
+
+    util::info(QString("Partition skipping: dropped %1/%2 partitions, error %3 dB, peak error at most %4, %5% of the spectral MACs saved")
+                   .arg(stats.droppedPartitions).arg(stats.partitions)
+                   .arg(FFTConvolverSkipErrorDb(&stats), 0, 'f', 1)
+                   .arg(FFTConvolverSkipPeakError(&stats), 0, 'g', 3)
+                   .arg(FFTConvolverSkipSaving(&stats) * 100.0, 0, 'f', 1).toStdString());
+}
+
 void DspHost::updateGraphicEq(DspConfig *config)
 {
     bool paramExists;
@@ -575,9 +635,22 @@ bool DspHost::update(DspConfig *config, bool ignoreCache)
         case DspConfig::convolver_enable:
         case DspConfig::convolver_file:
         case DspConfig::convolver_optimization_mode:
+        case DspConfig::convolver_share_spectra:
         case DspConfig::convolver_waveform_edit:
             refreshConvolver = true;
             break;
+        case DspConfig::convolver_crossfade_ms:
+            // Applies to the next impulse response change
+            Convolver1DSetCrossfade(cast(this->_dsp), current.toFloat());
+            break;
+        case DspConfig::convolver_fused_lti:
+            Convolver1DSetFusedLTI(cast(this->_dsp), current.toBool());
+            break;
+        case DspConfig::convolver_skip_threshold:
+            // Reloads the playing IR itself when the threshold changes
+            Convolver1DSetPartitionSkip(cast(this->_dsp), current.toFloat());
+            reportPartitionSkip();
+            break;
         case DspConfig::crossfeed_enable:
             if(current.toBool())
                 CrossfeedEnable(cast(this->_dsp), 1);
@@ -631,6 +704,7 @@ bool DspHost::update(DspConfig *config, bool ignoreCache)
             break;
         case DspConfig::master_limrelease:
         case DspConfig::master_limthreshold:
+        case DspConfig::master_limtruepeak:
             updateLimiter(config);
             break;
         case DspConfig::master_postgain:
@@ -705,6 +779,9 @@ bool DspHost::update(DspConfig *config, bool ignoreCache)
         updateStereoWide(config);
     }
 
+    // Free effect state the audio thread has swapped out since the last update
+    JamesDSPReclaimParams(cast(this->_dsp));
+
 #ifdef DEBUG_FPE
     fedisableexcept(FE_ALL_EXCEPT & ~FE_INEXACT & ~FE_INVALID);
 #endif
@@ -760,12 +837,10 @@ void DspHost::reloadLiveprog(DspConfig* config)
     timer.start();
     int ret = LiveProgStringParser(cast(this->_dsp), in.readAll().toLocal8Bit().data());
 
-    // Workaround due to library bug
-    jdsp_unlock(cast(this->_dsp));
-
     float msecs = timer.nsecsElapsed() / 1000000.0;
 
-    const char* errorString = NSEEL_code_getcodeerror(cast(this->_dsp)->eel.vm);
+    // The freshly compiled VM only becomes live at the next processed block
+    const char* errorString = LiveProgGetCompileError(cast(this->_dsp));
     if(errorString != NULL)
     {
         util::warning("Syntax error in script file, cannot load. Reason: " + std::string(errorString));
@@ -854,6 +929,53 @@ void DspHost::freezeLiveprogExecution(bool freeze)
     Log::debug("Liveprog execution has been " + (freeze ? QString("frozen") : "resumed"));
 }
 
+void DspHost::setStageProfiling(bool enable)
+{
+    JamesDSPStageProfilerEnable(cast(this->_dsp), enable);
+    Log::debug("Stage profiling has been " + (enable ? QString("enabled") : "disabled"));
+}
+
+void DspHost::resetStageStats()
+{
+    JamesDSPStageProfilerReset(cast(this->_dsp));
+}
+
+QString DspHost::stageStats()
+{
+    std::vector<JStageStats> stats(JDSP_STAGE_COUNT * JDSP_STAGE_BLOCKBINS);
+    int count = JamesDSPGetStageStats(cast(this->_dsp), stats.data(), stats.size());
+
+    QJsonArray array;
+    for(int i = 0; i < count; i++)
+    {
+        const JStageStats& st = stats[i];
+        QJsonObject obj;
+        obj["stage"] = JamesDSPStageName(st.stage);
+        obj["blockSize"] = (int)st.blockSize;
+        obj["count"] = (qint64)st.count;
+        obj["minNs"] = st.minNs;
+        obj["meanNs"] = st.meanNs;
+        obj["maxNs"] = st.maxNs;
+        obj["p99Ns"] = st.p99Ns;
+        array.append(obj);
+    }
+
+    // Shared by every convolver tail, the counters run since startup
+    ConvolverWorkerPoolStats pool;
+    ConvolverWorkerPoolGetStats(&pool);
+    QJsonObject poolObj;
+    poolObj["stage"] = "workerPool";
+    poolObj["threads"] = (int)pool.threads;
+    poolObj["tasks"] = (int)pool.tasks;
+    poolObj["submitted"] = (qint64)pool.submitted;
+    poolObj["missedDeadlines"] = (qint64)pool.missedDeadlines;
+    poolObj["spinResolved"] = (qint64)pool.spinResolved;
+    poolObj["lowLatency"] = (bool)pool.lowLatency;
+    array.append(poolObj);
+
+    return QString::fromUtf8(QJsonDocument(array).toJson(QJsonDocument::Compact));
+}
+
 void DspHost::dispatch(Message msg, std::any value)
 {
     _extraFunc(msg, value);
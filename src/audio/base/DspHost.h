@@ -13,6 +13,8 @@ class BenchmarkWorker;
 class DspConfig;
 class QThread;
 #include <QtCore/qcontainerfwd.h>
+#include <QMetaObject>
+#include <QString>
 
 class DspHost
 {
@@ -39,7 +41,11 @@ public:
     bool manipulateEelVariable(const char *name, float value);
     void freezeLiveprogExecution(bool freeze);
     void runBenchmarks();
-    void loadBenchmarkData();
+    bool loadBenchmarkData();
+
+    void setStageProfiling(bool enable);
+    void resetStageStats();
+    QString stageStats();
 
     void dispatch(Message msg, std::any value);
 
@@ -55,12 +61,17 @@ private:
     QThread* benchmarkThread;
     BenchmarkWorker* benchmarkWorker;
 
+    QMetaObject::Connection appConfigConnection;
+
+    void updateWorkerPool();
+    void updateIrCache();
     void updateLimiter(DspConfig *config);
     void updateFirEqualizer(DspConfig *config);
     void updateVdc(DspConfig *config);
     void updateCompander(DspConfig *config);
     void updateReverb(DspConfig *config);
     void updateConvolver(DspConfig *config);
+    void reportPartitionSkip();
     void updateGraphicEq(DspConfig *config);
     void updateCrossfeed(DspConfig *config);
     void updateStereoWide(DspConfig *config);
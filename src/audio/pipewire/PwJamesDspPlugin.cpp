@@ -1,4 +1,5 @@
 #include "PwJamesDspPlugin.h"
+#include <QElapsedTimer>
 #include <QString>
 #include <clocale>
 
@@ -47,6 +48,8 @@ PwJamesDspPlugin::PwJamesDspPlugin(PwPipelineManager* pipe_manager, IAudioServic
                 break;
         }
     });
+
+    reconfig_thread = std::thread(&PwJamesDspPlugin::reconfigure_worker, this);
 }
 
 PwJamesDspPlugin::~PwJamesDspPlugin() {
@@ -54,6 +57,9 @@ PwJamesDspPlugin::~PwJamesDspPlugin() {
     disconnect_from_pw();
   }
 
+  reconfig_stop = true;
+  reconfig_request.release();
+  reconfig_thread.join();
 
 #ifdef DEBUG_FPE
   feenableexcept(FE_ALL_EXCEPT & ~FE_INEXACT);
@@ -69,7 +75,47 @@ PwJamesDspPlugin::~PwJamesDspPlugin() {
 }
 
 void PwJamesDspPlugin::setup() {
-    JamesDSPSetSampleRate(this->dsp, rate, 0);
+    // Called on the RT thread; resampler and filter redesign happen on the worker
+    if (rate == requested_rate.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    requested_rate.store(rate, std::memory_order_relaxed);
+    requested_seq.fetch_add(1, std::memory_order_release);
+    reconfig_request.release();
+}
+
+void PwJamesDspPlugin::reconfigure_worker() {
+    while (true) {
+        reconfig_request.acquire();
+
+        if (reconfig_stop) {
+            break;
+        }
+
+        const auto seq = requested_seq.load(std::memory_order_acquire);
+        const auto new_rate = requested_rate.load(std::memory_order_relaxed);
+
+        if (applied_seq.load(std::memory_order_relaxed) == seq) {
+            continue;
+        }
+
+        QElapsedTimer timer;
+        timer.start();
+
+#ifdef DEBUG_FPE
+        feenableexcept(FE_ALL_EXCEPT & ~FE_INEXACT & ~FE_INVALID);
+#endif
+        // The internal rate may change as well, so every rate dependent effect is redesigned
+        JamesDSPSetSampleRate(this->dsp, new_rate, 1);
+#ifdef DEBUG_FPE
+        fedisableexcept(FE_ALL_EXCEPT & ~FE_INEXACT & ~FE_INVALID);
+#endif
+
+        applied_seq.store(seq, std::memory_order_release);
+
+        util::debug(log_tag + name + " reconfigured for " + std::to_string(new_rate) + " Hz in " + std::to_string(timer.elapsed()) + " ms");
+    }
 }
 
 void PwJamesDspPlugin::process(float* left_in,
@@ -78,10 +124,13 @@ void PwJamesDspPlugin::process(float* left_in,
                                float* right_out,
                                size_t length)
 {
-  if (bypass)
+  const bool reconfiguring = applied_seq.load(std::memory_order_acquire) != requested_seq.load(std::memory_order_relaxed);
+
+  if (bypass || reconfiguring)
   {
       memcpy(left_out, left_in, length * sizeof (float));
       memcpy(right_out, right_in, length * sizeof (float));
+      reconfig_bypassed = reconfiguring;
       return;
   }
 
@@ -90,6 +139,18 @@ void PwJamesDspPlugin::process(float* left_in,
 #endif
   this->dsp->processFloatDeinterleaved(this->dsp, left_in, right_in, left_out, right_out, length);
 
+  if (reconfig_bypassed)
+  {
+      // Fade from the dry signal back into the reconfigured output
+      for (size_t i = 0; i < length; i++)
+      {
+          const float g = static_cast<float>(i) / static_cast<float>(length);
+          left_out[i] = left_in[i] + (left_out[i] - left_in[i]) * g;
+          right_out[i] = right_in[i] + (right_out[i] - right_in[i]) * g;
+      }
+      reconfig_bypassed = false;
+  }
+
   if (post_messages) {
     get_peaks(left_in, right_in, left_out, right_out, length);
 
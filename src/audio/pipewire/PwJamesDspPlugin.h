@@ -5,6 +5,10 @@
 #include "IDspElement.h"
 #include "IAudioService.h"
 
+#include <atomic>
+#include <semaphore>
+#include <thread>
+
 extern "C" {
 #include "jdsp_header.h"
 }
@@ -29,6 +33,18 @@ public:
   DspStatus status() override;
 
   JamesDSPLib* dsp;
+
+private:
+  void reconfigure_worker();
+
+  // Sample rate changes are applied by a worker; the RT thread passes audio through until it finishes
+  std::thread reconfig_thread;
+  std::counting_semaphore<> reconfig_request{0};
+  std::atomic<bool> reconfig_stop{false};
+  std::atomic<uint32_t> requested_rate{48000U};
+  std::atomic<uint32_t> requested_seq{0U};
+  std::atomic<uint32_t> applied_seq{0U};
+  bool reconfig_bypassed = false;
 };
 
 #endif
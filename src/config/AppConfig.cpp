@@ -47,8 +47,15 @@ AppConfig::AppConfig()
     DEFINE_KEY(AudioVirtualSinkForceMaxValue, true);
 
     DEFINE_KEY(BenchmarkOnBoot, true);
-    DEFINE_KEY(BenchmarkCacheC0, "");
-    DEFINE_KEY(BenchmarkCacheC1, "");
+    DEFINE_KEY(BenchmarkCache, QByteArray());
+
+    DEFINE_KEY(ConvolverThreads, 0);
+    DEFINE_KEY(ConvolverRtPriority, 0);
+    DEFINE_KEY(ConvolverCpuAffinity, QStringList());
+    DEFINE_KEY(ConvolverLowLatency, false);
+    DEFINE_KEY(ConvolverCacheEnabled, true);
+    DEFINE_KEY(ConvolverCacheDirectory, "");
+    DEFINE_KEY(ConvolverCacheLimit, 1024);
 
     DEFINE_KEY(AeqPlotDarkMode, false);
 
@@ -69,8 +69,15 @@ public:
         AudioVirtualSinkForceMaxValue,
 
         BenchmarkOnBoot,
-        BenchmarkCacheC0,
-        BenchmarkCacheC1,
+        BenchmarkCache,
+
+        ConvolverThreads,
+        ConvolverRtPriority,
+        ConvolverCpuAffinity,
+        ConvolverLowLatency,
+        ConvolverCacheEnabled,
+        ConvolverCacheDirectory,
+        ConvolverCacheLimit,
 
         AeqPlotDarkMode,
 
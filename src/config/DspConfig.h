@@ -42,9 +42,13 @@ public:
         compander_granularity,
         compander_timeconstant,
         compander_time_freq_transforms,
+        convolver_crossfade_ms,
         convolver_enable,
         convolver_file,
+        convolver_fused_lti,
         convolver_optimization_mode,
+        convolver_share_spectra,
+        convolver_skip_threshold,
         convolver_waveform_edit,
         crossfeed_bs2b_fcut,
         crossfeed_bs2b_feed,
@@ -77,6 +81,7 @@ public:
         master_enable,
         master_limrelease,
         master_limthreshold,
+        master_limtruepeak,
         master_postgain,
         stereowide_enable,
         stereowide_level,
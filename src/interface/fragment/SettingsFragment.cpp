@@ -1,4 +1,5 @@
 #include <IAudioService.h>
+#include <BenchmarkWorker.h>
 
 #include "SettingsFragment.h"
 #include "ui_MainWindow.h"
@@ -276,8 +277,7 @@ void SettingsFragment::refreshAll()
 
     ui->aeqStatus->setText(AeqPackageManager().isPackageInstalled() ? tr("installed") : tr("not installed"));
 
-    if(AppConfig::instance().get<QString>(AppConfig::BenchmarkCacheC0).isEmpty() &&
-       AppConfig::instance().get<QString>(AppConfig::BenchmarkCacheC1).isEmpty())
+    if(!BenchmarkWorker::hasCache())
         updateBenchmarkStatus(tr("no benchmark data stored"));
     else
         updateBenchmarkStatus(tr("benchmark data loaded"));
@@ -456,8 +456,7 @@ void SettingsFragment::onBenchmarkRunClicked()
 
 void SettingsFragment::onBenchmarkClearClicked()
 {
-    AppConfig::instance().set(AppConfig::BenchmarkCacheC0, "");
-    AppConfig::instance().set(AppConfig::BenchmarkCacheC1, "");
+    BenchmarkWorker::clearCache();
     QMessageBox::information(this, tr("Cache cleared"), tr("Benchmark data has been cleared. Restart this app to fully apply the changes."));
     updateBenchmarkStatus(tr("no benchmark data stored"));
 }
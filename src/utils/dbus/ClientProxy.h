@@ -143,6 +143,12 @@ public Q_SLOTS: // METHODS
         return asyncCallWithArgumentList(QStringLiteral("getPresets"), argumentList);
     }
 
+    inline QDBusPendingReply<QString> getStageStats()
+    {
+        QList<QVariant> argumentList;
+        return asyncCallWithArgumentList(QStringLiteral("getStageStats"), argumentList);
+    }
+
     inline QDBusPendingReply<> loadPreset(const QString &name)
     {
         QList<QVariant> argumentList;
@@ -150,6 +156,12 @@ public Q_SLOTS: // METHODS
         return asyncCallWithArgumentList(QStringLiteral("loadPreset"), argumentList);
     }
 
+    inline QDBusPendingReply<> resetStageStats()
+    {
+        QList<QVariant> argumentList;
+        return asyncCallWithArgumentList(QStringLiteral("resetStageStats"), argumentList);
+    }
+
     inline QDBusPendingReply<> savePreset(const QString &name)
     {
         QList<QVariant> argumentList;
@@ -178,6 +190,13 @@ public Q_SLOTS: // METHODS
         return asyncCallWithArgumentList(QStringLiteral("setPresetRule"), argumentList);
     }
 
+    inline QDBusPendingReply<> setStageProfiling(bool enabled)
+    {
+        QList<QVariant> argumentList;
+        argumentList << QVariant::fromValue(enabled);
+        return asyncCallWithArgumentList(QStringLiteral("setStageProfiling"), argumentList);
+    }
+
 Q_SIGNALS: // SIGNALS
 };
 
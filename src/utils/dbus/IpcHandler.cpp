@@ -164,6 +164,21 @@ QList<IOutputDevice> IpcHandler::getOutputDevices() const
     return QVector<IOutputDevice>(devices.begin(), devices.end()).toList();
 }
 
+QString IpcHandler::getStageStats() const
+{
+    return _service->host()->stageStats();
+}
+
+void IpcHandler::resetStageStats() const
+{
+    _service->host()->resetStageStats();
+}
+
+void IpcHandler::setStageProfiling(bool enabled) const
+{
+    _service->host()->setStageProfiling(enabled);
+}
+
 void IpcHandler::setInternal(const QString &key, const QDBusVariant &value) const
 {
     QMetaEnum meta = QMetaEnum::fromType<DspConfig::Key>();
@@ -58,6 +58,10 @@ public slots:
 
      QList<IOutputDevice> getOutputDevices() const;
 
+    QString getStageStats() const;
+    void resetStageStats() const;
+    void setStageProfiling(bool enabled) const;
+
 private:
     QDBusConnection _connection = QDBusConnection::sessionBus();
     ServiceAdaptor* _dbusAdapter;
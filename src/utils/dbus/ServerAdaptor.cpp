@@ -157,12 +157,26 @@ QStringList ServiceAdaptor::getPresets()
     return presets;
 }
 
+QString ServiceAdaptor::getStageStats()
+{
+    // handle method call me.timschneeberger.jdsp4linux.Service.getStageStats
+    QString stats;
+    QMetaObject::invokeMethod(parent(), "getStageStats", Q_RETURN_ARG(QString, stats));
+    return stats;
+}
+
 void ServiceAdaptor::loadPreset(const QString &name)
 {
     // handle method call me.timschneeberger.jdsp4linux.Service.loadPreset
     QMetaObject::invokeMethod(parent(), "loadPreset", Q_ARG(QString, name));
 }
 
+void ServiceAdaptor::resetStageStats()
+{
+    // handle method call me.timschneeberger.jdsp4linux.Service.resetStageStats
+    QMetaObject::invokeMethod(parent(), "resetStageStats");
+}
+
 void ServiceAdaptor::savePreset(const QString &name)
 {
     // handle method call me.timschneeberger.jdsp4linux.Service.savePreset
@@ -187,3 +201,9 @@ void ServiceAdaptor::setPresetRule(const QString &deviceName, const QString &dev
     QMetaObject::invokeMethod(parent(), "setPresetRule", Q_ARG(QString, deviceName), Q_ARG(QString, deviceId), Q_ARG(QString, routeName), Q_ARG(QString, routeId), Q_ARG(QString, preset));
 }
 
+void ServiceAdaptor::setStageProfiling(bool enabled)
+{
+    // handle method call me.timschneeberger.jdsp4linux.Service.setStageProfiling
+    QMetaObject::invokeMethod(parent(), "setStageProfiling", Q_ARG(bool, enabled));
+}
+
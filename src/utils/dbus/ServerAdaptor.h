@@ -110,6 +110,13 @@ class ServiceAdaptor: public QDBusAbstractAdaptor
 "      <annotation value=\"QList&lt;IOutputDevice&gt;\" name=\"org.qtproject.QtDBus.QtTypeName.Out0\"/>\n"
 "      <arg direction=\"out\" type=\"a(issss)\" name=\"devices\"/>\n"
 "    </method>\n"
+"    <method name=\"getStageStats\">\n"
+"      <arg direction=\"out\" type=\"s\" name=\"stats\"/>\n"
+"    </method>\n"
+"    <method name=\"resetStageStats\"/>\n"
+"    <method name=\"setStageProfiling\">\n"
+"      <arg direction=\"in\" type=\"b\" name=\"enabled\"/>\n"
+"    </method>\n"
 "  </interface>\n"
         "")
 public:
@@ -145,11 +152,14 @@ public Q_SLOTS: // METHODS
     QList<IOutputDevice> getOutputDevices();
     QList<PresetRule> getPresetRules();
     QStringList getPresets();
+    QString getStageStats();
     void loadPreset(const QString &name);
+    void resetStageStats();
     void savePreset(const QString &name);
     void set(const QString &key, const QDBusVariant &value);
     void setAndCommit(const QString &key, const QDBusVariant &value);
     void setPresetRule(const QString &deviceName, const QString &deviceId, const QString &routeName, const QString &routeId, const QString &preset);
+    void setStageProfiling(bool enabled);
 Q_SIGNALS: // SIGNALS
 };
 